@@ -1,9 +1,27 @@
 #pragma once
 #include "AudioStream.hpp"
 #include "Sample.hpp"
+#include "Resampler.hpp"
 
 extern class Audio* g_audio;
 
+/*
+	Measurements of the output device clock that the position of playing streams is derived from
+	all times are in seconds
+*/
+struct AudioTiming
+{
+	// Time from handing a buffer to the device until it is heard
+	double latency = 0.0;
+	// How far the device clock has fallen behind the system clock since the last resync
+	double drift = 0.0;
+	// Average deviation of device callbacks from the smoothed clock
+	double jitter = 0.0;
+	// Number of times the clock was reset because a callback was too far off, for example after the device stalled
+	uint32 numResyncs = 0;
+	uint32 numCallbacks = 0;
+};
+
 /*
 	Main audio manager
 	keeps track of active samples and audio streams
@@ -16,16 +34,34 @@ public:
 	~Audio();
 	// Initializes the audio device
 	bool Init(bool exclusive);
+	// Initializes the mixer without an audio device, audio is only produced by calling Render
+	bool InitOffline(uint32 sampleRate);
+	// Renders interleaved stereo frames, only used after InitOffline
+	//	the playback time of streams advances by the number of frames rendered
+	void Render(float* data, uint32 numFrames);
 	void SetGlobalVolume(float vol);
 
 	// Opens a stream at path
 	//	settings preload loads the whole file into memory before playing
 	Ref<AudioStream> CreateStream(const String& path, bool preload = false);
+	// Creates a stream that plays a clip from memory
+	Ref<AudioStream> CreateStream(Ref<AudioClip> clip);
+	// Decodes part of a file into memory, can be called from any thread
+	Ref<AudioClip> DecodeClip(const String& path, int32 offset, int32 length);
 	// Open a wav file at path
 	Sample CreateSample(const String& path);
 
 	// Target/Output sample rate
 	uint32 GetSampleRate() const;
+	// Current state of the output device clock, can be called from any thread
+	AudioTiming GetTiming() const;
+
+	// Amount of audio in milliseconds that streams decode ahead of playback
+	//	only applies to streams that start playing after this is set
+	void SetDecodeAhead(uint32 ms);
+	uint32 GetDecodeAhead() const;
+	// Filter used by streams to convert to the output rate and playback speed
+	void SetResampleQuality(ResampleQuality quality);
 
 	// Private
 	class Audio_Impl* GetImpl();
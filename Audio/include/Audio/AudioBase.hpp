@@ -44,7 +44,10 @@ public:
 	// Adds a signal processor to the audio
 	void AddDSP(DSP* dsp);
 	// Removes a signal processor from the audio
+	//	waits for the mixer to stop using it
 	void RemoveDSP(DSP* dsp);
+	// Removes a signal processor and deletes it once the mixer is done with it, without waiting
+	void DestroyDSP(DSP* dsp);
 
 
 	void Deregister();
@@ -59,6 +62,7 @@ public:
 		return m_volume;
 	}
 
+	// Changed by the mixer while registered, use AddDSP and RemoveDSP
 	Vector<DSP*> DSPs;
 	float PlaybackSpeed = 1.0;
 	class Audio_Impl* audio = nullptr;
@@ -27,6 +27,9 @@ public:
 
 	// The actual length of the buffer in seconds
 	double GetBufferLength() const;
+	// Time until the first frame of the buffer that is being mixed is heard, in seconds
+	//	only valid while the mixer is called
+	double GetLatency() const;
 	bool IsIntegerFormat() const;
 
 private:
@@ -3,6 +3,29 @@
 
 class Audio;
 
+/*
+	Part of an audio file decoded into memory
+	shared by the streams that play it, it is not changed after decoding
+*/
+class AudioClip
+{
+public:
+	// Interleaved stereo frames
+	Vector<float> pcm;
+	uint32 sampleRate = 0;
+	// Position of the first frame in the file in milliseconds
+	int32 offset = 0;
+
+	uint32 GetNumFrames() const
+	{
+		return (uint32)(pcm.size() / 2);
+	}
+	size_t GetMemorySize() const
+	{
+		return pcm.size() * sizeof(float);
+	}
+};
+
 /*
 	Audio stream object, currently only supports .ogg format
 	The data is pre-loaded into memory and streamed from there
@@ -11,6 +34,11 @@ class AudioStream : public AudioBase
 {
 public:
 	static Ref<AudioStream> Create(Audio* audio, const String& path, bool preload);
+	// Creates a stream that plays a decoded clip, positions are relative to the start of the clip
+	static Ref<AudioStream> Create(Audio* audio, Ref<AudioClip> clip);
+	// Decodes length milliseconds starting at offset, returns null if the file could not be decoded
+	//	the stream used for decoding is never registered, so this can be called from any thread
+	static Ref<AudioClip> DecodeClip(Audio* audio, const String& path, int32 offset, int32 length);
 	virtual ~AudioStream() = default;
 	// Starts playback of the stream or continues a paused stream
 	virtual void Play() = 0;
@@ -19,4 +47,9 @@ public:
 	// Sets the playback position in milliseconds
 	// negative time alowed, which will produce no audio for a certain amount of time
 	virtual void SetPosition(int32 pos) = 0;
+
+	// Number of times the mixer ran out of decoded audio while playing
+	virtual uint32 GetNumUnderruns() const = 0;
+	// Number of frames that were left silent because of underruns
+	virtual uint64 GetUnderrunFrames() const = 0;
 };
@@ -1,42 +1,154 @@
 #pragma once
+#include "Audio.hpp"
 #include "AudioOutput.hpp"
 #include "AudioBase.hpp"
+#include "Resampler.hpp"
 
 // Threading
 #include <thread>
 #include <mutex>
+#include <atomic>
 using std::thread;
 using std::mutex;
 
+/*
+	A change to the items or DSP's rendered by the mixer
+	these are queued without locking and applied by the mixer between buffers
+*/
+struct MixerCommand
+{
+	enum Type : uint8
+	{
+		AddItem,
+		RemoveItem,
+		AddDSP,
+		RemoveDSP,
+		// Removes the DSP and deletes it after the mixer is done with it
+		DestroyDSP,
+		// Voices of samples, rendered by the sample player
+		PlayVoice,
+		StopVoice,
+		SetVoiceMix,
+	};
+	Type type;
+	AudioBase* item = nullptr;
+	DSP* dsp = nullptr;
+	struct SampleSource* source = nullptr;
+	// Voice parameters, voice id 0 stops all voices of a sample
+	uint32 voiceId = 0;
+	float volume = 1.0f;
+	float pan = 0.0f;
+	bool looping = false;
+	// The sender waits for this command and deletes it after it is applied
+	bool wait = false;
+	std::atomic<bool> applied;
+	MixerCommand* next = nullptr;
+
+	MixerCommand(Type type, AudioBase* item, DSP* dsp = nullptr) : type(type), item(item), dsp(dsp), applied(false) {}
+	MixerCommand(Type type, struct SampleSource* source, uint32 voiceId) : type(type), source(source), voiceId(voiceId), applied(false) {}
+};
+
 class Audio_Impl : public IMixer
 {
 public:
+	Audio_Impl();
+	~Audio_Impl();
+
 	void Start();
 	void Stop();
 	// Get samples
 	virtual void Mix(void* data, uint32& numSamples) override;
+	// Renders stereo float samples without an output device
+	//	has to be called from the thread that registers items while the output is not started
+	void Render(float* data, uint32 numSamples);
+
+	// Allocates the mixing buffers and global DSP's, called by Start
+	void InitMixer(uint32 sampleRate);
+	void ReleaseMixer();
+
 	// Registers an AudioBase to be rendered
 	void Register(AudioBase* audio);
 	// Removes an AudioBase so it is no longer rendered
+	//	waits for the mixer, after this returns the item is no longer used by it
 	void Deregister(AudioBase* audio);
+	// Sends a change to the mixer, waits for it to be applied if the command has the wait flag set
+	void SendCommand(MixerCommand* command);
 
 	uint32 GetSampleRate() const;
 	double GetSecondsPerSample() const;
 
+	// Output frame that is being heard right now, extrapolated from the device clock
+	//	returns false until the device has asked for its first buffer
+	bool GetPlaybackFrame(double& frame) const;
+	// Output frame the buffer that is being rendered starts at, only used by the mixer
+	uint64 GetRenderedFrames() const;
+	AudioTiming GetTiming() const;
+
 	float globalVolume = 1.0f;
+	uint32 decodeAheadMs = 200;
+	ResampleQuality resampleQuality = ResampleQuality::Medium;
+	// Set when rendering without an output device
+	//	streams then decode on the thread that renders instead of ahead of it
+	bool offline = false;
 
-	mutex lock;
+	// Only accessed by the mixer after registering
 	Vector<AudioBase*> itemsToRender;
 	Vector<DSP*> globalDSPs;
 
 	class LimiterDSP* limiter = nullptr;
+	// Renders all sample voices as one item
+	class SamplePlayer* samplePlayer = nullptr;
 
-	// Used to limit rendering to a fixed number of samples (512)
+	// Scratch memory for mixing, allocated once
+	//	holds the mixed buffer and the buffer items render into
+	float* m_scratch = nullptr;
+	// Used to limit rendering to a fixed number of samples (384)
 	float* m_sampleBuffer = nullptr;
+	float* m_itemBuffer = nullptr;
 	uint32 m_sampleBufferLength = 384;
 	uint32 m_remainingSamples = 0;
+	uint32 m_sampleRate = 0;
 
 	thread audioThread;
 	bool runAudioThread = false;
 	AudioOutput* output = nullptr;
-};
\ No newline at end of file
+
+private:
+	void m_Mix(void* data, uint32 numSamples, uint32 outputChannels, bool integerFormat);
+	// Adds a measurement of the device clock, called when the device asks for a buffer
+	//	latency is the time until the first frame of that buffer is heard
+	void m_UpdateClock(double latency);
+	// Renders the next m_sampleBufferLength samples into m_sampleBuffer
+	void m_RenderBuffer();
+	void m_ApplyCommands();
+	void m_ApplyCommand(MixerCommand* command);
+	// Deletes commands and DSP's the mixer is done with
+	void m_ReclaimCommands();
+
+	// Commands sent to the mixer, newest first
+	std::atomic<MixerCommand*> m_commands;
+	// Applied commands that can be deleted by the next sender
+	std::atomic<MixerCommand*> m_retiredCommands;
+	// Set while an output device calls Mix, otherwise senders apply their commands themselves
+	std::atomic<bool> m_running;
+	// Held while applying commands
+	//	the mixer only tries to take it, so it never blocks on this
+	mutex m_applyLock;
+
+	// Frames rendered by the mixer and frames handed to the device, both count from the start of the mixer
+	uint64 m_renderedFrames = 0;
+	uint64 m_deliveredFrames = 0;
+
+	// Device clock, smoothed over callbacks
+	//	stored as the system time at which output frame 0 was heard, so it can be read without locking
+	Timer m_clockTimer;
+	std::atomic<double> m_clockOrigin;
+	// Start of the current drift measurement, reset on every resync
+	double m_driftStartTime = 0.0;
+	double m_driftStartFrame = 0.0;
+	std::atomic<double> m_latency;
+	std::atomic<double> m_drift;
+	std::atomic<double> m_jitter;
+	std::atomic<uint32> m_numResyncs;
+	std::atomic<uint32> m_numCallbacks;
+};
@@ -3,6 +3,7 @@
 */
 #pragma once
 #include "AudioBase.hpp"
+#include "DSPKernels.hpp"
 #include <Shared/Interpolation.hpp>
 
 class PanDSP : public DSP
@@ -19,12 +20,8 @@ public:
 class BQFDSP : public DSP
 {
 public:
-	float b0 = 1.0f;
-	float b1 = 0.0f;
-	float b2 = 0.0f;
-	float a0 = 1.0f;
-	float a1 = 0.0f;
-	float a2 = 0.0f;
+	// Filter coefficients, already divided by a0
+	DSPKernels::BiquadCoefficients coefficients;
 
 	virtual void Process(float* out, uint32 numSamples);
 
@@ -36,13 +33,11 @@ public:
 	void SetPeaking(float q, float freq, float gain, float sampleRate);
 	void SetLowPass(float q, float freq, float sampleRate);
 	void SetHighPass(float q, float freq, float sampleRate);
-private:
+protected:
+	void m_SetCoefficients(float b0, float b1, float b2, float a0, float a1, float a2);
+
 	// Delayed samples
-	static const uint32 order = 2;
-	// FIR Delay buffers
-	float zb[2][order];
-	// IIR Delay buffers
-	float za[2][order];
+	DSPKernels::BiquadState m_state;
 };
 
 // Combinded Low/High-pass and Peaking filter
@@ -0,0 +1,57 @@
+#pragma once
+#include <Shared/Enum.hpp>
+
+/*
+	Instruction sets the DSP kernels are available for
+	the best one supported by the cpu is selected when the program starts
+*/
+DefineEnum(DSPKernelLevel,
+	Scalar,
+	SSE2,
+	AVX,
+	NEON);
+
+/*
+	Inner loops of the DSP's working on interleaved stereo float frames
+	every kernel has a scalar reference version, counts don't have to be a multiple of the vector width
+*/
+namespace DSPKernels
+{
+	// Biquad filter coefficients, normalized so that a0 is 1
+	struct BiquadCoefficients
+	{
+		float b0 = 1.0f;
+		float b1 = 0.0f;
+		float b2 = 0.0f;
+		float a1 = 0.0f;
+		float a2 = 0.0f;
+	};
+	// Delayed input and output frames of a biquad filter, per channel
+	struct BiquadState
+	{
+		float x1[2] = { 0.0f };
+		float x2[2] = { 0.0f };
+		float y1[2] = { 0.0f };
+		float y2[2] = { 0.0f };
+	};
+
+	// Runs a biquad filter over both channels, the result is filtered * wet + input * dry
+	void Biquad(float* buffer, uint32 numFrames, const BiquadCoefficients& coefficients, BiquadState& state, float wet = 1.0f, float dry = 0.0f);
+	// buffer *= (left, right)
+	void ScaleStereo(float* buffer, uint32 numFrames, float left, float right);
+	// Multiplies frame i with gain + step * i
+	void ScaleRamp(float* buffer, uint32 numFrames, float gain, float step);
+	// Multiplies every frame with its own gain
+	void ScaleFrames(float* buffer, const float* gains, uint32 numFrames);
+	// buffer = src * srcGain + buffer * bufferGain
+	void Blend(float* buffer, const float* src, uint32 numFrames, float srcGain, float bufferGain);
+	// dst = src * gain, over single samples instead of frames
+	void ScaleCopy(float* dst, const float* src, uint32 count, float gain);
+
+	// The best level supported by this cpu
+	DSPKernelLevel GetSupportedLevel();
+	DSPKernelLevel GetLevel();
+	// Selects the kernels to use, returns false if the level is not supported by this cpu
+	//	only used to compare against the scalar reference, should not be changed while mixing
+	bool SetLevel(DSPKernelLevel level);
+}
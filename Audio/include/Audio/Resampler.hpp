@@ -0,0 +1,79 @@
+#pragma once
+#include <Shared/Enum.hpp>
+#include <Shared/Vector.hpp>
+
+/*
+	Resampling filter used by streams
+	Nearest picks the closest previous sample, this is the cheapest but aliases when the rates differ
+	Linear interpolates between samples
+	Medium and High use a windowed-sinc filter with 16 or 32 taps
+*/
+DefineEnum(ResampleQuality,
+	Nearest,
+	Linear,
+	Medium,
+	High);
+
+/*
+	Converts interleaved stereo audio from one rate to another
+	input is written in blocks and buffered until there is enough to render the requested output
+	the filters are shared by all resamplers and have to be built with PrepareFilter, so changing settings never allocates
+*/
+class Resampler
+{
+public:
+	Resampler();
+
+	// Builds the filter used for a quality and ratio if it is not built yet, can be called from any thread
+	static void PrepareFilter(ResampleQuality quality, double ratio);
+
+	// Returns false if the filter for the quality is not prepared yet, the previous quality is kept until then
+	bool SetQuality(ResampleQuality quality);
+	ResampleQuality GetQuality() const
+	{
+		return m_quality;
+	}
+	// Sets the number of input frames per output frame
+	//	returns false if the filter for the ratio is not prepared yet, the previous filter is used until then
+	bool SetRatio(double ratio);
+
+	// Clears buffered input and filter history
+	void Reset();
+
+	// Number of input frames that have to be written to render the given number of output frames
+	uint32 GetInputNeeded(uint32 numOutput) const;
+	// Buffered input frames that are not yet passed by the output
+	//	negative when the output has skipped past the end of the input
+	int32 GetPendingFrames() const;
+	void Write(const float* in, uint32 numFrames);
+	// Writes silence so the last frames of the input can be rendered
+	void Flush();
+
+	// Renders up to numOutput frames, limited by the buffered input
+	//	returns the number of frames rendered, consumed is set to the number of input frames passed
+	uint32 Render(float* out, uint32 numOutput, uint32& consumed);
+
+private:
+	// Looks up the filter for the current quality and ratio without waiting for other threads
+	bool m_UpdateFilter();
+	// Frames kept before and after the current position for the filter
+	uint32 m_GetHistory() const;
+	uint32 m_GetLookahead() const;
+
+	ResampleQuality m_quality = ResampleQuality::Nearest;
+	double m_ratio = 1.0;
+	// Input frames per output frame in 32.32 fixed point
+	uint64 m_step = 1ull << 32;
+
+	// Null for qualities that don't use a filter
+	const struct ResampleFilter* m_filter = nullptr;
+	uint32 m_numTaps = 0;
+	// Set when the ratio changed and the filter for it was not prepared yet
+	bool m_filterPending = false;
+
+	// Interleaved input frames, m_position is relative to the start of this buffer
+	Vector<float> m_input;
+	uint32 m_inputLength = 0;
+	// Position of the next output frame in the input in 32.32 fixed point
+	uint64 m_position = 0;
+};
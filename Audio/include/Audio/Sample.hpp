@@ -3,6 +3,9 @@
 
 /*
 	Audio sample, only supports wav files in signed 16 bit stereo or mono
+	every play starts a new voice, samples can play a limited number of voices at the same time
+	the volume of the sample applies to all of its voices
+	DSP's added to the sample are applied to all of its voices mixed together
 */
 class SampleRes : public AudioBase
 {
@@ -15,10 +18,20 @@ public:
 	virtual uint32 GetBitsPerSample() const = 0;
 	virtual uint32 GetNumChannels() const = 0;
 
-	// Plays this sample from the start
-	virtual void Play(bool looping = false) = 0;
+	// Plays this sample from the start on a new voice and returns its id
+	//	the oldest voice of this sample is stopped if it already plays the maximum number of voices
+	//	looping stops the other voices of this sample first
+	virtual uint32 Play(bool looping = false) = 0;
+	// Same as Play with a volume and a -1 to 1 LR pan value for the new voice
+	virtual uint32 PlayVoice(float volume, float pan = 0.0f, bool looping = false) = 0;
+	virtual void SetVoiceMix(uint32 voice, float volume, float pan) = 0;
+	virtual void StopVoice(uint32 voice) = 0;
+	// Stops all voices
 	virtual void Stop() = 0;
 	virtual bool IsPlaying() const = 0;
+
+	// Maximum number of voices playing at the same time, 8 by default
+	virtual void SetMaxVoices(uint32 numVoices) = 0;
 };
 
 typedef Ref<SampleRes> Sample;
\ No newline at end of file
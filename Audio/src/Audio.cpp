@@ -4,91 +4,82 @@
 #include "Audio_Impl.hpp"
 #include "AudioOutput.hpp"
 #include "DSP.hpp"
+#include "MixKernels.hpp"
+#include "SamplePlayer.hpp"
 
 Audio* g_audio = nullptr;
 Audio_Impl impl;
 
-void Audio_Impl::Mix(void* data, uint32& numSamples)
-{
 #if _DEBUG
-	static const uint32 guardBand = 1024;
+static const uint32 guardBand = 1024;
 #else
-	static const uint32 guardBand = 0;
+static const uint32 guardBand = 0;
 #endif
 
-	// Per-Channel data buffer
-	float* tempData = new float[m_sampleBufferLength * 2 + guardBand];
-	uint32* guardBuffer = (uint32*)tempData + 2 * m_sampleBufferLength;
-	double adv = GetSecondsPerSample();
+// Callbacks further off the smoothed device clock than this reset it
+static const double clockResyncThreshold = 0.05;
+// How fast the smoothed clock follows the callbacks
+static const double clockSmoothing = 0.05;
 
-	uint32 outputChannels = this->output->GetNumChannels();
-	if (output->IsIntegerFormat())
+Audio_Impl::Audio_Impl() : m_commands(nullptr), m_retiredCommands(nullptr), m_running(false), m_clockOrigin(0.0),
+	m_latency(0.0), m_drift(0.0), m_jitter(0.0), m_numResyncs(0), m_numCallbacks(0)
+{
+}
+Audio_Impl::~Audio_Impl()
+{
+	ReleaseMixer();
+}
+void Audio_Impl::Mix(void* data, uint32& numSamples)
+{
+	m_UpdateClock(output->GetLatency());
+	m_Mix(data, numSamples, output->GetNumChannels(), output->IsIntegerFormat());
+	m_deliveredFrames += numSamples;
+}
+void Audio_Impl::m_UpdateClock(double latency)
+{
+	const double now = m_clockTimer.SecondsAsDouble();
+	const double secondsPerSample = GetSecondsPerSample();
+	// The frame that is heard right now and the time frame 0 would have been heard according to it
+	const double frame = (double)m_deliveredFrames - latency * (double)m_sampleRate;
+	const double origin = now - frame * secondsPerSample;
+
+	const double clockOrigin = m_clockOrigin.load(std::memory_order_relaxed);
+	const double error = origin - clockOrigin;
+	if(m_numCallbacks.load(std::memory_order_relaxed) == 0 || fabs(error) > clockResyncThreshold)
 	{
-		memset(data, 0, numSamples * sizeof(int16) * outputChannels);
+		if(m_numCallbacks.load(std::memory_order_relaxed) > 0)
+		{
+			m_numResyncs++;
+			Logf("Audio clock resync, off by %.1f ms", Logger::Info, error * 1000.0);
+		}
+		m_clockOrigin.store(origin, std::memory_order_relaxed);
+		m_driftStartTime = now;
+		m_driftStartFrame = frame;
 	}
 	else
 	{
-		memset(data, 0, numSamples * sizeof(float) * outputChannels);
+		double jitter = m_jitter.load(std::memory_order_relaxed);
+		m_jitter.store(jitter + (fabs(error) - jitter) * clockSmoothing, std::memory_order_relaxed);
+		m_clockOrigin.store(clockOrigin + error * clockSmoothing, std::memory_order_relaxed);
 	}
 
+	m_drift.store((now - m_driftStartTime) - (frame - m_driftStartFrame) * secondsPerSample, std::memory_order_relaxed);
+	m_latency.store(latency, std::memory_order_relaxed);
+	m_numCallbacks.fetch_add(1, std::memory_order_release);
+}
+void Audio_Impl::Render(float* data, uint32 numSamples)
+{
+	m_Mix(data, numSamples, 2, false);
+}
+void Audio_Impl::m_Mix(void* data, uint32 numSamples, uint32 outputChannels, bool integerFormat)
+{
 	uint32 currentNumberOfSamples = 0;
 	while(currentNumberOfSamples < numSamples)
 	{
 		// Generate new sample
 		if(m_remainingSamples <= 0)
 		{
-			// Clear sample buffer storing a fixed amount of samples
-			memset(m_sampleBuffer, 0, sizeof(float) * 2 * m_sampleBufferLength);
-
-			// Render items
-			lock.lock();
-			for(auto& item : itemsToRender)
-			{
-				// Clearn per-channel data (and guard buffer in debug mode)
-				memset(tempData, 0, sizeof(float) * (2 * m_sampleBufferLength + guardBand));
-				item->Process(tempData, m_sampleBufferLength);
-#if _DEBUG
-				// Check for memory corruption
-				for(uint32 i = 0; i < guardBand; i++)
-				{
-					assert(guardBuffer[i] == 0);
-				}
-#endif
-				item->ProcessDSPs(tempData, m_sampleBufferLength);
-#if _DEBUG
-				// Check for memory corruption
-				for(uint32 i = 0; i < guardBand; i++)
-				{
-					assert(guardBuffer[i] == 0);
-				}
-#endif
-
-				// Mix into buffer and apply volume scaling
-				for(uint32 i = 0; i < m_sampleBufferLength; i++)
-				{
-					m_sampleBuffer[i * 2 + 0] += tempData[i * 2] * item->GetVolume();
-					m_sampleBuffer[i * 2 + 1] += tempData[i * 2 + 1] * item->GetVolume();
-				}
-			}
-
-			// Process global DSPs
-			for(auto dsp : globalDSPs)
-			{
-				dsp->Process(m_sampleBuffer, m_sampleBufferLength);
-			}
-			lock.unlock();
-
-			// Apply volume levels
-			for(uint32 i = 0; i < m_sampleBufferLength; i++)
-			{
-				m_sampleBuffer[i * 2 + 0] *= globalVolume;
-				m_sampleBuffer[i * 2 + 1] *= globalVolume;
-				// Safety clamp to [-1, 1] that should help protect speakers a bit in case of corruption
-				// this will clip, but so will values outside [-1, 1] anyway
-				m_sampleBuffer[i * 2 + 0] = fmin(fmax(m_sampleBuffer[i * 2 + 0], -1.f), 1.f);
-				m_sampleBuffer[i * 2 + 1] = fmin(fmax(m_sampleBuffer[i * 2 + 1], -1.f), 1.f);
-			}
-
+			m_RenderBuffer();
 			// Set new remaining buffer data
 			m_remainingSamples = m_sampleBufferLength;
 		}
@@ -96,74 +87,313 @@ void Audio_Impl::Mix(void* data, uint32& numSamples)
 		// Copy samples from sample buffer
 		uint32 sampleOffset = m_sampleBufferLength - m_remainingSamples;
 		uint32 maxSamples = Math::Min(numSamples - currentNumberOfSamples, m_remainingSamples);
-		for(uint32 c = 0; c < outputChannels; c++)
+		if(integerFormat)
+		{
+			MixKernels::ConvertToInt16((int16*)data + currentNumberOfSamples * outputChannels, m_sampleBuffer + sampleOffset * 2, maxSamples, outputChannels);
+		}
+		else
 		{
-			if(c < 2)
-			{
-				for(uint32 i = 0; i < maxSamples; i++)
-				{
-					if (output->IsIntegerFormat())
-					{
-						((int16*)data)[(currentNumberOfSamples + i) * outputChannels + c] = (int16)(0x7FFF * Math::Clamp(m_sampleBuffer[(sampleOffset + i) * 2 + c],-1.f,1.f));
-					}
-					else
-					{
-						((float*)data)[(currentNumberOfSamples + i) * outputChannels + c] = m_sampleBuffer[(sampleOffset + i) * 2 + c];
-					}
-				}
-			}
-			// TODO: Mix to surround channels as well?
+			MixKernels::ConvertToFloat((float*)data + currentNumberOfSamples * outputChannels, m_sampleBuffer + sampleOffset * 2, maxSamples, outputChannels);
 		}
 		m_remainingSamples -= maxSamples;
 		currentNumberOfSamples += maxSamples;
 	}
+}
+void Audio_Impl::m_RenderBuffer()
+{
+	// Apply changes to the items and DSP's between buffers
+	if(m_commands.load(std::memory_order_acquire) && m_applyLock.try_lock())
+	{
+		m_ApplyCommands();
+		m_applyLock.unlock();
+	}
+
+	const uint32 bufferSize = 2 * m_sampleBufferLength;
+	// Clear sample buffer storing a fixed amount of samples
+	memset(m_sampleBuffer, 0, sizeof(float) * bufferSize);
 
-	delete[] tempData;
+	// Render items
+	for(auto& item : itemsToRender)
+	{
+		// Clearn per-channel data (and guard buffer in debug mode)
+		memset(m_itemBuffer, 0, sizeof(float) * (bufferSize + guardBand));
+		item->Process(m_itemBuffer, m_sampleBufferLength);
+#if _DEBUG
+		// Check for memory corruption
+		const uint32* guardBuffer = (uint32*)(m_itemBuffer + bufferSize);
+		for(uint32 i = 0; i < guardBand; i++)
+		{
+			assert(guardBuffer[i] == 0);
+		}
+#endif
+		float* itemData = m_itemBuffer;
+		item->ProcessDSPs(itemData, m_sampleBufferLength);
+#if _DEBUG
+		// Check for memory corruption
+		for(uint32 i = 0; i < guardBand; i++)
+		{
+			assert(guardBuffer[i] == 0);
+		}
+#endif
+
+		// Mix into buffer and apply volume scaling
+		MixKernels::MixAdd(m_sampleBuffer, itemData, item->GetVolume(), bufferSize);
+	}
+	m_renderedFrames += m_sampleBufferLength;
+
+	// Process global DSPs
+	for(auto dsp : globalDSPs)
+	{
+		dsp->Process(m_sampleBuffer, m_sampleBufferLength);
+	}
+
+	// Apply volume levels
+	// Safety clamp to [-1, 1] that should help protect speakers a bit in case of corruption
+	// this will clip, but so will values outside [-1, 1] anyway
+	MixKernels::ScaleClamp(m_sampleBuffer, globalVolume, bufferSize);
 }
-void Audio_Impl::Start()
+void Audio_Impl::m_ApplyCommands()
+{
+	// Take all queued commands and apply them in the order they were sent
+	MixerCommand* list = m_commands.exchange(nullptr, std::memory_order_acquire);
+	MixerCommand* ordered = nullptr;
+	while(list)
+	{
+		MixerCommand* next = list->next;
+		list->next = ordered;
+		ordered = list;
+		list = next;
+	}
+
+	while(ordered)
+	{
+		MixerCommand* command = ordered;
+		ordered = command->next;
+		m_ApplyCommand(command);
+
+		if(command->wait)
+		{
+			// Owned by the sender from here on
+			command->applied.store(true, std::memory_order_release);
+		}
+		else
+		{
+			command->next = m_retiredCommands.load(std::memory_order_relaxed);
+			while(!m_retiredCommands.compare_exchange_weak(command->next, command, std::memory_order_release, std::memory_order_relaxed))
+				;
+		}
+	}
+}
+void Audio_Impl::m_ApplyCommand(MixerCommand* command)
+{
+	AudioBase* item = command->item;
+	switch(command->type)
+	{
+	case MixerCommand::AddItem:
+		itemsToRender.AddUnique(item);
+		break;
+	case MixerCommand::RemoveItem:
+		itemsToRender.Remove(item);
+		break;
+	case MixerCommand::AddDSP:
+	{
+		// Keep sorted by priority
+		DSP* dsp = command->dsp;
+		if(item->DSPs.Contains(dsp))
+			break;
+		auto it = item->DSPs.begin();
+		while(it != item->DSPs.end() && ((*it)->priority < dsp->priority || ((*it)->priority == dsp->priority && *it < dsp)))
+			it++;
+		item->DSPs.insert(it, dsp);
+		break;
+	}
+	case MixerCommand::RemoveDSP:
+	case MixerCommand::DestroyDSP:
+		item->DSPs.Remove(command->dsp);
+		break;
+	case MixerCommand::PlayVoice:
+		if(samplePlayer)
+			samplePlayer->PlayVoice(command->source, command->voiceId, command->volume, command->pan, command->looping);
+		else
+			command->source->numVoices--; // No mixer to play it
+		break;
+	case MixerCommand::StopVoice:
+		if(samplePlayer)
+			samplePlayer->StopVoice(command->source, command->voiceId);
+		break;
+	case MixerCommand::SetVoiceMix:
+		if(samplePlayer)
+			samplePlayer->SetVoiceMix(command->source, command->voiceId, command->volume, command->pan);
+		break;
+	}
+}
+void Audio_Impl::m_ReclaimCommands()
+{
+	MixerCommand* command = m_retiredCommands.exchange(nullptr, std::memory_order_acquire);
+	while(command)
+	{
+		MixerCommand* next = command->next;
+		if(command->type == MixerCommand::DestroyDSP)
+		{
+			command->dsp->audioBase = nullptr;
+			delete command->dsp;
+		}
+		delete command;
+		command = next;
+	}
+}
+void Audio_Impl::SendCommand(MixerCommand* command)
 {
-	m_sampleBuffer = new float[2 * m_sampleBufferLength];
+	m_ReclaimCommands();
+
+	command->next = m_commands.load(std::memory_order_relaxed);
+	while(!m_commands.compare_exchange_weak(command->next, command, std::memory_order_release, std::memory_order_relaxed))
+		;
+
+	if(!command->wait)
+	{
+		if(!m_running)
+		{
+			// Nothing is mixing right now
+			std::lock_guard<mutex> guard(m_applyLock);
+			m_ApplyCommands();
+		}
+		return;
+	}
+
+	while(!command->applied.load(std::memory_order_acquire))
+	{
+		if(!m_running)
+		{
+			std::lock_guard<mutex> guard(m_applyLock);
+			m_ApplyCommands();
+			continue;
+		}
+		// Applied by the mixer on its next buffer
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+	delete command;
+}
+void Audio_Impl::InitMixer(uint32 sampleRate)
+{
+	ReleaseMixer();
+	m_sampleRate = sampleRate;
+
+	// One block for the mixed samples and the item buffer with its guard band
+	const uint32 bufferSize = 2 * m_sampleBufferLength;
+	m_scratch = new float[bufferSize * 2 + guardBand];
+	m_sampleBuffer = m_scratch;
+	m_itemBuffer = m_scratch + bufferSize;
+	m_remainingSamples = 0;
+
+	// The clock starts over with the frame counters
+	m_renderedFrames = 0;
+	m_deliveredFrames = 0;
+	m_numCallbacks = 0;
+	m_numResyncs = 0;
+	m_jitter = 0.0;
+	m_drift = 0.0;
+	m_clockTimer.Restart();
+
+	// Avoid allocating while mixing
+	itemsToRender.reserve(256);
 
 	limiter = new LimiterDSP();
 	limiter->audio = this;
 	limiter->releaseTime = 0.2f;
 	globalDSPs.Add(limiter);
+
+	samplePlayer = new SamplePlayer();
+	samplePlayer->audio = this;
+	samplePlayer->SetBufferLength(m_sampleBufferLength);
+	itemsToRender.Add(samplePlayer);
+}
+void Audio_Impl::ReleaseMixer()
+{
+	std::lock_guard<mutex> guard(m_applyLock);
+	m_ApplyCommands();
+	m_ReclaimCommands();
+
+	if(limiter)
+	{
+		globalDSPs.Remove(limiter);
+		delete limiter;
+		limiter = nullptr;
+	}
+	if(samplePlayer)
+	{
+		itemsToRender.Remove(samplePlayer);
+		samplePlayer->StopAll();
+		samplePlayer->audio = nullptr;
+		delete samplePlayer;
+		samplePlayer = nullptr;
+	}
+
+	delete[] m_scratch;
+	m_scratch = nullptr;
+	m_sampleBuffer = nullptr;
+	m_itemBuffer = nullptr;
+}
+void Audio_Impl::Start()
+{
+	InitMixer(output->GetSampleRate());
+
+	m_running = true;
 	output->Start(this);
 }
 void Audio_Impl::Stop()
 {
 	output->Stop();
-	delete limiter;
-	globalDSPs.Remove(limiter);
+	m_running = false;
 
-	delete[] m_sampleBuffer;
-	m_sampleBuffer = nullptr;
+	ReleaseMixer();
 }
 void Audio_Impl::Register(AudioBase* audio)
 {
 	if (audio)
 	{
-		lock.lock();
-		itemsToRender.AddUnique(audio);
 		audio->audio = this;
-		lock.unlock();
+		// Avoid allocating when DSP's are added while mixing
+		audio->DSPs.reserve(16);
+		SendCommand(new MixerCommand(MixerCommand::AddItem, audio));
 	}
 }
 void Audio_Impl::Deregister(AudioBase* audio)
 {
-	lock.lock();
-	itemsToRender.Remove(audio);
+	MixerCommand* command = new MixerCommand(MixerCommand::RemoveItem, audio);
+	command->wait = true;
+	SendCommand(command);
 	audio->audio = nullptr;
-	lock.unlock();
 }
 uint32 Audio_Impl::GetSampleRate() const
 {
-	return output->GetSampleRate();
+	return m_sampleRate;
 }
 double Audio_Impl::GetSecondsPerSample() const
 {
 	return 1.0 / (double)GetSampleRate();
 }
+bool Audio_Impl::GetPlaybackFrame(double& frame) const
+{
+	if(m_numCallbacks.load(std::memory_order_acquire) == 0)
+		return false;
+	frame = (m_clockTimer.SecondsAsDouble() - m_clockOrigin.load(std::memory_order_relaxed)) * (double)m_sampleRate;
+	return true;
+}
+uint64 Audio_Impl::GetRenderedFrames() const
+{
+	return m_renderedFrames;
+}
+AudioTiming Audio_Impl::GetTiming() const
+{
+	AudioTiming timing;
+	timing.latency = m_latency.load(std::memory_order_relaxed);
+	timing.drift = m_drift.load(std::memory_order_relaxed);
+	timing.jitter = m_jitter.load(std::memory_order_relaxed);
+	timing.numResyncs = m_numResyncs.load(std::memory_order_relaxed);
+	timing.numCallbacks = m_numCallbacks.load(std::memory_order_relaxed);
+	return timing;
+}
 
 Audio::Audio()
 {
@@ -175,10 +405,19 @@ Audio::~Audio()
 {
 	if(m_initialized)
 	{
-		impl.Stop();
-		delete impl.output;
-		impl.output = nullptr;
+		if(impl.output)
+		{
+			impl.Stop();
+			delete impl.output;
+			impl.output = nullptr;
+		}
+		else
+		{
+			impl.ReleaseMixer();
+		}
 	}
+	// The implementation outlives this, the next audio object can use a device
+	impl.offline = false;
 
 	assert(g_audio == this);
 	g_audio = nullptr;
@@ -187,6 +426,7 @@ bool Audio::Init(bool exclusive)
 {
 	audioLatency = 0;
 
+	impl.offline = false;
 	impl.output = new AudioOutput();
 	if(!impl.output->Init(exclusive))
 	{
@@ -199,13 +439,43 @@ bool Audio::Init(bool exclusive)
 
 	return m_initialized = true;
 }
+bool Audio::InitOffline(uint32 sampleRate)
+{
+	audioLatency = 0;
+
+	impl.offline = true;
+	impl.InitMixer(sampleRate);
+
+	return m_initialized = true;
+}
+void Audio::Render(float* data, uint32 numFrames)
+{
+	assert(impl.offline);
+	impl.Render(data, numFrames);
+}
 void Audio::SetGlobalVolume(float vol)
 {
 	impl.globalVolume = vol;
 }
 uint32 Audio::GetSampleRate() const
 {
-	return impl.output->GetSampleRate();
+	return impl.GetSampleRate();
+}
+AudioTiming Audio::GetTiming() const
+{
+	return impl.GetTiming();
+}
+void Audio::SetDecodeAhead(uint32 ms)
+{
+	impl.decodeAheadMs = ms;
+}
+uint32 Audio::GetDecodeAhead() const
+{
+	return impl.decodeAheadMs;
+}
+void Audio::SetResampleQuality(ResampleQuality quality)
+{
+	impl.resampleQuality = quality;
 }
 class Audio_Impl* Audio::GetImpl()
 {
@@ -216,6 +486,14 @@ Ref<AudioStream> Audio::CreateStream(const String& path, bool preload)
 {
 	return AudioStream::Create(this, path, preload);
 }
+Ref<AudioStream> Audio::CreateStream(Ref<AudioClip> clip)
+{
+	return AudioStream::Create(this, clip);
+}
+Ref<AudioClip> Audio::DecodeClip(const String& path, int32 offset, int32 length)
+{
+	return AudioStream::DecodeClip(this, path, offset, length);
+}
 Sample Audio::CreateSample(const String& path)
 {
 	return SampleRes::Create(this, path);
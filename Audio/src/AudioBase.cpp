@@ -24,27 +24,29 @@ void AudioBase::ProcessDSPs(float*& out, uint32 numSamples)
 }
 void AudioBase::AddDSP(DSP* dsp)
 {
-	audio->lock.lock();
-	DSPs.AddUnique(dsp);
-	// Sort by priority
-	DSPs.Sort([](DSP* l, DSP* r)
-	{
-		if(l->priority == r->priority)
-			return l < r;
-		return l->priority < r->priority;
-	});
 	dsp->audioBase = this;
 	dsp->audio = audio;
-	audio->lock.unlock();
+	// Inserted by the mixer, sorted by priority
+	audio->SendCommand(new MixerCommand(MixerCommand::AddDSP, this, dsp));
 }
 void AudioBase::RemoveDSP(DSP* dsp)
 {
-	assert(DSPs.Contains(dsp));
-	audio->lock.lock();
-	DSPs.Remove(dsp);
+	MixerCommand* command = new MixerCommand(MixerCommand::RemoveDSP, this, dsp);
+	command->wait = true;
+	audio->SendCommand(command);
 	dsp->audioBase = nullptr;
 	dsp->audio = nullptr;
-	audio->lock.unlock();
+}
+void AudioBase::DestroyDSP(DSP* dsp)
+{
+	if(!audio)
+	{
+		// Not rendered anymore
+		dsp->audioBase = nullptr;
+		delete dsp;
+		return;
+	}
+	audio->SendCommand(new MixerCommand(MixerCommand::DestroyDSP, this, dsp));
 }
 
 void AudioBase::Deregister()
@@ -4,6 +4,7 @@
 #include "AudioStreamMp3.hpp"
 #include "AudioStreamOgg.hpp"
 #include "AudioStreamWav.hpp"
+#include "AudioStreamClip.hpp"
 #include <unordered_map>
 
 using CreateFunc = Ref<AudioStream>(Audio *, const String &, bool);
@@ -44,4 +45,31 @@ Ref<AudioStream> AudioStream::Create(Audio* audio, const String& path, bool prel
 	if(impl)
 		audio->GetImpl()->Register(impl.GetData());
 	return impl;
-}
\ No newline at end of file
+}
+Ref<AudioStream> AudioStream::Create(Audio* audio, Ref<AudioClip> clip)
+{
+	Ref<AudioStream> impl = AudioStreamClip::Create(audio, clip);
+	if(impl)
+		audio->GetImpl()->Register(impl.GetData());
+	return impl;
+}
+Ref<AudioClip> AudioStream::DecodeClip(Audio* audio, const String& path, int32 offset, int32 length)
+{
+	Ref<AudioStream> impl = FindImplementation(audio, path, false);
+	if(!impl)
+		return Ref<AudioClip>();
+
+	// Every decoder is based on AudioStreamBase
+	AudioStreamBase* stream = static_cast<AudioStreamBase*>(impl.GetData());
+	Ref<AudioClip> clip = Ref<AudioClip>(new AudioClip());
+	clip->sampleRate = stream->GetSampleRate();
+	clip->offset = Math::Max(offset, 0);
+	uint64 startFrame = (uint64)clip->offset * clip->sampleRate / 1000;
+	uint32 numFrames = (uint32)((uint64)Math::Max(length, 0) * clip->sampleRate / 1000);
+	clip->pcm.resize((size_t)numFrames * 2);
+	numFrames = stream->DecodeFrames(startFrame, numFrames, clip->pcm.data());
+	if(numFrames == 0)
+		return Ref<AudioClip>();
+	clip->pcm.resize((size_t)numFrames * 2);
+	return clip;
+}
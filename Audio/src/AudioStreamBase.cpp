@@ -2,29 +2,37 @@
 #include "Shared/Profiling.hpp"
 #include "AudioStreamBase.hpp"
 
-// Fixed point format for resampling
-const uint64 AudioStreamBase::fp_sampleStep = 1ull << 48;
-
+AudioStreamBase::AudioStreamBase() : m_filterNeeded(false), m_clockBase(0.0), m_clockStart(0.0), m_clockValid(false), m_ringRead(0), m_ringWrite(0), m_decodeEnded(false),
+	m_seekTarget(0), m_seekGeneration(1), m_decoderRunning(false), m_numUnderruns(0), m_underrunFrames(0)
+{
+	// Starts with a seek to the beginning so the decoder thread fills the ring before playback starts
+}
+AudioStreamBase::~AudioStreamBase()
+{
+	// Implementations should have stopped the decoder thread before freeing their decoder
+	assert(!m_decoderThread.joinable());
+	m_StopDecoder();
+}
 BinaryStream& AudioStreamBase::m_reader()
 {
-	return m_preloaded ? (BinaryStream&)m_memoryReader : (BinaryStream&)m_fileReader;
+	return m_preloaded ? (BinaryStream&)m_mappedReader : (BinaryStream&)m_fileReader;
 }
 bool AudioStreamBase::Init(Audio* audio, const String& path, bool preload)
 {
 	m_audio = audio;
 
-	if(!m_file.OpenRead(path))
-		return false;
-
 	if(preload)
 	{
-		m_data.resize(m_file.GetSize());
-		m_file.Read(m_data.data(), m_data.size());
-		m_memoryReader = MemoryReader(m_data);
+		// Pages are loaded by the decoder as it reads them, so playback can start without copying the whole file
+		if(!m_mappedFile.Open(path))
+			return false;
+		m_mappedReader = MappedFileReader(m_mappedFile);
 		m_preloaded = preload;
 	}
 	else
 	{
+		if(!m_file.OpenRead(path))
+			return false;
 		m_fileReader = FileReader(m_file);
 		m_preloaded = false;
 	}
@@ -34,10 +42,7 @@ bool AudioStreamBase::Init(Audio* audio, const String& path, bool preload)
 void AudioStreamBase::m_initSampling(uint32 sampleRate)
 {
 	// Calculate the sample step if the rate is not the same as the output rate
-	double sampleStep = (double)sampleRate / (double)m_audio->GetSampleRate();
-	m_sampleStepIncrement = (uint64)(sampleStep * (double)fp_sampleStep);
-	double stepCheck = (double)m_sampleStepIncrement / (double)fp_sampleStep;
-	// TODO: for practice mode: m_sampleStepIncrement *= playback_speed;
+	m_sampleRatio = (double)sampleRate / (double)m_audio->GetSampleRate();
 	m_numChannels = 2;
 	m_readBuffer = new float*[m_numChannels];
 	for(uint32 c = 0; c < m_numChannels; c++)
@@ -46,8 +51,161 @@ void AudioStreamBase::m_initSampling(uint32 sampleRate)
 	}
 }
 
+void AudioStreamBase::m_StartDecoder()
+{
+	if(m_ring)
+		return;
+
+	// Round the ring up to a power of two so positions can be masked
+	uint32 streamRate = (uint32)GetStreamRate_Internal();
+	m_ringAhead = Math::Max<uint32>((uint32)((uint64)streamRate * m_audio->GetDecodeAhead() / 1000), m_bufferSize);
+	uint32 ringSize = 1;
+	while(ringSize < m_ringAhead)
+		ringSize <<= 1;
+	m_ring = new float[ringSize * 2];
+	m_ringMask = ringSize - 1;
+
+	// Most streams keep playing at the speed they start at, so the mixer can use the filter right away
+	Resampler::PrepareFilter(m_audio->GetImpl()->resampleQuality, m_sampleRatio * PlaybackSpeed);
+
+	// Offline the ring is filled by Process instead
+	if(m_audio->GetImpl()->offline)
+		return;
+	m_decoderRunning = true;
+	m_decoderThread = thread(&AudioStreamBase::m_DecoderThread, this);
+}
+void AudioStreamBase::m_StopDecoder()
+{
+	if(m_decoderThread.joinable())
+	{
+		{
+			std::lock_guard<mutex> lock(m_lock);
+			m_decoderRunning = false;
+		}
+		m_decoderSignal.notify_all();
+		m_decoderThread.join();
+	}
+	delete[] m_ring;
+	m_ring = nullptr;
+}
+void AudioStreamBase::m_DecoderThread()
+{
+	while(m_decoderRunning)
+	{
+		if(m_filterNeeded.exchange(false))
+			Resampler::PrepareFilter(m_audio->GetImpl()->resampleQuality, m_sampleRatio * PlaybackSpeed);
+		if(m_Decode())
+			continue;
+
+		// Ring is full or the stream has ended, wait for playback to catch up or for a seek
+		std::unique_lock<mutex> lock(m_lock);
+		m_decoderSignal.wait_for(lock, std::chrono::milliseconds(Math::Max<uint32>(m_audio->GetDecodeAhead() / 4, 1)), [&]()
+		{
+			return !m_decoderRunning || m_seekGeneration != m_decodedSeekGeneration || m_filterNeeded;
+		});
+	}
+}
+bool AudioStreamBase::m_Decode()
+{
+	uint32 seekGeneration = m_seekGeneration.load(std::memory_order_acquire);
+	if(seekGeneration != m_decodedSeekGeneration)
+	{
+		m_decodedSeekGeneration = seekGeneration;
+		SetPosition_Internal((int32)m_seekTarget.load());
+		m_remainingBufferData = 0;
+		m_decodeEnded = false;
+
+		// The mixer doesn't read while seeking, so the ring can be reset and refilled here
+		m_flushLock.lock();
+		m_ringRead = 0;
+		m_ringWrite = 0;
+		m_ringStartPos = GetStreamPosition_Internal();
+		m_ringGeneration++;
+		m_flushLock.unlock();
+		while(m_FillRing())
+		{
+		}
+
+		m_flushLock.lock();
+		if(seekGeneration == m_seekGeneration)
+			m_seeking = false;
+		m_flushLock.unlock();
+		return true;
+	}
+
+	return m_FillRing();
+}
+bool AudioStreamBase::m_FillRing()
+{
+	if(m_decodeEnded)
+		return false;
+
+	uint64 write = m_ringWrite.load(std::memory_order_relaxed);
+	uint64 buffered = write - m_ringRead.load(std::memory_order_acquire);
+	if(buffered >= m_ringAhead)
+		return false;
+
+	if(!m_ReadBlock())
+	{
+		m_decodeEnded.store(true, std::memory_order_release);
+		return false;
+	}
+
+	uint32 count = Math::Min((uint32)(m_ringAhead - buffered), m_remainingBufferData);
+	uint32 idxStart = m_currentBufferSize - m_remainingBufferData;
+	for(uint32 i = 0; i < count; i++)
+	{
+		uint32 idx = (uint32)(write + i) & m_ringMask;
+		m_ring[idx * 2] = m_readBuffer[0][idxStart + i];
+		m_ring[idx * 2 + 1] = m_readBuffer[1][idxStart + i];
+	}
+	m_remainingBufferData -= count;
+	m_ringWrite.store(write + count, std::memory_order_release);
+	return true;
+}
+
+bool AudioStreamBase::m_ReadBlock()
+{
+	if(m_remainingBufferData > 0)
+		return true;
+
+	int32 decoded = DecodeData_Internal();
+	if(decoded <= 0)
+		return false;
+	// At the end of a stream some decoders only fill part of the buffer they report
+	if((uint32)decoded < m_remainingBufferData)
+	{
+		m_currentBufferSize = decoded;
+		m_remainingBufferData = decoded;
+	}
+	return true;
+}
+uint32 AudioStreamBase::DecodeFrames(int64 startFrame, uint32 numFrames, float* out)
+{
+	// Uses the decoder directly, so this can't be used once the decoder thread is running
+	assert(!m_decoderThread.joinable());
+	SetPosition_Internal((int32)startFrame);
+	m_remainingBufferData = 0;
+
+	uint32 numDecoded = 0;
+	while(numDecoded < numFrames && m_ReadBlock())
+	{
+		uint32 count = Math::Min(numFrames - numDecoded, m_remainingBufferData);
+		uint32 idxStart = m_currentBufferSize - m_remainingBufferData;
+		for(uint32 i = 0; i < count; i++)
+		{
+			out[(numDecoded + i) * 2] = m_readBuffer[0][idxStart + i];
+			out[(numDecoded + i) * 2 + 1] = m_readBuffer[1][idxStart + i];
+		}
+		m_remainingBufferData -= count;
+		numDecoded += count;
+	}
+	return numDecoded;
+}
+
 void AudioStreamBase::Play()
 {
+	m_StartDecoder();
 	if(!m_playing)
 	{
 		m_playing = true;
@@ -62,8 +220,6 @@ void AudioStreamBase::Pause()
 {
 	if(!m_paused)
 	{
-		// Store time the stream was paused
-		m_streamTimeOffset = m_streamTimer.SecondsAsDouble();
 		m_paused = true;
 	}
 	else
@@ -84,18 +240,20 @@ double AudioStreamBase::SamplesToSeconds(int64 s) const
 {
 	return (double)s / (double)const_cast<AudioStreamBase*>(this)->GetStreamRate_Internal();
 }
-double AudioStreamBase::m_getPositionSeconds(bool allowFreezeSkip /*= true*/) const
+double AudioStreamBase::m_getPositionSeconds() const
 {
 	double samplePosTime = SamplesToSeconds(m_samplePos);
-	if(m_paused || m_samplePos < 0)
+	// Offline the rendered frames are the only clock
+	Audio_Impl* impl = m_audio->GetImpl();
+	double playbackFrame;
+	if(m_paused || impl->offline || !m_clockValid.load(std::memory_order_acquire) || !impl->GetPlaybackFrame(playbackFrame))
 		return samplePosTime;
-	else
-	{
-		double ret = m_streamTimeOffset + m_streamTimer.SecondsAsDouble() - m_offsetCorrection;
-		if(allowFreezeSkip && (ret - samplePosTime) > 0.2f) // Prevent time from running of when the application freezes
-			return samplePosTime;
-		return ret;
-	}
+
+	// The buffers between the mixer and the speakers are not heard yet, so this is behind the mixed position by the output latency
+	double ret = m_clockBase.load(std::memory_order_relaxed) + playbackFrame * impl->GetSecondsPerSample() * PlaybackSpeed;
+	if((ret - samplePosTime) > 0.2) // Prevent time from running off when the mixer stalls
+		return samplePosTime;
+	return Math::Max(ret, m_clockStart.load(std::memory_order_relaxed));
 }
 int32 AudioStreamBase::GetPosition() const
 {
@@ -103,12 +261,21 @@ int32 AudioStreamBase::GetPosition() const
 }
 void AudioStreamBase::SetPosition(int32 pos)
 {
-	m_lock.lock();
-	m_remainingBufferData = 0;
+	// The mixer outputs silence until the decoder thread has refilled the ring from the new position
+	m_flushLock.lock();
 	m_samplePos = m_secondsToSamples((double)pos / 1000.0);
-	SetPosition_Internal((int32)m_samplePos);
+	m_seekTarget = m_samplePos;
+	m_silenceFraction = 0.0;
+	m_clockValid = false;
+	m_seekGeneration++;
+	m_seeking = true;
 	m_ended = false;
-	m_lock.unlock();
+	m_flushLock.unlock();
+
+	{
+		std::lock_guard<mutex> lock(m_lock);
+	}
+	m_decoderSignal.notify_all();
 }
 float* AudioStreamBase::GetPCM()
 {
@@ -120,107 +287,127 @@ uint32 AudioStreamBase::GetSampleRate() const
 }
 void AudioStreamBase::m_restartTiming()
 {
-	m_streamTimeOffset = SamplesToSeconds(m_samplePos); // Add audio latency to this offset
-	m_samplePos = 0;
-	m_streamTimer.Restart();
-	m_offsetCorrection = 0.0f;
-	m_deltaSum = 0;
-	m_deltaSamples = 0;
+	// The position stays at the mixed position until the mixer continues
+	m_clockValid = false;
 }
 void AudioStreamBase::Process(float* out, uint32 numSamples)
 {
 	if(!m_playing || m_paused)
 		return;
 
-	m_lock.lock();
-
-	uint32 outCount = 0;
-	while(outCount < numSamples)
+	// Without an output device there is no deadline to meet, so decode everything needed right away
+	if(audio->offline)
 	{
-		if(m_remainingBufferData > 0)
+		while(m_Decode())
 		{
-			uint32 idxStart = (m_currentBufferSize - m_remainingBufferData);
-			uint32 readOffset = 0; // Offset from the start to read from
-			for(uint32 i = 0; outCount < numSamples && readOffset < m_remainingBufferData; i++)
-			{
-				if(m_samplePos < 0)
-				{
-					out[outCount * 2] = 0.0f;
-					out[outCount * 2 + 1] = 0.0f;
-				}
-				else
-				{
-					out[outCount * 2] = m_readBuffer[0][idxStart + readOffset];
-					out[outCount * 2 + 1] = m_readBuffer[1][idxStart + readOffset];
-				}
-				outCount++;
-
-				// Increment source sample with resampling
-				m_sampleStep += m_sampleStepIncrement * PlaybackSpeed;
-				while(m_sampleStep >= fp_sampleStep)
-				{
-					m_sampleStep -= fp_sampleStep;
-					if(m_samplePos >= 0)
-						readOffset++;
-					m_samplePos++;
-				}
-			}
-			m_remainingBufferData -= readOffset;
 		}
+	}
 
-		if(outCount >= numSamples)
-			break;
+	// Nothing to read while the decoder thread is refilling the ring after a seek
+	if(!m_flushLock.try_lock())
+		return;
+	if(m_seeking)
+	{
+		m_flushLock.unlock();
+		return;
+	}
 
-		// Read more data
-		if(DecodeData_Internal() <= 0)
-		{
-			// Ended
-			Log("Audio stream ended", Logger::Info);
-			m_ended = true;
-			m_playing = false;
-			break;
-		}
+	// The ring was flushed by a seek, drop what the resampler still holds from before
+	if(m_resamplerGeneration != m_ringGeneration)
+	{
+		m_resamplerGeneration = m_ringGeneration;
+		m_resampler.Reset();
+		m_resamplerFlushed = false;
 	}
 
-	// Store timing info
-	if (m_samplePos > 0)
+	// Building a filter allocates, so that is left to the decoder thread and the previous filter is used until it is done
+	const double ratio = m_sampleRatio * PlaybackSpeed;
+	if(audio->offline)
+		Resampler::PrepareFilter(audio->resampleQuality, ratio);
+	bool filterReady = m_resampler.SetQuality(audio->resampleQuality);
+	filterReady = m_resampler.SetRatio(ratio) && filterReady;
+	if(!filterReady && !m_filterNeeded.exchange(true))
+		m_decoderSignal.notify_all();
+	const int64 startPos = m_samplePos;
+
+	// Silence before the start of the stream, every output frame passes ratio stream frames
+	uint32 outCount = 0;
+	if(m_samplePos < 0)
 	{
-		m_samplePos = GetStreamPosition_Internal() - (int64)m_remainingBufferData;
+		double pos = (double)m_samplePos + m_silenceFraction;
+		outCount = (uint32)Math::Min(ceil(-pos / ratio), (double)numSamples);
+		pos += (double)outCount * ratio;
+		m_samplePos = (int64)floor(pos);
+		m_silenceFraction = pos - floor(pos);
 	}
 
-	if(m_samplePos > 0)
+	uint64 read = m_ringRead.load(std::memory_order_relaxed);
+	if(outCount < numSamples)
 	{
-		if(m_samplePos >= m_samplesTotal)
+		// Move as much from the ring as the resampler needs, in two parts when it wraps around
+		uint64 available = m_ringWrite.load(std::memory_order_acquire) - read;
+		uint32 count = (uint32)Math::Min<uint64>(m_resampler.GetInputNeeded(numSamples - outCount), available);
+		while(count > 0)
+		{
+			uint32 idx = (uint32)read & m_ringMask;
+			uint32 part = Math::Min(count, m_ringMask + 1 - idx);
+			m_resampler.Write(m_ring + idx * 2, part);
+			read += part;
+			count -= part;
+		}
+
+		// Check the write position again after the end flag, the decoder might have written more before setting it
+		if(!m_resamplerFlushed && m_decodeEnded.load(std::memory_order_acquire) && m_ringWrite.load(std::memory_order_acquire) == read)
 		{
-			if(!m_ended)
-			{
-				// Ended
-				Log("Audio stream ended", Logger::Info);
-				m_ended = true;
-			}
+			m_resampler.Flush();
+			m_resamplerFlushed = true;
 		}
 
-		double timingDelta = m_getPositionSeconds(false) - SamplesToSeconds(m_samplePos);
-		m_deltaSum += timingDelta;
-		m_deltaSamples += 1;
+		uint32 consumed;
+		outCount += m_resampler.Render(out + outCount * 2, numSamples - outCount, consumed);
+		m_samplePos = m_ringStartPos + (int64)read - m_resampler.GetPendingFrames();
+	}
+	m_ringRead.store(read, std::memory_order_release);
 
-		double avgDelta = m_deltaSum / (double)m_deltaSamples;
-		if(abs(timingDelta - avgDelta) > 0.2)
+	if(outCount < numSamples)
+	{
+		if(m_resamplerFlushed)
 		{
-			Logf("Timing restart, delta = %f", Logger::Info, avgDelta);
-			m_restartTiming();
+			Log("Audio stream ended", Logger::Info);
+			m_ended = true;
+			m_playing = false;
 		}
 		else
 		{
-			if(fabs(avgDelta) > 0.001f)
-			{
-				// Fine tune timing
-				double step = abs(avgDelta) * 0.1f;
-				step = Math::Min(step, fabs(timingDelta)) * Math::Sign(timingDelta);
-				m_offsetCorrection += step;
-			}
+			m_numUnderruns++;
+			m_underrunFrames += numSamples - outCount;
 		}
 	}
 
-	m_lock.unlock();
+	if(m_samplePos > 0 && m_samplePos >= m_samplesTotal)
+	{
+		if(!m_ended)
+		{
+			// Ended
+			Log("Audio stream ended", Logger::Info);
+			m_ended = true;
+		}
+	}
+
+	// Store timing info, the next buffer starts at the current position
+	if(!m_clockValid.load(std::memory_order_relaxed))
+		m_clockStart.store(SamplesToSeconds(startPos), std::memory_order_relaxed);
+	double blockEnd = (double)(audio->GetRenderedFrames() + numSamples) * audio->GetSecondsPerSample();
+	m_clockBase.store(SamplesToSeconds(m_samplePos) - blockEnd * PlaybackSpeed, std::memory_order_relaxed);
+	m_clockValid.store(true, std::memory_order_release);
+
+	m_flushLock.unlock();
+}
+uint32 AudioStreamBase::GetNumUnderruns() const
+{
+	return m_numUnderruns;
+}
+uint64 AudioStreamBase::GetUnderrunFrames() const
+{
+	return m_underrunFrames;
 }
@@ -2,21 +2,22 @@
 #include "Audio.hpp"
 #include "AudioStream.hpp"
 #include "Audio_Impl.hpp"
+#include "Resampler.hpp"
+#include <condition_variable>
 
 class AudioStreamBase : public AudioStream
 {
 protected:
-	// Fixed point format for sample positions (used in resampling)
-	static const uint64 fp_sampleStep;
-
 	Audio* m_audio;
 	File m_file;
-	Buffer m_data;
-	MemoryReader m_memoryReader;
+	// Preloaded files are mapped into memory instead of being read
+	MappedFile m_mappedFile;
+	MappedFileReader m_mappedReader;
 	FileReader m_fileReader;
 	bool m_preloaded = false;
 	BinaryStream& m_reader();
 
+	// Held by the decoder thread while it waits for work
 	mutex m_lock;
 
 	float** m_readBuffer = nullptr;
@@ -28,27 +29,68 @@ protected:
 	int64 m_samplePos = 0;
 	uint64 m_samplesTotal = 0; // Total pcm length of audio stream
 
-	// Resampling values
-	uint64 m_sampleStep = 0;
-	uint64 m_sampleStepIncrement = 0;
-
-	Timer m_deltaTimer;
-	Timer m_streamTimer;
-	double m_streamTimeOffset = 0.0f;
-	double m_offsetCorrection = 0.0f;
+	// Stream rate divided by the output rate
+	double m_sampleRatio = 1.0;
+	// Part of a stream frame passed while outputting silence before the start of the stream
+	double m_silenceFraction = 0.0;
+	// Only used by the mixer
+	Resampler m_resampler;
+	// Set by the mixer when the resampler needs a filter that is not built yet, the decoder thread builds it
+	std::atomic<bool> m_filterNeeded;
+	// Set once the end of the stream has been written to the resampler
+	bool m_resamplerFlushed = false;
+	uint32 m_resamplerGeneration = 0;
 
-	double m_deltaSum = 0.0f;
-	int32 m_deltaSamples = 0;
+	// Stream position in seconds at output frame 0, stored by the mixer after every buffer
+	//	the position is extrapolated from the output frame the device is playing
+	std::atomic<double> m_clockBase;
+	// Position the mixer continued from after the last seek or pause, the buffers before it are not part of the stream
+	std::atomic<double> m_clockStart;
+	// Cleared until the mixer has rendered from the current position
+	std::atomic<bool> m_clockValid;
 
 	bool m_paused = false;
 	bool m_playing = false;
 	bool m_ended = false;
 
 	float m_volume = 0.8f;
+
+	// Decoded stereo frames, filled ahead of playback by the decoder thread and read by the mixer without locking
+	float* m_ring = nullptr;
+	uint32 m_ringMask = 0;
+	// Number of frames the decoder thread keeps in the ring
+	uint32 m_ringAhead = 0;
+	std::atomic<uint64> m_ringRead;
+	std::atomic<uint64> m_ringWrite;
+	// Stream position of the first frame written to the ring after the last seek
+	int64 m_ringStartPos = 0;
+	// Increased every time the ring is flushed
+	uint32 m_ringGeneration = 0;
+	// Set by the decoder thread when the decoder has no more data
+	std::atomic<bool> m_decodeEnded;
+
+	// Taken by the mixer while it reads from the ring, the decoder thread only takes it to flush the ring after a seek
+	//	the mixer only tries to take it and outputs silence if it can't
+	mutex m_flushLock;
+	// Set until the decoder thread has refilled the ring after a seek
+	bool m_seeking = true;
+	// Last seek handled by the decoder
+	uint32 m_decodedSeekGeneration = 0;
+	// Seek requested by SetPosition, handled by the decoder thread
+	std::atomic<int64> m_seekTarget;
+	std::atomic<uint32> m_seekGeneration;
+
+	thread m_decoderThread;
+	std::atomic<bool> m_decoderRunning;
+	std::condition_variable_any m_decoderSignal;
+
+	std::atomic<uint32> m_numUnderruns;
+	std::atomic<uint64> m_underrunFrames;
+
 	void m_initSampling(uint32 sampleRate);
 	uint64 m_secondsToSamples(double s) const;
 	void m_restartTiming();
-	double m_getPositionSeconds(bool allowFreezeSkip = true) const;
+	double m_getPositionSeconds() const;
 
 	// Implementation specific set position
 	virtual void SetPosition_Internal(int32 pos) = 0;
@@ -61,7 +103,22 @@ protected:
 	// return negative for end of stream or failure
 	virtual int32 DecodeData_Internal() = 0;
 	virtual bool Init(Audio* audio, const String& path, bool preload);
+
+	// Starts the decoder thread, called when the stream is first played
+	void m_StartDecoder();
+	// Stops the decoder thread, has to be called by implementations before they free their decoder
+	void m_StopDecoder();
+	void m_DecoderThread();
+	// Handles a pending seek or decodes the next block into the ring, returns false if there was nothing to do
+	bool m_Decode();
+	// Moves decoded data from the read buffer into the ring, returns false if there is nothing to move
+	bool m_FillRing();
+	// Decodes the next block into the read buffer if it is empty, returns false at the end of the stream
+	bool m_ReadBlock();
 public:
+	AudioStreamBase();
+	~AudioStreamBase();
+
 	virtual void Play() override;
 	virtual void Pause() override;
 	virtual bool HasEnded() const override;
@@ -71,5 +128,11 @@ public:
 	virtual float* GetPCM() override;
 	virtual uint32 GetSampleRate() const override;
 	virtual void Process(float* out, uint32 numSamples) override;
+	virtual uint32 GetNumUnderruns() const override;
+	virtual uint64 GetUnderrunFrames() const override;
+
+	// Decodes interleaved stereo frames starting at a position in the stream, for streams that are not played
+	//	returns the number of frames decoded, which is less than numFrames at the end of the stream
+	uint32 DecodeFrames(int64 startFrame, uint32 numFrames, float* out);
 
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "stdafx.h"
+#include "AudioStreamClip.hpp"
+
+AudioStreamClip::~AudioStreamClip()
+{
+	Deregister();
+	m_StopDecoder();
+
+	for(size_t i = 0; i < m_numChannels; i++)
+	{
+		delete[] m_readBuffer[i];
+	}
+	delete[] m_readBuffer;
+}
+bool AudioStreamClip::Init(Audio* audio, Ref<AudioClip> clip)
+{
+	if(!clip || clip->sampleRate == 0)
+		return false;
+
+	// Nothing to open, the clip is already in memory
+	m_audio = audio;
+	m_clip = clip;
+	m_samplesTotal = clip->GetNumFrames();
+	m_initSampling(clip->sampleRate);
+	return true;
+}
+int32 AudioStreamClip::GetStreamPosition_Internal()
+{
+	return (int32)m_playPos;
+}
+int32 AudioStreamClip::GetStreamRate_Internal()
+{
+	return (int32)m_clip->sampleRate;
+}
+void AudioStreamClip::SetPosition_Internal(int32 pos)
+{
+	m_playPos = (uint32)Math::Clamp<int32>(pos, 0, (int32)m_clip->GetNumFrames());
+}
+int32 AudioStreamClip::DecodeData_Internal()
+{
+	uint32 count = Math::Min(m_bufferSize, m_clip->GetNumFrames() - m_playPos);
+	const float* src = m_clip->pcm.data() + (size_t)m_playPos * 2;
+	for(uint32 i = 0; i < count; i++)
+	{
+		m_readBuffer[0][i] = src[i * 2];
+		m_readBuffer[1][i] = src[i * 2 + 1];
+	}
+	m_playPos += count;
+	m_currentBufferSize = count;
+	m_remainingBufferData = count;
+	return (int32)count;
+}
+float* AudioStreamClip::GetPCM_Internal()
+{
+	return m_clip->pcm.data();
+}
+uint32 AudioStreamClip::GetSampleRate_Internal() const
+{
+	return m_clip->sampleRate;
+}
+
+Ref<AudioStream> AudioStreamClip::Create(class Audio* audio, Ref<AudioClip> clip)
+{
+	AudioStreamClip* impl = new AudioStreamClip();
+	if(!impl->Init(audio, clip))
+	{
+		delete impl;
+		return Ref<AudioStream>();
+	}
+	return Ref<AudioStream>(impl);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "stdafx.h"
+#include "AudioStreamBase.hpp"
+
+/*
+	Stream that plays a clip that was already decoded into memory
+*/
+class AudioStreamClip : public AudioStreamBase
+{
+private:
+	Ref<AudioClip> m_clip;
+	uint32 m_playPos = 0;
+protected:
+	AudioStreamClip() = default;
+	~AudioStreamClip();
+	bool Init(Audio* audio, Ref<AudioClip> clip);
+	int32 GetStreamPosition_Internal() override;
+	int32 GetStreamRate_Internal() override;
+	void SetPosition_Internal(int32 pos) override;
+	int32 DecodeData_Internal() override;
+	float* GetPCM_Internal() override;
+	uint32 GetSampleRate_Internal() const override;
+public:
+	static Ref<AudioStream> Create(class Audio* audio, Ref<AudioClip> clip);
+};
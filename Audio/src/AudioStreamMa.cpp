@@ -14,6 +14,7 @@
 AudioStreamMa::~AudioStreamMa()
 {
 	Deregister();
+	m_StopDecoder();
 	if (m_preloaded)
 	{
 		if (m_pcm)
@@ -44,7 +45,8 @@ bool AudioStreamMa::Init(Audio* audio, const String& path, bool preload)
 
 	if (m_preloaded)
 	{
-		result = ma_decode_memory((void*)m_data.data(), m_file.GetSize(), &config, &m_samplesTotal, (void**)&m_pcm);
+		result = ma_decode_memory((void*)m_mappedFile.GetData(), m_mappedFile.GetSize(), &config, &m_samplesTotal, (void**)&m_pcm);
+		m_mappedFile.Close();
 	}
 	else
 	{			
@@ -26,6 +26,7 @@ int AudioStreamMp3::m_toLittleEndian(int num)
 AudioStreamMp3::~AudioStreamMp3()
 {
 	Deregister();
+	m_StopDecoder();
 	mp3_done(m_decoder);
 
 	for (size_t i = 0; i < m_numChannels; i++)
@@ -43,7 +44,7 @@ bool AudioStreamMp3::Init(Audio* audio, const String& path, bool preload)
 
 	// Always use preloaded data
 	m_mp3dataLength = m_reader().GetSize();
-	m_dataSource = m_data.data();
+	m_dataSource = m_mappedFile.GetData();
 	int32 tagSize = 0;
 
 	String tag = "tag";
@@ -147,7 +148,7 @@ bool AudioStreamMp3::Init(Audio* audio, const String& path, bool preload)
 			totalSamples += r;
 			r = DecodeData_Internal();
 		}
-		m_data.clear();
+		m_mappedFile.Close();
 		m_dataSource = nullptr;
 		m_samplesTotal = totalSamples;
 	}
@@ -222,7 +223,6 @@ int32 AudioStreamMp3::DecodeData_Internal()
 			{
 				m_currentBufferSize = samplesPerRead;
 				m_remainingBufferData = samplesPerRead;
-				m_playing = false;
 				return i;
 			}
 			m_readBuffer[0][i] = m_pcm[m_playPos * 2];
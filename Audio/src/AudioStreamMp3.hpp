@@ -12,7 +12,7 @@ class AudioStreamMp3 : public AudioStreamBase
 	size_t m_mp3dataLength = 0;
 	int32 m_mp3samplePosition = 0;
 	int32 m_samplingRate = 0;
-	uint8* m_dataSource = 0;
+	const uint8* m_dataSource = 0;
 
 	Map<int32, size_t> m_frameIndices;
 	uint32 m_largetsFrameIndex;
@@ -6,6 +6,7 @@
 AudioStreamOgg::~AudioStreamOgg()
 {
 	Deregister();
+	m_StopDecoder();
 
 	for (size_t i = 0; i < m_numChannels; i++)
 	{
@@ -78,6 +79,8 @@ bool AudioStreamOgg::Init(Audio* audio, const String& path, bool preload)
 		}
 		m_samplesTotal = totalRead;
 		ov_clear(&m_ovf);
+		// Everything is decoded, the file is no longer needed
+		m_mappedFile.Close();
 		m_playPos = 0;
 	}
 	m_initSampling(m_info.rate);
@@ -189,13 +192,11 @@ int32 AudioStreamOgg::DecodeData_Internal()
 	else if(r == 0)
 	{
 		// EOF
-		m_playing = false;
 		return -1;
 	}
 	else
 	{
 		// Error
-		m_playing = false;
 		Logf("Ogg Stream error %d", Logger::Warning, r);
 		return -1;
 	}
@@ -78,6 +78,7 @@ uint32 AudioStreamWav::m_decode_ms_adpcm(const Buffer& encoded, Buffer* decoded,
 AudioStreamWav::~AudioStreamWav()
 {
 	Deregister();
+	m_StopDecoder();
 
 	for (size_t i = 0; i < m_numChannels; i++)
 	{
@@ -94,22 +95,22 @@ bool AudioStreamWav::Init(Audio* audio, const String& path, bool preload)
 	if (preload)
 	{
 		WavHeader riff;
-		m_memoryReader << riff;
+		m_mappedReader << riff;
 		if (riff != "RIFF")
 			return false;
 
 		char riffType[4];
-		m_memoryReader.SerializeObject(riffType);
+		m_mappedReader.SerializeObject(riffType);
 		if (strncmp(riffType, "WAVE", 4) != 0)
 			return false;
 
-		while (m_memoryReader.Tell() < m_memoryReader.GetSize())
+		while (m_mappedReader.Tell() < m_mappedReader.GetSize())
 		{
 			WavHeader chunkHdr;
-			m_memoryReader << chunkHdr;
+			m_mappedReader << chunkHdr;
 			if (chunkHdr == "fmt ")
 			{
-				m_memoryReader << m_format;
+				m_mappedReader << m_format;
 				String format = "Unknown";
 				if (m_format.nFormat == 1)
 					format = "PCM";
@@ -123,14 +124,14 @@ bool AudioStreamWav::Init(Audio* audio, const String& path, bool preload)
 				if (m_format.nFormat == 2)
 				{
 					uint16 cbSize;
-					m_memoryReader << cbSize;
-					m_memoryReader.Skip(cbSize);
+					m_mappedReader << cbSize;
+					m_mappedReader.Skip(cbSize);
 				}
 			}
 			else if (chunkHdr == "fact")
 			{
 				uint32 fh;
-				m_memoryReader << fh;
+				m_mappedReader << fh;
 				m_samplesTotal = fh;
 			}
 			else if (chunkHdr == "data") // data Chunk
@@ -148,13 +149,13 @@ bool AudioStreamWav::Init(Audio* audio, const String& path, bool preload)
 				{
 					m_samplesTotal = (chunkHdr.nLength / sizeof(short)) / m_format.nChannels;
 					m_Internaldata.resize(chunkHdr.nLength);
-					m_memoryReader.Serialize(m_Internaldata.data(), chunkHdr.nLength);
+					m_mappedReader.Serialize(m_Internaldata.data(), chunkHdr.nLength);
 				}
 				else if (m_format.nFormat == 2)
 				{
 					m_samplesTotal = chunkHdr.nLength;
 					m_Internaldata.resize(m_samplesTotal);
-					m_memoryReader.Serialize(m_Internaldata.data(), chunkHdr.nLength);
+					m_mappedReader.Serialize(m_Internaldata.data(), chunkHdr.nLength);
 				}
 
 
@@ -207,10 +208,12 @@ bool AudioStreamWav::Init(Audio* audio, const String& path, bool preload)
 			}
 			else
 			{
-				m_memoryReader.Skip(chunkHdr.nLength);
+				m_mappedReader.Skip(chunkHdr.nLength);
 			}
 		}
 		m_Internaldata.clear();
+		// Everything is decoded, the file is no longer needed
+		m_mappedFile.Close();
 	}
 	else
 	{
@@ -376,7 +379,6 @@ int32 AudioStreamWav::DecodeData_Internal()
 			int amountRead = m_fileReader.Serialize(readData.data(), m_format.nBlockAlign);
 			if (amountRead < m_format.nBlockAlign)
 			{
-				m_playing = false;
 				return 0;
 			}
 			uint32 decodedCount = m_decode_ms_adpcm(readData, &decoded, 0);
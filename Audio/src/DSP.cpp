@@ -4,44 +4,36 @@
 #include "Audio_Impl.hpp"
 #include <Shared/Interpolation.hpp>
 
+// Number of frames at the start of a buffer that are before the effect starts
+static uint32 GetStartFrame(int32 currentSample, int32 startSample, uint32 numSamples)
+{
+	return (uint32)Math::Clamp<int64>((int64)startSample - currentSample, 0, numSamples);
+}
+
 void PanDSP::Process(float* out, uint32 numSamples)
 {
-	for(uint32 i = 0; i < numSamples; i++)
-	{
-		if(panning > 0)
-			out[i * 2 + 0] = (out[i * 2 + 0] * (1.0f - panning)) * mix + out[i * 2 + 0] * (1 - mix);
-		if(panning < 0)
-			out[i * 2 + 1] = (out[i * 2 + 1] * (1.0f + panning)) * mix + out[i * 2 + 1] * (1 - mix);
-	}
+	float left = 1.0f;
+	float right = 1.0f;
+	if(panning > 0)
+		left = (1.0f - panning) * mix + (1 - mix);
+	if(panning < 0)
+		right = (1.0f + panning) * mix + (1 - mix);
+	if(left != 1.0f || right != 1.0f)
+		DSPKernels::ScaleStereo(out, numSamples, left, right);
 }
 
 void BQFDSP::Process(float* out, uint32 numSamples)
 {
-	for(uint32 c = 0; c < 2; c++)
-	{
-		for(uint32 i = 0; i < numSamples; i++)
-		{
-			float& sample = out[i * 2 + c];
-			float src = sample;
-
-			float filtered = 
-				(b0 / a0) * src + 
-				(b1 / a0) * zb[c][0] + 
-				(b2 / a0) * zb[c][1] - 
-				(a1 / a0) * za[c][0] - 
-				(a2 / a0) * za[c][1];
-
-			// Shift delay buffers
-			zb[c][1] = zb[c][0];
-			zb[c][0] = src;
-
-			// Feedback the calculated value into the IIR delay buffers
-			za[c][1] = za[c][0];
-			za[c][0] = filtered;
-
-			sample = filtered;
-		}
-	}
+	DSPKernels::Biquad(out, numSamples, coefficients, m_state);
+}
+void BQFDSP::m_SetCoefficients(float b0, float b1, float b2, float a0, float a1, float a2)
+{
+	// Normalized once here instead of for every sample
+	coefficients.b0 = b0 / a0;
+	coefficients.b1 = b1 / a0;
+	coefficients.b2 = b2 / a0;
+	coefficients.a1 = a1 / a0;
+	coefficients.a2 = a2 / a0;
 }
 void BQFDSP::SetLowPass(float q, float freq, float sampleRate)
 {
@@ -53,12 +45,8 @@ void BQFDSP::SetLowPass(float q, float freq, float sampleRate)
 	double cw0 = cos(w0);
 	float alpha = (float)(sin(w0) / (2 * q));
 
-	b0 = (float)((1 - cw0) / 2);
-	b1 = (float)(1 - cw0);
-	b2 = (float)((1 - cw0) / 2);
-	a0 = 1 + alpha;
-	a1 = (float)(-2 * cw0);
-	a2 = 1 - alpha;
+	m_SetCoefficients((float)((1 - cw0) / 2), (float)(1 - cw0), (float)((1 - cw0) / 2),
+		1 + alpha, (float)(-2 * cw0), 1 - alpha);
 }
 void BQFDSP::SetLowPass(float q, float freq)
 {
@@ -74,12 +62,8 @@ void BQFDSP::SetHighPass(float q, float freq, float sampleRate)
 	double cw0 = cos(w0);
 	float alpha = (float)(sin(w0) / (2 * q));
 
-	b0 = (float)((1 + cw0) / 2);
-	b1 = (float)-(1 + cw0);
-	b2 = float((1 + cw0) / 2);
-	a0 = 1 + alpha;
-	a1 = (float)(-2 * cw0);
-	a2 = 1 - alpha;
+	m_SetCoefficients((float)((1 + cw0) / 2), (float)-(1 + cw0), (float)((1 + cw0) / 2),
+		1 + alpha, (float)(-2 * cw0), 1 - alpha);
 }
 void BQFDSP::SetHighPass(float q, float freq)
 {
@@ -95,12 +79,8 @@ void BQFDSP::SetPeaking(float q, float freq, float gain, float sampleRate)
 	float alpha = (float)(sin(w0) / (2 * q));
 	double A = pow(10, (gain / 40));
 
-	b0 = 1 + (float)(alpha * A);
-	b1 = -2 * (float)cw0;
-	b2 = 1 - (float)(alpha*A);
-	a0 = 1 + (float)(alpha / A);
-	a1 = -2 * (float)cw0;
-	a2 = 1 - (float)(alpha / A);
+	m_SetCoefficients(1 + (float)(alpha * A), -2 * (float)cw0, 1 - (float)(alpha * A),
+		1 + (float)(alpha / A), -2 * (float)cw0, 1 - (float)(alpha / A));
 }
 void BQFDSP::SetPeaking(float q, float freq, float gain)
 {
@@ -186,37 +166,56 @@ void GateDSP::Process(float* out, uint32 numSamples)
 	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
 	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
 
-	for(uint32 i = 0; i < numSamples; i++)
+	// The volume is c * scale + offset, c is 1 while open and 0 while closed, with linear fades in between
+	const float scale = (1 - low) * mix;
+	const float offset = low * mix + (1.0f - mix);
+	const float fadeStep = m_fadeIn > 0 ? 1.0f / (float)m_fadeIn : 0.0f;
+	m_currentSample %= m_length;
+
+	// Process runs of samples with a constant or linear volume
+	uint32 i = GetStartFrame(currentSample, startSample, numSamples);
+	while(i < numSamples)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
-		float c = 1.0f;
+		uint32 end;
+		float c, step;
 		if(m_currentSample < m_halfway)
 		{
-			// Fade out before silence
-			if(m_currentSample > m_fadeOut)
-				c = 1-(float)(m_currentSample - m_fadeOut) / (float)m_fadeIn;
+			if(m_currentSample <= m_fadeOut)
+			{
+				end = Math::Min(m_fadeOut + 1, m_halfway);
+				c = 1.0f;
+				step = 0.0f;
+			}
+			else
+			{
+				// Fade out before silence
+				end = m_halfway;
+				c = 1.0f - (float)(m_currentSample - m_fadeOut) * fadeStep;
+				step = -fadeStep;
+			}
 		}
 		else
 		{
 			uint32 t = m_currentSample - m_halfway;
-			// Fade in again
-			if(t > m_fadeOut)
-				c = (float)(t - m_fadeOut) / (float)m_fadeIn;
-			else
+			if(t <= m_fadeOut)
+			{
+				end = m_halfway + m_fadeOut + 1;
 				c = 0.0f;
+				step = 0.0f;
+			}
+			else
+			{
+				// Fade in again
+				end = m_length;
+				c = (float)(t - m_fadeOut) * fadeStep;
+				step = fadeStep;
+			}
 		}
 
-		// Multiply volume
-		c = (c * (1 - low) + low); // Range [low, 1]
-		c = c * mix + (1.0f-mix);
-		out[i * 2] *= c;
-		out[i * 2 + 1] *= c;
-
-		m_currentSample++;
-		m_currentSample %= m_length;
+		uint32 n = Math::Min(Math::Min(end, m_length) - m_currentSample, numSamples - i);
+		DSPKernels::ScaleRamp(out + i * 2, n, c * scale + offset, step * scale);
+		i += n;
+		m_currentSample = (m_currentSample + n) % m_length;
 	}
 }
 
@@ -305,17 +304,14 @@ void RetriggerDSP::Process(float* out, uint32 numSamples)
 	int32 pcmStartSample = (double)lastTimingPoint * ((double)audioBase->GetSampleRate() / 1000.0);
 	int32 baseStartRepeat = (double)lastTimingPoint * ((double)audio->GetSampleRate() / 1000.0);
 
-	for(uint32 i = 0; i < numSamples; i++)
+	uint32 i = GetStartFrame(nowSample, startSample, numSamples);
+	while(i < numSamples)
 	{
-		if(nowSample + i < startSample)
-		{
-			continue;
-		}
-
+		int32 repeatPos = nowSample + (int32)i - baseStartRepeat;
 		int startOffset = 0;
 		if (m_resetDuration > 0)
 		{
-			startOffset = (nowSample + i - baseStartRepeat) / (int)m_resetDuration;
+			startOffset = repeatPos / (int)m_resetDuration;
 			startOffset = startOffset * m_resetDuration * rateMult;
 		}
 		else
@@ -327,13 +323,24 @@ void RetriggerDSP::Process(float* out, uint32 numSamples)
 		float gating = 1.0f;
 		if (m_currentSample > m_gateLength)
 			gating = 0;
+
+		// At the original rate the source is read in order until the loop restarts, the gate closes or the offset resets
+		uint32 n = 1;
+		if(rateMult == 1.0)
+		{
+			n = Math::Min(numSamples - i, m_length - m_currentSample);
+			if(m_currentSample <= m_gateLength)
+				n = Math::Min(n, m_gateLength + 1 - m_currentSample);
+			if(m_resetDuration > 0)
+				n = repeatPos < 0 ? 1 : Math::Min(n, m_resetDuration - (uint32)repeatPos % m_resetDuration);
+		}
+
 		// Sample from buffer
-		out[i * 2] = gating * pcmSource[pcmSample * 2] * mix + out[i * 2] * (1 - mix);
-		out[i * 2 + 1] = gating * pcmSource[pcmSample * 2 + 1] * mix + out[i * 2 + 1] * (1 - mix);
-		
-		// Increase index
-		m_currentSample = (m_currentSample + 1) % m_length;
+		DSPKernels::Blend(out + i * 2, pcmSource + pcmSample * 2, n, gating * mix, 1 - mix);
 
+		// Increase index
+		i += n;
+		m_currentSample = (m_currentSample + n) % m_length;
 	}
 }
 
@@ -351,28 +358,23 @@ void WobbleDSP::Process(float* out, uint32 numSamples)
 	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
 	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
 
-	for(uint32 i = 0; i < numSamples; i++)
+	// The filter frequency is updated for every block of this many samples
+	const uint32 updateInterval = 32;
+
+	uint32 i = GetStartFrame(currentSample, startSample, numSamples);
+	while(i < numSamples)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
 		float f = abs(2.0f * ((float)m_currentSample / (float)m_length) - 1.0f);
 		f = easing.Sample(f);
 		float freq = fmin + (fmax - fmin) * f;
 		SetLowPass(q, freq);
 
-		float s[2] = { out[i * 2], out[i * 2 + 1] };
-
-		BQFDSP::Process(&out[i * 2], 1);
-
 		// Apply slight mixing
-		float mix = 0.5f;
-		out[i * 2 + 0] = out[i * 2 + 0] * mix + s[0] * (1.0f - mix);
-		out[i * 2 + 1] = out[i * 2 + 1] * mix + s[1] * (1.0f - mix);
+		uint32 n = Math::Min(numSamples - i, updateInterval);
+		DSPKernels::Biquad(out + i * 2, n, coefficients, m_state, 0.5f, 0.5f);
 
-		m_currentSample++;
-		m_currentSample %= m_length;
+		i += n;
+		m_currentSample = (m_currentSample + n) % m_length;
 	}
 }
 
@@ -499,7 +501,7 @@ void EchoDSP::SetLength(double length)
 {
 	double flength = length / 1000.0 * audio->GetSampleRate();
 	m_sampleBuffer.clear();
-	m_bufferLength = (uint32)(flength * 2);
+	m_bufferLength = (uint32)flength * 2;
 	m_sampleBuffer.resize(m_bufferLength);
 	memset(m_sampleBuffer.data(), 0, sizeof(float) * m_bufferLength);
 	m_numLoops = 0;
@@ -512,28 +514,21 @@ void EchoDSP::Process(float* out, uint32 numSamples)
 	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
 	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
 
-	for(uint32 i = 0; i < numSamples; i++)
+	// Process runs of samples up to the end of the delay buffer
+	uint32 i = GetStartFrame(currentSample, startSample, numSamples);
+	while(i < numSamples)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
-
-		float l0 = data[m_bufferOffset + 0];
-		float l1 = data[m_bufferOffset + 1];
+		uint32 n = Math::Min(numSamples - i, (uint32)(m_bufferLength - m_bufferOffset) / 2);
 
+		// Send echo to output
 		if(m_numLoops > 0)
-		{
-			// Send echo to output
-			out[i * 2] = l0 * mix;
-			out[i * 2 + 1] = l1 * mix;
-		}
+			DSPKernels::ScaleCopy(out + i * 2, data + m_bufferOffset, n * 2, mix);
 
-		// Inject new sample
-		data[m_bufferOffset + 0] = out[i * 2] * feedback;
-		data[m_bufferOffset + 1] = out[i * 2 + 1] * feedback;
+		// Inject new samples
+		DSPKernels::ScaleCopy(data + m_bufferOffset, out + i * 2, n * 2, feedback);
 
-		m_bufferOffset += 2;
+		i += n;
+		m_bufferOffset += n * 2;
 		if(m_bufferOffset >= m_bufferLength)
 		{
 			m_bufferOffset = 0;
@@ -556,26 +551,31 @@ void SidechainDSP::Process(float* out, uint32 numSamples)
 	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
 	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
 
-	for(uint32 i = 0; i < numSamples; i++)
+	// Gains are calculated for a block of samples, then applied at once
+	const uint32 blockSize = 64;
+	float gains[blockSize];
+
+	uint32 i = GetStartFrame(currentSample, startSample, numSamples);
+	while(i < numSamples)
 	{
-		if(currentSample + i < startSample)
-		{
-			continue;
-		}
-		float r = (float)m_time / (float)m_length;
-		// FadeIn
-		const float fadeIn = 0.08f;
-		if(r < fadeIn)
-			r = 1.0f - r / fadeIn;
-		else
-			r = curve((r- fadeIn) / (1.0f- fadeIn));
-		float sampleGain = 1.0f - amount * (1.0f- r);
-		out[i * 2 + 0] *= sampleGain;
-		out[i * 2 + 1] *= sampleGain;
-		if(++m_time > m_length)
+		uint32 n = Math::Min(numSamples - i, blockSize);
+		for(uint32 j = 0; j < n; j++)
 		{
-			m_time = 0;
+			float r = (float)m_time / (float)m_length;
+			// FadeIn
+			const float fadeIn = 0.08f;
+			if(r < fadeIn)
+				r = 1.0f - r / fadeIn;
+			else
+				r = curve((r- fadeIn) / (1.0f- fadeIn));
+			gains[j] = 1.0f - amount * (1.0f- r);
+			if(++m_time > m_length)
+			{
+				m_time = 0;
+			}
 		}
+		DSPKernels::ScaleFrames(out + i * 2, gains, n);
+		i += n;
 	}
 }
 
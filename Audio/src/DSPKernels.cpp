@@ -0,0 +1,490 @@
+#include "stdafx.h"
+#include "DSPKernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DSP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define DSP_TARGET_SSE2
+#define DSP_TARGET_AVX
+#else
+#include <cpuid.h>
+// Compiled for these instruction sets regardless of the compiler flags, only called when the cpu supports them
+#define DSP_TARGET_SSE2 __attribute__((target("sse2")))
+#define DSP_TARGET_AVX __attribute__((target("avx")))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DSP_NEON
+#include <arm_neon.h>
+#endif
+
+namespace DSPKernels
+{
+	struct KernelTable
+	{
+		void(*biquad)(float*, uint32, const BiquadCoefficients&, BiquadState&, float, float);
+		void(*scaleStereo)(float*, uint32, float, float);
+		void(*scaleRamp)(float*, uint32, float, float);
+		void(*scaleFrames)(float*, const float*, uint32);
+		void(*blend)(float*, const float*, uint32, float, float);
+		void(*scaleCopy)(float*, const float*, uint32, float);
+	};
+
+	/* Scalar reference */
+
+	static void BiquadScalar(float* buffer, uint32 numFrames, const BiquadCoefficients& c, BiquadState& s, float wet, float dry)
+	{
+		for(uint32 ch = 0; ch < 2; ch++)
+		{
+			float x1 = s.x1[ch], x2 = s.x2[ch];
+			float y1 = s.y1[ch], y2 = s.y2[ch];
+			for(uint32 i = 0; i < numFrames; i++)
+			{
+				float& sample = buffer[i * 2 + ch];
+				float x = sample;
+				// The last term depends on the previous output, keep it last to shorten the dependency chain
+				float y = c.b0 * x + c.b1 * x1 + c.b2 * x2 - c.a2 * y2 - c.a1 * y1;
+				x2 = x1;
+				x1 = x;
+				y2 = y1;
+				y1 = y;
+				sample = y * wet + x * dry;
+			}
+			s.x1[ch] = x1;
+			s.x2[ch] = x2;
+			s.y1[ch] = y1;
+			s.y2[ch] = y2;
+		}
+	}
+	static void ScaleStereoScalar(float* buffer, uint32 numFrames, float left, float right)
+	{
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			buffer[i * 2] *= left;
+			buffer[i * 2 + 1] *= right;
+		}
+	}
+	static void ScaleRampScalar(float* buffer, uint32 numFrames, float gain, float step)
+	{
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			float g = gain + step * (float)i;
+			buffer[i * 2] *= g;
+			buffer[i * 2 + 1] *= g;
+		}
+	}
+	static void ScaleFramesScalar(float* buffer, const float* gains, uint32 numFrames)
+	{
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			buffer[i * 2] *= gains[i];
+			buffer[i * 2 + 1] *= gains[i];
+		}
+	}
+	static void BlendScalar(float* buffer, const float* src, uint32 numFrames, float srcGain, float bufferGain)
+	{
+		for(uint32 i = 0; i < numFrames * 2; i++)
+		{
+			buffer[i] = src[i] * srcGain + buffer[i] * bufferGain;
+		}
+	}
+	static void ScaleCopyScalar(float* dst, const float* src, uint32 count, float gain)
+	{
+		for(uint32 i = 0; i < count; i++)
+		{
+			dst[i] = src[i] * gain;
+		}
+	}
+
+	static const KernelTable scalarKernels = {
+		BiquadScalar, ScaleStereoScalar, ScaleRampScalar, ScaleFramesScalar, BlendScalar, ScaleCopyScalar
+	};
+
+#if defined(DSP_X86)
+	/* SSE2, left and right are processed in the same vector */
+
+	DSP_TARGET_SSE2 static void BiquadSSE2(float* buffer, uint32 numFrames, const BiquadCoefficients& c, BiquadState& s, float wet, float dry)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 b0 = _mm_set1_ps(c.b0), b1 = _mm_set1_ps(c.b1), b2 = _mm_set1_ps(c.b2);
+		const __m128 a1 = _mm_set1_ps(c.a1), a2 = _mm_set1_ps(c.a2);
+		const __m128 vwet = _mm_set1_ps(wet), vdry = _mm_set1_ps(dry);
+		__m128 x1 = _mm_loadl_pi(zero, (const __m64*)s.x1);
+		__m128 x2 = _mm_loadl_pi(zero, (const __m64*)s.x2);
+		__m128 y1 = _mm_loadl_pi(zero, (const __m64*)s.y1);
+		__m128 y2 = _mm_loadl_pi(zero, (const __m64*)s.y2);
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			__m128 x = _mm_loadl_pi(zero, (const __m64*)(buffer + i * 2));
+			__m128 y = _mm_add_ps(_mm_mul_ps(b0, x), _mm_mul_ps(b1, x1));
+			y = _mm_add_ps(y, _mm_mul_ps(b2, x2));
+			y = _mm_sub_ps(y, _mm_mul_ps(a2, y2));
+			y = _mm_sub_ps(y, _mm_mul_ps(a1, y1));
+			x2 = x1;
+			x1 = x;
+			y2 = y1;
+			y1 = y;
+			_mm_storel_pi((__m64*)(buffer + i * 2), _mm_add_ps(_mm_mul_ps(y, vwet), _mm_mul_ps(x, vdry)));
+		}
+		_mm_storel_pi((__m64*)s.x1, x1);
+		_mm_storel_pi((__m64*)s.x2, x2);
+		_mm_storel_pi((__m64*)s.y1, y1);
+		_mm_storel_pi((__m64*)s.y2, y2);
+	}
+	DSP_TARGET_SSE2 static void ScaleStereoSSE2(float* buffer, uint32 numFrames, float left, float right)
+	{
+		uint32 i = 0;
+		const __m128 gain = _mm_setr_ps(left, right, left, right);
+		for(; i + 2 <= numFrames; i += 2)
+		{
+			_mm_storeu_ps(buffer + i * 2, _mm_mul_ps(_mm_loadu_ps(buffer + i * 2), gain));
+		}
+		ScaleStereoScalar(buffer + i * 2, numFrames - i, left, right);
+	}
+	DSP_TARGET_SSE2 static void ScaleRampSSE2(float* buffer, uint32 numFrames, float gain, float step)
+	{
+		uint32 i = 0;
+		const __m128 vgain = _mm_set1_ps(gain);
+		const __m128 vstep = _mm_set1_ps(step);
+		const __m128 two = _mm_set1_ps(2.0f);
+		// Frame indices, exact as long as they fit in the mantissa
+		__m128 index = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+		for(; i + 2 <= numFrames; i += 2)
+		{
+			__m128 g = _mm_add_ps(vgain, _mm_mul_ps(vstep, index));
+			_mm_storeu_ps(buffer + i * 2, _mm_mul_ps(_mm_loadu_ps(buffer + i * 2), g));
+			index = _mm_add_ps(index, two);
+		}
+		for(; i < numFrames; i++)
+		{
+			float g = gain + step * (float)i;
+			buffer[i * 2] *= g;
+			buffer[i * 2 + 1] *= g;
+		}
+	}
+	DSP_TARGET_SSE2 static void ScaleFramesSSE2(float* buffer, const float* gains, uint32 numFrames)
+	{
+		uint32 i = 0;
+		for(; i + 4 <= numFrames; i += 4)
+		{
+			__m128 g = _mm_loadu_ps(gains + i);
+			_mm_storeu_ps(buffer + i * 2, _mm_mul_ps(_mm_loadu_ps(buffer + i * 2), _mm_unpacklo_ps(g, g)));
+			_mm_storeu_ps(buffer + i * 2 + 4, _mm_mul_ps(_mm_loadu_ps(buffer + i * 2 + 4), _mm_unpackhi_ps(g, g)));
+		}
+		ScaleFramesScalar(buffer + i * 2, gains + i, numFrames - i);
+	}
+	DSP_TARGET_SSE2 static void BlendSSE2(float* buffer, const float* src, uint32 numFrames, float srcGain, float bufferGain)
+	{
+		uint32 i = 0;
+		const uint32 count = numFrames * 2;
+		const __m128 sg = _mm_set1_ps(srcGain);
+		const __m128 bg = _mm_set1_ps(bufferGain);
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), sg), _mm_mul_ps(_mm_loadu_ps(buffer + i), bg));
+			_mm_storeu_ps(buffer + i, v);
+		}
+		for(; i < count; i++)
+		{
+			buffer[i] = src[i] * srcGain + buffer[i] * bufferGain;
+		}
+	}
+	DSP_TARGET_SSE2 static void ScaleCopySSE2(float* dst, const float* src, uint32 count, float gain)
+	{
+		uint32 i = 0;
+		const __m128 g = _mm_set1_ps(gain);
+		for(; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+		}
+		ScaleCopyScalar(dst + i, src + i, count - i, gain);
+	}
+
+	static const KernelTable sse2Kernels = {
+		BiquadSSE2, ScaleStereoSSE2, ScaleRampSSE2, ScaleFramesSSE2, BlendSSE2, ScaleCopySSE2
+	};
+
+	/* AVX, four frames per vector. The biquad can't use the wider vectors so it uses the SSE2 version */
+
+	DSP_TARGET_AVX static void ScaleStereoAVX(float* buffer, uint32 numFrames, float left, float right)
+	{
+		uint32 i = 0;
+		const __m256 gain = _mm256_setr_ps(left, right, left, right, left, right, left, right);
+		for(; i + 4 <= numFrames; i += 4)
+		{
+			_mm256_storeu_ps(buffer + i * 2, _mm256_mul_ps(_mm256_loadu_ps(buffer + i * 2), gain));
+		}
+		ScaleStereoScalar(buffer + i * 2, numFrames - i, left, right);
+	}
+	DSP_TARGET_AVX static void ScaleRampAVX(float* buffer, uint32 numFrames, float gain, float step)
+	{
+		uint32 i = 0;
+		const __m256 vgain = _mm256_set1_ps(gain);
+		const __m256 vstep = _mm256_set1_ps(step);
+		const __m256 four = _mm256_set1_ps(4.0f);
+		__m256 index = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+		for(; i + 4 <= numFrames; i += 4)
+		{
+			__m256 g = _mm256_add_ps(vgain, _mm256_mul_ps(vstep, index));
+			_mm256_storeu_ps(buffer + i * 2, _mm256_mul_ps(_mm256_loadu_ps(buffer + i * 2), g));
+			index = _mm256_add_ps(index, four);
+		}
+		for(; i < numFrames; i++)
+		{
+			float g = gain + step * (float)i;
+			buffer[i * 2] *= g;
+			buffer[i * 2 + 1] *= g;
+		}
+	}
+	DSP_TARGET_AVX static void ScaleFramesAVX(float* buffer, const float* gains, uint32 numFrames)
+	{
+		uint32 i = 0;
+		for(; i + 4 <= numFrames; i += 4)
+		{
+			__m128 g = _mm_loadu_ps(gains + i);
+			__m256 g2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(g, g)), _mm_unpackhi_ps(g, g), 1);
+			_mm256_storeu_ps(buffer + i * 2, _mm256_mul_ps(_mm256_loadu_ps(buffer + i * 2), g2));
+		}
+		ScaleFramesScalar(buffer + i * 2, gains + i, numFrames - i);
+	}
+	DSP_TARGET_AVX static void BlendAVX(float* buffer, const float* src, uint32 numFrames, float srcGain, float bufferGain)
+	{
+		uint32 i = 0;
+		const uint32 count = numFrames * 2;
+		const __m256 sg = _mm256_set1_ps(srcGain);
+		const __m256 bg = _mm256_set1_ps(bufferGain);
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), sg), _mm256_mul_ps(_mm256_loadu_ps(buffer + i), bg));
+			_mm256_storeu_ps(buffer + i, v);
+		}
+		for(; i < count; i++)
+		{
+			buffer[i] = src[i] * srcGain + buffer[i] * bufferGain;
+		}
+	}
+	DSP_TARGET_AVX static void ScaleCopyAVX(float* dst, const float* src, uint32 count, float gain)
+	{
+		uint32 i = 0;
+		const __m256 g = _mm256_set1_ps(gain);
+		for(; i + 8 <= count; i += 8)
+		{
+			_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+		}
+		ScaleCopyScalar(dst + i, src + i, count - i, gain);
+	}
+
+	static const KernelTable avxKernels = {
+		BiquadSSE2, ScaleStereoAVX, ScaleRampAVX, ScaleFramesAVX, BlendAVX, ScaleCopyAVX
+	};
+
+	static DSPKernelLevel DetectLevel()
+	{
+		uint32 ecx = 0, edx = 0;
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		ecx = (uint32)info[2];
+		edx = (uint32)info[3];
+#else
+		uint32 eax, ebx;
+		if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+			return DSPKernelLevel::Scalar;
+#endif
+		if(!(edx & (1 << 26)))
+			return DSPKernelLevel::Scalar;
+
+		// AVX also needs the OS to save the upper halves of the registers (OSXSAVE and XCR0)
+		if((ecx & (1 << 27)) && (ecx & (1 << 28)))
+		{
+#ifdef _MSC_VER
+			uint64 xcr0 = _xgetbv(0);
+#else
+			uint32 xcr0Low, xcr0High;
+			__asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+			uint64 xcr0 = ((uint64)xcr0High << 32) | xcr0Low;
+#endif
+			if((xcr0 & 6) == 6)
+				return DSPKernelLevel::AVX;
+		}
+		return DSPKernelLevel::SSE2;
+	}
+
+#elif defined(DSP_NEON)
+	/* NEON, left and right are processed in the same vector */
+
+	static void BiquadNEON(float* buffer, uint32 numFrames, const BiquadCoefficients& c, BiquadState& s, float wet, float dry)
+	{
+		float32x2_t x1 = vld1_f32(s.x1), x2 = vld1_f32(s.x2);
+		float32x2_t y1 = vld1_f32(s.y1), y2 = vld1_f32(s.y2);
+		const float32x2_t vwet = vdup_n_f32(wet), vdry = vdup_n_f32(dry);
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			float32x2_t x = vld1_f32(buffer + i * 2);
+			float32x2_t y = vadd_f32(vmul_n_f32(x, c.b0), vmul_n_f32(x1, c.b1));
+			y = vadd_f32(y, vmul_n_f32(x2, c.b2));
+			y = vsub_f32(y, vmul_n_f32(y2, c.a2));
+			y = vsub_f32(y, vmul_n_f32(y1, c.a1));
+			x2 = x1;
+			x1 = x;
+			y2 = y1;
+			y1 = y;
+			vst1_f32(buffer + i * 2, vadd_f32(vmul_f32(y, vwet), vmul_f32(x, vdry)));
+		}
+		vst1_f32(s.x1, x1);
+		vst1_f32(s.x2, x2);
+		vst1_f32(s.y1, y1);
+		vst1_f32(s.y2, y2);
+	}
+	static void ScaleStereoNEON(float* buffer, uint32 numFrames, float left, float right)
+	{
+		uint32 i = 0;
+		const float gains[4] = { left, right, left, right };
+		const float32x4_t gain = vld1q_f32(gains);
+		for(; i + 2 <= numFrames; i += 2)
+		{
+			vst1q_f32(buffer + i * 2, vmulq_f32(vld1q_f32(buffer + i * 2), gain));
+		}
+		ScaleStereoScalar(buffer + i * 2, numFrames - i, left, right);
+	}
+	static void ScaleRampNEON(float* buffer, uint32 numFrames, float gain, float step)
+	{
+		uint32 i = 0;
+		const float indices[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+		float32x4_t index = vld1q_f32(indices);
+		const float32x4_t vgain = vdupq_n_f32(gain);
+		const float32x4_t two = vdupq_n_f32(2.0f);
+		for(; i + 2 <= numFrames; i += 2)
+		{
+			float32x4_t g = vaddq_f32(vgain, vmulq_n_f32(index, step));
+			vst1q_f32(buffer + i * 2, vmulq_f32(vld1q_f32(buffer + i * 2), g));
+			index = vaddq_f32(index, two);
+		}
+		for(; i < numFrames; i++)
+		{
+			float g = gain + step * (float)i;
+			buffer[i * 2] *= g;
+			buffer[i * 2 + 1] *= g;
+		}
+	}
+	static void ScaleFramesNEON(float* buffer, const float* gains, uint32 numFrames)
+	{
+		uint32 i = 0;
+		for(; i + 4 <= numFrames; i += 4)
+		{
+			float32x4x2_t g = vzipq_f32(vld1q_f32(gains + i), vld1q_f32(gains + i));
+			vst1q_f32(buffer + i * 2, vmulq_f32(vld1q_f32(buffer + i * 2), g.val[0]));
+			vst1q_f32(buffer + i * 2 + 4, vmulq_f32(vld1q_f32(buffer + i * 2 + 4), g.val[1]));
+		}
+		ScaleFramesScalar(buffer + i * 2, gains + i, numFrames - i);
+	}
+	static void BlendNEON(float* buffer, const float* src, uint32 numFrames, float srcGain, float bufferGain)
+	{
+		uint32 i = 0;
+		const uint32 count = numFrames * 2;
+		for(; i + 4 <= count; i += 4)
+		{
+			float32x4_t v = vaddq_f32(vmulq_n_f32(vld1q_f32(src + i), srcGain), vmulq_n_f32(vld1q_f32(buffer + i), bufferGain));
+			vst1q_f32(buffer + i, v);
+		}
+		for(; i < count; i++)
+		{
+			buffer[i] = src[i] * srcGain + buffer[i] * bufferGain;
+		}
+	}
+	static void ScaleCopyNEON(float* dst, const float* src, uint32 count, float gain)
+	{
+		uint32 i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			vst1q_f32(dst + i, vmulq_n_f32(vld1q_f32(src + i), gain));
+		}
+		ScaleCopyScalar(dst + i, src + i, count - i, gain);
+	}
+
+	static const KernelTable neonKernels = {
+		BiquadNEON, ScaleStereoNEON, ScaleRampNEON, ScaleFramesNEON, BlendNEON, ScaleCopyNEON
+	};
+
+	static DSPKernelLevel DetectLevel()
+	{
+		// Always available when the compiler targets it
+		return DSPKernelLevel::NEON;
+	}
+#else
+	static DSPKernelLevel DetectLevel()
+	{
+		return DSPKernelLevel::Scalar;
+	}
+#endif
+
+	static const KernelTable* GetKernels(DSPKernelLevel level)
+	{
+		switch(level)
+		{
+#if defined(DSP_X86)
+		case DSPKernelLevel::SSE2:
+			return &sse2Kernels;
+		case DSPKernelLevel::AVX:
+			return &avxKernels;
+#elif defined(DSP_NEON)
+		case DSPKernelLevel::NEON:
+			return &neonKernels;
+#endif
+		default:
+			return &scalarKernels;
+		}
+	}
+
+	static DSPKernelLevel supportedLevel = DetectLevel();
+	static DSPKernelLevel currentLevel = supportedLevel;
+	static const KernelTable* kernels = GetKernels(currentLevel);
+
+	void Biquad(float* buffer, uint32 numFrames, const BiquadCoefficients& coefficients, BiquadState& state, float wet, float dry)
+	{
+		kernels->biquad(buffer, numFrames, coefficients, state, wet, dry);
+	}
+	void ScaleStereo(float* buffer, uint32 numFrames, float left, float right)
+	{
+		kernels->scaleStereo(buffer, numFrames, left, right);
+	}
+	void ScaleRamp(float* buffer, uint32 numFrames, float gain, float step)
+	{
+		kernels->scaleRamp(buffer, numFrames, gain, step);
+	}
+	void ScaleFrames(float* buffer, const float* gains, uint32 numFrames)
+	{
+		kernels->scaleFrames(buffer, gains, numFrames);
+	}
+	void Blend(float* buffer, const float* src, uint32 numFrames, float srcGain, float bufferGain)
+	{
+		kernels->blend(buffer, src, numFrames, srcGain, bufferGain);
+	}
+	void ScaleCopy(float* dst, const float* src, uint32 count, float gain)
+	{
+		kernels->scaleCopy(dst, src, count, gain);
+	}
+
+	DSPKernelLevel GetSupportedLevel()
+	{
+		return supportedLevel;
+	}
+	DSPKernelLevel GetLevel()
+	{
+		return currentLevel;
+	}
+	bool SetLevel(DSPKernelLevel level)
+	{
+		bool supported = level == DSPKernelLevel::Scalar || level == supportedLevel;
+#if defined(DSP_X86)
+		// Every cpu with AVX also has SSE2
+		supported |= level == DSPKernelLevel::SSE2 && supportedLevel == DSPKernelLevel::AVX;
+#endif
+		if(!supported)
+			return false;
+		currentLevel = level;
+		kernels = GetKernels(level);
+		return true;
+	}
+}
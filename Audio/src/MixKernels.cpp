@@ -0,0 +1,199 @@
+#include "stdafx.h"
+#include "MixKernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIX_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIX_NEON
+#include <arm_neon.h>
+#endif
+
+namespace MixKernels
+{
+	void MixAdd(float* dst, const float* src, float volume, uint32 count)
+	{
+		uint32 i = 0;
+#if defined(MIX_SSE2)
+		const __m128 vol = _mm_set1_ps(volume);
+		for(; i + 8 <= count; i += 8)
+		{
+			__m128 a = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), vol));
+			__m128 b = _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_mul_ps(_mm_loadu_ps(src + i + 4), vol));
+			_mm_storeu_ps(dst + i, a);
+			_mm_storeu_ps(dst + i + 4, b);
+		}
+#elif defined(MIX_NEON)
+		const float32x4_t vol = vdupq_n_f32(volume);
+		for(; i + 8 <= count; i += 8)
+		{
+			vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), vol));
+			vst1q_f32(dst + i + 4, vmlaq_f32(vld1q_f32(dst + i + 4), vld1q_f32(src + i + 4), vol));
+		}
+#endif
+		for(; i < count; i++)
+		{
+			dst[i] += src[i] * volume;
+		}
+	}
+
+	void MixAddStereo(float* dst, const float* src, float left, float right, uint32 numFrames)
+	{
+		uint32 i = 0;
+#if defined(MIX_SSE2)
+		const __m128 vol = _mm_setr_ps(left, right, left, right);
+		for(; i + 4 <= numFrames; i += 4)
+		{
+			__m128 a = _mm_add_ps(_mm_loadu_ps(dst + i * 2), _mm_mul_ps(_mm_loadu_ps(src + i * 2), vol));
+			__m128 b = _mm_add_ps(_mm_loadu_ps(dst + i * 2 + 4), _mm_mul_ps(_mm_loadu_ps(src + i * 2 + 4), vol));
+			_mm_storeu_ps(dst + i * 2, a);
+			_mm_storeu_ps(dst + i * 2 + 4, b);
+		}
+#elif defined(MIX_NEON)
+		const float gains[4] = { left, right, left, right };
+		const float32x4_t vol = vld1q_f32(gains);
+		for(; i + 4 <= numFrames; i += 4)
+		{
+			vst1q_f32(dst + i * 2, vmlaq_f32(vld1q_f32(dst + i * 2), vld1q_f32(src + i * 2), vol));
+			vst1q_f32(dst + i * 2 + 4, vmlaq_f32(vld1q_f32(dst + i * 2 + 4), vld1q_f32(src + i * 2 + 4), vol));
+		}
+#endif
+		for(; i < numFrames; i++)
+		{
+			dst[i * 2] += src[i * 2] * left;
+			dst[i * 2 + 1] += src[i * 2 + 1] * right;
+		}
+	}
+
+	void ScaleClamp(float* buffer, float volume, uint32 count)
+	{
+		uint32 i = 0;
+#if defined(MIX_SSE2)
+		const __m128 vol = _mm_set1_ps(volume);
+		const __m128 lo = _mm_set1_ps(-1.0f);
+		const __m128 hi = _mm_set1_ps(1.0f);
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_mul_ps(_mm_loadu_ps(buffer + i), vol);
+			_mm_storeu_ps(buffer + i, _mm_min_ps(_mm_max_ps(v, lo), hi));
+		}
+#elif defined(MIX_NEON)
+		const float32x4_t vol = vdupq_n_f32(volume);
+		const float32x4_t lo = vdupq_n_f32(-1.0f);
+		const float32x4_t hi = vdupq_n_f32(1.0f);
+		for(; i + 4 <= count; i += 4)
+		{
+			float32x4_t v = vmulq_f32(vld1q_f32(buffer + i), vol);
+			vst1q_f32(buffer + i, vminq_f32(vmaxq_f32(v, lo), hi));
+		}
+#endif
+		for(; i < count; i++)
+		{
+			// NaN turns into -1, same as fmax(v, -1)
+			float v = buffer[i] * volume;
+			buffer[i] = v > -1.0f ? (v < 1.0f ? v : 1.0f) : -1.0f;
+		}
+	}
+
+	void ConvertToFloat(float* out, const float* in, uint32 numFrames, uint32 outputChannels)
+	{
+		if(outputChannels == 2)
+		{
+			memcpy(out, in, sizeof(float) * 2 * numFrames);
+			return;
+		}
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			for(uint32 c = 0; c < outputChannels; c++)
+			{
+				// TODO: Mix to surround channels as well?
+				out[i * outputChannels + c] = c < 2 ? in[i * 2 + c] : 0.0f;
+			}
+		}
+	}
+
+	void ConvertToInt16(int16* out, const float* in, uint32 numFrames, uint32 outputChannels)
+	{
+		uint32 i = 0;
+#if defined(MIX_SSE2)
+		if(outputChannels == 2)
+		{
+			// Input is already clamped to [-1,1]
+			const __m128 scale = _mm_set1_ps((float)0x7FFF);
+			for(; i + 4 <= numFrames; i += 4)
+			{
+				__m128i a = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i * 2), scale));
+				__m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i * 2 + 4), scale));
+				_mm_storeu_si128((__m128i*)(out + i * 2), _mm_packs_epi32(a, b));
+			}
+		}
+#elif defined(MIX_NEON)
+		if(outputChannels == 2)
+		{
+			const float32x4_t scale = vdupq_n_f32((float)0x7FFF);
+			for(; i + 4 <= numFrames; i += 4)
+			{
+				int32x4_t a = vcvtq_s32_f32(vmulq_f32(vld1q_f32(in + i * 2), scale));
+				int32x4_t b = vcvtq_s32_f32(vmulq_f32(vld1q_f32(in + i * 2 + 4), scale));
+				vst1q_s16(out + i * 2, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+			}
+		}
+#endif
+		for(; i < numFrames; i++)
+		{
+			for(uint32 c = 0; c < outputChannels; c++)
+			{
+				out[i * outputChannels + c] = c < 2 ? (int16)(0x7FFF * Math::Clamp(in[i * 2 + c], -1.f, 1.f)) : 0;
+			}
+		}
+	}
+
+	uint64 ResampleFIR(float* out, uint32 numFrames, const float* in, uint64 position, uint64 step,
+		const float* filter, uint32 numTaps, uint32 phaseBits)
+	{
+		const uint32 phaseShift = 32 - phaseBits;
+		const uint32 phaseRound = 1u << (phaseShift - 1);
+		const uint32 phaseSize = numTaps * 2;
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			const float* src = in + (position >> 32) * 2;
+			// Rounded to the nearest phase, the last phase is the same as the first one of the next sample
+			const float* coefs = filter + (((uint64)(uint32)position + phaseRound) >> phaseShift) * phaseSize;
+#if defined(MIX_SSE2)
+			__m128 a = _mm_setzero_ps();
+			__m128 b = _mm_setzero_ps();
+			for(uint32 t = 0; t < phaseSize; t += 8)
+			{
+				a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(src + t), _mm_loadu_ps(coefs + t)));
+				b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(src + t + 4), _mm_loadu_ps(coefs + t + 4)));
+			}
+			a = _mm_add_ps(a, b);
+			// Add the two frames in the vector, leaving left and right in the lower half
+			a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+			_mm_storel_pi((__m64*)(out + i * 2), a);
+#elif defined(MIX_NEON)
+			float32x4_t a = vdupq_n_f32(0.0f);
+			float32x4_t b = vdupq_n_f32(0.0f);
+			for(uint32 t = 0; t < phaseSize; t += 8)
+			{
+				a = vmlaq_f32(a, vld1q_f32(src + t), vld1q_f32(coefs + t));
+				b = vmlaq_f32(b, vld1q_f32(src + t + 4), vld1q_f32(coefs + t + 4));
+			}
+			a = vaddq_f32(a, b);
+			vst1_f32(out + i * 2, vadd_f32(vget_low_f32(a), vget_high_f32(a)));
+#else
+			float l = 0.0f;
+			float r = 0.0f;
+			for(uint32 t = 0; t < phaseSize; t += 2)
+			{
+				l += src[t] * coefs[t];
+				r += src[t + 1] * coefs[t + 1];
+			}
+			out[i * 2] = l;
+			out[i * 2 + 1] = r;
+#endif
+			position += step;
+		}
+		return position;
+	}
+}
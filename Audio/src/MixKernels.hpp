@@ -0,0 +1,26 @@
+#pragma once
+
+/*
+	Inner loops of the mixer working on interleaved float buffers
+	uses SSE2 or NEON when available, counts don't have to be a multiple of the vector width
+*/
+namespace MixKernels
+{
+	// dst += src * volume
+	void MixAdd(float* dst, const float* src, float volume, uint32 count);
+	// dst += src * (left, right) over interleaved stereo frames
+	void MixAddStereo(float* dst, const float* src, float left, float right, uint32 numFrames);
+	// buffer = clamp(buffer * volume, -1, 1)
+	void ScaleClamp(float* buffer, float volume, uint32 count);
+
+	// Copies stereo samples to an output with the given number of channels, extra channels are silent
+	void ConvertToFloat(float* out, const float* in, uint32 numFrames, uint32 outputChannels);
+	void ConvertToInt16(int16* out, const float* in, uint32 numFrames, uint32 outputChannels);
+
+	// Renders stereo frames from interleaved input with a polyphase FIR filter
+	//	position and step are in 32.32 fixed point, position points at the first tap of the filter
+	//	the filter has (1 << phaseBits) + 1 phases of numTaps coefficients that are each stored twice, numTaps has to be a multiple of 4
+	//	returns the position after the last frame
+	uint64 ResampleFIR(float* out, uint32 numFrames, const float* in, uint64 position, uint64 step,
+		const float* filter, uint32 numTaps, uint32 phaseBits);
+}
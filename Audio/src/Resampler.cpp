@@ -0,0 +1,266 @@
+#include "stdafx.h"
+#include "Resampler.hpp"
+#include "MixKernels.hpp"
+#include <mutex>
+using std::mutex;
+
+static const double pi = 3.14159265358979323846;
+
+// Modified bessel function of the first kind, used for the kaiser window
+static double BesselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for(uint32 k = 1; k < 32; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+/*
+	Polyphase filter coefficients for one quality and cutoff
+*/
+struct ResampleFilter
+{
+	// Coefficients per phase, each coefficient is stored twice to match the interleaved input
+	Vector<float> coefs;
+	uint32 numTaps = 0;
+	uint32 phaseBits = 0;
+};
+
+// The cutoff is lowered in steps of this fraction when downsampling, so only a few filters are built for all ratios
+static const uint32 cutoffSteps = 64;
+
+// Built filters by quality and cutoff step, these are never freed
+static Map<uint32, ResampleFilter*> filterCache;
+static mutex filterCacheLock;
+
+static ResampleFilter* BuildFilter(ResampleQuality quality, uint32 cutoffStep)
+{
+	ResampleFilter* filter = new ResampleFilter();
+	double beta = 0.0;
+	double cutoff = 0.0;
+	if(quality == ResampleQuality::Medium)
+	{
+		filter->numTaps = 16;
+		filter->phaseBits = 8;
+		beta = 5.0;
+		cutoff = 0.8;
+	}
+	else
+	{
+		filter->numTaps = 32;
+		filter->phaseBits = 9;
+		beta = 8.0;
+		cutoff = 0.85;
+	}
+	cutoff *= (double)cutoffStep / (double)cutoffSteps;
+
+	const uint32 numTaps = filter->numTaps;
+	const uint32 numPhases = (1 << filter->phaseBits) + 1;
+	const double half = numTaps / 2;
+	const double windowScale = 1.0 / BesselI0(beta);
+	filter->coefs.resize(numPhases * numTaps * 2);
+	for(uint32 p = 0; p < numPhases; p++)
+	{
+		double phase = (double)p / (double)(1 << filter->phaseBits);
+		float* coefs = filter->coefs.data() + p * numTaps * 2;
+		double sum = 0.0;
+		for(uint32 t = 0; t < numTaps; t++)
+		{
+			// Distance from the output position to this tap in input frames
+			double x = (double)t - (half - 1.0) - phase;
+			double sinc = x == 0.0 ? 1.0 : sin(pi * cutoff * x) / (pi * cutoff * x);
+			double w = x / half;
+			double window = fabs(w) >= 1.0 ? 0.0 : BesselI0(beta * sqrt(1.0 - w * w)) * windowScale;
+			coefs[t * 2] = (float)(sinc * window);
+			sum += sinc * window;
+		}
+		// Normalize every phase to unity gain
+		for(uint32 t = 0; t < numTaps; t++)
+		{
+			coefs[t * 2] = (float)(coefs[t * 2] / sum);
+			coefs[t * 2 + 1] = coefs[t * 2];
+		}
+	}
+	return filter;
+}
+
+// Finds the filter for a quality and ratio, returns false if it is not built yet or the cache is in use by another thread
+//	qualities without a filter return true with filter set to null
+static bool FindFilter(ResampleQuality quality, double ratio, bool build, const ResampleFilter*& filter)
+{
+	filter = nullptr;
+	if(quality != ResampleQuality::Medium && quality != ResampleQuality::High)
+		return true;
+
+	// Lower the cutoff below the output nyquist frequency when downsampling
+	uint32 cutoffStep = ratio <= 1.0 ? cutoffSteps : Math::Max(1u, (uint32)((double)cutoffSteps / ratio));
+	uint32 key = ((uint32)quality << 16) | cutoffStep;
+	if(build)
+		filterCacheLock.lock();
+	else if(!filterCacheLock.try_lock())
+		return false;
+
+	auto it = filterCache.find(key);
+	if(it != filterCache.end())
+	{
+		filter = it->second;
+	}
+	else if(build)
+	{
+		ResampleFilter* built = BuildFilter(quality, cutoffStep);
+		filterCache.Add(key, built);
+		filter = built;
+	}
+	filterCacheLock.unlock();
+	return filter != nullptr;
+}
+
+Resampler::Resampler()
+{
+	Reset();
+}
+void Resampler::PrepareFilter(ResampleQuality quality, double ratio)
+{
+	const ResampleFilter* filter;
+	FindFilter(quality, ratio, true, filter);
+}
+bool Resampler::SetQuality(ResampleQuality quality)
+{
+	if(quality == m_quality)
+		return true;
+	const ResampleFilter* filter;
+	if(!FindFilter(quality, m_ratio, false, filter))
+		return false;
+	m_quality = quality;
+	m_filter = filter;
+	m_numTaps = filter ? filter->numTaps : 0;
+	m_filterPending = false;
+	Reset();
+	return true;
+}
+bool Resampler::SetRatio(double ratio)
+{
+	if(ratio != m_ratio)
+	{
+		m_ratio = ratio;
+		m_step = (uint64)(ratio * (double)(1ull << 32));
+		m_filterPending = true;
+	}
+	if(m_filterPending)
+		return m_UpdateFilter();
+	return true;
+}
+bool Resampler::m_UpdateFilter()
+{
+	const ResampleFilter* filter;
+	if(!FindFilter(m_quality, m_ratio, false, filter))
+		return false;
+	// Filters of the same quality have the same length, so the buffered input stays valid
+	m_filter = filter;
+	m_filterPending = false;
+	return true;
+}
+void Resampler::Reset()
+{
+	// Start with silence as history so the first frame can be filtered
+	uint32 history = m_GetHistory();
+	m_input.resize(Math::Max<size_t>(m_input.size(), history * 2));
+	memset(m_input.data(), 0, sizeof(float) * history * 2);
+	m_inputLength = history;
+	m_position = (uint64)history << 32;
+}
+uint32 Resampler::m_GetHistory() const
+{
+	return m_numTaps > 0 ? m_numTaps / 2 - 1 : 0;
+}
+uint32 Resampler::m_GetLookahead() const
+{
+	if(m_numTaps > 0)
+		return m_numTaps / 2;
+	return m_quality == ResampleQuality::Linear ? 1 : 0;
+}
+uint32 Resampler::GetInputNeeded(uint32 numOutput) const
+{
+	if(numOutput == 0)
+		return 0;
+	uint64 last = (m_position + m_step * (numOutput - 1)) >> 32;
+	uint64 needed = last + m_GetLookahead() + 1;
+	return needed > m_inputLength ? (uint32)(needed - m_inputLength) : 0;
+}
+int32 Resampler::GetPendingFrames() const
+{
+	return (int32)m_inputLength - (int32)(m_position >> 32);
+}
+void Resampler::Write(const float* in, uint32 numFrames)
+{
+	if(m_input.size() < (m_inputLength + numFrames) * 2)
+		m_input.resize((m_inputLength + numFrames) * 2);
+	memcpy(m_input.data() + m_inputLength * 2, in, sizeof(float) * numFrames * 2);
+	m_inputLength += numFrames;
+}
+void Resampler::Flush()
+{
+	uint32 lookahead = m_GetLookahead();
+	if(m_input.size() < (m_inputLength + lookahead) * 2)
+		m_input.resize((m_inputLength + lookahead) * 2);
+	memset(m_input.data() + m_inputLength * 2, 0, sizeof(float) * lookahead * 2);
+	m_inputLength += lookahead;
+}
+uint32 Resampler::Render(float* out, uint32 numOutput, uint32& consumed)
+{
+	const uint32 history = m_GetHistory();
+	const uint32 lookahead = m_GetLookahead();
+	const uint64 start = m_position;
+
+	// Every output frame needs the input up to its position plus the lookahead
+	uint32 count = 0;
+	if(m_inputLength > lookahead)
+	{
+		uint64 end = (uint64)(m_inputLength - lookahead) << 32;
+		if(m_position < end)
+			count = (uint32)Math::Min<uint64>(numOutput, (end - m_position - 1) / m_step + 1);
+	}
+
+	const float* in = m_input.data();
+	switch(m_quality)
+	{
+	case ResampleQuality::Nearest:
+		for(uint32 i = 0; i < count; i++)
+		{
+			const float* src = in + (m_position >> 32) * 2;
+			out[i * 2] = src[0];
+			out[i * 2 + 1] = src[1];
+			m_position += m_step;
+		}
+		break;
+	case ResampleQuality::Linear:
+		for(uint32 i = 0; i < count; i++)
+		{
+			const float* src = in + (m_position >> 32) * 2;
+			float f = (float)(uint32)m_position * (1.0f / 4294967296.0f);
+			out[i * 2] = src[0] + (src[2] - src[0]) * f;
+			out[i * 2 + 1] = src[1] + (src[3] - src[1]) * f;
+			m_position += m_step;
+		}
+		break;
+	default:
+		m_position = MixKernels::ResampleFIR(out, count, in, m_position - ((uint64)history << 32), m_step,
+			m_filter->coefs.data(), m_numTaps, m_filter->phaseBits) + ((uint64)history << 32);
+		break;
+	}
+	consumed = (uint32)((m_position >> 32) - (start >> 32));
+
+	// Drop input that is no longer needed by the filter
+	uint32 drop = Math::Min((uint32)(m_position >> 32) - history, m_inputLength);
+	if(drop > 0)
+	{
+		memmove(m_input.data(), m_input.data() + drop * 2, sizeof(float) * (m_inputLength - drop) * 2);
+		m_inputLength -= drop;
+		m_position -= (uint64)drop << 32;
+	}
+	return count;
+}
@@ -2,6 +2,7 @@
 #include "Sample.hpp"
 #include "Audio_Impl.hpp"
 #include "Audio.hpp"
+#include "SamplePlayer.hpp"
 
 #include "extras/dr_wav.h"   // Enables WAV decoding.
 #include "extras/dr_flac.h"  // Enables FLAC decoding.
@@ -18,77 +19,83 @@ public:
 	Audio* m_audio;
 	float* m_pcm = nullptr;
 
-	mutex m_lock;
-
-	uint64 m_playbackPointer = 0;
-	uint64 m_length = 0;
-	bool m_playing = false;
-	bool m_looping = false;
+	// Shared with the mixer, which plays the voices of all samples
+	SampleSource m_source;
 
 public:
 	~Sample_Impl()
 	{
+		// Wait for the mixer to stop using the sample data and its DSP's
+		m_audio->GetImpl()->SendCommand(new MixerCommand(MixerCommand::StopVoice, &m_source, 0));
 		Deregister();
 		if (m_pcm)
 		{
 			ma_free(m_pcm);
 		}
 	}
-	virtual void Play(bool looping) override
+	virtual uint32 Play(bool looping) override
+	{
+		return PlayVoice(1.0f, 0.0f, looping);
+	}
+	virtual uint32 PlayVoice(float volume, float pan, bool looping) override
+	{
+		if(looping)
+			Stop();
+
+		uint32 id = m_source.nextVoiceId++;
+		if(id == 0)
+			id = m_source.nextVoiceId++;
+		m_source.numVoices++;
+
+		MixerCommand* command = new MixerCommand(MixerCommand::PlayVoice, &m_source, id);
+		command->volume = volume;
+		command->pan = pan;
+		command->looping = looping;
+		m_audio->GetImpl()->SendCommand(command);
+		return id;
+	}
+	virtual void SetVoiceMix(uint32 voice, float volume, float pan) override
+	{
+		MixerCommand* command = new MixerCommand(MixerCommand::SetVoiceMix, &m_source, voice);
+		command->volume = volume;
+		command->pan = pan;
+		m_audio->GetImpl()->SendCommand(command);
+	}
+	virtual void StopVoice(uint32 voice) override
 	{
-		m_lock.lock();
-		m_playing = true;
-		m_playbackPointer = 0;
-		m_looping = looping;
-		m_lock.unlock();	
+		if(voice != 0)
+			m_audio->GetImpl()->SendCommand(new MixerCommand(MixerCommand::StopVoice, &m_source, voice));
 	}
 	virtual void Stop() override
 	{
-		m_lock.lock();
-		m_playing = false;
-		m_looping = false;
-		m_lock.unlock();
+		m_audio->GetImpl()->SendCommand(new MixerCommand(MixerCommand::StopVoice, &m_source, 0));
+	}
+	virtual void SetMaxVoices(uint32 numVoices) override
+	{
+		// Read by the mixer when a voice is started
+		m_source.maxVoices = Math::Max(numVoices, 1u);
 	}
 	bool Init(const String& path)
 	{
 
 		ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, g_audio->GetSampleRate());
 		ma_result result;
-		result = ma_decode_file( *path, &config, &m_length, (void**)&m_pcm);
+		result = ma_decode_file( *path, &config, &m_source.length, (void**)&m_pcm);
 
 		if (result != MA_SUCCESS)
 			return false;
 
+		m_source.sample = this;
+		m_source.pcm = m_pcm;
+
+		// Not rendered as an item, DSP's added to the sample are applied to its voices by the sample player
+		audio = m_audio->GetImpl();
+		DSPs.reserve(16);
 		return true;
 	}
 	virtual void Process(float* out, uint32 numSamples) override
 	{
-		if(!m_playing)
-			return;
-
-		m_lock.lock();
-
-		for(uint32 i = 0; i < numSamples; i++)
-		{
-			if(m_playbackPointer >= m_length)
-			{
-				if(m_looping)
-				{
-					m_playbackPointer = 0;
-				}
-				else
-				{
-					// Playback ended
-					m_playing = false;
-					break;
-				}
-			}
-
-			out[i * 2] = m_pcm[m_playbackPointer * 2];
-			out[i * 2 + 1] = m_pcm[m_playbackPointer * 2 + 1];
-			m_playbackPointer++;
-		}
-		m_lock.unlock();
+		// Voices are rendered by the sample player
 	}
 	const Buffer& GetData() const
 	{
@@ -104,7 +111,7 @@ public:
 	}
 	int32 GetPosition() const
 	{
-		return m_playbackPointer;
+		return m_source.position;
 	}
 	float* GetPCM()
 	{
@@ -116,7 +123,7 @@ public:
 	}
 	bool IsPlaying() const
 	{
-		return m_playing;
+		return m_source.numVoices > 0;
 	}
 
 };
@@ -132,7 +139,5 @@ Sample SampleRes::Create(Audio* audio, const String& path)
 		return Sample();
 	}
 
-	audio->GetImpl()->Register(res);
-
 	return Sample(res);
 }
\ No newline at end of file
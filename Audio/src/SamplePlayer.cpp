@@ -0,0 +1,162 @@
+#include "stdafx.h"
+#include "SamplePlayer.hpp"
+#include "Audio_Impl.hpp"
+#include "MixKernels.hpp"
+
+void SamplePlayer::PlayVoice(SampleSource* source, uint32 id, float volume, float pan, bool looping)
+{
+	// Use a free voice, unless the sample already plays its maximum number of voices
+	Voice* target = nullptr;
+	Voice* oldest = nullptr;
+	Voice* oldestOfSource = nullptr;
+	uint32 numSourceVoices = 0;
+	for(Voice& voice : m_voices)
+	{
+		if(!voice.source)
+		{
+			if(!target)
+				target = &voice;
+			continue;
+		}
+		if(!oldest || voice.startIndex < oldest->startIndex)
+			oldest = &voice;
+		if(voice.source == source)
+		{
+			numSourceVoices++;
+			if(!oldestOfSource || voice.startIndex < oldestOfSource->startIndex)
+				oldestOfSource = &voice;
+		}
+	}
+	if(numSourceVoices >= source->maxVoices && oldestOfSource)
+		target = oldestOfSource;
+	else if(!target)
+		target = oldest;
+	if(target->source)
+		m_StopVoice(*target);
+
+	target->source = source;
+	target->id = id;
+	target->position = 0;
+	target->startIndex = m_numStarted++;
+	target->volume = volume;
+	target->pan = pan;
+	target->looping = looping;
+}
+void SamplePlayer::StopVoice(SampleSource* source, uint32 id)
+{
+	for(Voice& voice : m_voices)
+	{
+		if(voice.source == source && (id == 0 || voice.id == id))
+			m_StopVoice(voice);
+	}
+}
+void SamplePlayer::StopAll()
+{
+	for(Voice& voice : m_voices)
+	{
+		if(voice.source)
+			m_StopVoice(voice);
+	}
+}
+void SamplePlayer::SetVoiceMix(SampleSource* source, uint32 id, float volume, float pan)
+{
+	for(Voice& voice : m_voices)
+	{
+		if(voice.source == source && voice.id == id)
+		{
+			voice.volume = volume;
+			voice.pan = pan;
+		}
+	}
+}
+void SamplePlayer::SetBufferLength(uint32 numSamples)
+{
+	m_dspBuffer.resize(numSamples * 2);
+}
+void SamplePlayer::m_StopVoice(Voice& voice)
+{
+	voice.source->numVoices.fetch_sub(1, std::memory_order_release);
+	voice.source = nullptr;
+}
+void SamplePlayer::m_MixVoice(Voice& voice, float* out, uint32 numSamples)
+{
+	SampleSource* source = voice.source;
+	voice.mixed = true;
+
+	// Same panning as PanDSP
+	float volume = voice.volume * source->sample->GetVolume();
+	float left = volume * Math::Min(1.0f, 1.0f - voice.pan);
+	float right = volume * Math::Min(1.0f, 1.0f + voice.pan);
+
+	uint32 rendered = 0;
+	while(rendered < numSamples)
+	{
+		if(voice.position >= source->length)
+		{
+			if(!voice.looping || source->length == 0)
+				break;
+			voice.position = 0;
+		}
+		uint32 count = (uint32)Math::Min<uint64>(numSamples - rendered, source->length - voice.position);
+		MixKernels::MixAddStereo(out + rendered * 2, source->pcm + voice.position * 2, left, right, count);
+		voice.position += count;
+		rendered += count;
+	}
+
+	// Playback ended
+	if(rendered < numSamples)
+		m_StopVoice(voice);
+}
+void SamplePlayer::Process(float* out, uint32 numSamples)
+{
+	for(Voice& voice : m_voices)
+	{
+		voice.mixed = false;
+	}
+	for(Voice& voice : m_voices)
+	{
+		SampleSource* source = voice.source;
+		if(!source || voice.mixed)
+			continue;
+
+		AudioBase* sample = source->sample;
+		if(sample->DSPs.empty())
+		{
+			m_MixVoice(voice, out, numSamples);
+			continue;
+		}
+
+		// Mix all voices of the sample before applying its DSP's
+		assert(numSamples * 2 <= m_dspBuffer.size());
+		float* data = m_dspBuffer.data();
+		memset(data, 0, sizeof(float) * numSamples * 2);
+		for(Voice& other : m_voices)
+		{
+			if(other.source == source)
+				m_MixVoice(other, data, numSamples);
+		}
+		sample->ProcessDSPs(data, numSamples);
+		MixKernels::MixAdd(out, data, 1.0f, numSamples * 2);
+	}
+
+	Voice* newest = nullptr;
+	for(Voice& voice : m_voices)
+	{
+		if(voice.source && (!newest || voice.startIndex > newest->startIndex))
+			newest = &voice;
+	}
+	if(newest)
+		newest->source->position.store((uint32)newest->position, std::memory_order_relaxed);
+}
+int32 SamplePlayer::GetPosition() const
+{
+	return 0;
+}
+uint32 SamplePlayer::GetSampleRate() const
+{
+	return audio ? audio->GetSampleRate() : 0;
+}
+float* SamplePlayer::GetPCM()
+{
+	return nullptr;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "AudioBase.hpp"
+#include <atomic>
+
+/*
+	Decoded sample data shared between a sample and the mixer
+*/
+struct SampleSource
+{
+	// The sample, its volume applies to all of its voices
+	AudioBase* sample = nullptr;
+	// Interleaved stereo frames at the output rate
+	const float* pcm = nullptr;
+	uint64 length = 0;
+	// Voices this sample can play at the same time
+	uint32 maxVoices = 8;
+
+	// Voices that are playing or queued to play
+	std::atomic<int32> numVoices;
+	// Position of the last started voice in frames
+	std::atomic<uint32> position;
+	std::atomic<uint32> nextVoiceId;
+
+	SampleSource() : numVoices(0), position(0), nextVoiceId(1) {}
+};
+
+/*
+	Plays the voices of all samples as a single mixer item
+	only used by the mixer, changes are made through mixer commands
+*/
+class SamplePlayer : public AudioBase
+{
+public:
+	// Total number of voices over all samples, the oldest one is stolen when all are in use
+	static const uint32 maxVoices = 64;
+
+	void PlayVoice(SampleSource* source, uint32 id, float volume, float pan, bool looping);
+	// Stops one voice of a sample, or all of them when the id is 0
+	void StopVoice(SampleSource* source, uint32 id);
+	void SetVoiceMix(SampleSource* source, uint32 id, float volume, float pan);
+	void StopAll();
+	// Sets the number of frames the mixer renders at a time
+	void SetBufferLength(uint32 numSamples);
+
+	virtual void Process(float* out, uint32 numSamples) override;
+	virtual int32 GetPosition() const override;
+	virtual uint32 GetSampleRate() const override;
+	virtual float* GetPCM() override;
+
+private:
+	struct Voice
+	{
+		SampleSource* source = nullptr;
+		uint32 id = 0;
+		uint64 position = 0;
+		// Order the voices were started in
+		uint64 startIndex = 0;
+		float volume = 1.0f;
+		// -1 to 1 LR pan value
+		float pan = 0.0f;
+		bool looping = false;
+		// Set once the voice is rendered in the current buffer
+		bool mixed = false;
+	};
+	void m_StopVoice(Voice& voice);
+	// Adds the next numSamples frames of a voice to out, stops the voice when it ends
+	void m_MixVoice(Voice& voice, float* out, uint32 numSamples);
+
+	Voice m_voices[maxVoices];
+	// The voices of a sample with DSP's are mixed here, so its DSP's are applied once for all of them
+	Vector<float> m_dspBuffer;
+	uint64 m_numStarted = 0;
+};
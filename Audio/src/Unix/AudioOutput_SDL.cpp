@@ -130,6 +130,11 @@ double AudioOutput::GetBufferLength() const
 {
 	return 0;
 }
+double AudioOutput::GetLatency() const
+{
+	// SDL asks for the next buffer when the device starts playing the previous one
+	return (double)m_impl->m_audioSpec.samples / (double)m_impl->m_audioSpec.freq;
+}
 void AudioOutput::Start(IMixer* mixer)
 {
 	m_impl->m_mixer = mixer;
@@ -64,6 +64,10 @@ public:
 	NotificationClient m_notificationClient;
 
 	double m_bufferLength;
+	// Latency of the device after the shared buffer
+	double m_streamLatency = 0.0;
+	// Time until the buffer returned by Begin is heard
+	double m_latency = 0.0;
 
 	// Dummy audio output
 	static const uint32 m_dummyChannelCount = 2;
@@ -296,6 +300,10 @@ public:
 
 		m_bufferLength = (double)m_numBufferFrames / (double)m_format.nSamplesPerSec;
 
+		REFERENCE_TIME streamLatency = 0;
+		m_audioClient->GetStreamLatency(&streamLatency);
+		m_streamLatency = (double)streamLatency / (double)REFTIMES_PER_SEC;
+
 		res = m_audioClient->Start();
 		return true;
 	}
@@ -305,6 +313,8 @@ public:
 		m_format.nChannels = 2;
 		m_dummyTimer.Restart();
 		m_dummyTimerPos = 0;
+		m_streamLatency = 0.0;
+		m_latency = 0.0;
 		return true;
 	}
 	bool NullBegin(float*& buffer, uint32_t& numSamples)
@@ -342,6 +352,8 @@ public:
 		uint32_t numFramesPadding;
 		m_audioClient->GetCurrentPadding(&numFramesPadding);
 		numSamples = m_numBufferFrames - numFramesPadding;
+		// Everything still in the buffer plays before the new data
+		m_latency = (double)numFramesPadding / (double)m_format.nSamplesPerSec + m_streamLatency;
 
 		if(numSamples > 0)
 		{
@@ -454,6 +466,10 @@ double AudioOutput::GetBufferLength() const
 {
 	return m_impl->m_bufferLength;
 }
+double AudioOutput::GetLatency() const
+{
+	return m_impl->m_latency;
+}
 bool AudioOutput::IsIntegerFormat() const
 {
 	///TODO: check more cases?
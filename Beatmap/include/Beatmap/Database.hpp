@@ -49,5 +49,40 @@ public:
 	bool Exec(const String& queryString);
 	bool ExecDirect(const String& queryString);
 
+	// Switches to write-ahead logging, commits only append to the log and are not synced to disk individually
+	bool EnableWAL();
+	// Writes the write-ahead log back into the database file, do this before copying the file
+	bool Checkpoint();
+
+	// Explicit transactions, nested calls are counted and only the outermost pair begins/commits
+	bool BeginTransaction();
+	bool CommitTransaction();
+	// Rolls back the whole transaction, including nested ones
+	void RollbackTransaction();
+	bool InTransaction() const;
+
 	struct sqlite3* db = nullptr;
+
+private:
+	int32 m_transactionDepth = 0;
 };
+
+/*
+	Groups many writes into transactions of a fixed size, used for bulk inserts
+	a transaction is open for the lifetime of this object, the last batch is committed on destruction
+*/
+class DBBatch : public Unique
+{
+public:
+	DBBatch(Database& db, uint32 batchSize = 1000);
+	~DBBatch();
+	// Call after every write, commits and starts a new transaction once the batch is full
+	void Add();
+	// Commits the current batch and starts a new one
+	void Commit();
+
+private:
+	Database& m_db;
+	uint32 m_batchSize;
+	uint32 m_count = 0;
+};
\ No newline at end of file
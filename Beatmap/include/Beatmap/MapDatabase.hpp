@@ -1,5 +1,6 @@
 #pragma once
 #include "Beatmap.hpp"
+#include "Shared/InternedString.hpp"
 
 struct SimpleHitStat
 {
@@ -50,6 +51,7 @@ struct DifficultyIndex
 	String hash;
 };
 
+// Fields that only take a few distinct values over the whole library are interned
 struct ChartIndex
 {
 	int32 id;
@@ -62,9 +64,9 @@ struct ChartIndex
 	String jacket_path;
 	String effector;
 	String illustrator;
-	String diff_name;
-	String diff_shortname;
-	String bpm;
+	InternedString diff_name;
+	InternedString diff_shortname;
+	InternedString bpm;
 	int32 diff_index;
 	int32 level;
 	String hash;
@@ -72,7 +74,13 @@ struct ChartIndex
 	int32 preview_offset;
 	int32 preview_length;
 	uint64 lwt;
+	// Scores sorted from best to worst
 	Vector<ScoreIndex*> scores;
+	// False if only the best scores are loaded, see MapDatabase::GetScores
+	bool scoresComplete = true;
+	// Best score and badge of all the scores of this chart, also the ones that are not loaded
+	int32 topScore = 0;
+	uint8 topBadge = 0;
 };
 
 // Map located in database
@@ -89,12 +97,34 @@ struct FolderIndex
 	Vector<ChartIndex*> charts;
 };
 
+// Timing information gathered during the last chart scan
+struct MapDatabaseScanStats
+{
+	// Number of chart files found on disk
+	uint32 numFiles = 0;
+	// Number of new or changed charts that were parsed and hashed
+	uint32 numProcessed = 0;
+	// Number of threads used for parsing and hashing
+	uint32 numWorkers = 0;
+	// Time spent in each stage of the scan, in ms
+	uint32 enumerateTime = 0;
+	uint32 removedTime = 0;
+	uint32 processTime = 0;
+
+	// Parsed charts per second during the process stage
+	float GetChartsPerSecond() const;
+};
+
 class MapDatabase : public Unique
 {
 public:
+	// Calculates the badge of a score, higher is better
+	typedef uint8(*BadgeFunction)(const ScoreIndex& score);
+
 	MapDatabase();
 	// Postpone initialization to allow for hooks
-	MapDatabase(bool postponeInit /* = false */);
+	//	the database file is created relative to the executable if the path is not absolute
+	MapDatabase(bool postponeInit /* = false */, const String& databasePath = "maps.db");
 	~MapDatabase();
 
 	// Finish initialization if postponed
@@ -103,9 +133,32 @@ public:
 	// Checks the background scanning and actualized the current map database
 	void Update();
 
+	// True while a scan is running, charts reported by the folder watcher are parsed without starting a scan
 	bool IsSearching() const;
-	void StartSearching();
+	// Starts scanning the search paths in the background
+	//	only folders that changed since the last scan are listed again, unless a full scan is requested
+	//	charts that are modified in place are only picked up by a full scan or the folder watcher
+	void StartSearching(bool fullScan = false);
 	void StopSearching();
+	// Blocks until the running scan has finished, then applies its changes
+	void WaitForSearch();
+	// Watch the search paths for changes after a scan has finished, applied on the next scan
+	//	only supported on Linux
+	void SetWatchFolders(bool enabled);
+	// Minimum number of changes written per transaction while a scan is running
+	void SetFlushBatchSize(uint32 batchSize);
+	// Statistics of the last completed scan
+	MapDatabaseScanStats GetLastScanStats() const;
+	// Only load the best scores of every chart up front, the rest is loaded by GetScores
+	//	at most maxCachedScores of those are kept, the least recently used charts drop them first
+	//	scoresPerChart = 0 loads all scores, applies the next time scores are loaded (call before FinishInit for the initial load)
+	void SetScoreLimits(uint32 scoresPerChart, uint32 maxCachedScores);
+	// Loads all the scores of a chart if they were not loaded yet
+	//	the best scores stay valid, scores beyond those can be freed by later calls to this function
+	const Vector<ScoreIndex*>& GetScores(ChartIndex* chart);
+	// Used to calculate ChartIndex::topBadge, call before FinishInit
+	//	without it topBadge stays 0
+	void SetBadgeFunction(BadgeFunction badgeFunction);
 
 	// Grab all the maps, with their id's
 	Map<int32, FolderIndex*> GetMaps();
@@ -147,4 +200,8 @@ public:
 
 private:
 	class MapDatabase_Impl* m_impl;
+	String m_databasePath;
+	uint32 m_scoresPerChart = 0;
+	uint32 m_maxCachedScores = 0;
+	BadgeFunction m_badgeFunction = nullptr;
 };
\ No newline at end of file
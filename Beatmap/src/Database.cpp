@@ -143,6 +143,12 @@ void Database::Close()
 {
 	if(db)
 	{
+		if(m_transactionDepth > 0)
+		{
+			Log("Closing database with an open transaction, committing", Logger::Warning);
+			m_transactionDepth = 1;
+			CommitTransaction();
+		}
 		sqlite3_close(db);
 	}
 	db = nullptr;
@@ -180,3 +186,61 @@ bool Database::ExecDirect(const String& queryString)
 	}
 	return true;
 }
+
+bool Database::EnableWAL()
+{
+	// WAL only needs to sync on checkpoints, NORMAL is still safe against corruption
+	return ExecDirect("PRAGMA journal_mode=WAL") && ExecDirect("PRAGMA synchronous=NORMAL");
+}
+bool Database::Checkpoint()
+{
+	return ExecDirect("PRAGMA wal_checkpoint(TRUNCATE)");
+}
+bool Database::BeginTransaction()
+{
+	if(m_transactionDepth++ > 0)
+		return true;
+	if(!ExecDirect("BEGIN"))
+	{
+		m_transactionDepth = 0;
+		return false;
+	}
+	return true;
+}
+bool Database::CommitTransaction()
+{
+	assert(m_transactionDepth > 0);
+	if(--m_transactionDepth > 0)
+		return true;
+	return ExecDirect("COMMIT");
+}
+void Database::RollbackTransaction()
+{
+	assert(m_transactionDepth > 0);
+	m_transactionDepth = 0;
+	ExecDirect("ROLLBACK");
+}
+bool Database::InTransaction() const
+{
+	return m_transactionDepth > 0;
+}
+
+DBBatch::DBBatch(Database& db, uint32 batchSize) : m_db(db), m_batchSize(Math::Max(batchSize, 1u))
+{
+	m_db.BeginTransaction();
+}
+DBBatch::~DBBatch()
+{
+	m_db.CommitTransaction();
+}
+void DBBatch::Add()
+{
+	if(++m_count >= m_batchSize)
+		Commit();
+}
+void DBBatch::Commit()
+{
+	m_db.CommitTransaction();
+	m_db.BeginTransaction();
+	m_count = 0;
+}
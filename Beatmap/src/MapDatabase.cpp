@@ -5,14 +5,25 @@
 #include "TinySHA1.hpp"
 #include "Shared/Profiling.hpp"
 #include "Shared/Files.hpp"
+#include "Shared/FolderWatcher.hpp"
 #include "Shared/Time.hpp"
+#include "Shared/ObjectPool.hpp"
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 using std::thread;
 using std::mutex;
 using namespace std;
 
+float MapDatabaseScanStats::GetChartsPerSecond() const
+{
+	if(processTime == 0)
+		return 0.0f;
+	return (float)numProcessed / ((float)processTime / 1000.0f);
+}
+
 class MapDatabase_Impl
 {
 public:
@@ -24,6 +35,42 @@ public:
 	bool m_interruptSearch = false;
 	Set<String> m_searchPaths;
 	Database m_database;
+	String m_databasePath;
+
+	MapDatabaseScanStats m_scanStats;
+	mutable mutex m_scanStatsLock;
+
+	// Cached listings of all folders in the search paths, stored in the DirectoryCache table
+	//	the search thread works on a copy that is swapped in when the folders have been listed
+	Map<String, FolderScanCache> m_folderCache;
+	mutex m_folderCacheLock;
+	// Folders changed/removed by the last scan that still need to be written to the database
+	Vector<String> m_folderCacheUpdated;
+	Vector<String> m_folderCacheRemoved;
+	bool m_folderCacheDirty = false;
+
+	// Picks up changes in the search paths between scans, if enabled
+	FolderWatcher* m_folderWatcher = nullptr;
+	bool m_watchFolders = false;
+	// Set while charts reported by the folder watcher are being parsed, this is not a search
+	atomic<bool> m_parsingWatched;
+
+	// Full text index over the searchable chart fields, LIKE scans are used if FTS5 is not available
+	bool m_useSearchIndex = false;
+
+	// Number of scores per chart loaded up front, 0 loads all of them
+	uint32 m_scoresPerChart = 0;
+	// Scores loaded by GetScores on top of the ones loaded up front
+	uint32 m_maxCachedScores = 0;
+	uint32 m_numCachedScores = 0;
+	// Charts that had all their scores loaded by GetScores, most recently used first
+	List<ChartIndex*> m_scoreCache;
+	MapDatabase::BadgeFunction m_badgeFunction = nullptr;
+
+	// Index objects are allocated from pools, there can be tens of thousands of them
+	ObjectPool<FolderIndex> m_folderPool;
+	ObjectPool<ChartIndex> m_chartPool;
+	ObjectPool<ScoreIndex> m_scorePool;
 
 	Map<int32, FolderIndex*> m_folders;
 	Map<int32, ChartIndex*> m_charts;
@@ -68,17 +115,29 @@ public:
 	List<Event> m_pendingChanges;
 	mutex m_pendingChangesLock;
 
-	static const int32 m_version = 13;
+	// While searching, pending changes are written in batches of at least this size (or once per flush interval)
+	//	so a scan is committed in a few large transactions instead of one per frame
+	uint32 m_flushBatchSize = 2000;
+	uint32 m_flushInterval = 1000;
+	Timer m_lastFlush;
+
+	static const int32 m_version = 15;
 
 public:
-	MapDatabase_Impl(MapDatabase& outer) : m_outer(outer)
+	MapDatabase_Impl(MapDatabase& outer, const String& databasePath, uint32 scoresPerChart, uint32 maxCachedScores, MapDatabase::BadgeFunction badgeFunction)
+		: m_outer(outer), m_parsingWatched(false)
 	{
-		String databasePath = Path::Absolute("maps.db");
-		if(!m_database.Open(databasePath))
+		m_scoresPerChart = scoresPerChart;
+		m_maxCachedScores = maxCachedScores;
+		m_badgeFunction = badgeFunction;
+		m_databasePath = Path::IsAbsolute(databasePath) ? databasePath : Path::Absolute(databasePath);
+		if(!m_database.Open(m_databasePath))
 		{
-			Logf("Failed to open database [%s]", Logger::Warning, databasePath);
+			Logf("Failed to open database [%s]", Logger::Warning, m_databasePath);
 			assert(false);
 		}
+		if(!m_database.EnableWAL())
+			Log("Failed to enable write-ahead logging for the map database", Logger::Warning);
 
 		bool rebuild = false;
 		bool update = false;
@@ -142,8 +201,9 @@ public:
 			}
 			if (gotVersion == 12) //upgrade from 12 to 13
 			{
-				//back up old db file
-				Path::Copy(Path::Absolute("maps.db"), Path::Absolute("maps.db_" + Shared::Time::Now().ToString() + ".bak"));
+				//back up old db file, the write-ahead log has to be merged first for the copy to be complete
+				m_database.Checkpoint();
+				Path::Copy(m_databasePath, m_databasePath + "_" + Shared::Time::Now().ToString() + ".bak");
 
 				int diffCount = 1;
 				{
@@ -251,30 +311,45 @@ public:
 
 				DBStatement addScore = m_database.Query("INSERT INTO Scores(score,crit,near,miss,gauge,gameflags,replay,timestamp,chart_hash) VALUES(?,?,?,?,?,?,?,?,?)");
 				
-				m_database.Exec("BEGIN");
-				for (ScoreIndex& score : scoresToAdd)
 				{
-					addScore.BindInt(1, score.score);
-					addScore.BindInt(2, score.crit);
-					addScore.BindInt(3, score.almost);
-					addScore.BindInt(4, score.miss);
-					addScore.BindDouble(5, score.gauge);
-					addScore.BindInt(6, score.gameflags);
-					addScore.BindString(7, score.replayPath);
-					addScore.BindInt64(8, score.timestamp);
-					addScore.BindString(9, score.chartHash);
-
-					addScore.Step();
-					addScore.Rewind();
-
-					if (progress % 16 == 0)
+					// Last batch is committed when this goes out of scope, VACUUM can not run inside a transaction
+					DBBatch batch(m_database, m_flushBatchSize);
+					for (ScoreIndex& score : scoresToAdd)
 					{
-						m_outer.OnDatabaseUpdateProgress.Call(progress, totalScoreCount);
+						addScore.BindInt(1, score.score);
+						addScore.BindInt(2, score.crit);
+						addScore.BindInt(3, score.almost);
+						addScore.BindInt(4, score.miss);
+						addScore.BindDouble(5, score.gauge);
+						addScore.BindInt(6, score.gameflags);
+						addScore.BindString(7, score.replayPath);
+						addScore.BindInt64(8, score.timestamp);
+						addScore.BindString(9, score.chartHash);
+
+						addScore.Step();
+						addScore.Rewind();
+						batch.Add();
+
+						if (progress % 16 == 0)
+						{
+							m_outer.OnDatabaseUpdateProgress.Call(progress, totalScoreCount);
+						}
+						progress++;
 					}
-					progress++;
 				}
-				m_database.Exec("END");
 				m_database.Exec("VACUUM");
+				gotVersion = 13;
+			}
+			if (gotVersion == 13) //upgrade from 13 to 14
+			{
+				m_database.Exec("CREATE TABLE IF NOT EXISTS DirectoryCache"
+					"(path TEXT PRIMARY KEY, lwt INTEGER, files BLOB, subfolders BLOB)");
+				gotVersion = 14;
+			}
+			if (gotVersion == 14) //upgrade from 14 to 15
+			{
+				m_database.Exec("CREATE INDEX IF NOT EXISTS ScoresByChart ON Scores(chart_hash, score)");
+				gotVersion = 15;
 			}
 			m_database.Exec(Utility::Sprintf("UPDATE Database SET `version`=%d WHERE `rowid`=1", m_version));
 
@@ -285,6 +360,8 @@ public:
 			// Load initial folder tree
 			m_LoadInitialData();
 		}
+
+		m_InitSearchIndex();
 	}
 	~MapDatabase_Impl()
 	{
@@ -298,9 +375,12 @@ public:
 			if(c.mapData)
 				delete c.mapData;
 		}
+
+		if(m_folderWatcher)
+			delete m_folderWatcher;
 	}
 
-	void StartSearching()
+	void StartSearching(bool fullScan)
 	{
 		if(m_searching)
 			return;
@@ -308,9 +388,30 @@ public:
 		if(m_thread.joinable())
 			m_thread.join();
 		// Apply previous diff to prevent duplicated entry 
-		Update();
+		m_ApplyChanges();
+		m_SaveFolderCache();
 		// Create initial data set to compare to when evaluating if a file is added/removed/updated
 		m_LoadInitialData();
+		if(fullScan)
+		{
+			// Forces every folder to be listed again
+			lock_guard<mutex> lock(m_folderCacheLock);
+			for(auto& f : m_folderCache)
+			{
+				f.second.lastWriteTime = 0;
+			}
+		}
+
+		if(m_watchFolders && !m_folderWatcher && FolderWatcher::IsSupported())
+		{
+			m_folderWatcher = new FolderWatcher();
+		}
+		else if(!m_watchFolders && m_folderWatcher)
+		{
+			delete m_folderWatcher;
+			m_folderWatcher = nullptr;
+		}
+
 		m_interruptSearch = false;
 		m_searching = true;
 		m_thread = thread(&MapDatabase_Impl::m_SearchThread, this);
@@ -324,6 +425,20 @@ public:
 			m_thread.join();
 		}
 	}
+	void WaitForSearch()
+	{
+		if(m_thread.joinable())
+		{
+			m_thread.join();
+		}
+		m_ApplyChanges();
+		m_SaveFolderCache();
+	}
+	MapDatabaseScanStats GetLastScanStats() const
+	{
+		lock_guard<mutex> lock(m_scanStatsLock);
+		return m_scanStats;
+	}
 	void AddSearchPath(const String& path)
 	{
 		String normalizedPath = Path::Normalize(Path::Absolute(path));
@@ -393,59 +508,65 @@ public:
 
 	Map<int32, FolderIndex*> FindFoldersByPath(const String& searchString)
 	{
-		String stmt = "SELECT DISTINCT folderId FROM Charts WHERE path LIKE \"%" + searchString + "%\"";
+		if(!m_useSearchIndex)
+			return m_FindFoldersLike("SELECT DISTINCT folderId FROM Charts WHERE path LIKE \"%" + searchString + "%\"");
 
-		Map<int32, FolderIndex*> res;
-		DBStatement search = m_database.Query(stmt);
-		while(search.StepRow())
+		// Everything matches an empty path
+		if(searchString.empty())
 		{
-			int32 id = search.IntColumn(0);
-			FolderIndex** folder = m_folders.Find(id);
-			if(folder)
+			Map<int32, FolderIndex*> res;
+			for(auto& folder : m_folders)
 			{
-				res.Add(id, *folder);
+				if(!folder.second->charts.empty())
+					res.Add(folder.first, folder.second);
 			}
+			return res;
 		}
 
-		return res;
+		// Match the path as a phrase, the last component can be incomplete
+		String phrase = m_MakeSearchPhrase(searchString);
+		if(phrase.empty())
+			return Map<int32, FolderIndex*>();
+		return m_FindFoldersIndexed("path : " + phrase + "*");
 	}
 	
 	Map<int32, FolderIndex*> FindFolders(const String& searchString)
 	{
-		WString test = Utility::ConvertToWString(searchString);
-		String stmt = "SELECT DISTINCT folderId FROM Charts WHERE";
-
-
-		//search.spl
-		Vector<String> terms = searchString.Explode(" ");
-		int32 i = 0;
-		for(auto term : terms)
+		if(!m_useSearchIndex)
 		{
-			if(i > 0)
-				stmt += " AND";
-			stmt += " (artist LIKE \"%" + term + "%\"" + 
-				" OR title LIKE \"%" + term + "%\"" +
-				" OR path LIKE \"%" + term + "%\"" +
-				" OR effector LIKE \"%" + term + "%\"" +
-				" OR artist_translit LIKE \"%" + term + "%\"" +
-				" OR title_translit LIKE \"%" + term + "%\")";
-			i++;
-		}
+			String stmt = "SELECT DISTINCT folderId FROM Charts WHERE";
 
-		Map<int32, FolderIndex*> res;
-		DBStatement search = m_database.Query(stmt);
-		while(search.StepRow())
-		{
-			int32 id = search.IntColumn(0);
-			FolderIndex** folder = m_folders.Find(id);
-			if(folder)
+			Vector<String> terms = searchString.Explode(" ");
+			int32 i = 0;
+			for(auto term : terms)
 			{
-				res.Add(id, *folder);
+				if(i > 0)
+					stmt += " AND";
+				stmt += " (artist LIKE \"%" + term + "%\"" + 
+					" OR title LIKE \"%" + term + "%\"" +
+					" OR path LIKE \"%" + term + "%\"" +
+					" OR effector LIKE \"%" + term + "%\"" +
+					" OR artist_translit LIKE \"%" + term + "%\"" +
+					" OR title_translit LIKE \"%" + term + "%\")";
+				i++;
 			}
+			return m_FindFoldersLike(stmt);
 		}
 
-
-		return res;
+		// Every term has to match the start of a word in any of the indexed columns
+		String match;
+		for(const String& term : searchString.Explode(" "))
+		{
+			String phrase = m_MakeSearchPhrase(term);
+			if(phrase.empty())
+				continue;
+			if(!match.empty())
+				match += " ";
+			match += phrase + "*";
+		}
+		if(match.empty())
+			return Map<int32, FolderIndex*>();
+		return m_FindFoldersIndexed(match);
 	}
 
 	Vector<String> GetCollections()
@@ -496,25 +617,89 @@ public:
 		csep[0] = Path::sep;
 		csep[1] = 0;
 		String sep(csep);
-		String stmt = "SELECT rowid FROM folders WHERE path LIKE \"%" + sep + folder + sep + "%\"";
 
-		Map<int32, FolderIndex*> res;
-		DBStatement search = m_database.Query(stmt);
-		while (search.StepRow())
+		String phrase = m_MakeSearchPhrase(folder);
+		if(!m_useSearchIndex || phrase.empty())
+			return m_FindFoldersLike("SELECT rowid FROM folders WHERE path LIKE \"%" + sep + folder + sep + "%\"");
+
+		// The index finds candidates containing the folder name, only keep the ones that have it as a path component
+		String component = sep + folder + sep;
+		Map<int32, FolderIndex*> res = m_FindFoldersIndexed("path : " + phrase);
+		for(auto it = res.begin(); it != res.end();)
 		{
-			int32 id = search.IntColumn(0);
-			FolderIndex** folder = m_folders.Find(id);
-			if (folder)
-			{
-				res.Add(id, *folder);
-			}
+			if((it->second->path + sep).find(component) == String::npos)
+				it = res.erase(it);
+			else
+				++it;
 		}
-
 		return res;
 	}
-	// Processes pending database changes
+	void SetScoreLimits(uint32 scoresPerChart, uint32 maxCachedScores)
+	{
+		// Drop everything that was loaded with the old limits
+		while (!m_scoreCache.empty())
+		{
+			m_TrimScores(m_scoreCache.back());
+		}
+		m_scoresPerChart = scoresPerChart;
+		m_maxCachedScores = maxCachedScores;
+	}
+	const Vector<ScoreIndex*>& GetScores(ChartIndex* chart)
+	{
+		if (chart->scoresComplete)
+		{
+			// Mark as recently used
+			auto it = std::find(m_scoreCache.begin(), m_scoreCache.end(), chart);
+			if (it != m_scoreCache.end())
+				m_scoreCache.splice(m_scoreCache.begin(), m_scoreCache, it);
+			return chart->scores;
+		}
+
+		// Same order as the initial load, so the scores that are already loaded can be skipped
+		DBStatement scoreScan = m_database.Query("SELECT rowid,score,crit,near,miss,gauge,gameflags,replay,timestamp FROM Scores WHERE chart_hash=? ORDER BY score DESC, rowid");
+		scoreScan.BindString(1, chart->hash);
+		size_t numLoaded = chart->scores.size();
+		for (size_t i = 0; scoreScan.StepRow(); i++)
+		{
+			if (i < numLoaded)
+				continue;
+			ScoreIndex* score = m_ReadScore(scoreScan);
+			score->chartHash = chart->hash;
+			chart->scores.Add(score);
+			m_numCachedScores++;
+		}
+		chart->scoresComplete = true;
+		m_scoreCache.AddFront(chart);
+
+		// Free the scores of the least recently used charts
+		while (m_numCachedScores > m_maxCachedScores && m_scoreCache.back() != chart)
+		{
+			m_TrimScores(m_scoreCache.back());
+		}
+
+		return chart->scores;
+	}
+
 	void Update()
 	{
+		m_ApplyChanges();
+		m_SaveFolderCache();
+		m_PollFolderWatcher();
+	}
+
+	// Processes pending database changes
+	void m_ApplyChanges()
+	{
+		if(m_searching && m_lastFlush.Milliseconds() < m_flushInterval)
+		{
+			m_pendingChangesLock.lock();
+			size_t numPending = m_pendingChanges.size();
+			m_pendingChangesLock.unlock();
+			if(numPending < m_flushBatchSize)
+				return;
+		}
+		m_lastFlush.Restart();
+
 		List<Event> changes = FlushChanges();
 		if(changes.empty())
 			return;
@@ -528,7 +713,7 @@ public:
 			"diff_name=?,diff_shortname=?,bpm=?,diff_index=?,level=?,hash=?,preview_file=?,preview_offset=?,preview_length=?,lwt=? WHERE rowid=?"); //TODO: update
 		DBStatement removeChart = m_database.Query("DELETE FROM Charts WHERE rowid=?");
 		DBStatement removeFolder = m_database.Query("DELETE FROM Folders WHERE rowid=?");
-		DBStatement scoreScan = m_database.Query("SELECT rowid,score,crit,near,miss,gauge,gameflags,replay,timestamp FROM Scores WHERE chart_hash=?");
+		DBStatement scoreScan = m_database.Query("SELECT rowid,score,crit,near,miss,gauge,gameflags,replay,timestamp FROM Scores WHERE chart_hash=? ORDER BY score DESC, rowid");
 
 		Set<FolderIndex*> addedEvents;
 		Set<FolderIndex*> removeEvents;
@@ -537,7 +722,7 @@ public:
 		const String diffShortNames[4] = { "NOV", "ADV", "EXH", "INF" };
 		const String diffNames[4] = { "Novice", "Advanced", "Exhaust", "Infinite" };
 
-		m_database.Exec("BEGIN");
+		m_database.BeginTransaction();
 		for(Event& e : changes)
 		{
 			if(e.action == Event::Added)
@@ -551,7 +736,7 @@ public:
 				if(folderIt == m_foldersByPath.end())
 				{
 					// Add folder
-					folder = new FolderIndex();
+					folder = m_folderPool.Create();
 					folder->id = m_nextFolderId++;
 					folder->path = folderPath;
 					folder->selectId = m_folders.size();
@@ -573,7 +758,7 @@ public:
 				}
 
 
-				ChartIndex* chart = new ChartIndex();
+				ChartIndex* chart = m_chartPool.Create();
 				chart->id = m_nextChartId++;
 				chart->lwt = e.lwt;
 				chart->folderId = folder->id;
@@ -597,24 +782,22 @@ public:
 				scoreScan.BindString(1, chart->hash);
 				while (scoreScan.StepRow())
 				{
-					ScoreIndex* score = new ScoreIndex();
-					score->id = scoreScan.IntColumn(0);
-					score->score = scoreScan.IntColumn(1);
-					score->crit = scoreScan.IntColumn(2);
-					score->almost = scoreScan.IntColumn(3);
-					score->miss = scoreScan.IntColumn(4);
-					score->gauge = scoreScan.DoubleColumn(5);
-					score->gameflags = scoreScan.IntColumn(6);
-					score->replayPath = scoreScan.StringColumn(7);
-
-					score->timestamp = scoreScan.Int64Column(8);
+					if (m_scoresPerChart > 0 && chart->scores.size() >= m_scoresPerChart)
+					{
+						// Not loaded, but still counts for the top score and badge
+						ScoreIndex score;
+						m_ReadScoreColumns(scoreScan, score);
+						m_AddToTopScore(chart, score);
+						chart->scoresComplete = false;
+						continue;
+					}
+					ScoreIndex* score = m_ReadScore(scoreScan);
 					score->chartHash = chart->hash;
 					chart->scores.Add(score);
+					m_AddToTopScore(chart, *score);
 				}
 				scoreScan.Rewind();
 
-				m_SortScores(chart);
-
 
 				m_charts.Add(chart->id, chart);
 				m_chartsByHash.Add(chart->hash, chart);
@@ -719,12 +902,12 @@ public:
 
 				itFolder->second->charts.Remove(itChart->second);
 
-				for (auto s : itChart->second->scores)
-				{
-					delete s;
-				}
-				itChart->second->scores.clear();
-				delete itChart->second;
+				auto itHash = m_chartsByHash.find(itChart->second->hash);
+				if (itHash != m_chartsByHash.end() && itHash->second == itChart->second)
+					m_chartsByHash.erase(itHash);
+
+				m_TrimScores(itChart->second);
+				m_DestroyChart(itChart->second);
 				m_charts.erase(e.id);
 
 				// Remove diff in db
@@ -751,7 +934,7 @@ public:
 			if(e.mapData)
 				delete e.mapData;
 		}
-		m_database.Exec("END");
+		m_database.CommitTransaction();
 
 		// Fire events
 		if(!removeEvents.empty())
@@ -768,7 +951,7 @@ public:
 			m_outer.OnFoldersRemoved.Call(eventsArray);
 			for(auto e : eventsArray)
 			{
-				delete e;
+				m_folderPool.Destroy(e);
 			}
 		}
 		if(!addedEvents.empty())
@@ -808,9 +991,7 @@ public:
 			fw.SerializeObject(simpleHitStats);
 		}
 
-		m_database.Exec("BEGIN");
-
-		
+		m_database.BeginTransaction();
 
 		addScore.BindInt(1, score);
 		addScore.BindInt(2, crit);
@@ -825,14 +1006,13 @@ public:
 		addScore.Step();
 		addScore.Rewind();
 
-		m_database.Exec("END");
-
+		m_database.CommitTransaction();
 	}
 
 	void AddOrRemoveToCollection(const String& name, int32 mapid)
 	{
 		DBStatement addColl = m_database.Query("INSERT INTO Collections(folderid,collection) VALUES(?,?)");
-		m_database.Exec("BEGIN");
+		m_database.BeginTransaction();
 
 		addColl.BindInt(1, mapid);
 		addColl.BindString(2, name);
@@ -840,7 +1020,7 @@ public:
 		bool result = addColl.Step();
 		addColl.Rewind();
 
-		m_database.Exec("END");
+		m_database.CommitTransaction();
 
 		if (!result) //Failed to add, try to remove
 		{
@@ -861,26 +1041,108 @@ private:
 	{
 		for(auto m : m_folders)
 		{
-			delete m.second;
+			m_folderPool.Destroy(m.second);
 		}
 		for(auto m : m_charts)
 		{
-			for (auto s : m.second->scores)
-			{
-				delete s;
-			}
-			m.second->scores.clear();
-			delete m.second;
+			m_DestroyChart(m.second);
 		}
 		m_folders.clear();
 		m_charts.clear();
+		m_foldersByPath.clear();
+		m_chartsByHash.clear();
+		m_scoreCache.clear();
+		m_numCachedScores = 0;
+	}
+	// Turns user input into a quoted FTS5 string, empty if it contains nothing to search for
+	static String m_MakeSearchPhrase(const String& text)
+	{
+		bool hasToken = false;
+		String phrase = "\"";
+		for(char c : text)
+		{
+			// The tokenizer ignores ASCII punctuation and whitespace, everything else can be matched
+			if(isalnum((uint8)c) || (uint8)c >= 0x80)
+				hasToken = true;
+			if(c == '"')
+				phrase += "\"\"";
+			else
+				phrase.push_back(c);
+		}
+		if(!hasToken)
+			return String();
+		return phrase + "\"";
+	}
+	Map<int32, FolderIndex*> m_FindFoldersIndexed(const String& match)
+	{
+		Map<int32, FolderIndex*> res;
+		DBStatement search = m_database.Query("SELECT rowid FROM ChartSearch WHERE ChartSearch MATCH ?");
+		search.BindString(1, match);
+		while(search.StepRow())
+		{
+			ChartIndex** chart = m_charts.Find(search.IntColumn(0));
+			if(!chart)
+				continue;
+			FolderIndex** folder = m_folders.Find((*chart)->folderId);
+			if(folder)
+			{
+				res.Add((*folder)->id, *folder);
+			}
+		}
+		return res;
+	}
+	Map<int32, FolderIndex*> m_FindFoldersLike(const String& stmt)
+	{
+		Map<int32, FolderIndex*> res;
+		DBStatement search = m_database.Query(stmt);
+		while(search.StepRow())
+		{
+			int32 id = search.IntColumn(0);
+			FolderIndex** folder = m_folders.Find(id);
+			if(folder)
+			{
+				res.Add(id, *folder);
+			}
+		}
+		return res;
+	}
+	// Creates the search index if it is missing, filled from the existing charts
+	//	triggers on the Charts table keep it in sync with the changes applied from scans
+	void m_InitSearchIndex()
+	{
+		DBStatement exists = m_database.Query("SELECT COUNT(*) FROM sqlite_master WHERE name='ChartSearch'");
+		bool hasIndex = exists.StepRow() && exists.IntColumn(0) > 0;
+		exists.Finish();
+		if(!hasIndex)
+		{
+			if(!m_database.ExecDirect("CREATE VIRTUAL TABLE ChartSearch USING fts5"
+				"(title, artist, title_translit, artist_translit, effector, path, tokenize='unicode61')"))
+			{
+				Log("FTS5 is not available, song search will be slow", Logger::Warning);
+				m_useSearchIndex = false;
+				return;
+			}
+			m_database.Exec("INSERT INTO ChartSearch(rowid,title,artist,title_translit,artist_translit,effector,path) "
+				"SELECT rowid,title,artist,title_translit,artist_translit,effector,path FROM Charts");
+		}
+
+		const String insertRow = "INSERT INTO ChartSearch(rowid,title,artist,title_translit,artist_translit,effector,path) "
+			"VALUES(new.rowid,new.title,new.artist,new.title_translit,new.artist_translit,new.effector,new.path);";
+		const String deleteRow = "DELETE FROM ChartSearch WHERE rowid=old.rowid;";
+		m_database.Exec("CREATE TRIGGER IF NOT EXISTS ChartSearchInsert AFTER INSERT ON Charts BEGIN " + insertRow + " END");
+		m_database.Exec("CREATE TRIGGER IF NOT EXISTS ChartSearchDelete AFTER DELETE ON Charts BEGIN " + deleteRow + " END");
+		m_database.Exec("CREATE TRIGGER IF NOT EXISTS ChartSearchUpdate AFTER UPDATE ON Charts BEGIN " + deleteRow + " " + insertRow + " END");
+		m_useSearchIndex = true;
 	}
+
 	void m_CreateTables()
 	{
 		m_database.Exec("DROP TABLE IF EXISTS Folders");
 		m_database.Exec("DROP TABLE IF EXISTS Charts");
 		m_database.Exec("DROP TABLE IF EXISTS Scores");
 		m_database.Exec("DROP TABLE IF EXISTS Collections");
+		m_database.Exec("DROP TABLE IF EXISTS DirectoryCache");
+		m_database.Exec("DROP TABLE IF EXISTS ChartSearch");
 
 		m_database.Exec("CREATE TABLE Folders"
 			"(path TEXT)");
@@ -918,10 +1180,15 @@ private:
 			"replay TEXT,"
 			"chart_hash TEXT)");
 
+		m_database.Exec("CREATE INDEX ScoresByChart ON Scores(chart_hash, score)");
+
 		m_database.Exec("CREATE TABLE Collections"
 			"(collection TEXT, folderid INTEGER, "
 			"UNIQUE(collection,folderid), "
 			"FOREIGN KEY(folderid) REFERENCES Folders(rowid))");
+
+		m_database.Exec("CREATE TABLE DirectoryCache"
+			"(path TEXT PRIMARY KEY, lwt INTEGER, files BLOB, subfolders BLOB)");
 	}
 	void m_LoadInitialData()
 	{
@@ -937,7 +1204,7 @@ private:
 		DBStatement mapScan = m_database.Query("SELECT rowid, path FROM Folders");
 		while(mapScan.StepRow())
 		{
-			FolderIndex* folder = new FolderIndex();
+			FolderIndex* folder = m_folderPool.Create();
 			folder->id = mapScan.IntColumn(0);
 			folder->path = mapScan.StringColumn(1);
 			folder->selectId = m_folders.size();
@@ -970,7 +1237,7 @@ private:
 			"FROM Charts");
 		while(chartScan.StepRow())
 		{
-			ChartIndex* chart = new ChartIndex();
+			ChartIndex* chart = m_chartPool.Create();
 			chart->id = chartScan.IntColumn(0);
 			chart->folderId = chartScan.IntColumn(1);
 			chart->path = chartScan.StringColumn(2);
@@ -1016,40 +1283,228 @@ private:
 			m_searchState.difficulties.Add(chart->path, ed);
 		}
 
-		// Select Scores
-		DBStatement scoreScan = m_database.Query("SELECT rowid,score,crit,near,miss,gauge,gameflags,replay,timestamp,chart_hash FROM Scores");
-		
+		// Select Scores, grouped by chart and sorted from best to worst
+		DBStatement scoreScan = m_database.Query("SELECT rowid,score,crit,near,miss,gauge,gameflags,replay,timestamp,chart_hash FROM Scores ORDER BY chart_hash, score DESC, rowid");
+		String scoreHash;
+		ChartIndex* scoreChart = nullptr;
 		while (scoreScan.StepRow())
 		{
-			ScoreIndex* score = new ScoreIndex();
-			score->id = scoreScan.IntColumn(0);
-			score->score = scoreScan.IntColumn(1);
-			score->crit = scoreScan.IntColumn(2);
-			score->almost = scoreScan.IntColumn(3);
-			score->miss = scoreScan.IntColumn(4);
-			score->gauge = scoreScan.DoubleColumn(5);
-			score->gameflags = scoreScan.IntColumn(6);
-			score->replayPath = scoreScan.StringColumn(7);
-
-			score->timestamp = scoreScan.Int64Column(8);
-			score->chartHash = scoreScan.StringColumn(9);
+			String hash = scoreScan.StringColumn(9);
+			if (!scoreChart || hash != scoreHash)
+			{
+				scoreHash = hash;
+				auto diffIt = m_chartsByHash.find(hash);
+				// If for whatever reason the diff that the score is attatched to is not in the db, ignore the score.
+				scoreChart = diffIt == m_chartsByHash.end() ? nullptr : diffIt->second;
+			}
+			if (!scoreChart)
+				continue;
 
-			// Add difficulty to map and resort difficulties
-			auto diffIt = m_chartsByHash.find(score->chartHash);
-			if (diffIt == m_chartsByHash.end()) // If for whatever reason the diff that the score is attatched to is not in the db, ignore the score.
+			// Only keep the best scores, the rest is loaded when needed
+			if (m_scoresPerChart > 0 && scoreChart->scores.size() >= m_scoresPerChart)
 			{
-				delete score;
+				// Not loaded, but still counts for the top score and badge
+				ScoreIndex score;
+				m_ReadScoreColumns(scoreScan, score);
+				m_AddToTopScore(scoreChart, score);
+				scoreChart->scoresComplete = false;
 				continue;
 			}
 
-			diffIt->second->scores.Add(score);
-			m_SortScores(diffIt->second);
+			ScoreIndex* score = m_ReadScore(scoreScan);
+			score->chartHash = hash;
+			scoreChart->scores.Add(score);
+			m_AddToTopScore(scoreChart, *score);
 		}
 
+		// Select cached folder listings
+		{
+			lock_guard<mutex> folderCacheLock(m_folderCacheLock);
+			m_folderCache.clear();
+			DBStatement folderCacheScan = m_database.Query("SELECT path,lwt,files,subfolders FROM DirectoryCache");
+			while(folderCacheScan.StepRow())
+			{
+				FolderScanCache& entry = m_folderCache.FindOrAdd(folderCacheScan.StringColumn(0));
+				entry.lastWriteTime = folderCacheScan.Int64Column(1);
+
+				Buffer files = folderCacheScan.BlobColumn(2);
+				MemoryReader filesReader(files);
+				uint32 numFiles = 0;
+				filesReader << numFiles;
+				for(uint32 i = 0; i < numFiles; i++)
+				{
+					FileInfo info;
+					info.type = FileType::Regular;
+					filesReader << info.fullPath;
+					filesReader << info.lastWriteTime;
+					entry.files.Add(info);
+				}
 
+				Buffer subFolders = folderCacheScan.BlobColumn(3);
+				MemoryReader subFoldersReader(subFolders);
+				subFoldersReader << entry.subFolders;
+			}
+		}
 
 		m_outer.OnFoldersCleared.Call(m_folders);
 	}
+	// Writes folders changed by the last scan to the database
+	void m_SaveFolderCache()
+	{
+		Vector<String> updatedFolders;
+		Vector<String> removedFolders;
+		m_pendingChangesLock.lock();
+		bool dirty = m_folderCacheDirty;
+		m_folderCacheDirty = false;
+		updatedFolders = std::move(m_folderCacheUpdated);
+		removedFolders = std::move(m_folderCacheRemoved);
+		m_pendingChangesLock.unlock();
+		if(!dirty)
+			return;
+
+		DBStatement addFolder = m_database.Query("INSERT OR REPLACE INTO DirectoryCache(path,lwt,files,subfolders) VALUES(?,?,?,?)");
+		DBStatement removeFolder = m_database.Query("DELETE FROM DirectoryCache WHERE path=?");
+
+		DBBatch batch(m_database, m_flushBatchSize);
+		lock_guard<mutex> lock(m_folderCacheLock);
+		for(String& path : updatedFolders)
+		{
+			FolderScanCache* entry = m_folderCache.Find(path);
+			if(!entry)
+				continue;
+
+			Buffer files;
+			MemoryWriter filesWriter(files);
+			uint32 numFiles = (uint32)entry->files.size();
+			filesWriter << numFiles;
+			for(FileInfo& info : entry->files)
+			{
+				filesWriter << info.fullPath;
+				filesWriter << info.lastWriteTime;
+			}
+
+			Buffer subFolders;
+			MemoryWriter subFoldersWriter(subFolders);
+			subFoldersWriter << entry->subFolders;
+
+			addFolder.BindString(1, path);
+			addFolder.BindInt64(2, entry->lastWriteTime);
+			addFolder.BindBlob(3, files);
+			addFolder.BindBlob(4, subFolders);
+			addFolder.Step();
+			addFolder.Rewind();
+			batch.Add();
+		}
+		for(String& path : removedFolders)
+		{
+			removeFolder.BindString(1, path);
+			removeFolder.Step();
+			removeFolder.Rewind();
+			batch.Add();
+		}
+	}
+
+	// Turns changes reported by the folder watcher into events, charts that need parsing are handled on the search thread
+	void m_PollFolderWatcher()
+	{
+		if(!m_folderWatcher || m_searching || m_parsingWatched)
+			return;
+
+		// Wait until all events of the previous poll are applied, otherwise charts could be added twice
+		m_pendingChangesLock.lock();
+		bool pendingChanges = !m_pendingChanges.empty();
+		m_pendingChangesLock.unlock();
+		if(pendingChanges)
+			return;
+
+		Vector<FolderWatcher::Change> changes = m_folderWatcher->Poll();
+		if(changes.empty())
+			return;
+
+		Map<String, ChartIndex*> chartsByPath;
+		for(auto& c : m_charts)
+		{
+			chartsByPath.Add(c.second->path, c.second);
+		}
+
+		// Latest event per chart path
+		Map<String, Event> chartEvents;
+		for(FolderWatcher::Change& change : changes)
+		{
+			if(change.action == FolderWatcher::Change::Removed)
+			{
+				// Remove the chart or all the charts inside of a removed folder
+				String prefix = change.path + Path::sep;
+				for(auto& c : chartsByPath)
+				{
+					if(c.first == change.path || (change.isFolder && c.first.compare(0, prefix.size(), prefix) == 0))
+					{
+						Event& evt = chartEvents.FindOrAdd(c.first);
+						evt.action = Event::Removed;
+						evt.path = c.first;
+						evt.id = c.second->id;
+					}
+				}
+				if(!change.isFolder && !chartsByPath.Contains(change.path))
+					chartEvents.erase(change.path);
+			}
+			else if(!change.isFolder && Path::GetExtension(change.path) == "ksh")
+			{
+				Event& evt = chartEvents.FindOrAdd(change.path);
+				evt.path = change.path;
+				evt.lwt = File::GetLastWriteTime(change.path);
+				ChartIndex** existing = chartsByPath.Find(change.path);
+				if(existing)
+				{
+					evt.action = Event::Updated;
+					evt.id = (*existing)->id;
+				}
+				else
+				{
+					evt.action = Event::Added;
+				}
+			}
+		}
+
+		Vector<Event> parseEvents;
+		for(auto& e : chartEvents)
+		{
+			if(e.second.action == Event::Removed)
+				AddChange(e.second);
+			else
+				parseEvents.Add(e.second);
+		}
+		if(parseEvents.empty())
+			return;
+
+		if(m_thread.joinable())
+			m_thread.join();
+		m_interruptSearch = false;
+		m_parsingWatched = true;
+		m_thread = thread(&MapDatabase_Impl::m_WatchedChartsThread, this, std::move(parseEvents));
+	}
+
+	// Parses charts reported by the folder watcher
+	void m_WatchedChartsThread(Vector<Event> events)
+	{
+		for(Event& evt : events)
+		{
+			if(m_interruptSearch)
+				break;
+
+			if(!m_ParseAndHashChart(evt.path, evt.mapData, evt.hash))
+			{
+				if(evt.action == Event::Added)
+					continue;
+				// Invalid maps get removed from the database
+				evt.action = Event::Removed;
+			}
+			Logf("Discovered Chart [%s]", Logger::Info, evt.path);
+			AddChange(evt);
+		}
+		m_parsingWatched = false;
+	}
+
 	void m_SortCharts(FolderIndex* folderIndex)
 	{
 		folderIndex->charts.Sort([](ChartIndex* a, ChartIndex* b)
@@ -1060,25 +1515,112 @@ private:
 		});
 	}
 
-	void m_SortScores(ChartIndex* diffIndex)
+	// Reads the columns rowid,score,crit,near,miss,gauge,gameflags,replay,timestamp from a score query
+	ScoreIndex* m_ReadScore(DBStatement& scoreScan)
+	{
+		ScoreIndex* score = m_scorePool.Create();
+		m_ReadScoreColumns(scoreScan, *score);
+		score->replayPath = scoreScan.StringColumn(7);
+		return score;
+	}
+	// Same as m_ReadScore, without the replay path
+	static void m_ReadScoreColumns(DBStatement& scoreScan, ScoreIndex& score)
+	{
+		score.id = scoreScan.IntColumn(0);
+		score.score = scoreScan.IntColumn(1);
+		score.crit = scoreScan.IntColumn(2);
+		score.almost = scoreScan.IntColumn(3);
+		score.miss = scoreScan.IntColumn(4);
+		score.gauge = scoreScan.DoubleColumn(5);
+		score.gameflags = scoreScan.IntColumn(6);
+		score.timestamp = scoreScan.Int64Column(8);
+	}
+	void m_AddToTopScore(ChartIndex* chart, const ScoreIndex& score)
+	{
+		chart->topScore = Math::Max(chart->topScore, score.score);
+		if (m_badgeFunction)
+			chart->topBadge = Math::Max(chart->topBadge, m_badgeFunction(score));
+	}
+
+	void m_DestroyChart(ChartIndex* chart)
 	{
-		diffIndex->scores.Sort([](ScoreIndex* a, ScoreIndex* b)
+		for (auto s : chart->scores)
 		{
-			return a->score > b->score;
-		});
+			m_scorePool.Destroy(s);
+		}
+		m_chartPool.Destroy(chart);
+	}
+
+	// Frees the scores of a chart that were loaded by GetScores, keeping the best ones
+	void m_TrimScores(ChartIndex* chart)
+	{
+		auto it = std::find(m_scoreCache.begin(), m_scoreCache.end(), chart);
+		if (it == m_scoreCache.end())
+			return;
+		m_scoreCache.erase(it);
+
+		for (size_t i = m_scoresPerChart; i < chart->scores.size(); i++)
+		{
+			m_scorePool.Destroy(chart->scores[i]);
+			m_numCachedScores--;
+		}
+		chart->scores.resize(m_scoresPerChart);
+		chart->scoresComplete = false;
+	}
+
+	// Reads a chart file into memory once, then parses its metadata and hashes it from the same buffer
+	//	returns false if the file could not be read or is not a valid chart
+	static bool m_ParseAndHashChart(const String& path, BeatmapSettings*& outSettings, String& outHash)
+	{
+		Buffer chartData;
+		{
+			File fileStream;
+			if(!fileStream.OpenRead(path))
+				return false;
+			chartData.resize(fileStream.GetSize());
+			if(fileStream.Read(chartData.data(), chartData.size()) != chartData.size())
+				return false;
+		}
+
+		Beatmap map;
+		MemoryReader reader(chartData);
+		if(!map.Load(reader, true))
+			return false;
+
+		uint32_t digest[5];
+		sha1::SHA1 s;
+		s.processBytes(chartData.data(), chartData.size());
+		s.getDigest(digest);
+
+		outSettings = new BeatmapSettings(map.GetMapSettings());
+		outHash = Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
+		return true;
 	}
 
 	// Main search thread
+	//	Enumerate -> Process removed files -> Parse+hash on a worker pool -> Emit events in enumeration order
 	void m_SearchThread()
 	{
 		Map<String, FileInfo> fileList;
+		MapDatabaseScanStats stats;
 
 		{
 			ProfilerScope $("Chart Database - Enumerate Files and Folders");
+			Timer stageTimer;
 			m_outer.OnSearchStatusUpdated.Call("[START] Chart Database - Enumerate Files and Folders");
+			m_folderCacheLock.lock();
+			Map<String, FolderScanCache> folderCache = m_folderCache;
+			m_folderCacheLock.unlock();
+
+			Map<String, uint64> previousFolders;
+			for(auto& f : folderCache)
+			{
+				previousFolders.Add(f.first, f.second.lastWriteTime);
+			}
+
 			for(String rootSearchPath : m_searchPaths)
 			{
-				Vector<FileInfo> files = Files::ScanFilesRecursive(rootSearchPath, "ksh", &m_interruptSearch);
+				Vector<FileInfo> files = Files::ScanFilesRecursiveCached(rootSearchPath, folderCache, "ksh", &m_interruptSearch);
 				if(m_interruptSearch)
 					return;
 				for(FileInfo& fi : files)
@@ -1086,11 +1628,59 @@ private:
 					fileList.Add(fi.fullPath, fi);
 				}
 			}
+
+			// Drop folders of search paths that were removed
+			for(auto it = folderCache.begin(); it != folderCache.end();)
+			{
+				bool inSearchPath = false;
+				for(const String& rootSearchPath : m_searchPaths)
+				{
+					String rootPrefix = rootSearchPath + Path::sep;
+					if(it->first == rootSearchPath || it->first.compare(0, rootPrefix.size(), rootPrefix) == 0)
+					{
+						inSearchPath = true;
+						break;
+					}
+				}
+				if(inSearchPath)
+					++it;
+				else
+					it = folderCache.erase(it);
+			}
+
+			// Collect folders that need to be written to the database
+			Vector<String> updatedFolders;
+			Vector<String> removedFolders;
+			for(auto& f : folderCache)
+			{
+				uint64* previous = previousFolders.Find(f.first);
+				if(!previous || *previous != f.second.lastWriteTime)
+					updatedFolders.Add(f.first);
+			}
+			for(auto& f : previousFolders)
+			{
+				if(!folderCache.Contains(f.first))
+					removedFolders.Add(f.first);
+			}
+			m_folderCacheLock.lock();
+			m_folderCache = std::move(folderCache);
+			m_folderCacheLock.unlock();
+			if(!updatedFolders.empty() || !removedFolders.empty())
+			{
+				m_pendingChangesLock.lock();
+				m_folderCacheUpdated = std::move(updatedFolders);
+				m_folderCacheRemoved = std::move(removedFolders);
+				m_folderCacheDirty = true;
+				m_pendingChangesLock.unlock();
+			}
+			stats.numFiles = (uint32)fileList.size();
+			stats.enumerateTime = stageTimer.Milliseconds();
 			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Enumerate Files and Folders");
 		}
 
 		{
 			ProfilerScope $("Chart Database - Process Removed Files");
+			Timer stageTimer;
 			m_outer.OnSearchStatusUpdated.Call("[START] Chart Database - Process Removed Files");
 			// Process scanned files
 			for(auto f : m_searchState.difficulties)
@@ -1104,103 +1694,153 @@ private:
 					AddChange(evt);
 				}
 			}
+			stats.removedTime = stageTimer.Milliseconds();
 			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Process Removed Files");
 		}
 
 		{
 			ProfilerScope $("Chart Database - Process New Files");
+			Timer stageTimer;
 			m_outer.OnSearchStatusUpdated.Call("[START] Chart Database - Process New Files");
-			// Process scanned files
-			for(auto f : fileList)
-			{
-				if(!m_searching)
-					break;
 
-				uint64 mylwt = f.second.lastWriteTime;
+			// A new or changed chart, parsed and hashed by one of the workers
+			struct ScanItem
+			{
 				Event evt;
-				evt.lwt = mylwt;
+				bool existing = false;
+				bool valid = false;
+				bool done = false;
+			};
+
+			// Collect the files that need to be (re)parsed
+			Vector<ScanItem> items;
+			for(auto& f : fileList)
+			{
+				ScanItem item;
+				item.evt.lwt = f.second.lastWriteTime;
+				item.evt.path = f.first;
 
 				SearchState::ExistingDifficulty* existing = m_searchState.difficulties.Find(f.first);
 				if(existing)
 				{
-					evt.id = existing->id;
-					if(existing->lwt != mylwt)
-					{
-						// Map Updated
-						evt.action = Event::Updated;
-					}
-					else
-					{
-						// Skip, not changed
+					// Skip, not changed
+					if(existing->lwt == item.evt.lwt)
 						continue;
-					}
+
+					// Map Updated
+					item.evt.id = existing->id;
+					item.evt.action = Event::Updated;
+					item.existing = true;
 				}
 				else
 				{
 					// Map added
-					evt.action = Event::Added;
+					item.evt.action = Event::Added;
 				}
+				items.push_back(std::move(item));
+			}
 
-				Logf("Discovered Chart [%s]", Logger::Info, f.first);
-				m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Discovered Chart [%s]", f.first));
-				// Try to read map metadata
-				bool mapValid = false;
-				File fileStream;
-				Beatmap map;
-				if(fileStream.OpenRead(f.first))
+			// Parse and hash on a worker pool, items are claimed in order so they complete roughly in order
+			mutex itemsLock;
+			condition_variable itemDone;
+			atomic<size_t> nextItem(0);
+			auto worker = [&]()
+			{
+				while(m_searching)
 				{
-					FileReader reader(fileStream);
+					size_t i = nextItem++;
+					if(i >= items.size())
+						break;
 
-					if(map.Load(reader, true))
-					{
-						mapValid = true;
-					}
+					ScanItem& item = items[i];
+					item.valid = m_ParseAndHashChart(item.evt.path, item.evt.mapData, item.evt.hash);
+
+					itemsLock.lock();
+					item.done = true;
+					itemsLock.unlock();
+					itemDone.notify_all();
 				}
+				// Wake up the emitter in case the search got interrupted
+				itemDone.notify_all();
+			};
+
+			size_t numWorkers = Math::Clamp<size_t>(thread::hardware_concurrency(), 1, Math::Max<size_t>(items.size(), 1));
+			Vector<thread> workers;
+			for(size_t i = 0; i < numWorkers; i++)
+			{
+				workers.emplace_back(worker);
+			}
 
-				if(mapValid)
+			// Emit events in enumeration order as soon as they are ready
+			size_t numEmitted = 0;
+			for(; numEmitted < items.size(); numEmitted++)
+			{
+				ScanItem& item = items[numEmitted];
 				{
-					fileStream.Seek(0);
-					evt.mapData = new BeatmapSettings(map.GetMapSettings());
+					unique_lock<mutex> lock(itemsLock);
+					itemDone.wait(lock, [&]() { return item.done || !m_searching; });
+					if(!item.done)
+						break;
+				}
 
-					ProfilerScope $("Chart Database - Hash Chart");
-					char data_buffer[0x80];
-					uint32_t digest[5];
-					sha1::SHA1 s;
+				Logf("Discovered Chart [%s]", Logger::Info, item.evt.path);
+				m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Discovered Chart [%s]", item.evt.path));
 
-					size_t amount_read = 0;
-					size_t read_size;
-					do
+				if(!item.valid)
+				{
+					if(item.evt.mapData)
 					{
-						read_size = fileStream.Read(data_buffer, sizeof(data_buffer));
-						amount_read += read_size;
-						s.processBytes(data_buffer, read_size);
+						delete item.evt.mapData;
+						item.evt.mapData = nullptr;
 					}
-					while (read_size != 0);
-						
-					s.getDigest(digest);
-
-					evt.hash = Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
-				}
-
-				if (!mapValid)
-				{
-					if(!existing) // Never added
+					if(!item.existing) // Never added
 					{
-						Logf("Skipping corrupted chart [%s]", Logger::Warning, f.first);
-						m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Skipping corrupted chart [%s]", f.first));
-						if(evt.mapData)
-							delete evt.mapData;
+						Logf("Skipping corrupted chart [%s]", Logger::Warning, item.evt.path);
+						m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Skipping corrupted chart [%s]", item.evt.path));
 						continue;
 					}
 					// Invalid maps get removed from the database
-					evt.action = Event::Removed;
+					item.evt.action = Event::Removed;
 				}
-				evt.path = f.first;
-				AddChange(evt);
-				continue;
+				AddChange(item.evt);
+				item.evt.mapData = nullptr; // Owned by the event queue now
+			}
+
+			for(thread& t : workers)
+			{
+				t.join();
+			}
+
+			// Discard results that were not emitted due to an interrupted search
+			for(ScanItem& item : items)
+			{
+				if(item.evt.mapData)
+					delete item.evt.mapData;
 			}
+
+			stats.numWorkers = (uint32)numWorkers;
+			stats.numProcessed = (uint32)numEmitted;
+			stats.processTime = stageTimer.Milliseconds();
 			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Process New Files");
 		}
+
+		Logf("Chart Database - Processed %d charts on %d threads (%.1f charts/s)", Logger::Info,
+			stats.numProcessed, stats.numWorkers, stats.GetChartsPerSecond());
+		m_scanStatsLock.lock();
+		m_scanStats = stats;
+		m_scanStatsLock.unlock();
+
+		if(m_folderWatcher && m_searching)
+		{
+			// Clearing also discards changes that happened during the scan
+			m_folderWatcher->Clear();
+			lock_guard<mutex> lock(m_folderCacheLock);
+			for(auto& f : m_folderCache)
+			{
+				m_folderWatcher->AddFolder(f.first, false);
+			}
+		}
+
 		m_outer.OnSearchStatusUpdated.Call("");
 		m_searching = false;
 	}
@@ -1209,18 +1849,17 @@ private:
 void MapDatabase::FinishInit()
 {
 	assert(!m_impl);
-	m_impl = new MapDatabase_Impl(*this);
+	m_impl = new MapDatabase_Impl(*this, m_databasePath, m_scoresPerChart, m_maxCachedScores, m_badgeFunction);
 }
-MapDatabase::MapDatabase(bool postponeInit)
+MapDatabase::MapDatabase(bool postponeInit, const String& databasePath) : m_databasePath(databasePath)
 {
+	m_impl = NULL;
 	if (!postponeInit)
 		FinishInit();
-	else
-		m_impl = NULL;
 }
-MapDatabase::MapDatabase()
+MapDatabase::MapDatabase() : m_databasePath("maps.db")
 {
-	m_impl = new MapDatabase_Impl(*this);
+	m_impl = new MapDatabase_Impl(*this, m_databasePath, m_scoresPerChart, m_maxCachedScores, m_badgeFunction);
 }
 MapDatabase::~MapDatabase()
 {
@@ -1234,14 +1873,46 @@ bool MapDatabase::IsSearching() const
 {
 	return m_impl->m_searching;
 }
-void MapDatabase::StartSearching()
+void MapDatabase::StartSearching(bool fullScan)
+{
+	m_impl->StartSearching(fullScan);
+}
+void MapDatabase::SetWatchFolders(bool enabled)
+{
+	m_impl->m_watchFolders = enabled;
+}
+void MapDatabase::SetScoreLimits(uint32 scoresPerChart, uint32 maxCachedScores)
+{
+	m_scoresPerChart = scoresPerChart;
+	m_maxCachedScores = maxCachedScores;
+	if(m_impl)
+		m_impl->SetScoreLimits(scoresPerChart, maxCachedScores);
+}
+const Vector<ScoreIndex*>& MapDatabase::GetScores(ChartIndex* chart)
+{
+	return m_impl->GetScores(chart);
+}
+void MapDatabase::SetBadgeFunction(BadgeFunction badgeFunction)
+{
+	assert(!m_impl);
+	m_badgeFunction = badgeFunction;
+}
+void MapDatabase::SetFlushBatchSize(uint32 batchSize)
 {
-	m_impl->StartSearching();
+	m_impl->m_flushBatchSize = Math::Max(batchSize, 1u);
 }
 void MapDatabase::StopSearching()
 {
 	m_impl->StopSearching();
 }
+void MapDatabase::WaitForSearch()
+{
+	m_impl->WaitForSearch();
+}
+MapDatabaseScanStats MapDatabase::GetLastScanStats() const
+{
+	return m_impl->GetLastScanStats();
+}
 Map<int32, FolderIndex*> MapDatabase::FindFoldersByPath(const String& search)
 {
 	return m_impl->FindFoldersByPath(search);
@@ -13,12 +13,21 @@ namespace Graphics
 	class TextRes
 	{
 		friend class Font_Impl;
-		struct FontSize* fontSize;
+		friend class RenderQueue;
+		Ref<struct GlyphAtlas> atlas;
+		// The mesh is returned to this when the text is destroyed, unless it was handed out by GetMesh
+		Ref<class TextMeshPool> meshPool;
 		Ref<class MeshRes> mesh;
+		bool meshShared = false;
 	public:
 		~TextRes();
 		Ref<class TextureRes> GetTexture();
-		Ref<class MeshRes> GetMesh() { return mesh; }
+		// The mesh can be kept after the text is destroyed, so it is not reused for other text
+		Ref<class MeshRes> GetMesh()
+		{
+			meshShared = true;
+			return mesh;
+		}
 		void Draw();
 		Vector2 size;
 	};
@@ -41,7 +50,12 @@ namespace Graphics
 			Monospace = 0x1,
 		};
 
+		// Limits of the text cache of a font, the least recently used text is removed when one is reached
+		static const uint32 maxCachedTexts = 512;
+		static const size_t maxCachedTextBytes = 4 * 1024 * 1024;
+
 		// Renders the input string into a drawable text object
+		//	the same text object is returned for the same input while it is cached
 		virtual Ref<TextRes> CreateText(const WString& str, uint32 nFontSize, TextOptions options = TextOptions::None) = 0;
 
 	private:
@@ -5,10 +5,37 @@
 
 namespace Graphics
 {
+	/*
+		Identifies a material parameter by name, every name is resolved to the same handle for all materials
+		resolving a name takes a lookup, so create handles for parameters that are set often once, e.g. as static variables
+	*/
+	class MaterialParameterHandle
+	{
+	public:
+		MaterialParameterHandle() = default;
+		MaterialParameterHandle(const String& name);
+		MaterialParameterHandle(const char* name);
+
+		const String& GetName() const;
+		// Number of distinct names that have been resolved, handles are in the range [0, GetNumHandles())
+		static uint32 GetNumHandles();
+
+		bool operator==(const MaterialParameterHandle& other) const
+		{
+			return id == other.id;
+		}
+
+		uint32 id = -1;
+	};
+
 	/* A single parameter that is set for a material */
 	struct MaterialParameter
 	{
-		CopyableBuffer parameterData;
+		// Large enough for a Transform
+		static const uint32 maxSize = 64;
+
+		uint8 parameterData[maxSize];
+		uint32 parameterSize = 0;
 		uint32 parameterType;
 
 		template<typename T>
@@ -22,43 +49,84 @@ namespace Graphics
 		template<typename T>
 		void Bind(const T& obj)
 		{
-			parameterData.resize(sizeof(T));
-			memcpy(parameterData.data(), &obj, sizeof(T));
+			static_assert(sizeof(T) <= maxSize, "Material parameter too large");
+			parameterSize = sizeof(T);
+			memcpy(parameterData, &obj, sizeof(T));
 		}
 		template<typename T>
-		const T& Get()
+		const T& Get() const
 		{
-			assert(sizeof(T) == parameterData.size());
-			return *(T*)parameterData.data();
+			assert(sizeof(T) == parameterSize);
+			return *(const T*)parameterData;
 		}
 
 		bool operator==(const MaterialParameter& other) const
 		{
 			if(parameterType != other.parameterType)
 				return false;
-			if(parameterData.size() != other.parameterData.size())
+			if(parameterSize != other.parameterSize)
 				return false;
-			return memcmp(parameterData.data(), other.parameterData.data(), parameterData.size()) == 0;
+			return memcmp(parameterData, other.parameterData, parameterSize) == 0;
 		}
 	};
 
 	/*
 		A list of parameters that is set for a material
-		use SetParameter(name, param) to set any parameter by name
+		use SetParameter(handle, param) to set any parameter, names convert to a handle
+		the first parameters are stored inline so creating and copying a small set doesn't allocate
 	*/
-	class MaterialParameterSet : public Map<String, MaterialParameter>
+	class MaterialParameterSet
 	{
 	public:
-		using Map<String, MaterialParameter>::Map;
-		void SetParameter(const String& name, int sc);
-		void SetParameter(const String& name, float sc);
-		void SetParameter(const String& name, const Vector4& vec);
-		void SetParameter(const String& name, const Colori& color);
-		void SetParameter(const String& name, const Vector2& vec2);
-		void SetParameter(const String & name, const Vector3 & vec3);
-		void SetParameter(const String& name, const Vector2i& vec2);
-		void SetParameter(const String& name, const Transform& tf);
-		void SetParameter(const String& name, Ref<class TextureRes> tex);
+		static const uint32 capacity = 16;
+
+		struct Entry
+		{
+			MaterialParameterHandle handle;
+			MaterialParameter parameter;
+		};
+
+		MaterialParameterSet() = default;
+		MaterialParameterSet(const MaterialParameterSet& other);
+		MaterialParameterSet& operator=(const MaterialParameterSet& other);
+
+		void SetParameter(MaterialParameterHandle handle, int sc);
+		void SetParameter(MaterialParameterHandle handle, float sc);
+		void SetParameter(MaterialParameterHandle handle, const Vector4& vec);
+		void SetParameter(MaterialParameterHandle handle, const Colori& color);
+		void SetParameter(MaterialParameterHandle handle, const Vector2& vec2);
+		void SetParameter(MaterialParameterHandle handle, const Vector3& vec3);
+		void SetParameter(MaterialParameterHandle handle, const Vector2i& vec2);
+		void SetParameter(MaterialParameterHandle handle, const Transform& tf);
+		void SetParameter(MaterialParameterHandle handle, Ref<class TextureRes> tex);
+
+		// Returns null if the parameter is not set
+		const MaterialParameter* Find(MaterialParameterHandle handle) const;
+
+		const Entry* begin() const
+		{
+			return m_spilled.empty() ? m_entries : m_spilled.data();
+		}
+		const Entry* end() const
+		{
+			return begin() + m_size;
+		}
+		uint32 size() const
+		{
+			return m_size;
+		}
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+	private:
+		void m_Set(MaterialParameterHandle handle, const MaterialParameter& parameter);
+
+		Entry m_entries[capacity];
+		// Holds all entries instead of m_entries once there are more than capacity
+		Vector<Entry> m_spilled;
+		uint32 m_size = 0;
 	};
 
 	enum class MaterialBlendMode
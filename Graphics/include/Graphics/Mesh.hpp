@@ -41,6 +41,14 @@ namespace Graphics
 		virtual void Draw() = 0;
 		// Draws the mesh after if has already been drawn once, reuse of bound objects
 		virtual void Redraw() = 0;
+		// Draws the mesh once for every element in instances
+		// the attributes of the instance type follow the vertex attributes, so the shader reads them at the locations after the vertex data
+		template<typename T>
+		void DrawInstanced(const Vector<T>& instances)
+		{
+			DrawInstanced(instances.data(), instances.size(), T::GetDescriptors());
+		}
+		virtual void DrawInstanced(const void* pData, size_t instanceCount, const VertexFormatList& desc) = 0;
 
 	private:
 		virtual void SetData(const void* pData, size_t vertexCount, const VertexFormatList& desc) = 0;
@@ -10,6 +10,19 @@ namespace Graphics
 	void GLDebugProc(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
 #endif
 
+	// Work done by the render queues in a frame
+	struct RenderStats
+	{
+		uint32 drawCalls = 0;
+		// Draw calls that drew multiple instances and the total number of instances they drew
+		uint32 instancedDrawCalls = 0;
+		uint32 instances = 0;
+		uint32 programBinds = 0;
+		uint32 textureBinds = 0;
+		// Blend, scissor and line/point size changes
+		uint32 stateChanges = 0;
+	};
+
 	/*
 		OpenGL context wrapper with common functionality
 	*/
@@ -21,6 +34,14 @@ namespace Graphics
 		class OpenGL_Impl* m_impl;
 		Window* m_window;
 
+		// Textures bound to each unit while a render queue is processed
+		//	other code binds textures directly, so these are only valid inside of RenderQueue::Process
+		static const uint32 numTextureUnits = 16;
+		uint32 m_boundTextures[numTextureUnits] = { 0 };
+		bool m_trackTextureBindings = false;
+		RenderStats m_frameStats;
+		RenderStats m_lastFrameStats;
+
 		friend class ShaderRes;
 		friend class TextureRes;
 		friend class MeshRes;
@@ -41,6 +62,12 @@ namespace Graphics
 		// Check if the calling thread is the thread that runs this OpenGL context
 		bool IsOpenGLThread() const;
 
+		// Binds a texture to a texture unit, skipped if a render queue already bound it
+		void BindTexture(uint32 unit, uint32 handle);
+
+		// Statistics of the render queues in the last frame, updated on SwapBuffers
+		const RenderStats& GetLastFrameStats() const;
+
 		virtual void SwapBuffers();
 	};
 }
\ No newline at end of file
@@ -8,13 +8,26 @@ namespace Graphics
 {
 
 	using Shared::Rect;
+
+	enum class RenderQueueItemType : uint8
+	{
+		SimpleDraw,
+		Points,
+		Instanced,
+	};
+
 	/*
 		Represents a draw command that can be executed in a render queue
 	*/
 	class RenderQueueItem
 	{
 	public:
+		RenderQueueItem(RenderQueueItemType type) : type(type) {};
 		virtual ~RenderQueueItem() = default;
+
+		RenderQueueItemType type;
+		// Layer the item was added in, see RenderQueue::SetLayer
+		uint8 layer = 0;
 	};
 
 	// Most basic draw command that only contains a material, it's parameters and a world transform
@@ -31,12 +44,15 @@ namespace Graphics
 		Transform worldTransform; 
 		// Scissor rectangle
 		Rect scissorRect;
+		// Text that is drawn, kept until the command is destroyed so its mesh is not reused for other text before that
+		Text text;
 	};
 
 	// Command for points/lines with size/width parameter
 	class PointDrawCall : public RenderQueueItem
 	{
 	public:
+		PointDrawCall() : RenderQueueItem(RenderQueueItemType::Points) {};
 		// List of points/lines
 		Mesh mesh;
 		Material mat;
@@ -44,11 +60,29 @@ namespace Graphics
 		float size;
 	};
 
+	// Draws a mesh once for every instance, each instance has its own attributes
+	class InstancedDrawCall : public RenderQueueItem
+	{
+	public:
+		InstancedDrawCall() : RenderQueueItem(RenderQueueItemType::Instanced) {};
+		Mesh mesh;
+		Material mat;
+		MaterialParameterSet params;
+		// The world transform shared by all instances
+		Transform worldTransform;
+		// Copy of the instance data
+		Vector<uint8> instanceData;
+		VertexFormatList instanceFormat;
+		uint32 instanceCount = 0;
+	};
+
 	/*
 		This class is a queue that collects draw commands
 		each of these is stored together with their wanted render state.
 
-		When Process is called, the commands are sorted and grouped, then sent to the graphics pipeline.
+		When Process is called, the commands are sent to the graphics pipeline ordered by layer.
+		Within a layer commands are drawn in the order they were added, opaque or not,
+		there is no depth test so the draw order decides what ends up on top.
 	*/
 	class RenderQueue : public Unique
 	{
@@ -70,9 +104,34 @@ namespace Graphics
 		// Draw for lines/points with point size parameter
 		void DrawPoints(Mesh m, Material mat, const MaterialParameterSet& params, float pointSize);
 
+		// Draws a mesh once for every element in instances using a single draw call, see MeshRes::DrawInstanced
+		// the material needs a shader that reads the instance attributes, not available on EMBEDDED
+		template<typename T>
+		void DrawInstanced(Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params, const Vector<T>& instances)
+		{
+			DrawInstanced(worldTransform, m, mat, params, instances.data(), (uint32)instances.size(), sizeof(T), T::GetDescriptors());
+		}
+		void DrawInstanced(Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params,
+			const void* instanceData, uint32 instanceCount, uint32 instanceSize, const VertexFormatList& instanceFormat);
+
+		// Layer of the commands that are added after this, lower layers are drawn first (default = 0)
+		void SetLayer(uint8 layer);
+
+		// Commands in the order they will be drawn in
+		const Vector<RenderQueueItem*>& GetCommands() const
+		{
+			return m_orderedCommands;
+		}
+
 	private:
+		// Inserts the command after all commands of the same or a lower layer
+		void m_AddCommand(RenderQueueItem* item);
+
 		RenderState m_renderState;
 		Vector<RenderQueueItem*> m_orderedCommands;
+		// Materials that had the render state bound during Process
+		Vector<MaterialRes*> m_initializedMaterials;
+		uint8 m_layer = 0;
 		class OpenGL* m_ogl = nullptr;
 	};
 }
\ No newline at end of file
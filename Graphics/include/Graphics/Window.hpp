@@ -78,6 +78,9 @@ namespace Graphics
 		bool IsKeyPressed(int32 key) const;
 
 		ModifierKeys GetModifierKeys() const;
+		// Time in milliseconds (SDL ticks) at which the event that is being handled was received
+		//	only valid inside event handlers
+		uint32 GetEventTime() const;
 
 		// Start allowing text input
 		void StartTextInput();
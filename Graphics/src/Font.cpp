@@ -5,8 +5,8 @@
 #include "Texture.hpp"
 #include "Mesh.hpp"
 #include "OpenGL.hpp"
-#include <Shared/Timer.hpp>
 #include <Shared/Profiling.hpp>
+#include <list>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -16,47 +16,127 @@ namespace Graphics
 	using Shared::Margin;
 	using Shared::Recti;
 
-	struct CachedText
+	struct TextKey
 	{
-		Text text;
-		float lastUsage;
+		WString str;
+		uint32 size;
+		uint32 options;
+
+		bool operator<(const TextKey& other) const
+		{
+			if(size != other.size)
+				return size < other.size;
+			if(options != other.options)
+				return options < other.options;
+			return str < other.str;
+		}
 	};
 	// Prevents continuous recreation of text that doesn't change
-	class TextCache : public Map<WString, CachedText>
+	//	keeps the most recently used text objects, the least recently used ones are removed when the limits are reached
+	class TextCache
 	{
-		Timer timer;
+		struct CachedText
+		{
+			TextKey key;
+			Text text;
+			size_t bytes;
+		};
+		// Most recently used first
+		std::list<CachedText> m_texts;
+		Map<TextKey, std::list<CachedText>::iterator> m_textsByKey;
+		size_t m_bytes = 0;
+
 	public:
-		void Update()
+		Text GetText(const TextKey& key)
+		{
+			auto it = m_textsByKey.find(key);
+			if(it == m_textsByKey.end())
+				return Text();
+			m_texts.splice(m_texts.begin(), m_texts, it->second);
+			return it->second->text;
+		}
+		void AddText(const TextKey& key, Text obj, size_t bytes)
 		{
-			float currentTime = timer.SecondsAsFloat();
-			for(auto it = begin(); it != end();)
+			m_texts.push_front({ key, obj, bytes });
+			m_textsByKey.Add(key, m_texts.begin());
+			m_bytes += bytes;
+			while(m_texts.size() > FontRes::maxCachedTexts || (m_bytes > FontRes::maxCachedTextBytes && m_texts.size() > 1))
 			{
-				float durationSinceUsed = currentTime - it->second.lastUsage;
-				if(durationSinceUsed > 1.0f)
-				{
-					it = erase(it);
-					continue;
-				}
-				it++;
+				m_bytes -= m_texts.back().bytes;
+				m_textsByKey.erase(m_texts.back().key);
+				m_texts.pop_back();
 			}
 		}
-		Text GetText(const WString& key)
+	};
+
+	// Meshes of text objects that have been destroyed, reused for new text so text that changes doesn't create new buffers
+	//	the data of a reused mesh is replaced, so the driver can orphan the old buffer
+	//	a text owns its mesh, render queues keep the text alive while they draw it,
+	//	and meshes handed out by TextRes::GetMesh never return here, so every mesh in the pool is unused
+	class TextMeshPool
+	{
+		OpenGL* m_gl;
+		Vector<Mesh> m_meshes;
+	public:
+		// Maximum number of unused meshes to keep
+		static const uint32 maxMeshes = 64;
+
+		TextMeshPool(OpenGL* gl) : m_gl(gl)
 		{
-			auto it = find(key);
-			if(it != end())
+		}
+		Mesh Get()
+		{
+			if(!m_meshes.empty())
 			{
-				it->second.lastUsage = timer.SecondsAsFloat();
-				return it->second.text;
+				Mesh mesh = m_meshes.back();
+				m_meshes.pop_back();
+				return mesh;
 			}
-			return Text();
+			Mesh mesh = MeshRes::Create(m_gl);
+			mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+			return mesh;
 		}
-		void AddText(const WString& key, Text obj)
+		void Release(Mesh mesh)
 		{
-			Update();
-			Add(key, { obj, timer.SecondsAsFloat() });
+			if(mesh && m_meshes.size() < maxMeshes)
+				m_meshes.push_back(mesh);
 		}
 	};
 
+	// Glyphs of all sizes of a font
+	struct GlyphAtlas
+	{
+		SpriteMap spriteMap;
+		Texture texture;
+		bool bUpdated = false;
+
+		GlyphAtlas(OpenGL* gl) : m_gl(gl)
+		{
+			spriteMap = SpriteMapRes::Create();
+			texture = TextureRes::Create(m_gl);
+			texture->SetWrap(TextureWrap::Clamp, TextureWrap::Clamp);
+		}
+		Recti AddGlyph(Image image)
+		{
+			bUpdated = true;
+			return spriteMap->GetCoords(spriteMap->AddSegment(image));
+		}
+		Texture GetTexture()
+		{
+			// Update the existing texture, the coordinates of glyphs stay the same when the atlas grows
+			if(bUpdated)
+			{
+				Image image = spriteMap->GetImage();
+				texture->SetData(image->GetSize(), image->GetBits());
+				bUpdated = false;
+			}
+			return texture;
+		}
+
+	private:
+		OpenGL* m_gl;
+	};
+
 	FT_Library library;
 	class Font_Impl;
 
@@ -77,25 +157,16 @@ namespace Graphics
 	};
 	struct FontSize
 	{
-		SpriteMap spriteMap;
-		Texture textureMap;
 		FT_Face face;
 		Vector<CharInfo> infos;
 		Map<wchar_t, uint32> infoByChar;
-		bool bUpdated = false;
 		float lineHeight;
-		TextCache cache;
 
-		FontSize(OpenGL* gl, FT_Face& face)
-			: face(face), m_gl(gl)
+		FontSize(GlyphAtlas& atlas, FT_Face& face)
+			: face(face), m_atlas(atlas)
 		{
-			spriteMap = SpriteMapRes::Create();
-			textureMap = TextureRes::Create(m_gl);
 			lineHeight = (float)face->size->metrics.height / 64.0f;
 		}
-		~FontSize()
-		{
-		}
 
 		const CharInfo& GetCharInfo(wchar_t t)
 		{
@@ -104,19 +175,9 @@ namespace Graphics
 				return AddCharInfo(t);
 			return infos[it->second];
 		}
-		Texture GetTextureMap()
-		{
-			if(bUpdated)
-			{
-				textureMap = spriteMap->GenerateTexture(m_gl);
-				bUpdated = false;
-			}
-			return textureMap;
-		}
 	private:
 		const CharInfo& AddCharInfo(wchar_t t)
 		{
-			bUpdated = true;
 			infoByChar.Add(t, (uint32)infos.size());
 			infos.emplace_back();
 			CharInfo& ci = infos.back();
@@ -151,23 +212,24 @@ namespace Graphics
 				pSrc++;
 				pDst++;
 			}
-			uint32 nIndex = spriteMap->AddSegment(img);
-			ci.coords = spriteMap->GetCoords(nIndex);
+			ci.coords = m_atlas.AddGlyph(img);
 
 			return ci;
 		}
 
-		OpenGL* m_gl;
+		GlyphAtlas& m_atlas;
 	};
 
 
 	TextRes::~TextRes()
 	{
+		if(!meshShared)
+			meshPool->Release(mesh);
 	}
 
 	Ref<class TextureRes> TextRes::GetTexture()
 	{
-		return fontSize->GetTextureMap();
+		return atlas->GetTexture();
 	}
 	void TextRes::Draw()
 	{
@@ -183,13 +245,19 @@ namespace Graphics
 		Map<uint32, FontSize*> m_sizes;
 		uint32 m_currentSize = 0;
 
+		// Shared with the text objects, which can outlive the font
+		Ref<GlyphAtlas> m_atlas;
+		Ref<TextMeshPool> m_meshPool;
+		TextCache m_cache;
+
 		OpenGL* m_gl;
 
 		friend class TextRes;
 	public:
 		Font_Impl(class OpenGL* gl) : m_gl(gl) , m_face(nullptr)
 		{
-
+			m_atlas = Ref<GlyphAtlas>(new GlyphAtlas(gl));
+			m_meshPool = Ref<TextMeshPool>(new TextMeshPool(gl));
 		}
 		~Font_Impl()
 		{
@@ -239,18 +307,19 @@ namespace Graphics
 			if(it != m_sizes.end())
 				return it->second;
 
-			FontSize* pMap = new FontSize(m_gl, m_face);
+			FontSize* pMap = new FontSize(*m_atlas, m_face);
 			m_sizes.Add(nSize, pMap);
 			return pMap;
 		}
 		Ref<TextRes> CreateText(const WString& str, uint32 nFontSize, TextOptions options)
 		{
-			FontSize* size = GetSize(nFontSize);
-
-			Text cachedText = size->cache.GetText(str);
+			TextKey key = { str, nFontSize, (uint32)options };
+			Text cachedText = m_cache.GetText(key);
 			if(cachedText)
 				return cachedText;
 
+			FontSize* size = GetSize(nFontSize);
+
 			struct TextVertex : public VertexFormat<Vector2, Vector2>
 			{
 				TextVertex(Vector2 point, Vector2 uv) : pos(point), tex(uv) {}
@@ -259,7 +328,9 @@ namespace Graphics
 			};
 
 			TextRes* ret = new TextRes();
-			ret->mesh = MeshRes::Create(m_gl);
+			ret->atlas = m_atlas;
+			ret->meshPool = m_meshPool;
+			ret->mesh = m_meshPool->Get();
 
 			float monospaceWidth = size->GetCharInfo(L'_').advance;
 
@@ -327,13 +398,11 @@ namespace Graphics
 
 			ret->size.y += size->lineHeight;
 
-			ret->fontSize = size;
 			ret->mesh->SetData(vertices);
-			ret->mesh->SetPrimitiveType(PrimitiveType::TriangleList);
 
 			Text textObj = Ref<TextRes>(ret);
 			// Insert into cache
-			size->cache.AddText(str, textObj);
+			m_cache.AddText(key, textObj, vertices.size() * sizeof(TextVertex));
 			return textObj;
 		}
 	};
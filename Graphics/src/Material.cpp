@@ -3,6 +3,8 @@
 #include "OpenGL.hpp"
 #include <Graphics/ResourceManagers.hpp>
 #include "RenderQueue.hpp"
+#include <Shared/Thread.hpp>
+#include <deque>
 
 namespace Graphics
 {
@@ -42,6 +44,64 @@ namespace Graphics
 	};
 	BuiltInShaderVariableMap builtInShaderVariableMap;
 
+	// Names of all material parameter handles, the index is the handle
+	class MaterialParameterNames
+	{
+	public:
+		uint32 Resolve(const String& name)
+		{
+			m_lock.lock();
+			uint32* id = m_ids.Find(name);
+			uint32 result = id ? *id : m_ids.Add(name, (uint32)m_names.size());
+			if(!id)
+				m_names.push_back(name);
+			m_lock.unlock();
+			return result;
+		}
+		const String& GetName(uint32 id)
+		{
+			m_lock.lock();
+			const String& name = m_names[id];
+			m_lock.unlock();
+			return name;
+		}
+		uint32 GetNumNames()
+		{
+			m_lock.lock();
+			uint32 num = (uint32)m_names.size();
+			m_lock.unlock();
+			return num;
+		}
+
+	private:
+		Mutex m_lock;
+		Map<String, uint32> m_ids;
+		// Deque so references to the names stay valid
+		std::deque<String> m_names;
+	};
+	static MaterialParameterNames& GetParameterNames()
+	{
+		static MaterialParameterNames names;
+		return names;
+	}
+
+	MaterialParameterHandle::MaterialParameterHandle(const String& name)
+	{
+		id = GetParameterNames().Resolve(name);
+	}
+	MaterialParameterHandle::MaterialParameterHandle(const char* name)
+	{
+		id = GetParameterNames().Resolve(name);
+	}
+	const String& MaterialParameterHandle::GetName() const
+	{
+		return GetParameterNames().GetName(id);
+	}
+	uint32 MaterialParameterHandle::GetNumHandles()
+	{
+		return GetParameterNames().GetNumNames();
+	}
+
 	struct BoundParameterInfo
 	{
 		BoundParameterInfo(ShaderType shaderType, uint32 paramType, uint32 location)
@@ -49,12 +109,29 @@ namespace Graphics
 		{
 		}
 
+		// Returns true if the value differs from the last value that was uploaded to this uniform
+		bool UpdateValue(const void* data, uint32 size)
+		{
+			assert(size <= sizeof(value));
+			if(valueSize == size && memcmp(value, data, size) == 0)
+				return false;
+			memcpy(value, data, size);
+			valueSize = size;
+			return true;
+		}
+
 		ShaderType shaderType;
 		uint32 location;
 		uint32 paramType;
+
+		// Last uploaded value, uniforms keep their value in the shader program
+		uint8 value[MaterialParameter::maxSize];
+		uint32 valueSize = 0;
 	};
 	struct BoundParameterList : public Vector<BoundParameterInfo>
 	{
+		// Texture unit of sampler parameters
+		int32 textureUnit = -1;
 	};
 
 	// Defined in Shader.cpp
@@ -73,10 +150,9 @@ namespace Graphics
 #else
 		uint32 m_pipeline;
 #endif
-		Map<uint32, BoundParameterList> m_boundParameters;
-		Map<String, uint32> m_mappedParameters;
-		Map<String, uint32> m_textureIDs;
-		uint32 m_userID = SV_User;
+		BoundParameterList m_builtInParameters[SV__BuiltInEnd];
+		// Indexed by the id of a MaterialParameterHandle
+		Vector<BoundParameterList> m_parameters;
 		uint32 m_textureID = 0;
 		Set<String> m_uniforms;
 
@@ -133,14 +209,28 @@ namespace Graphics
 				uint32 loc = glGetUniformLocation(handle, name);
 				#endif
 				m_uniforms.Add(name);
+				// Built in variable?
+				BoundParameterList* list;
+				BuiltInShaderVariable* builtIn = builtInShaderVariableMap.Find(name);
+				if(builtIn)
+				{
+					list = &m_builtInParameters[*builtIn];
+				}
+				else
+				{
+					MaterialParameterHandle parameter(name);
+					if(parameter.id >= m_parameters.size())
+						m_parameters.resize(parameter.id + 1);
+					list = &m_parameters[parameter.id];
+				}
+
 				// Select type
-				uint32 textureID = 0;
 				String typeName = "Unknown";
 				if(type == GL_SAMPLER_2D)
 				{
 					typeName = "Sampler2D";
-					if(!m_textureIDs.Contains(name))
-						m_textureIDs.Add(name, m_textureID++);
+					if(list->textureUnit < 0)
+						list->textureUnit = m_textureID++;
 				}
 				else if(type == GL_FLOAT_MAT4)
 				{
@@ -163,21 +253,7 @@ namespace Graphics
 					typeName = "Float";
 				}
 
-				// Built in variable?
-				uint32 targetID = 0;
-				if(builtInShaderVariableMap.Contains(name))
-				{
-					targetID = builtInShaderVariableMap[name];
-				}
-				else
-				{
-					if(m_mappedParameters.Contains(name))
-						targetID = m_mappedParameters[name];
-					else
-						targetID = m_mappedParameters.Add(name, m_userID++);
-				}
-
-				BoundParameterInfo& param = m_boundParameters.FindOrAdd(targetID).Add(BoundParameterInfo(t, type, loc));
+				list->Add(BoundParameterInfo(t, type, loc));
 
 #ifdef _DEBUG
 				Logf("Uniform [%d, loc=%d, %s] = %s", Logger::Info,
@@ -206,10 +282,9 @@ namespace Graphics
 			if(reloadedShaders)
 			{
 				Log("Reloading material", Logger::Info);
-				m_boundParameters.clear();
-				m_textureIDs.clear();
-				m_mappedParameters.clear();
-				m_userID = SV_User;
+				for(BoundParameterList& list : m_builtInParameters)
+					list = BoundParameterList();
+				m_parameters.clear();
 				m_textureID = 0;
 				for(uint32 i = 0; i < 3; i++)
 				{
@@ -244,54 +319,57 @@ namespace Graphics
 		virtual void BindParameters(const MaterialParameterSet& params, const Transform& worldTransform)
 		{
 			BindAll(SV_World, worldTransform);
-			for(auto p : params)
+			for(const MaterialParameterSet::Entry& p : params)
 			{
-				switch(p.second.parameterType)
+				// Not used by this material
+				if(p.handle.id >= m_parameters.size())
+					continue;
+				BoundParameterList& list = m_parameters[p.handle.id];
+
+				switch(p.parameter.parameterType)
 				{
 				case GL_INT:
-					BindAll(p.first, p.second.Get<int>());
+					BindAll(list, p.parameter.Get<int>());
 					break;
 				case GL_FLOAT:
-					BindAll(p.first, p.second.Get<float>());
+					BindAll(list, p.parameter.Get<float>());
 					break;
 				case GL_INT_VEC2:
-					BindAll(p.first, p.second.Get<Vector2i>());
+					BindAll(list, p.parameter.Get<Vector2i>());
 					break;
 				case GL_INT_VEC3:
-					BindAll(p.first, p.second.Get<Vector3i>());
+					BindAll(list, p.parameter.Get<Vector3i>());
 					break;
 				case GL_INT_VEC4:
-					BindAll(p.first, p.second.Get<Vector4i>());
+					BindAll(list, p.parameter.Get<Vector4i>());
 					break;
 				case GL_FLOAT_VEC2:
-					BindAll(p.first, p.second.Get<Vector2>());
+					BindAll(list, p.parameter.Get<Vector2>());
 					break;
 				case GL_FLOAT_VEC3:
-					BindAll(p.first, p.second.Get<Vector3>());
+					BindAll(list, p.parameter.Get<Vector3>());
 					break;
 				case GL_FLOAT_VEC4:
-					BindAll(p.first, p.second.Get<Vector4>());
+					BindAll(list, p.parameter.Get<Vector4>());
 					break;
 				case GL_FLOAT_MAT4:
-					BindAll(p.first, p.second.Get<Transform>());
+					BindAll(list, p.parameter.Get<Transform>());
 					break;
 				case GL_SAMPLER_2D:
 				{
-					uint32* textureUnit = m_textureIDs.Find(p.first);
-					if(!textureUnit)
+					if(list.textureUnit < 0)
 					{
 						/// TODO: Add print once mechanism for these kind of errors
-						//Logf("Texture not found \"%s\"", Logger::Warning, p.first);
+						//Logf("Texture not found \"%s\"", Logger::Warning, p.handle.GetName());
 						break;
 					}
-					Ref<TextureRes> texture = p.second.Get<Ref<TextureRes>>();
+					Ref<TextureRes> texture = p.parameter.Get<Ref<TextureRes>>();
 
 					// Bind the texture
-					texture->Bind(*textureUnit);
-
+					texture->Bind(list.textureUnit);
 
 					// Bind sampler
-					BindAll<int32>(p.first, *textureUnit);
+					BindAll<int32>(list, list.textureUnit);
 					break;
 				}
 				default:
@@ -315,47 +393,21 @@ namespace Graphics
 			return m_uniforms.Contains(name);
 		}
 
-		BoundParameterInfo* GetBoundParameters(const String& name, uint32& count)
-		{
-			uint32* mappedID = m_mappedParameters.Find(name);
-			if(!mappedID)
-				return nullptr;
-			return GetBoundParameters((BuiltInShaderVariable)*mappedID, count);
-		}
-		BoundParameterInfo* GetBoundParameters(BuiltInShaderVariable bsv, uint32& count)
-		{
-			BoundParameterList* l = m_boundParameters.Find(bsv);
-			if(!l)
-				return nullptr;
-			else
-			{
-				count = (uint32)l->size();
-				return l->data();
-			}
-		}
-		template<typename T> void BindAll(const String& name, const T& obj)
+		template<typename T> void BindAll(BoundParameterList& list, const T& obj)
 		{
-			uint32 num = 0;
 			#ifdef EMBEDDED
 			glUseProgram(m_program);
 			#endif
-			BoundParameterInfo* bp = GetBoundParameters(name, num);
-			for(uint32 i = 0; bp && i < num; i++)
+			for(BoundParameterInfo& bp : list)
 			{
-				BindShaderVar<T>(m_shaders[(size_t)bp[i].shaderType]->Handle(), bp[i].location, obj);
+				// Skip uniforms that already have this value
+				if(bp.UpdateValue(&obj, sizeof(T)))
+					BindShaderVar<T>(m_shaders[(size_t)bp.shaderType]->Handle(), bp.location, obj);
 			}
 		}
 		template<typename T> void BindAll(BuiltInShaderVariable bsv, const T& obj)
 		{
-			uint32 num = 0;
-			#ifdef EMBEDDED
-			glUseProgram(m_program);
-			#endif
-			BoundParameterInfo* bp = GetBoundParameters(bsv, num);
-			for(uint32 i = 0; bp && i < num; i++)
-			{
-				BindShaderVar<T>(m_shaders[(size_t)bp[i].shaderType]->Handle(), bp[i].location, obj);
-			}
+			BindAll(m_builtInParameters[bsv], obj);
 		}
 
 		template<typename T> void BindShaderVar(uint32 shader, uint32 loc, const T& obj)
@@ -482,40 +534,87 @@ namespace Graphics
 		return GetResourceManager<ResourceType::Material>().Register(impl);
 	}
 
-	void MaterialParameterSet::SetParameter(const String& name, int sc)
+	MaterialParameterSet::MaterialParameterSet(const MaterialParameterSet& other)
+	{
+		*this = other;
+	}
+	MaterialParameterSet& MaterialParameterSet::operator=(const MaterialParameterSet& other)
+	{
+		// Only copy the used part
+		m_size = other.m_size;
+		m_spilled = other.m_spilled;
+		if(m_spilled.empty())
+		{
+			for(uint32 i = 0; i < m_size; i++)
+				m_entries[i] = other.m_entries[i];
+		}
+		return *this;
+	}
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, int sc)
+	{
+		m_Set(handle, MaterialParameter::Create(sc, GL_INT));
+	}
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, float sc)
+	{
+		m_Set(handle, MaterialParameter::Create(sc, GL_FLOAT));
+	}
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, const Vector4& vec)
 	{
-		Add(name, MaterialParameter::Create(sc, GL_INT));
+		m_Set(handle, MaterialParameter::Create(vec, GL_FLOAT_VEC4));
 	}
-	void MaterialParameterSet::SetParameter(const String& name, float sc)
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, const Colori& color)
 	{
-		Add(name, MaterialParameter::Create(sc, GL_FLOAT));
+		m_Set(handle, MaterialParameter::Create(Color(color), GL_FLOAT_VEC4));
 	}
-	void MaterialParameterSet::SetParameter(const String& name, const Vector4& vec)
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, const Vector2& vec2)
 	{
-		Add(name, MaterialParameter::Create(vec, GL_FLOAT_VEC4));
+		m_Set(handle, MaterialParameter::Create(vec2, GL_FLOAT_VEC2));
 	}
-	void MaterialParameterSet::SetParameter(const String& name, const Colori& color)
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, const Vector3& vec3)
 	{
-		Add(name, MaterialParameter::Create(Color(color), GL_FLOAT_VEC4));
+		m_Set(handle, MaterialParameter::Create(vec3, GL_FLOAT_VEC3));
 	}
-	void MaterialParameterSet::SetParameter(const String& name, const Vector2& vec2)
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, const Transform& tf)
 	{
-		Add(name, MaterialParameter::Create(vec2, GL_FLOAT_VEC2));
+		m_Set(handle, MaterialParameter::Create(tf, GL_FLOAT_MAT4));
 	}
-	void MaterialParameterSet::SetParameter(const String& name, const Vector3& vec3)
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, Ref<class TextureRes> tex)
 	{
-		Add(name, MaterialParameter::Create(vec3, GL_FLOAT_VEC3));
+		m_Set(handle, MaterialParameter::Create(tex, GL_SAMPLER_2D));
 	}
-	void MaterialParameterSet::SetParameter(const String& name, const Transform& tf)
+	void MaterialParameterSet::SetParameter(MaterialParameterHandle handle, const Vector2i& vec2)
 	{
-		Add(name, MaterialParameter::Create(tf, GL_FLOAT_MAT4));
+		m_Set(handle, MaterialParameter::Create(vec2, GL_INT_VEC2));
 	}
-	void MaterialParameterSet::SetParameter(const String& name, Ref<class TextureRes> tex)
+	const MaterialParameter* MaterialParameterSet::Find(MaterialParameterHandle handle) const
 	{
-		Add(name, MaterialParameter::Create(tex, GL_SAMPLER_2D));
+		for(const Entry& e : *this)
+		{
+			if(e.handle == handle)
+				return &e.parameter;
+		}
+		return nullptr;
 	}
-	void MaterialParameterSet::SetParameter(const String& name, const Vector2i& vec2)
+	void MaterialParameterSet::m_Set(MaterialParameterHandle handle, const MaterialParameter& parameter)
 	{
-		Add(name, MaterialParameter::Create(vec2, GL_INT_VEC2));
+		Entry* entries = m_spilled.empty() ? m_entries : m_spilled.data();
+		for(uint32 i = 0; i < m_size; i++)
+		{
+			if(entries[i].handle == handle)
+			{
+				entries[i].parameter = parameter;
+				return;
+			}
+		}
+		if(m_size < capacity)
+		{
+			m_entries[m_size++] = { handle, parameter };
+			return;
+		}
+		// Move to the heap once the inline entries are used up
+		if(m_spilled.empty())
+			m_spilled.assign(m_entries, m_entries + capacity);
+		m_spilled.push_back({ handle, parameter });
+		m_size++;
 	}
 }
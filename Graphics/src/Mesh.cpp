@@ -17,6 +17,9 @@ namespace Graphics
 	{
 		uint32 m_buffer = 0;
 		uint32 m_vao = 0;
+		// Per instance data for instanced draws, created on first use
+		uint32 m_instanceBuffer = 0;
+		uint32 m_numVertexAttributes = 0;
 		PrimitiveType m_type;
 		uint32 m_glType;
 		size_t m_vertexCount;
@@ -29,6 +32,8 @@ namespace Graphics
 		{
 			if(m_buffer)
 				glDeleteBuffers(1, &m_buffer);
+			if(m_instanceBuffer)
+				glDeleteBuffers(1, &m_instanceBuffer);
 			if(m_vao)
 				glDeleteVertexArrays(1, &m_vao);
 		}
@@ -45,46 +50,40 @@ namespace Graphics
 			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
 
 			m_vertexCount = vertexCount;
-			size_t totalVertexSize = 0;
-			for(auto e : desc)
-				totalVertexSize += e.componentSize * e.components;
-			size_t index = 0;
-			size_t offset = 0;
-			for(auto e : desc)
-			{
-				uint32 type = -1;
-				if(!e.isFloat)
-				{
-					if(e.componentSize == 4)
-						type = e.isSigned ? GL_INT : GL_UNSIGNED_INT;
-					else if(e.componentSize == 2)
-						type = e.isSigned ? GL_SHORT : GL_UNSIGNED_SHORT;
-					else if(e.componentSize == 1)
-						type = e.isSigned ? GL_BYTE : GL_UNSIGNED_BYTE;
-				}
-				else
-				{
-					#ifdef EMBEDDED
-					type = GL_FLOAT;
-					#else
-					if(e.componentSize == 4)
-						type = GL_FLOAT;
-					else if(e.componentSize == 8)
-						type = GL_DOUBLE;
-					#endif
-				}
-				assert(type != -1);
-				glVertexAttribPointer((int)index, (int)e.components, type, GL_TRUE, (int)totalVertexSize, (void*)offset);
-				glEnableVertexAttribArray((int)index);
-				offset += e.componentSize * e.components;
-				index++;
-			}
+			m_numVertexAttributes = (uint32)desc.size();
+			size_t totalVertexSize = m_SetAttributes(desc, 0);
 			glBufferData(GL_ARRAY_BUFFER, totalVertexSize * vertexCount, pData, m_bDynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
 
 			glBindVertexArray(0);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
-		
+
+		#ifdef EMBEDDED
+		virtual void DrawInstanced(const void* pData, size_t instanceCount, const VertexFormatList& desc)
+		{
+			// Not available in OpenGL ES 2
+			assert(false);
+		}
+		#else
+		virtual void DrawInstanced(const void* pData, size_t instanceCount, const VertexFormatList& desc)
+		{
+			if(!m_instanceBuffer)
+				glGenBuffers(1, &m_instanceBuffer);
+
+			glBindVertexArray(m_vao);
+			glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+			size_t instanceSize = m_SetAttributes(desc, m_numVertexAttributes);
+			for(uint32 i = 0; i < (uint32)desc.size(); i++)
+				glVertexAttribDivisor(m_numVertexAttributes + i, 1);
+			// Orphan the previous data, it can still be in use by an earlier draw
+			glBufferData(GL_ARRAY_BUFFER, instanceSize * instanceCount, nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, instanceSize * instanceCount, pData);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			glDrawArraysInstanced(m_glType, 0, (int)m_vertexCount, (int)instanceCount);
+		}
+		#endif
+
 		#ifdef EMBEDDED
 		virtual void Draw()
 		{
@@ -119,6 +118,47 @@ namespace Graphics
 		{
 			return m_type;
 		}
+
+	private:
+		// Sets up the attributes for the currently bound buffer starting at the given location, returns the size of a single element
+		size_t m_SetAttributes(const VertexFormatList& desc, uint32 firstIndex)
+		{
+			size_t totalVertexSize = 0;
+			for(auto e : desc)
+				totalVertexSize += e.componentSize * e.components;
+			size_t index = firstIndex;
+			size_t offset = 0;
+			for(auto e : desc)
+			{
+				uint32 type = -1;
+				if(!e.isFloat)
+				{
+					if(e.componentSize == 4)
+						type = e.isSigned ? GL_INT : GL_UNSIGNED_INT;
+					else if(e.componentSize == 2)
+						type = e.isSigned ? GL_SHORT : GL_UNSIGNED_SHORT;
+					else if(e.componentSize == 1)
+						type = e.isSigned ? GL_BYTE : GL_UNSIGNED_BYTE;
+				}
+				else
+				{
+					#ifdef EMBEDDED
+					type = GL_FLOAT;
+					#else
+					if(e.componentSize == 4)
+						type = GL_FLOAT;
+					else if(e.componentSize == 8)
+						type = GL_DOUBLE;
+					#endif
+				}
+				assert(type != -1);
+				glVertexAttribPointer((int)index, (int)e.components, type, GL_TRUE, (int)totalVertexSize, (void*)offset);
+				glEnableVertexAttribArray((int)index);
+				offset += e.componentSize * e.components;
+				index++;
+			}
+			return totalVertexSize;
+		}
 	};
 
 	Mesh MeshRes::Create(class OpenGL* gl)
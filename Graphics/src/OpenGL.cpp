@@ -178,8 +178,27 @@ namespace Graphics
 		return m_impl->threadId == std::this_thread::get_id();
 	}
 
+	void OpenGL::BindTexture(uint32 unit, uint32 handle)
+	{
+		if(m_trackTextureBindings && unit < numTextureUnits)
+		{
+			if(m_boundTextures[unit] == handle)
+				return;
+			m_boundTextures[unit] = handle;
+		}
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, handle);
+		m_frameStats.textureBinds++;
+	}
+	const RenderStats& OpenGL::GetLastFrameStats() const
+	{
+		return m_lastFrameStats;
+	}
+
 	void OpenGL::SwapBuffers()
 	{
+		m_lastFrameStats = m_frameStats;
+		m_frameStats = RenderStats();
 		glFlush();
 		SDL_Window* sdlWnd = (SDL_Window*)m_window->Handle();
 		SDL_GL_SwapWindow(sdlWnd);
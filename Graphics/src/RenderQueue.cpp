@@ -1,7 +1,6 @@
 #include "stdafx.h"
 #include "RenderQueue.hpp"
 #include "OpenGL.hpp"
-using Utility::Cast;
 
 namespace Graphics
 {
@@ -16,6 +15,7 @@ namespace Graphics
 		other.m_ogl = nullptr;
 		m_orderedCommands = move(other.m_orderedCommands);
 		m_renderState = other.m_renderState;
+		m_layer = other.m_layer;
 	}
 	RenderQueue& RenderQueue::operator=(RenderQueue&& other)
 	{
@@ -24,6 +24,7 @@ namespace Graphics
 		other.m_ogl = nullptr;
 		m_orderedCommands = move(other.m_orderedCommands);
 		m_renderState = other.m_renderState;
+		m_layer = other.m_layer;
 		return *this;
 	}
 	RenderQueue::~RenderQueue()
@@ -33,87 +34,114 @@ namespace Graphics
 	void RenderQueue::Process(bool clearQueue)
 	{
 		assert(m_ogl);
+		RenderStats& stats = m_ogl->m_frameStats;
+
+		// Textures may have been bound outside of a render queue
+		memset(m_ogl->m_boundTextures, 0, sizeof(m_ogl->m_boundTextures));
+		m_ogl->m_trackTextureBindings = true;
 
 		bool scissorEnabled = false;
+		int32 activeScissor[4] = { 0, 0, -1, -1 };
 		bool blendEnabled = false;
 		MaterialBlendMode activeBlendMode = (MaterialBlendMode)-1;
+		float activeLineWidth = -1.0f;
+		float activePointSize = -1.0f;
 
-		Set<Material> initializedShaders;
-		Mesh currentMesh;
-		Material currentMaterial;
+		m_initializedMaterials.clear();
+		MeshRes* currentMesh = nullptr;
+		MaterialRes* currentMaterial = nullptr;
 
-		// Create a new list of items
-		for(RenderQueueItem* item : m_orderedCommands)
+		auto SetupMaterial = [&](Material& mat, MaterialParameterSet& params)
 		{
-			auto SetupMaterial = [&](Material& mat, MaterialParameterSet& params)
+			// Only bind params if material is already bound to context
+			if(currentMaterial == mat.GetData())
+				mat->BindParameters(params, m_renderState.worldTransform);
+			else
 			{
-				// Only bind params if material is already bound to context
-				if(currentMaterial == mat)
+				if(m_initializedMaterials.Contains(mat.GetData()))
+				{
+					// Only bind params and rebind
 					mat->BindParameters(params, m_renderState.worldTransform);
+					mat->BindToContext();
+				}
 				else
 				{
-					if(initializedShaders.Contains(mat))
-					{
-						// Only bind params and rebind
-						mat->BindParameters(params, m_renderState.worldTransform);
-						mat->BindToContext();
-						currentMaterial = mat;
-					}
-					else
-					{
-						mat->Bind(m_renderState, params);
-						initializedShaders.Add(mat);
-						currentMaterial = mat;
-					}
+					mat->Bind(m_renderState, params);
+					m_initializedMaterials.Add(mat.GetData());
 				}
+				currentMaterial = mat.GetData();
+				stats.programBinds++;
+			}
 
-				// Setup Render state for transparent object
-				if(mat->opaque)
+			// Setup Render state for transparent object
+			if(mat->opaque)
+			{
+				if(blendEnabled)
 				{
-					if(blendEnabled)
-					{
-						glDisable(GL_BLEND);
-						blendEnabled = false;
-					}
+					glDisable(GL_BLEND);
+					blendEnabled = false;
+					stats.stateChanges++;
 				}
-				else
+			}
+			else
+			{
+				if(!blendEnabled)
 				{
-					if(!blendEnabled)
-					{
-						glEnable(GL_BLEND);
-						blendEnabled = true;
-					}
-					if(activeBlendMode != mat->blendMode)
+					glEnable(GL_BLEND);
+					blendEnabled = true;
+					stats.stateChanges++;
+				}
+				if(activeBlendMode != mat->blendMode)
+				{
+					switch(mat->blendMode)
 					{
-						switch(mat->blendMode)
-						{
-						case MaterialBlendMode::Normal:
-							glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
-							break;
-						case MaterialBlendMode::Additive:
-							glBlendFunc(GL_ONE, GL_ONE);
-							break;
-						case MaterialBlendMode::Multiply:
-							glBlendFunc(GL_SRC_ALPHA, GL_SRC_COLOR);
-							break;
-						}
+					case MaterialBlendMode::Normal:
+						glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+						break;
+					case MaterialBlendMode::Additive:
+						glBlendFunc(GL_ONE, GL_ONE);
+						break;
+					case MaterialBlendMode::Multiply:
+						glBlendFunc(GL_SRC_ALPHA, GL_SRC_COLOR);
+						break;
 					}
+					activeBlendMode = mat->blendMode;
+					stats.stateChanges++;
 				}
-			};
+			}
+		};
 
-			// Draw mesh helper
-			auto DrawOrRedrawMesh = [&](Mesh& mesh)
+		// Draw mesh helper
+		auto DrawOrRedrawMesh = [&](Mesh& mesh)
+		{
+			if(currentMesh == mesh.GetData())
+				mesh->Redraw();
+			else
 			{
-				if(currentMesh == mesh)
-					mesh->Redraw();
-				else
-				{
-					mesh->Draw();
-					currentMesh = mesh;
-				}
-			};
+				mesh->Draw();
+				currentMesh = mesh.GetData();
+			}
+			stats.drawCalls++;
+			#ifdef EMBEDDED
+			glUseProgram(0);
+			#endif
+		};
 
-			if(Cast<SimpleDrawCall>(item))
+		auto DisableScissor = [&]()
+		{
+			if(scissorEnabled)
+			{
+				glDisable(GL_SCISSOR_TEST);
+				scissorEnabled = false;
+				stats.stateChanges++;
+			}
+		};
+
+		for(RenderQueueItem* item : m_orderedCommands)
+		{
+			switch(item->type)
+			{
+			case RenderQueueItemType::SimpleDraw:
 			{
 				SimpleDrawCall* sdc = (SimpleDrawCall*)item;
 				m_renderState.worldTransform = sdc->worldTransform;
@@ -128,33 +156,29 @@ namespace Graphics
 					{
 						glEnable(GL_SCISSOR_TEST);
 						scissorEnabled = true;
+						stats.stateChanges++;
 					}
 					float scissorY = m_renderState.viewportSize.y - sdc->scissorRect.Bottom();
-					glScissor((int32)sdc->scissorRect.Left(), (int32)scissorY,
-						(int32)sdc->scissorRect.size.x, (int32)sdc->scissorRect.size.y);
+					int32 scissor[4] = { (int32)sdc->scissorRect.Left(), (int32)scissorY,
+						(int32)sdc->scissorRect.size.x, (int32)sdc->scissorRect.size.y };
+					if(memcmp(scissor, activeScissor, sizeof(scissor)) != 0)
+					{
+						glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+						memcpy(activeScissor, scissor, sizeof(scissor));
+						stats.stateChanges++;
+					}
 				}
 				else
 				{
-					if(scissorEnabled)
-					{
-						glDisable(GL_SCISSOR_TEST);
-						scissorEnabled = false;
-					}
+					DisableScissor();
 				}
 
 				DrawOrRedrawMesh(sdc->mesh);
-				#ifdef EMBEDDED
-				glUseProgram(0);
-				#endif
+				break;
 			}
-			else if(Cast<PointDrawCall>(item))
+			case RenderQueueItemType::Points:
 			{
-				if(scissorEnabled)
-				{
-					// Disable scissor
-					glDisable(GL_SCISSOR_TEST);
-					scissorEnabled = false;
-				}
+				DisableScissor();
 
 				PointDrawCall* pdc = (PointDrawCall*)item;
 				m_renderState.worldTransform = Transform();
@@ -162,25 +186,51 @@ namespace Graphics
 				PrimitiveType pt = pdc->mesh->GetPrimitiveType();
 				if(pt >= PrimitiveType::LineList && pt <= PrimitiveType::LineStrip)
 				{
-					glLineWidth(pdc->size);
+					if(activeLineWidth != pdc->size)
+					{
+						glLineWidth(pdc->size);
+						activeLineWidth = pdc->size;
+						stats.stateChanges++;
+					}
 				}
 				else
 				{
 					#ifndef EMBEDDED
-					glPointSize(pdc->size);
+					if(activePointSize != pdc->size)
+					{
+						glPointSize(pdc->size);
+						activePointSize = pdc->size;
+						stats.stateChanges++;
+					}
 					#endif
 				}
-				
+
 				DrawOrRedrawMesh(pdc->mesh);
-				#ifdef EMBEDDED
-				glUseProgram(0);
-				#endif
+				break;
+			}
+			case RenderQueueItemType::Instanced:
+			{
+				DisableScissor();
+
+				InstancedDrawCall* idc = (InstancedDrawCall*)item;
+				m_renderState.worldTransform = idc->worldTransform;
+				SetupMaterial(idc->mat, idc->params);
+
+				// Binds the vertex array of the mesh, so it can be redrawn after this
+				idc->mesh->DrawInstanced(idc->instanceData.data(), idc->instanceCount, idc->instanceFormat);
+				currentMesh = idc->mesh.GetData();
+				stats.drawCalls++;
+				stats.instancedDrawCalls++;
+				stats.instances += idc->instanceCount;
+				break;
+			}
 			}
 		}
 
 		// Disable all states that were on
 		glDisable(GL_BLEND);
 		glDisable(GL_SCISSOR_TEST);
+		m_ogl->m_trackTextureBindings = false;
 
 		if(clearQueue)
 		{
@@ -205,18 +255,19 @@ namespace Graphics
 		sdc->mesh = m;
 		sdc->params = params;
 		sdc->worldTransform = worldTransform;
-		m_orderedCommands.push_back(sdc);
+		m_AddCommand(sdc);
 	}
 	void RenderQueue::Draw(Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params)
 	{
 		SimpleDrawCall* sdc = new SimpleDrawCall();
 		sdc->mat = mat;
-		sdc->mesh = text->GetMesh();
+		sdc->mesh = text->mesh;
+		sdc->text = text;
 		sdc->params = params;
 		// Set Font texture map
 		sdc->params.SetParameter("mainTex", text->GetTexture());
 		sdc->worldTransform = worldTransform;
-		m_orderedCommands.push_back(sdc);
+		m_AddCommand(sdc);
 	}
 
 	void RenderQueue::DrawScissored(Rect scissor, Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params /*= MaterialParameterSet()*/)
@@ -227,20 +278,21 @@ namespace Graphics
 		sdc->params = params;
 		sdc->worldTransform = worldTransform;
 		sdc->scissorRect = scissor;
-		m_orderedCommands.push_back(sdc);
+		m_AddCommand(sdc);
 	}
 	void RenderQueue::DrawScissored(Rect scissor, Transform worldTransform, Ref<class TextRes> text, Material mat, const MaterialParameterSet& params /*= MaterialParameterSet()*/)
 	{
 		SimpleDrawCall* sdc = new SimpleDrawCall();
 		sdc->mat = mat;
-		sdc->mesh = text->GetMesh();
+		sdc->mesh = text->mesh;
+		sdc->text = text;
 		sdc->params = params;
 		// Set Font texture map
 		sdc->params.SetParameter("mainTex", text->GetTexture());
 		sdc->params.SetParameter("mapSize", text->GetTexture()->GetSize());
 		sdc->worldTransform = worldTransform;
 		sdc->scissorRect = scissor;
-		m_orderedCommands.push_back(sdc);
+		m_AddCommand(sdc);
 	}
 
 	void RenderQueue::DrawPoints(Mesh m, Material mat, const MaterialParameterSet& params, float pointSize)
@@ -250,12 +302,47 @@ namespace Graphics
 		pdc->mesh = m;
 		pdc->params = params;
 		pdc->size = pointSize;
-		m_orderedCommands.push_back(pdc);
+		m_AddCommand(pdc);
+	}
+
+	void RenderQueue::DrawInstanced(Transform worldTransform, Mesh m, Material mat, const MaterialParameterSet& params,
+		const void* instanceData, uint32 instanceCount, uint32 instanceSize, const VertexFormatList& instanceFormat)
+	{
+		if(instanceCount == 0)
+			return;
+		InstancedDrawCall* idc = new InstancedDrawCall();
+		idc->mat = mat;
+		idc->mesh = m;
+		idc->params = params;
+		idc->worldTransform = worldTransform;
+		idc->instanceData.resize(instanceCount * instanceSize);
+		memcpy(idc->instanceData.data(), instanceData, idc->instanceData.size());
+		idc->instanceFormat = instanceFormat;
+		idc->instanceCount = instanceCount;
+		m_AddCommand(idc);
+	}
+
+	void RenderQueue::SetLayer(uint8 layer)
+	{
+		m_layer = layer;
+	}
+
+	void RenderQueue::m_AddCommand(RenderQueueItem* item)
+	{
+		item->layer = m_layer;
+		// Usually every command is in the same layer, so the command goes at the end
+		auto it = m_orderedCommands.end();
+		if(!m_orderedCommands.empty() && m_orderedCommands.back()->layer > m_layer)
+		{
+			it = std::upper_bound(m_orderedCommands.begin(), m_orderedCommands.end(), item,
+				[](const RenderQueueItem* a, const RenderQueueItem* b) { return a->layer < b->layer; });
+		}
+		m_orderedCommands.insert(it, item);
 	}
 
 	// Initializes the simple draw call structure
 	SimpleDrawCall::SimpleDrawCall()
-		: scissorRect(Vector2(), Vector2(-1))
+		: RenderQueueItem(RenderQueueItemType::SimpleDraw), scissorRect(Vector2(), Vector2(-1))
 	{
 	}
 
@@ -152,9 +152,7 @@ namespace Graphics
 		}
 		virtual void Bind(uint32 index)
 		{
-			glActiveTexture(GL_TEXTURE0 + index);
-			glBindTexture(GL_TEXTURE_2D, m_texture);
-
+			m_gl->BindTexture(index, m_texture);
 		}
 		virtual uint32 Handle()
 		{
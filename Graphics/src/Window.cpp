@@ -259,6 +259,7 @@ namespace Graphics
 			SDL_Event evt;
 			while(SDL_PollEvent(&evt))
 			{
+				m_eventTime = evt.common.timestamp;
 				if(evt.type == SDL_EventType::SDL_KEYDOWN)
 				{
 					if(m_textComposition.composition.empty())
@@ -447,6 +448,8 @@ namespace Graphics
 		Map<SDL_Keycode, uint8> m_keyStates;
 		KeyMap m_keyMapping;
 		ModifierKeys m_modKeys = ModifierKeys::None;
+		// Timestamp of the event that is being handled
+		uint32 m_eventTime = 0;
 
 		// Gamepad input
 		Map<int32, Ref<Gamepad_Impl>> m_gamepads;
@@ -560,6 +563,10 @@ namespace Graphics
 	{
 		return m_impl->m_modKeys;
 	}
+	uint32 Window::GetEventTime() const
+	{
+		return m_impl->m_eventTime;
+	}
 
 	bool Window::IsActive() const
 	{
@@ -28,6 +28,8 @@ public:
 		float lastUsage;
 		int texture;
 		bool loaded = false;
+		// Set when the loading job was cancelled before the image was loaded
+		bool cancelled = false;
 		Job loadingJob;
 	};
 	void ApplySettings();
@@ -109,8 +111,14 @@ private:
 	void m_SaveConfig();
 	void m_InitDiscord();
 	bool m_Init();
+	// Renders the chart on the command line to a wav file instead of starting the game
+	int32 m_RenderOffline(const String& outputPath);
+	// Plays the chart on the command line without a window and logs the result, with recorded input or autoplay
+	int32 m_Simulate(const String& inputPath);
 	void m_MainLoop();
 	void m_Tick();
+	void m_QueueJacketJob(const String& path, CachedJacketImage* image, Vector2i size, bool web);
+	void m_UpdateJacketJobs();
 	void m_Cleanup();
 	void m_OnKeyPressed(int32 key);
 	void m_OnKeyReleased(int32 key);
@@ -154,16 +162,28 @@ private:
 	int m_multiRoomCount = 0;
 };
 
+// Reads or downloads the image file for a jacket
+class JacketReadJob : public JobBase
+{
+public:
+	virtual bool Run();
+
+	Buffer data;
+	String imagePath;
+	bool web = false;
+};
+
+// Decodes a jacket after its JacketReadJob finished
 class JacketLoadingJob : public JobBase
 {
 public:
 	virtual bool Run();
 	virtual void Finalize();
 
+	Ref<JacketReadJob> readJob;
 	Image loadedImage;
-	String imagePath;
 	int w = 0, h = 0;
-	bool web = false;
+	// Image that receives the result, null if the result should be dropped
 	Application::CachedJacketImage* target;
 };
 
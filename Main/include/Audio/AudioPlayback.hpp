@@ -50,6 +50,9 @@ public:
 	void TogglePause();
 	bool IsPaused() const { return m_paused; }
 	bool HasEnded() const;
+	// Underruns of the music track since it was loaded
+	uint32 GetNumUnderruns() const;
+	uint64 GetUnderrunFrames() const;
 
 	// Sets either button effect 0 or 1
 	void SetEffect(uint32 index, HoldObjectState* object, class BeatmapPlayback& playback);
@@ -0,0 +1,41 @@
+#pragma once
+#include <Beatmap/BeatmapPlayback.hpp>
+#include "AudioPlayback.hpp"
+#include "Scoring.hpp"
+
+/*
+	Renders the audio of a chart to a wav file as fast as possible, without an audio device
+	the chart is played by autoplay, so laser and FX button effects are applied like in a perfect play
+	g_audio has to be initialized with InitOffline
+*/
+class OfflineRender : Unique
+{
+public:
+	// Loads the chart and its audio
+	bool Init(const String& chartPath);
+	// Renders the chart from the start until the music ends, writes 32-bit float stereo samples
+	bool Render(const String& outputPath);
+
+	// Number of frames written by the last render
+	uint64 GetRenderedFrames() const
+	{
+		return m_renderedFrames;
+	}
+
+	// Frames rendered per block, this is also the step of the virtual clock that drives the chart
+	uint32 blockSize = 512;
+
+private:
+	void m_OnFXBegin(HoldObjectState* object);
+	void m_OnFXEnd(HoldObjectState* object);
+	void m_OnEventChanged(EventKey key, EventData data);
+	void m_OnObjectHold(Input::Button, ObjectState* object);
+	void m_OnObjectReleased(Input::Button, ObjectState* object);
+
+	Ref<Beatmap> m_beatmap;
+	BeatmapPlayback m_playback;
+	AudioPlayback m_audioPlayback;
+	Scoring m_scoring;
+
+	uint64 m_renderedFrames = 0;
+};
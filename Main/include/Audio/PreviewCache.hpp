@@ -0,0 +1,49 @@
+#pragma once
+#include <Audio/AudioStream.hpp>
+#include <Shared/Jobs.hpp>
+
+/*
+	Decodes song previews on a job thread so changing the selection doesn't block on opening files
+	keeps the most recently used previews in memory, limited by a memory budget
+*/
+class PreviewCache : public Unique
+{
+public:
+	~PreviewCache();
+
+	// Memory the decoded previews can use before the least recently used ones are dropped
+	void SetMemoryBudget(size_t bytes);
+	size_t GetMemoryUsage() const
+	{
+		return m_memoryUsage;
+	}
+
+	// Requests the preview of an audio file, replacing the previous request if it is still waiting
+	//	OnLoaded is called right away if the preview is cached, otherwise once it has been decoded
+	void Request(const String& path, int32 offset, int32 length);
+	// Drops the pending request without calling OnLoaded
+	void Cancel();
+
+	// Called on the main thread with the path of the requested file and the preview, null if it could not be decoded
+	Delegate<String, Ref<AudioClip>> OnLoaded;
+
+private:
+	struct Entry
+	{
+		String key;
+		Ref<AudioClip> clip;
+	};
+
+	static String m_GetKey(const String& path, int32 offset, int32 length);
+	void m_OnJobFinished(Job job);
+	void m_Add(const String& key, Ref<AudioClip> clip);
+
+	// Cached previews, most recently used first
+	List<Entry> m_entries;
+	size_t m_memoryUsage = 0;
+	size_t m_memoryBudget = 64 * 1024 * 1024;
+
+	Job m_job;
+	String m_jobPath;
+	String m_jobKey;
+};
@@ -34,6 +34,9 @@ GameFlags operator|(const GameFlags& a, const GameFlags& b);
 GameFlags operator&(const GameFlags& a, const GameFlags& b);
 GameFlags operator~(const GameFlags& a);
 
+// Loads a chart file, returns null if it could not be loaded
+Ref<class Beatmap> TryLoadMap(const String& path);
+
 /*
 	Main game scene / logic manager
 */
@@ -1,6 +1,7 @@
 #pragma once
 #include "Shared/Config.hpp"
 #include "Input.hpp"
+#include <Audio/Resampler.hpp>
 
 DefineEnum(GameConfigKeys,
 		   // Screen settings
@@ -28,6 +29,10 @@ DefineEnum(GameConfigKeys,
 		   GlobalOffset,
 		   InputOffset,
 		   SongFolder,
+		   WatchSongFolder,
+		   ScoresPerChart,
+		   MaxCachedScores,
+		   JobIOThreads,
 		   Skin,
 		   Laser0Color,
 		   Laser1Color,
@@ -113,6 +118,9 @@ DefineEnum(GameConfigKeys,
 		   AutoScoreScreenshot,
 
 		   WASAPI_Exclusive,
+		   AudioDecodeAhead,
+		   AudioResampleQuality,
+		   PreviewCacheSize,
 		   MuteUnfocused,
 
 		   CheckForUpdates,
@@ -0,0 +1,72 @@
+#pragma once
+#include <Beatmap/BeatmapPlayback.hpp>
+#include "Scoring.hpp"
+#include "Input.hpp"
+
+/*
+	Plays a chart without a window, audio device or gpu, by stepping the gameplay at a fixed rate
+	buttons and lasers come from a recorded input stream, the chart is played by autoplay if there is none
+	the result only depends on the chart, the input, the step rate and the game config
+*/
+class GameSimulation : Unique
+{
+public:
+	// A change of the input state at a given time in the chart
+	struct InputEvent
+	{
+		MapTime time = 0;
+		// Button that changed, Length for laser input
+		Input::Button button = Input::Button::Length;
+		bool pressed = false;
+		// Laser that changed and its movement per second, the same as the keyboard laser input
+		uint32 laser = 0;
+		float laserSpeed = 0.0f;
+	};
+
+	// Loads the chart, recorded input is kept
+	bool Init(const String& chartPath, GameFlags flags = GameFlags::None);
+	// Loads recorded input from a text file, every line contains one event:
+	//	"<time> <button> <1/0>" for a button press/release, buttons are named like Input::Button (BT_0, FX_1, ...)
+	//	"<time> Laser<0/1> <speed>" for laser movement
+	//	lines starting with # are ignored
+	bool LoadInput(const String& inputPath);
+	void AddInput(const InputEvent& event);
+
+	// Plays the chart from the start until all objects have passed, or until a hard gauge is empty
+	//	input is judged at the time of its event at any rate, but objects only become hittable on a step
+	//	so steps should be less than Scoring::missHitTime - Scoring::goodHitTime (158ms) apart
+	void Run(float stepsPerSecond);
+	// Logs the score, gauge and hit statistics of the last run
+	void LogResult() const;
+
+	const Scoring& GetScoring() const
+	{
+		return m_scoring;
+	}
+	MapTime GetEndTime() const
+	{
+		return m_endTime;
+	}
+	// Number of gameplay ticks in the last run
+	uint32 GetNumSteps() const
+	{
+		return m_numSteps;
+	}
+
+private:
+	void m_ApplyInput(const InputEvent& event);
+
+	Ref<Beatmap> m_beatmap;
+	BeatmapPlayback m_playback;
+	Input m_input;
+	Scoring m_scoring;
+	GameFlags m_flags = GameFlags::None;
+	MapTime m_endTime = 0;
+
+	// Sorted by time
+	Vector<InputEvent> m_inputEvents;
+	float m_laserSpeeds[2] = { 0.0f };
+
+	uint32 m_numSteps = 0;
+	double m_runTime = 0.0;
+};
@@ -37,6 +37,11 @@ public:
 	void Update(float deltaTime);
 
 	bool GetButton(Button button) const;
+	// Time in milliseconds at which the button last changed state, on the clock returned by GetTime
+	//	this is the time the event was received, which can be before the frame that handles it
+	uint32 GetButtonTime(Button button) const;
+	// Current time of the clock input events are timestamped with
+	uint32 GetTime() const;
 	float GetAbsoluteLaser(int laser) const;
 	bool Are3BTsHeld() const;
 
@@ -58,6 +63,12 @@ public:
 	// Request laser input state without sensitivity applied
 	float GetAbsoluteInputLaserDir(uint32 laserIdx);
 
+	// Changes the state of a button without a window, used to play back recorded input
+	//	time is on the clock the button times are reported in
+	void SimulateButton(Button button, bool pressed, uint32 time);
+	// Sets the laser input until the next call, without a window
+	void SimulateLaser(uint32 laserIdx, float dir);
+
 	// Button delegates
 	Delegate<Button> OnButtonPressed;
 	Delegate<Button> OnButtonReleased;
@@ -65,7 +76,7 @@ public:
 private:
 	void m_InitKeyboardMapping();
 	void m_InitControllerMapping();
-	void m_OnButtonInput(Button b, bool pressed);
+	void m_OnButtonInput(Button b, bool pressed, uint32 time);
 
 	void m_OnGamepadButtonPressed(uint8 button);
 	void m_OnGamepadButtonReleased(uint8 button);
@@ -76,7 +87,8 @@ private:
 	InputDevice m_laserDevice;
 	InputDevice m_buttonDevice;
 
-	bool m_buttonStates[(size_t)Button::Length];
+	bool m_buttonStates[(size_t)Button::Length] = { false };
+	uint32 m_buttonTimes[(size_t)Button::Length] = { 0 };
 	bool m_backComboHold = false;
 	bool m_backComboInstant = false;
 	bool m_backSent = false;
@@ -89,7 +101,7 @@ private:
 
 	// Keyboard bindings
 	Multimap<int32, Button> m_buttonMap;
-	float m_keySensitivity;
+	float m_keySensitivity = 0.0f;
 	float m_keyLaserReleaseTime;
 
 	// Mouse bindings
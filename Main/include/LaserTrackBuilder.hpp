@@ -1,6 +1,15 @@
 #pragma once
 #include <Beatmap/BeatmapObjects.hpp>
 
+typedef Vector<MeshGenerators::SimpleVertex> LaserVertices;
+
+/*
+	Generates the geometry of laser segments, relative to the start of the segment
+	the vertices of a segment are cached until it has passed
+
+	Segments are drawn by adding them to a batch, every batch is uploaded to a mesh that is reused every frame
+	so drawing lasers doesn't create any gpu buffers, uploading replaces the data which lets the driver orphan the old buffer
+*/
 class LaserTrackBuilder
 {
 public:
@@ -9,12 +18,30 @@ public:
 	void Update(MapTime newTime);
 
 	// Generates a normal segment
-	Mesh GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser);
+	const LaserVertices& GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser);
 
 	// Generate the starting segment of a laser
-	Mesh GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser);
+	const LaserVertices& GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser);
 	// Generate the ending segment of a laser
-	Mesh GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser);
+	const LaserVertices& GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser);
+
+	// Adds a segment to a batch, offset moves it along the track
+	void AddToBatch(uint32 batch, const LaserVertices& verts, float offset);
+	// Uploads the segments added to a batch since the last upload, returns an invalid mesh if there are none
+	Mesh UploadBatch(uint32 batch);
+
+	// Number of batches that can be used at the same time
+	static const uint32 numBatches = 10;
+
+	// Size of the vertex data uploaded during the last frame
+	size_t GetUploadedBytes() const
+	{
+		return m_lastUploadedBytes;
+	}
+	// Size of the data currently stored in the batch meshes
+	size_t GetBatchBytes() const;
+	// Size of the cached segment vertices
+	size_t GetCacheBytes() const;
 
 	// Laser length scale at a given position
 	float GetLaserLengthScaleAt(MapTime time);
@@ -53,14 +80,21 @@ private:
 
 private:
 	void m_RecalculateConstants();
-	void m_Cleanup(MapTime newTime, Map<LaserObjectState*, Mesh>& arr);
+	void m_Cleanup(MapTime newTime, Map<LaserObjectState*, LaserVertices>& arr);
 	class OpenGL* m_gl;
 	class Track* m_track;
 
 	float m_trackWidth;
 	float m_laserWidth;
 	uint32 m_laserIndex;
-	Map<LaserObjectState*, Mesh> m_objectCache;
-	Map<LaserObjectState*, Mesh> m_cachedEntries;
-	Map<LaserObjectState*, Mesh> m_cachedExits;
+	Map<LaserObjectState*, LaserVertices> m_objectCache;
+	Map<LaserObjectState*, LaserVertices> m_cachedEntries;
+	Map<LaserObjectState*, LaserVertices> m_cachedExits;
+
+	// Vertices added to each batch and the mesh they are uploaded to
+	LaserVertices m_batchVertices[numBatches];
+	Mesh m_batchMeshes[numBatches];
+	size_t m_batchBytes[numBatches] = { 0 };
+	size_t m_uploadedBytes = 0;
+	size_t m_lastUploadedBytes = 0;
 };
\ No newline at end of file
@@ -75,6 +75,11 @@ public:
 
 	// Needs to be set to handle input
 	void SetInput(Input* input);
+	// Links the last time the playback was updated with to the input clock, call after every playback update
+	//	buttons are then judged at the time their event was received instead of the last playback time
+	//	speed is the number of map milliseconds per input millisecond
+	//	exact disables the limit on the correction, for input clocks that can be trusted like the one of a simulation
+	void SetInputTimeReference(uint32 inputTime, float speed = 1.0f, bool exact = false);
 
 	void SetFlags(GameFlags flags);
 	void SetEndTime(MapTime time);
@@ -219,6 +224,8 @@ private:
 	// Calculates the times at which a single laser chain object ticks
 	//	use the root laser object
 	void m_CalculateLaserTicks(LaserObjectState* laserRoot, Vector<ScoreTick>& ticks) const;
+	// Calculates the ticks of every object in the map, called on reset
+	void m_BuildTicks();
 	void m_OnObjectEntered(ObjectState* obj);
 	void m_OnObjectLeaved(ObjectState* obj);
 	void m_OnFXBegin(HoldObjectState* obj);
@@ -230,8 +237,14 @@ private:
 
 	// Updates all pending ticks
 	void m_UpdateTicks();
+	// Map time of the last state change of a button, converted from the input clock
+	MapTime m_GetInputTime(Input::Button button) const;
+	// Makes the ticks of the next object in a lane hittable
+	void m_EnterTicks(uint32 buttonCode);
+	// First tick of a lane that is hittable and not processed yet, null if there is none
+	ScoreTick* m_GetFrontTick(uint32 buttonCode);
 	// Tries to trigger a hit event on an approaching tick
-	ObjectState* m_ConsumeTick(uint32 buttonCode);
+	ObjectState* m_ConsumeTick(uint32 buttonCode, MapTime time);
 	// Called whenether missed or not
 	void m_OnTickProcessed(ScoreTick* tick, uint32 index);
 	void m_TickHit(ScoreTick* tick, uint32 index, MapTime delta = 0);
@@ -272,6 +285,12 @@ private:
 	class Input* m_input = nullptr;
 	class BeatmapPlayback* m_playback = nullptr;
 
+	// Input clock time of the last playback update
+	uint32 m_inputTimeReference = 0;
+	float m_inputTimeSpeed = 1.0f;
+	bool m_hasInputTimeReference = false;
+	bool m_inputTimeExact = false;
+
 	// Input values for laser [-1,1]
 	float m_laserInput[2] = { 0.0f };
 	// Keeps being set to the last direction the laser was moving in to create laser intertia
@@ -304,7 +323,14 @@ private:
 	Vector<LaserObjectState*> m_laserSegmentQueue;
 
 	// Ticks for each BT[4] / FX[2] / Laser[2]
-	Vector<ScoreTick*> m_ticks[8];
+	//	contains the ticks of the whole map, in the order their objects become hittable
+	Vector<ScoreTick> m_ticks[8];
+	// End of the ticks of each object in a lane, the ticks of a hold or laser chain are added at once
+	Vector<uint32> m_tickObjectEnds[8];
+	uint32 m_nextTickObject[8] = { 0 };
+	// Ticks in [cursor, end) are hittable, the ones before the cursor are processed
+	uint32 m_tickCursor[8] = { 0 };
+	uint32 m_tickEnd[8] = { 0 };
 	// Hold objects
 	ObjectState* m_holdObjects[8];
 	Set<ObjectState*> m_heldObjects;
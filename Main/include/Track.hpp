@@ -46,7 +46,10 @@ public:
 	// Just the board with tick lines
 	void DrawBase(RenderQueue& rq);
 	// Draws an object
+	//	buttons of the same type are collected and drawn together when the next type starts, call FlushObjectBatch after the last object
 	void DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, ObjectState* obj, bool active, const std::unordered_set<MapTime> chipFXTimes[2]);
+	// Draws the buttons and lasers collected by DrawObjectState
+	void FlushObjectBatch(RenderQueue& rq);
 	// Things like the laser pointers, hit bar and effect
 	void DrawOverlays(RenderQueue& rq);
 	// Draws a plane over the track
@@ -71,6 +74,11 @@ public:
 	// Normal/FX button X-axis placement
 	float GetButtonPlacement(uint32 buttonIdx);
 
+	// Size of the cached and uploaded laser geometry of both lasers, in bytes
+	size_t GetLaserMemory() const;
+	// Size of the laser geometry uploaded during the last frame, in bytes
+	size_t GetLaserUploadedBytes() const;
+
 	// Laser positions, as shown on the overlay
 	float laserPositions[2];
 	// Current lasers are extended
@@ -114,6 +122,9 @@ public:
 	Texture fxbuttonHoldTexture;
 	Material holdButtonMaterial;
 	Material buttonMaterial;
+	// Instanced versions of the button materials, invalid on EMBEDDED or if the skin doesn't have them
+	Material holdButtonInstancedMaterial;
+	Material buttonInstancedMaterial;
 	Material trackCoverMaterial;
 	Texture laserTextures[2];
 	Texture laserTailTextures[4]; // Entry and exit textures, both sides
@@ -146,6 +157,42 @@ public:
 	Transform trackOrigin;
 
 private:
+	// Per button attributes of the instanced button materials
+	struct ButtonInstance : public VertexFormat<Vector4, Vector4, float>
+	{
+		// Offset (xy) and scale (zw) on the track
+		Vector4 placement;
+		// trackPos, trackScale, objectGlow, hitState
+		Vector4 state;
+		float hasSample;
+	};
+
+	// Texture and shader parameters of a laser segment, 0 = body, 1 = entry, 2 = exit
+	enum class LaserPart
+	{
+		Body = 0,
+		Entry,
+		Exit,
+	};
+	// Laser glow, the same for every laser in a state
+	enum class LaserState
+	{
+		NotHittable = 0,
+		Active,
+		Inactive,
+	};
+
+	void m_DrawButtonBatch(RenderQueue& rq);
+	void m_DrawLaserBatches(RenderQueue& rq);
+	// Index of the laser builder batch for segments with the given part and state
+	static uint32 m_LaserBatch(LaserPart part, LaserState state);
+
+	// Buttons that share a mesh, material and texture, drawn with a single instanced draw
+	Mesh m_batchMesh;
+	Material m_batchMaterial;
+	Texture m_batchTexture;
+	Vector<ButtonInstance> m_batchInstances;
+
 	// Laser track generators
 	class LaserTrackBuilder* m_laserTrackBuilder[2] = { 0 };
 
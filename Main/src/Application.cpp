@@ -14,6 +14,8 @@
 #include "GameConfig.hpp"
 #include "Input.hpp"
 #include "TransitionScreen.hpp"
+#include "OfflineRender.hpp"
+#include "GameSimulation.hpp"
 #include "GUI/HealthGauge.hpp"
 #include "lua.hpp"
 #include "nanovg.h"
@@ -118,6 +120,16 @@ void Application::ApplySettings()
 }
 int32 Application::Run()
 {
+	// Rendering the audio of a chart or simulating a play doesn't need a window
+	for (auto &cl : m_commandLine)
+	{
+		String k, v;
+		if (cl.Split("=", &k, &v) && k == "-render")
+			return m_RenderOffline(v);
+		if (cl == "-simulate" || k == "-simulate")
+			return m_Simulate(v);
+	}
+
 	if (!m_Init())
 		return 1;
 
@@ -167,6 +179,68 @@ int32 Application::Run()
 	return 0;
 }
 
+int32 Application::m_RenderOffline(const String &outputPath)
+{
+	if (m_commandLine.size() < 2 || m_commandLine[1].front() == '-')
+	{
+		Log("No chart to render, usage: <chart> -render=<output.wav>", Logger::Error);
+		return 1;
+	}
+
+	if (!m_LoadConfig())
+	{
+		Log("Failed to load config file", Logger::Warning);
+	}
+
+	// Fixed rate so renders can be compared between machines
+	new Audio();
+	g_audio->InitOffline(48000);
+	g_audio->SetResampleQuality(g_gameConfig.GetEnum<Enum_ResampleQuality>(GameConfigKeys::AudioResampleQuality));
+
+	int32 result = 0;
+	{
+		OfflineRender render;
+		if (!render.Init(m_commandLine[1]) || !render.Render(outputPath))
+			result = 1;
+	}
+
+	// The streams of the render are released, so the mixer can be shut down
+	delete g_audio;
+	g_audio = nullptr;
+	return result;
+}
+
+int32 Application::m_Simulate(const String &inputPath)
+{
+	if (m_commandLine.size() < 2 || m_commandLine[1].front() == '-')
+	{
+		Log("No chart to simulate, usage: <chart> -simulate[=<input.txt>] [-simrate=<ticks per second>]", Logger::Error);
+		return 1;
+	}
+
+	if (!m_LoadConfig())
+	{
+		Log("Failed to load config file", Logger::Warning);
+	}
+
+	float stepsPerSecond = 60.0f;
+	for (auto &cl : m_commandLine)
+	{
+		String k, v;
+		if (cl.Split("=", &k, &v) && k == "-simrate")
+			stepsPerSecond = Math::Max(1.0f, (float)atof(*v));
+	}
+
+	GameSimulation simulation;
+	if (!simulation.Init(m_commandLine[1]))
+		return 1;
+	if (!inputPath.empty() && !simulation.LoadInput(inputPath))
+		return 1;
+	simulation.Run(stepsPerSecond);
+	simulation.LogResult();
+	return 0;
+}
+
 void Application::SetUpdateAvailable(const String &version, const String &url, const String &download)
 {
 	m_updateVersion = version;
@@ -639,7 +713,7 @@ bool Application::m_Init()
 	}
 
 	// Job sheduler
-	g_jobSheduler = new JobSheduler();
+	g_jobSheduler = new JobSheduler(0, g_gameConfig.GetInt(GameConfigKeys::JobIOThreads));
 
 	m_allowMapConversion = false;
 	bool debugMute = false;
@@ -756,6 +830,9 @@ bool Application::m_Init()
 			}
 		}
 
+		g_audio->SetDecodeAhead(Math::Max(g_gameConfig.GetInt(GameConfigKeys::AudioDecodeAhead), 20));
+		g_audio->SetResampleQuality(g_gameConfig.GetEnum<Enum_ResampleQuality>(GameConfigKeys::AudioResampleQuality));
+
 		// Debug Mute?
 		// Test tracks may get annoying when continously debugging ;)
 		if (debugMute)
@@ -948,6 +1025,8 @@ void Application::m_Tick()
 	// Handle input first
 	g_input.Update(m_deltaTime);
 
+	m_UpdateJacketJobs();
+
 	// Process async lua http callbacks
 	m_skinHttp.ProcessCallbacks();
 
@@ -1078,11 +1157,14 @@ void Application::m_Cleanup()
 
 	Discord_Shutdown();
 
+	if (g_guiState.vg)
+	{
 #ifdef EMBEDDED
-	nvgDeleteGLES2(g_guiState.vg);
+		nvgDeleteGLES2(g_guiState.vg);
 #else
-	nvgDeleteGL3(g_guiState.vg);
+		nvgDeleteGL3(g_guiState.vg);
 #endif
+	}
 
 	if (m_updateThread.joinable())
 		m_updateThread.join();
@@ -1241,30 +1323,81 @@ int Application::LoadImageJob(const String &path, Vector2i size, int placeholder
 	if (it == m_jacketImages.end() || !it->second)
 	{
 		CachedJacketImage *newImage = new CachedJacketImage();
-		JacketLoadingJob *job = new JacketLoadingJob();
-		job->imagePath = path;
-		job->target = newImage;
-		job->w = size.x;
-		job->h = size.y;
-		job->web = web;
-		newImage->loadingJob = Ref<JobBase>(job);
 		newImage->lastUsage = m_jobTimer.SecondsAsFloat();
-		g_jobSheduler->Queue(newImage->loadingJob);
+		m_QueueJacketJob(path, newImage, size, web);
 
 		m_jacketImages.Add(path, newImage);
 	}
 	else
 	{
-		it->second->lastUsage = m_jobTimer.SecondsAsFloat();
+		CachedJacketImage *image = it->second;
+		image->lastUsage = m_jobTimer.SecondsAsFloat();
 		// If loaded set texture
-		if (it->second->loaded)
+		if (image->loaded)
+		{
+			ret = image->texture;
+		}
+		else if (image->loadingJob->IsCancelled())
 		{
-			ret = it->second->texture;
+			// Requested again after it was cancelled, start over with a new job
+			// without waiting for the old one, it is skipped if it did not start yet and drops its result otherwise
+			static_cast<JacketLoadingJob*>(image->loadingJob.GetData())->target = nullptr;
+			image->cancelled = false;
+			m_QueueJacketJob(path, image, size, web);
 		}
 	}
 	return ret;
 }
 
+void Application::m_QueueJacketJob(const String &path, CachedJacketImage *image, Vector2i size, bool web)
+{
+	// The file is read on an IO thread and decoded on a worker thread after that,
+	// requested jackets are on screen so they go ahead of other jobs
+	JacketReadJob *readJob = new JacketReadJob();
+	readJob->imagePath = path;
+	readJob->web = web;
+	readJob->jobFlags = JobFlags::IO;
+	readJob->priority = web ? JobPriority::Normal : JobPriority::High;
+
+	JacketLoadingJob *job = new JacketLoadingJob();
+	job->readJob = Ref<JacketReadJob>(readJob);
+	job->target = image;
+	job->w = size.x;
+	job->h = size.y;
+	job->priority = JobPriority::High;
+	readJob->cancelToken = job->cancelToken;
+
+	Job read = job->readJob.As<JobBase>();
+	image->loadingJob = Ref<JobBase>(job);
+	image->loadingJob->AddDependency(read);
+	g_jobSheduler->Queue(read);
+	g_jobSheduler->Queue(image->loadingJob);
+}
+
+void Application::m_UpdateJacketJobs()
+{
+	// Jackets that are no longer requested every frame went off screen, skip loading them
+	const float jacketCancelTime = 0.25f;
+	const float now = m_jobTimer.SecondsAsFloat();
+	for (auto it = m_jacketImages.begin(); it != m_jacketImages.end();)
+	{
+		CachedJacketImage *image = it->second;
+		if (image && !image->loaded && image->loadingJob)
+		{
+			if (image->cancelled)
+			{
+				// Queued again when requested
+				delete image;
+				it = m_jacketImages.erase(it);
+				continue;
+			}
+			if (!image->loadingJob->IsCancelled() && now - image->lastUsage > jacketCancelTime)
+				image->loadingJob->Cancel();
+		}
+		it++;
+	}
+}
+
 void Application::SetScriptPath(lua_State *s)
 {
 	//Set path for 'require' (https://stackoverflow.com/questions/4125971/setting-the-global-lua-path-variable-from-c-c?lq=1)
@@ -2274,9 +2407,8 @@ void Application::SetLuaBindings(lua_State *state)
 	m_skinHttp.PushFunctions(state);
 }
 
-bool JacketLoadingJob::Run()
+bool JacketReadJob::Run()
 {
-	// Create loading task
 	if (web)
 	{
 		auto response = cpr::Get(imagePath);
@@ -2284,38 +2416,50 @@ bool JacketLoadingJob::Run()
 		{
 			return false;
 		}
-		Buffer b;
-		b.resize(response.text.length());
-		memcpy(b.data(), response.text.c_str(), b.size());
-		loadedImage = ImageRes::Create(b);
-		if (loadedImage.IsValid())
-		{
-			if (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h)
-			{
-				loadedImage->ReSize({w, h});
-			}
-		}
-		return loadedImage.IsValid();
+		data.resize(response.text.length());
+		memcpy(data.data(), response.text.c_str(), data.size());
 	}
 	else
 	{
-		loadedImage = ImageRes::Create(imagePath);
-		if (loadedImage.IsValid())
+		File file;
+		if (!file.OpenRead(imagePath))
+			return false;
+		data.resize(file.GetSize());
+		file.Read(data.data(), data.size());
+	}
+	// Too small to detect the image type
+	return data.size() >= 4;
+}
+bool JacketLoadingJob::Run()
+{
+	if (!readJob->IsSuccessfull())
+		return false;
+
+	loadedImage = ImageRes::Create(readJob->data);
+	if (loadedImage.IsValid())
+	{
+		if (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h)
 		{
-			if (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h)
-			{
-				loadedImage->ReSize({w, h});
-			}
+			loadedImage->ReSize({w, h});
 		}
-		return loadedImage.IsValid();
 	}
+	return loadedImage.IsValid();
 }
 void JacketLoadingJob::Finalize()
 {
+	// Free the file data
+	readJob.Release();
+	// Replaced by another job for the same image
+	if (!target)
+		return;
 	if (IsSuccessfull())
 	{
 		///TODO: Maybe do the nvgCreateImage in Run() instead
 		target->texture = nvgCreateImageRGBA(g_guiState.vg, loadedImage->GetSize().x, loadedImage->GetSize().y, 0, (unsigned char *)loadedImage->GetBits());
 		target->loaded = true;
 	}
+	else if (IsCancelled())
+	{
+		target->cancelled = true;
+	}
 }
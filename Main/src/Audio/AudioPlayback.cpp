@@ -162,6 +162,14 @@ bool AudioPlayback::HasEnded() const
 {
 	return m_music->HasEnded();
 }
+uint32 AudioPlayback::GetNumUnderruns() const
+{
+	return m_music->GetNumUnderruns();
+}
+uint64 AudioPlayback::GetUnderrunFrames() const
+{
+	return m_music->GetUnderrunFrames();
+}
 void AudioPlayback::SetEffect(uint32 index, HoldObjectState* object, class BeatmapPlayback& playback)
 {
 	// Don't use effects when using an FX track
@@ -394,8 +402,7 @@ void AudioPlayback::m_CleanupDSP(DSP*& ptr)
 {
 	if(ptr)
 	{
-		m_GetDSPTrack()->RemoveDSP(ptr);
-		delete ptr;
+		m_GetDSPTrack()->DestroyDSP(ptr);
 		ptr = nullptr;
 	}
 }
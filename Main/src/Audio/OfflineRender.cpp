@@ -0,0 +1,127 @@
+#include "stdafx.h"
+#include "OfflineRender.hpp"
+#include "Game.hpp"
+#include "Application.hpp"
+#include <Audio/Audio.hpp>
+
+// Header of a wav file with a single IEEE float data chunk
+struct WavFileHeader
+{
+	char riff[4] = { 'R', 'I', 'F', 'F' };
+	uint32 riffSize = 0;
+	char wave[4] = { 'W', 'A', 'V', 'E' };
+	char fmt[4] = { 'f', 'm', 't', ' ' };
+	uint32 fmtSize = 16;
+	uint16 format = 3;
+	uint16 numChannels = 2;
+	uint32 sampleRate = 0;
+	uint32 byteRate = 0;
+	uint16 blockAlign = 2 * sizeof(float);
+	uint16 bitsPerSample = 8 * sizeof(float);
+	char data[4] = { 'd', 'a', 't', 'a' };
+	uint32 dataSize = 0;
+};
+static_assert(sizeof(WavFileHeader) == 44, "Wav header should not be padded");
+
+bool OfflineRender::Init(const String& chartPath)
+{
+	m_beatmap = TryLoadMap(chartPath);
+	if(!m_beatmap)
+	{
+		Logf("Failed to load chart \"%s\"", Logger::Error, chartPath);
+		return false;
+	}
+
+	m_playback = BeatmapPlayback(*m_beatmap);
+	m_playback.OnFXBegin.Add(this, &OfflineRender::m_OnFXBegin);
+	m_playback.OnFXEnd.Add(this, &OfflineRender::m_OnFXEnd);
+	m_playback.OnEventChanged.Add(this, &OfflineRender::m_OnEventChanged);
+	m_playback.hittableObjectEnter = Scoring::missHitTime;
+	m_playback.hittableObjectLeave = Scoring::goodHitTime;
+	m_playback.Reset();
+
+	// Autoplay drives the laser filters and holds the FX buttons, so no input is attached
+	m_scoring.autoplay = true;
+	m_scoring.SetPlayback(m_playback);
+	m_scoring.Reset();
+	m_scoring.OnObjectHold.Add(this, &OfflineRender::m_OnObjectHold);
+	m_scoring.OnObjectReleased.Add(this, &OfflineRender::m_OnObjectReleased);
+
+	return m_audioPlayback.Init(m_playback, Path::RemoveLast(chartPath, nullptr));
+}
+bool OfflineRender::Render(const String& outputPath)
+{
+	File file;
+	if(!file.OpenWrite(outputPath))
+	{
+		Logf("Failed to open \"%s\" for writing", Logger::Error, outputPath);
+		return false;
+	}
+	FileWriter writer(file);
+	WavFileHeader header;
+	header.sampleRate = g_audio->GetSampleRate();
+	header.byteRate = header.sampleRate * header.blockAlign;
+	writer << header;
+
+	Vector<float> buffer(blockSize * 2);
+	const float deltaTime = (float)blockSize / (float)header.sampleRate;
+	m_renderedFrames = 0;
+
+	Timer timer;
+	m_audioPlayback.Play();
+	while(!m_audioPlayback.HasEnded())
+	{
+		// Same order as a gameplay tick, the chart follows the position of the music
+		m_playback.Update(m_audioPlayback.GetPosition());
+		m_audioPlayback.SetLaserFilterInput(m_scoring.GetLaserOutput(), m_scoring.IsLaserHeld(0, false) || m_scoring.IsLaserHeld(1, false));
+		m_audioPlayback.Tick(deltaTime);
+		m_audioPlayback.SetFXTrackEnabled(m_scoring.GetLaserActive() || m_scoring.GetFXActive());
+		m_scoring.Tick(deltaTime);
+
+		g_audio->Render(buffer.data(), blockSize);
+		writer.Serialize(buffer.data(), buffer.size() * sizeof(float));
+		m_renderedFrames += blockSize;
+	}
+
+	// Fill in the sizes now that the length is known
+	header.dataSize = (uint32)(m_renderedFrames * header.blockAlign);
+	header.riffSize = header.dataSize + sizeof(WavFileHeader) - 8;
+	writer.Seek(0);
+	writer << header;
+
+	double length = (double)m_renderedFrames / (double)header.sampleRate;
+	double renderTime = timer.SecondsAsDouble();
+	Logf("Rendered %.1f s of audio in %.2f s (%.1fx real time)", Logger::Info, length, renderTime, length / Math::Max(renderTime, 0.001));
+	return true;
+}
+void OfflineRender::m_OnFXBegin(HoldObjectState* object)
+{
+	m_audioPlayback.SetEffect(object->index - 4, object, m_playback);
+}
+void OfflineRender::m_OnFXEnd(HoldObjectState* object)
+{
+	m_audioPlayback.ClearEffect(object->index - 4, object);
+}
+void OfflineRender::m_OnEventChanged(EventKey key, EventData data)
+{
+	if(key == EventKey::LaserEffectType)
+	{
+		m_audioPlayback.SetLaserEffect(data.effectVal);
+	}
+	else if(key == EventKey::LaserEffectMix)
+	{
+		m_audioPlayback.SetLaserEffectMix(data.floatVal);
+	}
+}
+void OfflineRender::m_OnObjectHold(Input::Button, ObjectState* object)
+{
+	HoldObjectState* hold = (HoldObjectState*)object;
+	if(object->type == ObjectType::Hold && hold->effectType != EffectType::None)
+		m_audioPlayback.SetEffectEnabled(hold->index - 4, true);
+}
+void OfflineRender::m_OnObjectReleased(Input::Button, ObjectState* object)
+{
+	HoldObjectState* hold = (HoldObjectState*)object;
+	if(object->type == ObjectType::Hold && hold->effectType != EffectType::None)
+		m_audioPlayback.SetEffectEnabled(hold->index - 4, false);
+}
@@ -0,0 +1,104 @@
+#include "stdafx.h"
+#include "PreviewCache.hpp"
+#include "Application.hpp"
+#include <Audio/Audio.hpp>
+
+// Decodes the preview window of a file
+class PreviewJob : public JobBase
+{
+public:
+	String path;
+	int32 offset;
+	int32 length;
+	Ref<AudioClip> clip;
+
+	virtual bool Run() override
+	{
+		if(IsCancelled())
+			return false;
+		clip = g_audio->DecodeClip(path, offset, length);
+		return (bool)clip;
+	}
+};
+
+PreviewCache::~PreviewCache()
+{
+	Cancel();
+}
+void PreviewCache::SetMemoryBudget(size_t bytes)
+{
+	m_memoryBudget = bytes;
+	while(m_memoryUsage > m_memoryBudget && !m_entries.empty())
+	{
+		m_memoryUsage -= m_entries.back().clip->GetMemorySize();
+		m_entries.pop_back();
+	}
+}
+String PreviewCache::m_GetKey(const String& path, int32 offset, int32 length)
+{
+	return Utility::Sprintf("%s|%d|%d", path, offset, length);
+}
+void PreviewCache::Request(const String& path, int32 offset, int32 length)
+{
+	String key = m_GetKey(path, offset, length);
+	if(m_job && key == m_jobKey)
+		return;
+	Cancel();
+
+	for(auto it = m_entries.begin(); it != m_entries.end(); it++)
+	{
+		if(it->key == key)
+		{
+			// Mark as recently used
+			m_entries.splice(m_entries.begin(), m_entries, it);
+			OnLoaded.Call(path, m_entries.front().clip);
+			return;
+		}
+	}
+
+	PreviewJob* job = new PreviewJob();
+	job->path = path;
+	job->offset = offset;
+	job->length = length;
+	job->jobFlags = JobFlags::IO;
+	job->priority = JobPriority::High;
+	m_job = Job(job);
+	m_jobPath = path;
+	m_jobKey = key;
+	m_job->OnFinished.Add(this, &PreviewCache::m_OnJobFinished);
+	g_jobSheduler->Queue(m_job);
+}
+void PreviewCache::Cancel()
+{
+	if(!m_job)
+		return;
+	// A job that already started finishes on its own, its result is just not used
+	m_job->Cancel();
+	m_job->OnFinished.RemoveAll(this);
+	m_job.Release();
+	m_jobKey.clear();
+}
+void PreviewCache::m_OnJobFinished(Job job)
+{
+	if(job != m_job)
+		return;
+	m_job.Release();
+
+	Ref<AudioClip> clip = static_cast<PreviewJob*>(job.GetData())->clip;
+	if(clip)
+		m_Add(m_jobKey, clip);
+	m_jobKey.clear();
+	OnLoaded.Call(m_jobPath, clip);
+}
+void PreviewCache::m_Add(const String& key, Ref<AudioClip> clip)
+{
+	m_entries.AddFront({ key, clip });
+	m_memoryUsage += clip->GetMemorySize();
+
+	// Free the least recently used previews, the new one is kept even if it is over the budget on its own
+	while(m_memoryUsage > m_memoryBudget && m_entries.size() > 1)
+	{
+		m_memoryUsage -= m_entries.back().clip->GetMemorySize();
+		m_entries.pop_back();
+	}
+}
@@ -84,6 +84,7 @@ void CalibrationScreen::Render(float deltaTime)
 	{
 		m_track.DrawObjectState(renderQueue, m_playback, object, false, chipFXTimes);
 	}
+	m_track.FlushObjectBatch(renderQueue);
 	if (m_trackCover)
 	{
 		m_track.DrawTrackCover(renderQueue);
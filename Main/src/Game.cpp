@@ -61,6 +61,8 @@ public:
 	String m_chartRootPath;
 	String m_chartPath;
 	ChartIndex m_chartIndex;
+	// Copies of the chart's scores, the database can free its own while the game is running
+	Vector<ScoreIndex> m_scores;
 
 private:
 	bool m_playing = true;
@@ -182,6 +184,15 @@ public:
 		// Store path to map
 		m_chartPath = Path::Normalize(chart.path);
 		m_chartIndex = chart;
+		for (ScoreIndex* score : chart.scores)
+		{
+			m_scores.Add(*score);
+		}
+		m_chartIndex.scores.clear();
+		for (ScoreIndex& score : m_scores)
+		{
+			m_chartIndex.scores.Add(&score);
+		}
 		m_flags = flags;
 		// Get Parent path
 		m_chartRootPath = Path::RemoveLast(m_chartPath, nullptr);
@@ -593,6 +604,8 @@ public:
 
 		if(!m_paused)
 			TickGameplay(deltaTime);
+		else
+			m_scoring.SetInputTimeReference(g_input.GetTime(), 0.0f); // Map time stands still while paused
 
 
 		// Update hispeed or hidden range
@@ -731,6 +744,7 @@ public:
 			if(m_hiddenObjects.find(object) == m_hiddenObjects.end())
 				m_track->DrawObjectState(renderQueue, m_playback, object, m_scoring.IsObjectHeld(object), chipFXTimes);
 		}
+		m_track->FlushObjectBatch(renderQueue);
 		if(m_showCover)
 			m_track->DrawTrackCover(renderQueue);
 
@@ -1069,8 +1083,10 @@ public:
 		const BeatmapSettings& beatmapSettings = m_beatmap->GetMapSettings();
 
 		// Update beatmap playback
+		uint32 inputTime = g_input.GetTime();
 		MapTime playbackPositionMs = m_audioPlayback.GetPosition() - m_audioOffset;
 		m_playback.Update(playbackPositionMs);
+		m_scoring.SetInputTimeReference(inputTime, m_audioPlayback.GetPlaybackSpeed());
 
 		MapTime delta = playbackPositionMs - m_lastMapTime;
 		int32 beatStart = 0;
@@ -1158,6 +1174,7 @@ public:
 				while (!game) // ensure a working game
 				{
 					ChartIndex* chart = m_db->GetRandomChart();
+					m_db->GetScores(chart);
 					game = Game::Create(*chart, m_flags);
 				}
 				game->GetScoring().autoplay = true;
@@ -1207,6 +1224,7 @@ public:
 			while (!game) // ensure a working game
 			{
 				ChartIndex* diff = m_db->GetRandomChart();
+				m_db->GetScores(diff);
 				game = Game::Create(*diff, m_flags);
 			}
 			game->GetScoring().autoplay = true;
@@ -1343,7 +1361,22 @@ public:
 		textPos.y += RenderText(bms.title, textPos).y;
 		textPos.y += RenderText(bms.artist, textPos).y;
 		textPos.y += RenderText(Utility::Sprintf("%.2f FPS", g_application->GetRenderFPS()), textPos).y;
-		textPos.y += RenderText(Utility::Sprintf("Audio Offset: %d ms", g_audio->audioLatency), textPos).y;
+		const RenderStats& renderStats = g_gl->GetLastFrameStats();
+		textPos.y += RenderText(Utility::Sprintf("Draw Calls: %d (Programs: %d, Textures: %d, States: %d)",
+			renderStats.drawCalls, renderStats.programBinds, renderStats.textureBinds, renderStats.stateChanges), textPos).y;
+		// Number of draws it would take to draw every instance separately
+		textPos.y += RenderText(Utility::Sprintf("Instanced: %d draws, %d objects (%d draws without instancing)",
+			renderStats.instancedDrawCalls, renderStats.instances,
+			renderStats.drawCalls - renderStats.instancedDrawCalls + renderStats.instances), textPos).y;
+		textPos.y += RenderText(Utility::Sprintf("Laser Geometry: %.1f KB (Uploaded: %.1f KB)",
+			m_track->GetLaserMemory() / 1024.0f, m_track->GetLaserUploadedBytes() / 1024.0f), textPos).y;
+		AudioTiming audioTiming = g_audio->GetTiming();
+		textPos.y += RenderText(Utility::Sprintf("Audio Latency: %.1f ms (Jitter: %.2f ms)",
+			audioTiming.latency * 1000.0, audioTiming.jitter * 1000.0), textPos).y;
+		textPos.y += RenderText(Utility::Sprintf("Audio Drift: %.2f ms (Resyncs: %d)",
+			audioTiming.drift * 1000.0, audioTiming.numResyncs), textPos).y;
+		textPos.y += RenderText(Utility::Sprintf("Audio Underruns: %d (%llu frames)",
+			m_audioPlayback.GetNumUnderruns(), m_audioPlayback.GetUnderrunFrames()), textPos).y;
 
 		float currentBPM = (float)(60000.0 / tp.beatDuration);
 		textPos.y += RenderText(Utility::Sprintf("BPM: %.1f", currentBPM), textPos).y;
@@ -1492,8 +1525,8 @@ public:
 		{
 			if (m_fxSamples[st->sampleIndex])
 			{
-				m_fxSamples[st->sampleIndex]->SetVolume(st->sampleVolume);
-				m_fxSamples[st->sampleIndex]->Play();
+				// Each hit gets its own voice so overlapping hits don't cut each other off
+				m_fxSamples[st->sampleIndex]->PlayVoice(st->sampleVolume);
 			}
 		}
 
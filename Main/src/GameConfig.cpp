@@ -43,6 +43,10 @@ void GameConfig::InitDefaults()
 	Set(GameConfigKeys::ModSpeed, 300.0f);
 	Set(GameConfigKeys::AutoSaveSpeed, true);
 	Set(GameConfigKeys::SongFolder, "songs");
+	Set(GameConfigKeys::WatchSongFolder, false);
+	Set(GameConfigKeys::ScoresPerChart, 0);
+	Set(GameConfigKeys::MaxCachedScores, 2000);
+	Set(GameConfigKeys::JobIOThreads, 1);
 	Set(GameConfigKeys::Skin, "Default");
 	Set(GameConfigKeys::Laser0Color, 200.0f);
 	Set(GameConfigKeys::Laser1Color, 330.0f);
@@ -124,6 +128,10 @@ void GameConfig::InitDefaults()
 	Set(GameConfigKeys::EditorPath, "PathToEditor");
 	Set(GameConfigKeys::EditorParamsFormat, "%s");
 	Set(GameConfigKeys::WASAPI_Exclusive, false);
+	Set(GameConfigKeys::AudioDecodeAhead, 200);
+	SetEnum<Enum_ResampleQuality>(GameConfigKeys::AudioResampleQuality, ResampleQuality::Medium);
+	// Memory for decoded song previews in MB
+	Set(GameConfigKeys::PreviewCacheSize, 64);
 	Set(GameConfigKeys::MuteUnfocused, false);
 
 	Set(GameConfigKeys::CheckForUpdates, true);
@@ -0,0 +1,161 @@
+#include "stdafx.h"
+#include "GameSimulation.hpp"
+#include "GameConfig.hpp"
+#include <Shared/TextStream.hpp>
+
+bool GameSimulation::Init(const String& chartPath, GameFlags flags)
+{
+	m_beatmap = TryLoadMap(chartPath);
+	if(!m_beatmap)
+	{
+		Logf("Failed to load chart \"%s\"", Logger::Error, chartPath);
+		return false;
+	}
+	m_flags = flags;
+
+	// Same end time as the game, the end of the last object
+	m_endTime = 0;
+	for(ObjectState* obj : m_beatmap->GetLinearObjects())
+	{
+		MapTime end = obj->time;
+		if(obj->type == ObjectType::Hold)
+			end += ((HoldObjectState*)obj)->duration;
+		else if(obj->type == ObjectType::Laser)
+			end += ((LaserObjectState*)obj)->duration;
+		else if(obj->type == ObjectType::Event)
+			continue;
+		m_endTime = Math::Max(m_endTime, end);
+	}
+
+	m_playback = BeatmapPlayback(*m_beatmap);
+	m_playback.hittableObjectEnter = Scoring::missHitTime + g_gameConfig.GetInt(GameConfigKeys::InputOffset);
+	m_playback.hittableObjectLeave = Scoring::goodHitTime;
+	m_scoring.SetPlayback(m_playback);
+	return true;
+}
+bool GameSimulation::LoadInput(const String& inputPath)
+{
+	File file;
+	if(!file.OpenRead(inputPath))
+	{
+		Logf("Failed to open input file \"%s\"", Logger::Error, inputPath);
+		return false;
+	}
+	FileReader reader(file);
+
+	String line;
+	uint32 lineNumber = 0;
+	while(TextStream::ReadLine(reader, line))
+	{
+		lineNumber++;
+		line.TrimBack('\r');
+		line.Trim();
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		int32 time;
+		char name[32];
+		float value;
+		if(sscanf(*line, "%d %31s %f", &time, name, &value) != 3)
+		{
+			Logf("Invalid input event on line %d of \"%s\"", Logger::Error, lineNumber, inputPath);
+			return false;
+		}
+
+		InputEvent event;
+		event.time = time;
+		if(strcmp(name, "Laser0") == 0 || strcmp(name, "Laser1") == 0)
+		{
+			event.laser = name[5] - '0';
+			event.laserSpeed = value;
+		}
+		else
+		{
+			event.button = Input::Enum_Button::FromString(name);
+			if(event.button > Input::Button::BT_S)
+			{
+				Logf("Invalid button \"%s\" on line %d of \"%s\"", Logger::Error, name, lineNumber, inputPath);
+				return false;
+			}
+			event.pressed = value != 0.0f;
+		}
+		AddInput(event);
+	}
+	return true;
+}
+void GameSimulation::AddInput(const InputEvent& event)
+{
+	// Recorded input is mostly in order already
+	auto it = m_inputEvents.end();
+	while(it != m_inputEvents.begin() && (it - 1)->time > event.time)
+		it--;
+	m_inputEvents.insert(it, event);
+}
+void GameSimulation::Run(float stepsPerSecond)
+{
+	assert(m_beatmap && stepsPerSecond > 0.0f);
+	const double stepTime = 1000.0 / stepsPerSecond;
+	const float deltaTime = 1.0f / stepsPerSecond;
+
+	m_playback.Reset();
+	m_scoring.autoplay = m_inputEvents.empty();
+	m_scoring.SetFlags(m_flags);
+	m_scoring.SetEndTime(m_endTime);
+	m_scoring.SetInput(&m_input);
+	m_scoring.Reset();
+	m_laserSpeeds[0] = 0.0f;
+	m_laserSpeeds[1] = 0.0f;
+
+	Timer timer;
+	m_numSteps = 0;
+	size_t nextEvent = 0;
+	for(double time = 0.0;; time += stepTime)
+	{
+		MapTime mapTime = (MapTime)time;
+
+		// Input is received before the gameplay tick that handles it, like window events
+		//	the input clock runs on map time so events are judged at their exact time
+		for(; nextEvent < m_inputEvents.size() && m_inputEvents[nextEvent].time <= mapTime; nextEvent++)
+			m_ApplyInput(m_inputEvents[nextEvent]);
+		for(uint32 i = 0; i < 2; i++)
+			m_input.SimulateLaser(i, m_laserSpeeds[i] * deltaTime);
+
+		// Same order as a gameplay tick
+		m_playback.Update(mapTime);
+		// Ticks can be further apart than the correction limit at low rates, the events are exact
+		m_scoring.SetInputTimeReference((uint32)mapTime, 1.0f, true);
+		m_scoring.Tick(deltaTime);
+		m_numSteps++;
+
+		if((m_flags & GameFlags::Hard) != GameFlags::None && m_scoring.currentGauge == 0.f)
+			break;
+		// All ticks have left their hit window
+		if(mapTime > m_endTime + Scoring::missHitTime)
+			break;
+	}
+	m_scoring.FinishGame();
+	m_runTime = timer.SecondsAsDouble();
+
+	// Release everything for the next run, scoring doesn't listen to the input anymore
+	for(uint32 i = 0; i <= (uint32)Input::Button::BT_S; i++)
+		m_input.SimulateButton((Input::Button)i, false, 0);
+	for(uint32 i = 0; i < 2; i++)
+		m_input.SimulateLaser(i, 0.0f);
+}
+void GameSimulation::LogResult() const
+{
+	uint32 score = m_scoring.CalculateCurrentScore();
+	Logf("Score: %08d (%s), gauge: %.1f%%, max combo: %d", Logger::Info,
+		score, Scoring::CalculateGrade(score), m_scoring.currentGauge * 100.0f, m_scoring.maxComboCounter);
+	Logf("Critical: %d, near: %d (early: %d, late: %d), miss: %d", Logger::Info,
+		m_scoring.categorizedHits[2], m_scoring.categorizedHits[1], m_scoring.timedHits[0], m_scoring.timedHits[1], m_scoring.categorizedHits[0]);
+	Logf("Simulated %d ticks in %.3f s (%.1f us per tick)", Logger::Info,
+		m_numSteps, m_runTime, m_runTime * 1000000.0 / Math::Max(m_numSteps, 1u));
+}
+void GameSimulation::m_ApplyInput(const InputEvent& event)
+{
+	if(event.button == Input::Button::Length)
+		m_laserSpeeds[event.laser] = event.laserSpeed;
+	else
+		m_input.SimulateButton(event.button, event.pressed, (uint32)event.time);
+}
@@ -198,6 +198,15 @@ bool Input::GetButton(Button button) const
 {
 	return m_buttonStates[(size_t)button];
 }
+uint32 Input::GetButtonTime(Button button) const
+{
+	return m_buttonTimes[(size_t)button];
+}
+uint32 Input::GetTime() const
+{
+	// Same clock as the timestamps of SDL events
+	return SDL_GetTicks();
+}
 
 float Input::GetAbsoluteLaser(int laser) const
 {
@@ -250,6 +259,15 @@ float Input::GetAbsoluteInputLaserDir(uint32 laserIdx)
 {
 	return m_rawLaserStates[laserIdx];
 }
+void Input::SimulateButton(Button button, bool pressed, uint32 time)
+{
+	m_OnButtonInput(button, pressed, time);
+}
+void Input::SimulateLaser(uint32 laserIdx, float dir)
+{
+	m_laserStates[laserIdx] = dir;
+	m_rawLaserStates[laserIdx] = dir;
+}
 void Input::m_InitKeyboardMapping()
 {
 	memset(m_buttonStates, 0, sizeof(m_buttonStates));
@@ -305,12 +323,13 @@ void Input::m_InitControllerMapping()
 	}
 }
 
-void Input::m_OnButtonInput(Button b, bool pressed)
+void Input::m_OnButtonInput(Button b, bool pressed, uint32 time)
 {
 	bool& state = m_buttonStates[(size_t)b];
 	if(state != pressed)
 	{
 		state = pressed;
+		m_buttonTimes[(size_t)b] = time;
 		if(state)
 		{
 			if (b == Button::BT_S && m_backComboInstant && Are3BTsHeld())
@@ -353,14 +372,14 @@ void Input::m_OnGamepadButtonPressed(uint8 button)
 	// Handle button mappings
 	auto it = m_controllerMap.equal_range(button);
 	for(auto it1 = it.first; it1 != it.second; it1++)
-		m_OnButtonInput(it1->second, true);
+		m_OnButtonInput(it1->second, true, m_window->GetEventTime());
 }
 void Input::m_OnGamepadButtonReleased(uint8 button)
 {
 	// Handle button mappings
 	auto it = m_controllerMap.equal_range(button);
 	for(auto it1 = it.first; it1 != it.second; it1++)
-		m_OnButtonInput(it1->second, false);
+		m_OnButtonInput(it1->second, false, m_window->GetEventTime());
 }
 
 void Input::OnKeyPressed(int32 key)
@@ -368,14 +387,14 @@ void Input::OnKeyPressed(int32 key)
 	// Handle button mappings
 	auto it = m_buttonMap.equal_range(key);
 	for(auto it1 = it.first; it1 != it.second; it1++)
-		m_OnButtonInput(it1->second, true);
+		m_OnButtonInput(it1->second, true, m_window->GetEventTime());
 }
 void Input::OnKeyReleased(int32 key)
 {
 	// Handle button mappings
 	auto it = m_buttonMap.equal_range(key);
 	for(auto it1 = it.first; it1 != it.second; it1++)
-		m_OnButtonInput(it1->second, false);
+		m_OnButtonInput(it1->second, false, m_window->GetEventTime());
 }
 
 void Input::OnMouseMotion(int32 x, int32 y)
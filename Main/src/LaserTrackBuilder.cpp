@@ -20,12 +20,13 @@ LaserTrackBuilder::LaserTrackBuilder(class OpenGL* gl, class Track* track, uint3
 	laserEntryTextureSize = track->laserTailTextures[0]->GetSize();
 	laserExitTextureSize = track->laserTailTextures[2]->GetSize();
 }
-Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser)
+const LaserVertices& LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, LaserObjectState* laser)
 {
-	if(m_objectCache.Contains(laser))
-		return m_objectCache[laser];
+	auto it = m_objectCache.find(laser);
+	if(it != m_objectCache.end())
+		return it->second;
 
-	Mesh newMesh = MeshRes::Create(m_gl);
+	LaserVertices& verts = m_objectCache[laser];
 
 	float length = playback.DurationToViewDistanceAtTime(laser->time, laser->duration);
 
@@ -70,7 +71,7 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 		Rect3D centerTop = centerBottom;
 		centerTop.pos.y = centerMiddle.Top();
 
-		Vector<MeshGenerators::SimpleVertex> verts =
+		verts =
 		{
 			{ { centerMiddle.Left() + offsetB, centerMiddle.Bottom(),  0.0f },{ uvB, 0.0f } }, // BL
 			{ { centerMiddle.Right() + offsetB, centerMiddle.Bottom(),  0.0f },{ uvB, 1.0f } }, // BR
@@ -162,9 +163,6 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 			for (auto& v : rightVerts)
 				verts.Add(v);
 		}
-
-		newMesh->SetData(verts);
-		newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
 	}
 	else
 	{
@@ -192,7 +190,7 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 		float vMin = 0.0f;
 		float vMax = (int)((length * laserLengthScale) / actualLaserHeight);
 
-		Vector<MeshGenerators::SimpleVertex> verts =
+		verts =
 		{
 			{ { points[0].x - actualLaserWidth, points[0].y,  0.0f },{ uMin, vMax } }, // BL
 			{ { points[0].x + actualLaserWidth, points[0].y,  0.0f },{ uMax, vMax } }, // BR
@@ -202,24 +200,19 @@ Mesh LaserTrackBuilder::GenerateTrackMesh(class BeatmapPlayback& playback, Laser
 			{ { points[1].x + actualLaserWidth, points[1].y,  0.0f },{ uMax, vMin } }, // TR
 			{ { points[1].x - actualLaserWidth, points[1].y,  0.0f },{ uMin, vMin } }, // TL
 		};
-
-
-		newMesh->SetData(verts);
-		newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
 	}
 
-	// Cache this mesh
-	m_objectCache.Add(laser, newMesh);
-	return newMesh;
+	return verts;
 }
 
-Mesh LaserTrackBuilder::GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser)
+const LaserVertices& LaserTrackBuilder::GenerateTrackEntry(class BeatmapPlayback& playback, LaserObjectState* laser)
 {
 	assert(laser->prev == nullptr);
-	if(m_cachedEntries.Contains(laser))
-		return m_cachedEntries[laser];
+	auto it = m_cachedEntries.find(laser);
+	if(it != m_cachedEntries.end())
+		return it->second;
 
-	Mesh newMesh = MeshRes::Create(m_gl);
+	LaserVertices& verts = m_cachedEntries[laser];
 
 	// Starting point of laser
 	float startingX = laser->points[0] * effectiveWidth - effectiveWidth * 0.5f;
@@ -231,26 +224,20 @@ Mesh LaserTrackBuilder::GenerateTrackEntry(class BeatmapPlayback& playback, Lase
 	// Length of the tail
 	float length = (float)laserEntryTextureSize.y / (float)laserEntryTextureSize.x * actualLaserWidth;
 
-	Vector<MeshGenerators::SimpleVertex> verts;
 	Rect3D pos = Rect3D(Vector2(startingX - actualLaserWidth, -length), Vector2(actualLaserWidth * 2, length));
 	Rect uv = Rect(-0.5f, 0.0f, 1.5f, 1.0f);
 	MeshGenerators::GenerateSimpleXYQuad(pos, uv, verts);
 
-	newMesh->SetData(verts);
-	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
-
-	// Cache this mesh
-	m_cachedEntries.Add(laser, newMesh);
-	return newMesh;
-
+	return verts;
 }
-Mesh LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser)
+const LaserVertices& LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, LaserObjectState* laser)
 {
 	assert(laser->next == nullptr);
-	if(m_cachedExits.Contains(laser))
-		return m_cachedExits[laser];
+	auto it = m_cachedExits.find(laser);
+	if(it != m_cachedExits.end())
+		return it->second;
 
-	Mesh newMesh = MeshRes::Create(m_gl);
+	LaserVertices& verts = m_cachedExits[laser];
 
 	// Ending point of laser 
 	float startingX = laser->points[1] * effectiveWidth - effectiveWidth * 0.5f;
@@ -271,17 +258,59 @@ Mesh LaserTrackBuilder::GenerateTrackExit(class BeatmapPlayback& playback, Laser
 		prevLength = playback.DurationToViewDistanceAtTime(laser->time, laser->duration) * laserLengthScale;
 	}
 
-	Vector<MeshGenerators::SimpleVertex> verts;
 	Rect3D pos = Rect3D(Vector2(startingX - actualLaserWidth, prevLength), Vector2(actualLaserWidth * 2, length));
 	Rect uv = Rect(-0.5f, 0.0f, 1.5f, 1.0f);
 	MeshGenerators::GenerateSimpleXYQuad(pos, uv, verts);
 
-	newMesh->SetData(verts);
-	newMesh->SetPrimitiveType(PrimitiveType::TriangleList);
+	return verts;
+}
+
+void LaserTrackBuilder::AddToBatch(uint32 batch, const LaserVertices& verts, float offset)
+{
+	assert(batch < numBatches);
+	LaserVertices& batchVertices = m_batchVertices[batch];
+	for(const auto& v : verts)
+	{
+		batchVertices.push_back(v);
+		batchVertices.back().pos.y += offset;
+	}
+}
+Mesh LaserTrackBuilder::UploadBatch(uint32 batch)
+{
+	assert(batch < numBatches);
+	LaserVertices& batchVertices = m_batchVertices[batch];
+	if(batchVertices.empty())
+		return Mesh();
+
+	Mesh& mesh = m_batchMeshes[batch];
+	if(!mesh)
+	{
+		mesh = MeshRes::Create(m_gl);
+		mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+	}
+	mesh->SetData(batchVertices);
 
-	// Cache this mesh
-	m_cachedExits.Add(laser, newMesh);
-	return newMesh;
+	m_batchBytes[batch] = batchVertices.size() * sizeof(MeshGenerators::SimpleVertex);
+	m_uploadedBytes += m_batchBytes[batch];
+	batchVertices.clear();
+	return mesh;
+}
+size_t LaserTrackBuilder::GetBatchBytes() const
+{
+	size_t bytes = 0;
+	for(uint32 i = 0; i < numBatches; i++)
+		bytes += m_batchBytes[i];
+	return bytes;
+}
+size_t LaserTrackBuilder::GetCacheBytes() const
+{
+	size_t bytes = 0;
+	for(auto cache : { &m_objectCache, &m_cachedEntries, &m_cachedExits })
+	{
+		for(auto& it : *cache)
+			bytes += it.second.size() * sizeof(MeshGenerators::SimpleVertex);
+	}
+	return bytes;
 }
 
 float LaserTrackBuilder::GetLaserLengthScaleAt(MapTime time)
@@ -317,7 +346,7 @@ void LaserTrackBuilder::m_RecalculateConstants()
 	effectiveWidth = m_trackWidth - m_laserWidth;
 }
 
-void LaserTrackBuilder::m_Cleanup(MapTime newTime, Map<LaserObjectState*, Mesh>& arr)
+void LaserTrackBuilder::m_Cleanup(MapTime newTime, Map<LaserObjectState*, LaserVertices>& arr)
 {
 	// Cleanup unused meshes
 	for(auto it = arr.begin(); it != arr.end();)
@@ -341,6 +370,9 @@ void LaserTrackBuilder::Reset()
 }
 void LaserTrackBuilder::Update(MapTime newTime)
 {
+	m_lastUploadedBytes = m_uploadedBytes;
+	m_uploadedBytes = 0;
+
 	m_Cleanup(newTime, m_objectCache);
 	m_Cleanup(newTime, m_cachedEntries);
 	m_Cleanup(newTime, m_cachedExits);
@@ -370,6 +370,9 @@ bool MultiplayerScreen::m_handleStartPacket(nlohmann::json& packet)
 	if (is_mirror)
 		flags = flags | GameFlags::Mirror;
 
+	// The game loads the replays of all scores
+	m_mapDatabase->GetScores(chart);
+
 	// Create the game using the Create that takes the MultiplayerScreen class
 	Game* game = Game::Create(this, *(chart), flags);
 	if (!game)
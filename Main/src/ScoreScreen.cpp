@@ -49,7 +49,8 @@ private:
 	Vector<nlohmann::json> const* m_stats;
 	int m_numPlayersSeen = 0;
 
-	Vector<ScoreIndex*> m_highScores;
+	// Copied, the game that owns the scores is removed while the score screen is shown
+	Vector<ScoreIndex> m_highScores;
 	Vector<SimpleHitStat> m_simpleHitStats;
 
 	BeatmapSettings m_beatmapSettings;
@@ -214,15 +215,23 @@ public:
 	}
 
 	ScoreScreen_Impl(class Game* game, bool multiplayer,
-		String uid, Vector<nlohmann::json> const* multistats)
+		String uid, Vector<nlohmann::json> const* multistats) : m_mapDatabase(true)
 	{
+		// Only used to store the score, no need to load more than the song wheel does
+		m_mapDatabase.SetScoreLimits(g_gameConfig.GetInt(GameConfigKeys::ScoresPerChart), g_gameConfig.GetInt(GameConfigKeys::MaxCachedScores));
+		m_mapDatabase.FinishInit();
+
 		m_displayIndex = 0;
 
 		Scoring& scoring = game->GetScoring();
 		m_autoplay = scoring.autoplay;
-		m_highScores = game->GetChartIndex().scores;
+		for (ScoreIndex* score : game->GetChartIndex().scores)
+		{
+			m_highScores.Add(*score);
+		}
 		m_autoButtons = scoring.autoplayButtons;
 		m_chartIndex = game->GetChartIndex();
+		m_chartIndex.scores.clear();
 
 		// XXX add data for multi
 		m_gaugeSamples = game->GetGaugeSamples();
@@ -403,14 +412,14 @@ public:
 			{
 				lua_pushinteger(m_lua, scoreIndex++);
 				lua_newtable(m_lua);
-				m_PushFloatToTable("gauge", score->gauge);
-				m_PushIntToTable("flags", score->gameflags);
-				m_PushIntToTable("score", score->score);
-				m_PushIntToTable("perfects", score->crit);
-				m_PushIntToTable("goods", score->almost);
-				m_PushIntToTable("misses", score->miss);
-				m_PushIntToTable("timestamp", score->timestamp);
-				m_PushIntToTable("badge", Scoring::CalculateBadge(*score));
+				m_PushFloatToTable("gauge", score.gauge);
+				m_PushIntToTable("flags", score.gameflags);
+				m_PushIntToTable("score", score.score);
+				m_PushIntToTable("perfects", score.crit);
+				m_PushIntToTable("goods", score.almost);
+				m_PushIntToTable("misses", score.miss);
+				m_PushIntToTable("timestamp", score.timestamp);
+				m_PushIntToTable("badge", Scoring::CalculateBadge(score));
 				lua_settable(m_lua, -3);
 			}
 			lua_settable(m_lua, -3);
@@ -508,7 +517,7 @@ public:
 			AutoScoreScreenshotSettings screensetting = g_gameConfig.GetEnum<Enum_AutoScoreScreenshotSettings>(GameConfigKeys::AutoScoreScreenshot);
 			if (screensetting == AutoScoreScreenshotSettings::Always ||
 				(screensetting == AutoScoreScreenshotSettings::Highscore && m_highScores.empty()) ||
-				(screensetting == AutoScoreScreenshotSettings::Highscore && m_score > m_highScores.front()->score))
+				(screensetting == AutoScoreScreenshotSettings::Highscore && m_score > m_highScores.front().score))
 			{
 				Capture();
 			}
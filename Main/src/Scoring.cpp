@@ -9,6 +9,8 @@ const MapTime Scoring::holdHitTime = 138;
 const MapTime Scoring::goodHitTime = 92;
 const MapTime Scoring::perfectHitTime = 46;
 const float Scoring::idleLaserSpeed = 1.0f;
+// Largest difference between a button event and the last playback update that is corrected for (ms)
+static const int32 maxInputTimeCorrection = 100;
 
 Scoring::Scoring()
 {
@@ -96,6 +98,13 @@ void Scoring::SetInput(Input* input)
 		m_input->OnButtonReleased.Add(this, &Scoring::m_OnButtonReleased);
 	}
 }
+void Scoring::SetInputTimeReference(uint32 inputTime, float speed, bool exact)
+{
+	m_inputTimeReference = inputTime;
+	m_inputTimeSpeed = speed;
+	m_inputTimeExact = exact;
+	m_hasInputTimeReference = true;
+}
 void Scoring::SetFlags(GameFlags flags)
 {
 	m_flags = flags;
@@ -123,6 +132,7 @@ void Scoring::Reset()
 	maxComboCounter = 0;
 	comboState = 2;
 	m_assistTime = m_assistLevel * 0.1f;
+	m_hasInputTimeReference = false;
 
 	// Reset laser positions
 	laserTargetPositions[0] = 0.0f;
@@ -198,6 +208,7 @@ void Scoring::Reset()
 	memset(m_currentLaserSegments, 0, sizeof(m_currentLaserSegments));
 	m_CleanupHitStats();
 	m_CleanupTicks();
+	m_BuildTicks();
 
 	OnScoreChanged.Call(0);
 }
@@ -220,9 +231,9 @@ void Scoring::Tick(float deltaTime)
 	{
 		for (size_t i = 0; i < 6; i++)
 		{
-			if (m_ticks[i].size() > 0)
+			ScoreTick* tick = m_GetFrontTick(i);
+			if (tick)
 			{
-				auto tick = m_ticks[i].front();
 				if (tick->HasFlag(TickFlags::Hold))
 				{
 					if (tick->object->time <= m_playback->GetLastTime())
@@ -495,6 +506,8 @@ void Scoring::m_CalculateLaserTicks(LaserObjectState* laserRoot, Vector<ScoreTic
 	MapTime sectionStartTime = laserRoot->time;
 	MapTime combinedDuration = 0;
 	LaserObjectState* lastSlam = nullptr;
+	// Ticks can be added after the ones of other lasers
+	const size_t firstTick = ticks.size();
 	auto AddTicks = [&]()
 	{
 		uint32 numTicks = (uint32)Math::Floor((double)combinedDuration / tickInterval);
@@ -549,7 +562,7 @@ void Scoring::m_CalculateLaserTicks(LaserObjectState* laserRoot, Vector<ScoreTic
 		}
 	}
 	AddTicks();
-	if (ticks.size() > 0)
+	if (ticks.size() > firstTick)
 		ticks.back().SetFlag(TickFlags::End);
 }
 void Scoring::m_OnFXBegin(HoldObjectState* obj)
@@ -558,35 +571,60 @@ void Scoring::m_OnFXBegin(HoldObjectState* obj)
 		m_SetHoldObject((ObjectState*)obj, obj->index);
 }
 
+void Scoring::m_BuildTicks()
+{
+	// Objects become hittable in the order of the linear object list, so every lane stays sorted by that order
+	for (ObjectState* obj : m_playback->GetBeatmap().GetLinearObjects())
+	{
+		// The following code registers which ticks exist depending on the object type / duration
+		if (obj->type == ObjectType::Single)
+		{
+			ButtonObjectState* bt = (ButtonObjectState*)obj;
+			ScoreTick& t = m_ticks[bt->index].Add(ScoreTick(obj));
+			t.time = bt->time;
+			t.SetFlag(TickFlags::Button);
+			m_tickObjectEnds[bt->index].Add((uint32)m_ticks[bt->index].size());
+		}
+		else if (obj->type == ObjectType::Hold)
+		{
+			HoldObjectState* hold = (HoldObjectState*)obj;
+
+			// Add all hold ticks
+			Vector<MapTime> holdTicks;
+			m_CalculateHoldTicks(hold, holdTicks);
+			for (size_t i = 0; i < holdTicks.size(); i++)
+			{
+				ScoreTick& t = m_ticks[hold->index].Add(ScoreTick(obj));
+				t.SetFlag(TickFlags::Hold);
+				if (i == 0 && !hold->prev)
+					t.SetFlag(TickFlags::Start);
+				if (i == holdTicks.size() - 1 && !hold->next)
+					t.SetFlag(TickFlags::End);
+				t.time = holdTicks[i];
+			}
+			m_tickObjectEnds[hold->index].Add((uint32)m_ticks[hold->index].size());
+		}
+		else if (obj->type == ObjectType::Laser)
+		{
+			LaserObjectState* laser = (LaserObjectState*)obj;
+			if (!laser->prev) // Only register root laser objects
+			{
+				// All laser ticks, including slam segments
+				m_CalculateLaserTicks(laser, m_ticks[laser->index + 6]);
+				m_tickObjectEnds[laser->index + 6].Add((uint32)m_ticks[laser->index + 6].size());
+			}
+		}
+	}
+}
 void Scoring::m_OnObjectEntered(ObjectState* obj)
 {
-	// The following code registers which ticks exist depending on the object type / duration
 	if (obj->type == ObjectType::Single)
 	{
-		ButtonObjectState* bt = (ButtonObjectState*)obj;
-		ScoreTick* t = m_ticks[bt->index].Add(new ScoreTick(obj));
-		t->time = bt->time;
-		t->SetFlag(TickFlags::Button);
-
+		m_EnterTicks(((ButtonObjectState*)obj)->index);
 	}
 	else if (obj->type == ObjectType::Hold)
 	{
-		const TimingPoint* tp = m_playback->GetTimingPointAt(obj->time);
-		HoldObjectState* hold = (HoldObjectState*)obj;
-
-		// Add all hold ticks
-		Vector<MapTime> holdTicks;
-		m_CalculateHoldTicks(hold, holdTicks);
-		for (size_t i = 0; i < holdTicks.size(); i++)
-		{
-			ScoreTick* t = m_ticks[hold->index].Add(new ScoreTick(obj));
-			t->SetFlag(TickFlags::Hold);
-			if (i == 0 && !hold->prev)
-				t->SetFlag(TickFlags::Start);
-			if (i == holdTicks.size() - 1 && !hold->next)
-				t->SetFlag(TickFlags::End);
-			t->time = holdTicks[i];
-		}
+		m_EnterTicks(((HoldObjectState*)obj)->index);
 	}
 	else if (obj->type == ObjectType::Laser)
 	{
@@ -613,14 +651,7 @@ void Scoring::m_OnObjectEntered(ObjectState* obj)
 					lasersAreExtend[laser->index] = laser->flags & LaserObjectState::flag_Extended;
 				}
 			}
-			// All laser ticks, including slam segments
-			Vector<ScoreTick> laserTicks;
-			m_CalculateLaserTicks(laser, laserTicks);
-			for (size_t i = 0; i < laserTicks.size(); i++)
-			{
-				// Add copy
-				m_ticks[laser->index + 6].Add(new ScoreTick(laserTicks[i]));
-			}
+			m_EnterTicks(laser->index + 6);
 		}
 
 		// Add to laser segment queue
@@ -648,12 +679,10 @@ void Scoring::m_UpdateTicks()
 	{
 		Input::Button button = (Input::Button)buttonCode;
 
-		// List of ticks for the current button code
-		auto& ticks = m_ticks[buttonCode];
-		for (uint32 i = 0; i < ticks.size(); i++)
+		// Hittable ticks for the current button code
+		while (ScoreTick* tick = m_GetFrontTick(buttonCode))
 		{
-			ScoreTick* tick = ticks[i];
-			MapTime delta = currentTime - ticks[i]->time + m_inputOffset;
+			MapTime delta = currentTime - tick->time + m_inputOffset;
 			bool shouldMiss = abs(delta) > tick->GetHitWindow();
 			bool processed = false;
 			if (delta >= 0)
@@ -687,13 +716,17 @@ void Scoring::m_UpdateTicks()
 					{
 						// Check if slam hit
 						float dirSign = Math::Sign(laserObject->GetDirection());
-						float inputSign = Math::Sign(m_input->GetInputLaserDir(buttonCode - 6));
+						float inputSign = 0.0f;
 						float posDelta = (laserObject->points[1] - laserPositions[buttonCode - 6]) * dirSign;
 						if (autoplay)
 						{
 							inputSign = dirSign;
 							posDelta = 1;
 						}
+						else if (m_input)
+						{
+							inputSign = Math::Sign(m_input->GetInputLaserDir(buttonCode - 6));
+						}
 						if (dirSign == inputSign && delta > -10 && posDelta >= -laserDistanceLeniency)
 						{
 							m_TickHit(tick, buttonCode);
@@ -734,7 +767,7 @@ void Scoring::m_UpdateTicks()
 				LaserObjectState* laserObject = (LaserObjectState*)tick->object;
 				// Check if slam hit
 				float dirSign = Math::Sign(laserObject->GetDirection());
-				float inputSign = Math::Sign(m_input->GetInputLaserDir(buttonCode - 6));
+				float inputSign = m_input ? Math::Sign(m_input->GetInputLaserDir(buttonCode - 6)) : 0.0f;
 				float posDelta = (laserObject->points[1] - laserPositions[buttonCode - 6]) * dirSign;
 				if (dirSign == inputSign && posDelta >= -laserDistanceLeniency)
 				{
@@ -755,9 +788,7 @@ void Scoring::m_UpdateTicks()
 
 			if (processed)
 			{
-				delete tick;
-				ticks.Remove(tick, false);
-				i--;
+				m_tickCursor[buttonCode]++;
 			}
 			else
 			{
@@ -767,15 +798,38 @@ void Scoring::m_UpdateTicks()
 		}
 	}
 }
-ObjectState* Scoring::m_ConsumeTick(uint32 buttonCode)
+MapTime Scoring::m_GetInputTime(Input::Button button) const
+{
+	MapTime time = m_playback->GetLastTime();
+	if (!m_input || !m_hasInputTimeReference)
+		return time;
+
+	// Events are usually received after the last update, but can also be older if they were only handled later
+	//	limited in case the timestamps of the input device can not be trusted
+	int32 elapsed = (int32)(m_input->GetButtonTime(button) - m_inputTimeReference);
+	if (!m_inputTimeExact)
+		elapsed = Math::Clamp(elapsed, -maxInputTimeCorrection, maxInputTimeCorrection);
+	return time + (MapTime)((float)elapsed * m_inputTimeSpeed);
+}
+void Scoring::m_EnterTicks(uint32 buttonCode)
+{
+	// Empty after the game is finished
+	if (m_nextTickObject[buttonCode] < m_tickObjectEnds[buttonCode].size())
+		m_tickEnd[buttonCode] = m_tickObjectEnds[buttonCode][m_nextTickObject[buttonCode]++];
+}
+ScoreTick* Scoring::m_GetFrontTick(uint32 buttonCode)
+{
+	if (m_tickCursor[buttonCode] < m_tickEnd[buttonCode])
+		return &m_ticks[buttonCode][m_tickCursor[buttonCode]];
+	return nullptr;
+}
+ObjectState* Scoring::m_ConsumeTick(uint32 buttonCode, MapTime currentTime)
 {
-	MapTime currentTime = m_playback->GetLastTime();
-
 	assert(buttonCode < 8);
 
-	if (m_ticks[buttonCode].size() > 0)
+	ScoreTick* tick = m_GetFrontTick(buttonCode);
+	if (tick)
 	{
-		ScoreTick* tick = m_ticks[buttonCode].front();
 		MapTime delta = currentTime - tick->time + m_inputOffset;
 		ObjectState* hitObject = tick->object;
 		if (tick->HasFlag(TickFlags::Laser))
@@ -795,8 +849,7 @@ ObjectState* Scoring::m_ConsumeTick(uint32 buttonCode)
 			m_TickHit(tick, buttonCode, delta);
 		else
 			m_TickMiss(tick, buttonCode, delta);
-		delete tick;
-		m_ticks[buttonCode].Remove(tick, false);
+		m_tickCursor[buttonCode]++;
 
 		return hitObject;
 	}
@@ -921,9 +974,11 @@ void Scoring::m_CleanupTicks()
 {
 	for (uint32 i = 0; i < 8; i++)
 	{
-		for (ScoreTick* tick : m_ticks[i])
-			delete tick;
 		m_ticks[i].clear();
+		m_tickObjectEnds[i].clear();
+		m_nextTickObject[i] = 0;
+		m_tickCursor[i] = 0;
+		m_tickEnd[i] = 0;
 	}
 }
 
@@ -996,10 +1051,9 @@ void Scoring::m_UpdateLasers(float deltaTime)
 			if ((*it)->time <= mapTime)
 			{
 				auto current = m_currentLaserSegments[(*it)->index];
-				auto& currentTicks = m_ticks[6 + (*it)->index];
-				if (!currentTicks.empty() && current != nullptr)
+				ScoreTick* tick = m_GetFrontTick(6 + (*it)->index);
+				if (tick && current != nullptr)
 				{
-					auto tick = currentTicks.front();
 					if ((current->flags & LaserObjectState::flag_Instant) != 0)
 					{
 						if ((LaserObjectState*)tick->object == current) {
@@ -1031,10 +1085,10 @@ void Scoring::m_UpdateLasers(float deltaTime)
 
 			if ((currentSegment->time + currentSegment->duration) < mapTime)
 			{
-				auto currentTicks = m_ticks[6 + i];
+				ScoreTick* tick = m_GetFrontTick(6 + i);
 				if (currentSegment->flags & LaserObjectState::flag_Instant == 0 
-					|| currentTicks.empty() 
-					|| (LaserObjectState*)currentTicks.front()->object != currentSegment) // Don't null slam that hasn't been judged yet
+					|| !tick 
+					|| (LaserObjectState*)tick->object != currentSegment) // Don't null slam that hasn't been judged yet
 				{
 					// Apply laser roll ignore when the laser has scrolled past
 					if (!(currentSegment->flags & LaserObjectState::flag_Instant) && !currentSegment->next)
@@ -1068,7 +1122,7 @@ void Scoring::m_UpdateLasers(float deltaTime)
 			}
 		}
 
-		m_laserInput[i] = autoplay ? 0.0f : m_input->GetInputLaserDir(i);
+		m_laserInput[i] = (autoplay || !m_input) ? 0.0f : m_input->GetInputLaserDir(i);
 
 		bool notAffectingGameplay = true;
 		if (currentSegment)
@@ -1170,19 +1224,20 @@ void Scoring::m_OnButtonPressed(Input::Button buttonCode)
 	if (autoplay)
 		return;
 
+	MapTime time = m_GetInputTime(buttonCode);
 	if (buttonCode < Input::Button::BT_S)
 	{
-		int32 guardDelta = m_playback->GetLastTime() - m_buttonGuardTime[(uint32)buttonCode];
-		if (guardDelta < m_bounceGuard && guardDelta >= 0 && m_playback->GetLastTime() > 0.0)
+		int32 guardDelta = time - m_buttonGuardTime[(uint32)buttonCode];
+		if (guardDelta < m_bounceGuard && guardDelta >= 0 && time > 0.0)
 		{
-			//Logf("Button %d press bounce guard hit at %dms", Logger::Info, buttonCode, m_playback->GetLastTime());
+			//Logf("Button %d press bounce guard hit at %dms", Logger::Info, buttonCode, time);
 			return;
 		}
 
-		//Logf("Button %d pressed at %dms", Logger::Info, buttonCode, m_playback->GetLastTime());
-		m_buttonHitTime[(uint32)buttonCode] = m_playback->GetLastTime();
-		m_buttonGuardTime[(uint32)buttonCode] = m_playback->GetLastTime();
-		ObjectState* obj = m_ConsumeTick((uint32)buttonCode);
+		//Logf("Button %d pressed at %dms", Logger::Info, buttonCode, time);
+		m_buttonHitTime[(uint32)buttonCode] = time;
+		m_buttonGuardTime[(uint32)buttonCode] = time;
+		ObjectState* obj = m_ConsumeTick((uint32)buttonCode, time);
 		if (!obj)
 		{
 			// Fire event for idle hits
@@ -1193,22 +1248,23 @@ void Scoring::m_OnButtonPressed(Input::Button buttonCode)
 	{
 		ObjectState* obj = nullptr;
 		if (buttonCode < Input::Button::LS_1Neg)
-			obj = m_ConsumeTick(6); // Laser L
+			obj = m_ConsumeTick(6, time); // Laser L
 		else
-			obj = m_ConsumeTick(7); // Laser R
+			obj = m_ConsumeTick(7, time); // Laser R
 	}
 }
 void Scoring::m_OnButtonReleased(Input::Button buttonCode)
 {
 	if (buttonCode < Input::Button::BT_S)
 	{
-		int32 guardDelta = m_playback->GetLastTime() - m_buttonGuardTime[(uint32)buttonCode];
+		MapTime time = m_GetInputTime(buttonCode);
+		int32 guardDelta = time - m_buttonGuardTime[(uint32)buttonCode];
 		if (guardDelta < m_bounceGuard && guardDelta >= 0)
 		{
-			//Logf("Button %d release bounce guard hit at %dms", Logger::Info, buttonCode, m_playback->GetLastTime());
+			//Logf("Button %d release bounce guard hit at %dms", Logger::Info, buttonCode, time);
 			return;
 		}
-		m_buttonGuardTime[(uint32)buttonCode] = m_playback->GetLastTime();
+		m_buttonGuardTime[(uint32)buttonCode] = time;
 	}
 
 	//Logf("Button %d released at %dms", Logger::Info, buttonCode, m_playback->GetLastTime());
@@ -12,6 +12,7 @@
 #include "CollectionDialog.hpp"
 #include "GameplaySettingsDialog.hpp"
 #include <Audio/Audio.hpp>
+#include "PreviewCache.hpp"
 #include "lua.hpp"
 #include <iterator>
 #include <mutex>
@@ -123,6 +124,13 @@ public:
 	}
 	void Update(float deltaTime)
 	{
+		// Previews are short decoded clips, play them again once they end
+		if (m_currentStream && m_currentStream->HasEnded())
+		{
+			m_currentStream->SetPosition(0);
+			m_currentStream->Play();
+		}
+
 		if (m_fadeDelayTimer < m_fadeDelayDuration)
 		{
 			m_fadeDelayTimer += deltaTime;
@@ -786,7 +794,7 @@ private:
 				m_PushIntToTable("id", diff->id);
 				m_PushStringToTable("effector", diff->effector.c_str());
 				m_PushStringToTable("illustrator", diff->illustrator.c_str());
-				m_PushIntToTable("topBadge", Scoring::CalculateBestBadge(diff->scores));
+				m_PushIntToTable("topBadge", diff->topBadge);
 				lua_pushstring(m_lua, "scores");
 				lua_newtable(m_lua);
 				int scoreIndex = 0;
@@ -1292,6 +1300,8 @@ private:
 
 	// Player of preview music
 	PreviewPlayer m_previewPlayer;
+	// Decodes previews in the background and keeps recently played ones
+	PreviewCache m_previewCache;
 
 	// Current map that has music being preview played
 	ChartIndex *m_currentPreviewAudio;
@@ -1333,10 +1343,13 @@ public:
 		m_mapDatabase->OnDatabaseUpdateStarted.Add(this, &SongSelect_Impl::m_onDatabaseUpdateStart);
 		m_mapDatabase->OnDatabaseUpdateDone.Add(this, &SongSelect_Impl::m_onDatabaseUpdateDone);
 		m_mapDatabase->OnDatabaseUpdateProgress.Add(this, &SongSelect_Impl::m_onDatabaseUpdateProgress);
+		m_mapDatabase->SetScoreLimits(g_gameConfig.GetInt(GameConfigKeys::ScoresPerChart), g_gameConfig.GetInt(GameConfigKeys::MaxCachedScores));
+		m_mapDatabase->SetBadgeFunction(&Scoring::CalculateBadge);
 		m_mapDatabase->FinishInit();
 
 		// Setup the map database
 		m_mapDatabase->AddSearchPath(g_gameConfig.GetString(GameConfigKeys::SongFolder));
+		m_mapDatabase->SetWatchFolders(g_gameConfig.GetBool(GameConfigKeys::WatchSongFolder));
 
 		return true;
 	}
@@ -1415,6 +1428,8 @@ public:
 
 		m_sensMult = g_gameConfig.GetFloat(GameConfigKeys::SongSelSensMult);
 		m_previewParams = {"", 0, 0};
+		m_previewCache.SetMemoryBudget((size_t)Math::Max(g_gameConfig.GetInt(GameConfigKeys::PreviewCacheSize), 0) * 1024 * 1024);
+		m_previewCache.OnLoaded.Add(this, &SongSelect_Impl::m_OnPreviewLoaded);
 		m_hasCollDiag = m_collDiag.Init(m_mapDatabase);
 		if (!m_settDiag.Init())
 		{
@@ -1487,27 +1502,31 @@ public:
 
 		if (newPreview)
 		{
-			Ref<AudioStream> previewAudio = g_audio->CreateStream(audioPath);
-			if (previewAudio && previewAudio.GetData())
-			{
-				previewAudio->SetPosition(diff->preview_offset);
-
-				m_previewPlayer.FadeTo(previewAudio);
-
-				m_previewParams = params;
-			}
-			else
-			{
-				params = {"", 0, 0};
-
-				Logf("Failed to load preview audio from [%s]", Logger::Warning, audioPath);
-				if (m_previewParams != params)
-					m_previewPlayer.FadeTo(Ref<AudioStream>());
-			}
+			// Charts without a preview length get the usual default
+			int32 previewLength = diff->preview_length > 0 ? diff->preview_length : 15000;
 
+			// The current preview keeps playing until the new one is decoded
+			m_previewCache.Request(audioPath, diff->preview_offset, previewLength);
 			m_previewParams = params;
 		}
 	}
+	void m_OnPreviewLoaded(String audioPath, Ref<AudioClip> clip)
+	{
+		Ref<AudioStream> previewAudio;
+		if (clip)
+			previewAudio = g_audio->CreateStream(clip);
+
+		if (previewAudio)
+		{
+			m_previewPlayer.FadeTo(previewAudio);
+		}
+		else
+		{
+			Logf("Failed to load preview audio from [%s]", Logger::Warning, audioPath);
+			m_previewParams = {"", 0, 0};
+			m_previewPlayer.FadeTo(Ref<AudioStream>());
+		}
+	}
 
 	// When a map is selected in the song wheel
 	void OnFolderSelected(FolderIndex *folder)
@@ -1561,6 +1580,8 @@ public:
 				}
 
 				ChartIndex *chart = m_selectionWheel->GetSelectedChart();
+				// The game loads the replays of all scores
+				m_mapDatabase->GetScores(chart);
 
 				Game *game = Game::Create(*chart, Game::FlagsFromSettings());
 				if (!game)
@@ -1743,7 +1764,7 @@ public:
 			}
 			else if (key == SDLK_F5)
 			{
-				m_mapDatabase->StartSearching();
+				m_mapDatabase->StartSearching(true);
 				OnSearchTermChanged(m_searchInput->input);
 			}
 			else if (key == SDLK_F1 && m_hasCollDiag)
@@ -1757,6 +1778,7 @@ public:
 			else if (key == SDLK_F8) // start demo mode
 			{
 				ChartIndex *chart = m_mapDatabase->GetRandomChart();
+				m_mapDatabase->GetScores(chart);
 
 				Game *game = Game::Create(*chart, GameFlags::None);
 				if (!game)
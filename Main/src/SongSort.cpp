@@ -51,12 +51,7 @@ void ScoreSort::SortInplace(Vector<uint32>& vec, const Map<int32,
 		uint32 maxScore = 0;
 		for (auto& diff : song.GetCharts())
 		{
-			for (auto& score : diff->scores)
-			{
-				if (score->score < maxScore)
-					continue;
-				maxScore = score->score;
-			}
+			maxScore = Math::Max(maxScore, (uint32)diff->topScore);
 		}
 		m_scoreMap[mapIndex] = maxScore;
 	}
@@ -128,8 +123,14 @@ void ArtistSort::SortInplace(Vector<uint32>& vec, const Map<int32,
 		const SongSelectIndex& song_a = getSongFromCollection(ia, collection);
 		const SongSelectIndex& song_b = getSongFromCollection(ib, collection);
 
-		String a = song_a.GetCharts()[0]->artist;
-		String b = song_b.GetCharts()[0]->artist;
+		const String& artist_a = song_a.GetCharts()[0]->artist;
+		const String& artist_b = song_b.GetCharts()[0]->artist;
+		// Songs by the same artist don't need the case insensitive compare
+		if (artist_a == artist_b)
+			return CompareSongs(song_a, song_b);
+
+		String a = artist_a;
+		String b = artist_b;
 		a.ToUpper();
 		b.ToUpper();
 		int strres = a.compare(b);
@@ -150,8 +151,14 @@ void EffectorSort::SortInplace(Vector<uint32>& vec, const Map<int32,
 		const SongSelectIndex& song_a = getSongFromCollection(ia, collection);
 		const SongSelectIndex& song_b = getSongFromCollection(ib, collection);
 
-		String a = song_a.GetCharts()[0]->effector;
-		String b = song_b.GetCharts()[0]->effector;
+		const String& effector_a = song_a.GetCharts()[0]->effector;
+		const String& effector_b = song_b.GetCharts()[0]->effector;
+		// Songs by the same effector don't need the case insensitive compare
+		if (effector_a == effector_b)
+			return CompareSongs(song_a, song_b);
+
+		String a = effector_a;
+		String b = effector_b;
 		a.ToUpper();
 		b.ToUpper();
 		int strres = a.compare(b);
@@ -15,6 +15,23 @@ const float Track::laserWidth = buttonWidth;
 const float Track::fxbuttonWidth = buttonWidth * 2;
 const float Track::buttonTrackWidth = buttonWidth * 4;
 
+// Parameters set for every object, resolved once instead of looking up their names each draw
+static MaterialParameterHandle mainTexParam("mainTex");
+static MaterialParameterHandle hasSampleParam("hasSample");
+static MaterialParameterHandle trackPosParam("trackPos");
+static MaterialParameterHandle hitStateParam("hitState");
+static MaterialParameterHandle objectGlowParam("objectGlow");
+static MaterialParameterHandle trackScaleParam("trackScale");
+static MaterialParameterHandle hiddenCutoffParam("hiddenCutoff");
+static MaterialParameterHandle hiddenFadeWindowParam("hiddenFadeWindow");
+static MaterialParameterHandle suddenCutoffParam("suddenCutoff");
+static MaterialParameterHandle suddenFadeWindowParam("suddenFadeWindow");
+static MaterialParameterHandle laserPartParam("laserPart");
+static MaterialParameterHandle colorParam("color");
+
+// Laser builder batch used for the black laser underlays, the others are used for the laser parts
+static const uint32 laserBaseBatch = 9;
+
 Track::Track()
 {
 	m_viewRange = 2.0f;
@@ -117,6 +134,26 @@ bool Track::AsyncFinalize()
 		trackCoverMaterial->opaque = false;
 	}
 
+#ifndef EMBEDDED
+	// Instanced button materials are optional for skin back-compat, buttons are drawn one by one without them
+	String shaderPath = Path::Absolute("skins/" + g_application->GetCurrentSkin() + "/shaders/");
+	if (Path::FileExists(shaderPath + "buttonInstanced.vs") && Path::FileExists(shaderPath + "holdbuttonInstanced.vs"))
+	{
+		buttonInstancedMaterial = g_application->LoadMaterial("buttonInstanced");
+		holdButtonInstancedMaterial = g_application->LoadMaterial("holdbuttonInstanced");
+	}
+	if (buttonInstancedMaterial.IsValid() && holdButtonInstancedMaterial.IsValid())
+	{
+		buttonInstancedMaterial->opaque = false;
+		holdButtonInstancedMaterial->opaque = false;
+	}
+	else
+	{
+		buttonInstancedMaterial = Material();
+		holdButtonInstancedMaterial = Material();
+	}
+#endif
+
 	// Set Texture states
 	trackTexture->SetMipmaps(false);
 	trackTexture->SetFilter(true, true, 16.0f);
@@ -349,27 +386,26 @@ void Track::DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, cons
 		if ((laser->flags & LaserObjectState::flag_Extended) != 0 || m_trackHide > 0.f)
 		{
 			// Calculate height based on time on current track
-			float viewRange = GetViewRange();
 			float position = playback.TimeToViewDistance(obj->time);
 			float posmult = trackLength / (m_viewRange * laserSpeedOffset);
 
-			Mesh laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
-
-			MaterialParameterSet laserParams;
-			laserParams.SetParameter("mainTex", laserTextures[laser->index]);
+			LaserTrackBuilder* builder = m_laserTrackBuilder[laser->index];
+			builder->AddToBatch(laserBaseBatch, builder->GenerateTrackMesh(playback, laser), posmult * position);
+		}
+	}
 
-			// Get the length of this laser segment
-			Transform laserTransform = trackOrigin;
-			laserTransform *= Transform::Translation(Vector3{ 0.0f, posmult * position, 0.0f });
+	// Black underlays of all lasers of the same color are drawn together
+	for(uint32 i = 0; i < 2; i++)
+	{
+		Mesh laserMesh = m_laserTrackBuilder[i]->UploadBatch(laserBaseBatch);
+		if(!laserMesh)
+			continue;
 
-			if (laserMesh)
-			{
-				rq.Draw(laserTransform, laserMesh, blackLaserMaterial, laserParams);
-			}
-		}
+		MaterialParameterSet laserParams;
+		laserParams.SetParameter(mainTexParam, laserTextures[i]);
+		rq.Draw(trackOrigin, laserMesh, blackLaserMaterial, laserParams);
 	}
 }
-
 void Track::DrawBase(class RenderQueue& rq)
 {
 	// Base
@@ -422,9 +458,8 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 	{
 		bool isHold = obj->type == ObjectType::Hold;
 		MultiObjectState* mobj = (MultiObjectState*)obj;
-		MaterialParameterSet params;
-		Material mat = buttonMaterial;
 		Mesh mesh;
+		Texture texture;
 		float xscale = 1.0f;
 		float width;
 		float xposition;
@@ -451,8 +486,7 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 				xposition += width * ((1.0 - xscale) / 2.0);
 			}
 			length = buttonLength;
-			params.SetParameter("hasSample", mobj->button.hasSample);
-			params.SetParameter("mainTex", isHold ? buttonHoldTexture : buttonTexture);
+			texture = isHold ? buttonHoldTexture : buttonTexture;
 			mesh = buttonMesh;
 		}
 		else // FX Button
@@ -468,117 +502,204 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 				xposition += 0.5 * centerSplit * buttonWidth;
 			}
 			length = fxbuttonLength;
-			params.SetParameter("hasSample", mobj->button.hasSample);
-			params.SetParameter("mainTex", isHold ? fxbuttonHoldTexture : fxbuttonTexture);
+			texture = isHold ? fxbuttonHoldTexture : fxbuttonTexture;
 			mesh = fxbuttonMesh;
 		}
 
-		params.SetParameter("trackPos", position);
-
+		int hitState = 0;
 		if(isHold)
 		{
 			if(!active && mobj->hold.GetRoot()->time > playback.GetLastTime())
-				params.SetParameter("hitState", 1);
+				hitState = 1;
 			else
-				params.SetParameter("hitState", currentObjectGlowState);
-
-			params.SetParameter("objectGlow", currentObjectGlow);
-			mat = holdButtonMaterial;
+				hitState = currentObjectGlowState;
 		}
 
 		Vector3 buttonPos = Vector3(xposition, trackLength * position, 0.0f);
 
-		Transform buttonTransform = trackOrigin;
-		buttonTransform *= Transform::Translation(buttonPos);
 		float scale = 1.0f;
+		float trackScale;
 		if(isHold) // Hold Note?
 		{
-			float trackScale = (playback.DurationToViewDistanceAtTime(mobj->time, mobj->hold.duration) / viewRange) / length;
+			trackScale = (playback.DurationToViewDistanceAtTime(mobj->time, mobj->hold.duration) / viewRange) / length;
 			scale = trackScale * trackLength;
-
-			params.SetParameter("trackScale", trackScale);
 		}
 		else {
 			//Use actual distance from camera instead of position on the track?
 			scale = 1.0f + (Math::Max(1.0f, distantButtonScale) - 1.0f) * position;
-			params.SetParameter("trackScale", 1.0f / trackLength);
+			trackScale = 1.0f / trackLength;
 		}
 
-		params.SetParameter("hiddenCutoff", hiddenCutoff); // Hidden cutoff (% of track)
-		params.SetParameter("hiddenFadeWindow", hiddenFadewindow); // Hidden cutoff (% of track)
-		params.SetParameter("suddenCutoff", suddenCutoff); // Sudden cutoff (% of track)
-		params.SetParameter("suddenFadeWindow", suddenFadewindow); // Sudden cutoff (% of track)
+		if(buttonInstancedMaterial)
+		{
+			// Collect buttons of the same type, they are drawn together by FlushObjectBatch
+			Material mat = isHold ? holdButtonInstancedMaterial : buttonInstancedMaterial;
+			if(mesh != m_batchMesh || mat != m_batchMaterial || texture != m_batchTexture)
+			{
+				m_DrawButtonBatch(rq);
+				m_batchMesh = mesh;
+				m_batchMaterial = mat;
+				m_batchTexture = texture;
+			}
 
+			ButtonInstance instance;
+			instance.placement = Vector4(buttonPos.x, buttonPos.y, xscale, scale);
+			instance.state = Vector4(position, trackScale, isHold ? currentObjectGlow : 0.0f, (float)hitState);
+			instance.hasSample = mobj->button.hasSample ? 1.0f : 0.0f;
+			m_batchInstances.push_back(instance);
+			return;
+		}
 
+		MaterialParameterSet params;
+		Material mat = buttonMaterial;
+		params.SetParameter(hasSampleParam, mobj->button.hasSample);
+		params.SetParameter(mainTexParam, texture);
+		params.SetParameter(trackPosParam, position);
+		if(isHold)
+		{
+			params.SetParameter(hitStateParam, hitState);
+			params.SetParameter(objectGlowParam, currentObjectGlow);
+			mat = holdButtonMaterial;
+		}
+		params.SetParameter(trackScaleParam, trackScale);
+		params.SetParameter(hiddenCutoffParam, hiddenCutoff); // Hidden cutoff (% of track)
+		params.SetParameter(hiddenFadeWindowParam, hiddenFadewindow); // Hidden cutoff (% of track)
+		params.SetParameter(suddenCutoffParam, suddenCutoff); // Sudden cutoff (% of track)
+		params.SetParameter(suddenFadeWindowParam, suddenFadewindow); // Sudden cutoff (% of track)
+
+		Transform buttonTransform = trackOrigin;
+		buttonTransform *= Transform::Translation(buttonPos);
 		buttonTransform *= Transform::Scale({ xscale, scale, 1.0f });
 		rq.Draw(buttonTransform, mesh, mat, params);
 	}
 	else if(obj->type == ObjectType::Laser) // Draw laser
 	{
-		
+		// Keep the buttons that came before this under it
+		m_DrawButtonBatch(rq);
 
 		position = playback.TimeToViewDistance(obj->time);
 		float posmult = trackLength / (m_viewRange * laserSpeedOffset);
 		LaserObjectState* laser = (LaserObjectState*)obj;
-
-		// Draw segment function
-		auto DrawSegment = [&](Mesh mesh, Texture texture, int part)
-		{
-			MaterialParameterSet laserParams;
-			laserParams.SetParameter("trackPos", posmult * position / trackLength);
-			laserParams.SetParameter("trackScale", 1.0f / trackLength);
-			laserParams.SetParameter("hiddenCutoff", hiddenCutoff); // Hidden cutoff (% of track)
-			laserParams.SetParameter("hiddenFadeWindow", hiddenFadewindow); // Hidden cutoff (% of track)
-			laserParams.SetParameter("suddenCutoff", suddenCutoff); // Hidden cutoff (% of track)
-			laserParams.SetParameter("suddenFadeWindow", suddenFadewindow); // Hidden cutoff (% of track)
-
-			// Make not yet hittable lasers slightly glowing
-			if (laser->GetRoot()->time > playback.GetLastTime())
-			{
-				laserParams.SetParameter("objectGlow", 0.6f);
-				laserParams.SetParameter("hitState", 1);
-			}
-			else
-			{
-				laserParams.SetParameter("objectGlow", active ? objectGlow : 0.4f);
-				laserParams.SetParameter("hitState", active ? 2 + objectGlowState : 0);
-			}
-			laserParams.SetParameter("mainTex", texture);
-			laserParams.SetParameter("laserPart", part);
-
-			// Get the length of this laser segment
-			Transform laserTransform = trackOrigin;
-			laserTransform *= Transform::Translation(Vector3{ 0.0f, posmult * position,
-				0.0f });
-
-			// Set laser color
-			laserParams.SetParameter("color", laserColors[laser->index]);
-
-			if(mesh)
-			{
-				rq.Draw(laserTransform, mesh, laserMaterial, laserParams);
-			}
-		};
+		LaserTrackBuilder* builder = m_laserTrackBuilder[laser->index];
+
+		// Segments are collected per part and hit state, they are drawn by FlushObjectBatch
+		//	lasers are additive, so drawing them out of order doesn't change the result
+		LaserState state;
+		// Make not yet hittable lasers slightly glowing
+		if (laser->GetRoot()->time > playback.GetLastTime())
+			state = LaserState::NotHittable;
+		else
+			state = active ? LaserState::Active : LaserState::Inactive;
+		float offset = posmult * position;
 
 		// Draw entry?
 		if(!laser->prev)
-		{
-			Mesh laserTail = m_laserTrackBuilder[laser->index]->GenerateTrackEntry(playback, laser);
-			DrawSegment(laserTail, laserTailTextures[laser->index], 1);
-		}
+			builder->AddToBatch(m_LaserBatch(LaserPart::Entry, state), builder->GenerateTrackEntry(playback, laser), offset);
 
 		// Body
-		Mesh laserMesh = m_laserTrackBuilder[laser->index]->GenerateTrackMesh(playback, laser);
-		DrawSegment(laserMesh, laserTextures[laser->index], 0);
+		builder->AddToBatch(m_LaserBatch(LaserPart::Body, state), builder->GenerateTrackMesh(playback, laser), offset);
 
 		// Draw exit?
 		if(!laser->next && (laser->flags & LaserObjectState::flag_Instant) != 0) // Only draw exit on slams
+			builder->AddToBatch(m_LaserBatch(LaserPart::Exit, state), builder->GenerateTrackExit(playback, laser), offset);
+	}
+}
+void Track::FlushObjectBatch(RenderQueue& rq)
+{
+	m_DrawButtonBatch(rq);
+	m_DrawLaserBatches(rq);
+}
+void Track::m_DrawButtonBatch(RenderQueue& rq)
+{
+	if(m_batchInstances.empty())
+		return;
+
+	MaterialParameterSet params;
+	params.SetParameter(mainTexParam, m_batchTexture);
+	params.SetParameter(hiddenCutoffParam, hiddenCutoff); // Hidden cutoff (% of track)
+	params.SetParameter(hiddenFadeWindowParam, hiddenFadewindow); // Hidden cutoff (% of track)
+	params.SetParameter(suddenCutoffParam, suddenCutoff); // Sudden cutoff (% of track)
+	params.SetParameter(suddenFadeWindowParam, suddenFadewindow); // Sudden cutoff (% of track)
+	rq.DrawInstanced(trackOrigin, m_batchMesh, m_batchMaterial, params, m_batchInstances);
+	m_batchInstances.clear();
+}
+void Track::m_DrawLaserBatches(RenderQueue& rq)
+{
+	for(uint32 i = 0; i < 2; i++)
+	{
+		for(uint32 part = 0; part < 3; part++)
 		{
-			Mesh laserTail = m_laserTrackBuilder[laser->index]->GenerateTrackExit(playback, laser);
-			DrawSegment(laserTail, laserTailTextures[2 + laser->index], 2);
+			for(uint32 state = 0; state < 3; state++)
+			{
+				Mesh mesh = m_laserTrackBuilder[i]->UploadBatch(m_LaserBatch((LaserPart)part, (LaserState)state));
+				if(!mesh)
+					continue;
+
+				// The segments are already placed on the track
+				MaterialParameterSet laserParams;
+				laserParams.SetParameter(trackPosParam, 0.0f);
+				laserParams.SetParameter(trackScaleParam, 1.0f / trackLength);
+				laserParams.SetParameter(hiddenCutoffParam, hiddenCutoff); // Hidden cutoff (% of track)
+				laserParams.SetParameter(hiddenFadeWindowParam, hiddenFadewindow); // Hidden cutoff (% of track)
+				laserParams.SetParameter(suddenCutoffParam, suddenCutoff); // Hidden cutoff (% of track)
+				laserParams.SetParameter(suddenFadeWindowParam, suddenFadewindow); // Hidden cutoff (% of track)
+
+				switch((LaserState)state)
+				{
+				case LaserState::NotHittable:
+					laserParams.SetParameter(objectGlowParam, 0.6f);
+					laserParams.SetParameter(hitStateParam, 1);
+					break;
+				case LaserState::Active:
+					laserParams.SetParameter(objectGlowParam, objectGlow);
+					laserParams.SetParameter(hitStateParam, 2 + objectGlowState);
+					break;
+				case LaserState::Inactive:
+					laserParams.SetParameter(objectGlowParam, 0.4f);
+					laserParams.SetParameter(hitStateParam, 0);
+					break;
+				}
+
+				switch((LaserPart)part)
+				{
+				case LaserPart::Body:
+					laserParams.SetParameter(mainTexParam, laserTextures[i]);
+					break;
+				case LaserPart::Entry:
+					laserParams.SetParameter(mainTexParam, laserTailTextures[i]);
+					break;
+				case LaserPart::Exit:
+					laserParams.SetParameter(mainTexParam, laserTailTextures[2 + i]);
+					break;
+				}
+				laserParams.SetParameter(laserPartParam, (int)part);
+
+				// Set laser color
+				laserParams.SetParameter(colorParam, laserColors[i]);
+
+				rq.Draw(trackOrigin, mesh, laserMaterial, laserParams);
+			}
 		}
 	}
 }
+uint32 Track::m_LaserBatch(LaserPart part, LaserState state)
+{
+	return (uint32)part * 3 + (uint32)state;
+}
+size_t Track::GetLaserMemory() const
+{
+	size_t bytes = 0;
+	for(uint32 i = 0; i < 2; i++)
+		bytes += m_laserTrackBuilder[i]->GetBatchBytes() + m_laserTrackBuilder[i]->GetCacheBytes();
+	return bytes;
+}
+size_t Track::GetLaserUploadedBytes() const
+{
+	size_t bytes = 0;
+	for(uint32 i = 0; i < 2; i++)
+		bytes += m_laserTrackBuilder[i]->GetUploadedBytes();
+	return bytes;
+}
 void Track::DrawOverlays(class RenderQueue& rq)
 {
 	// Draw button hit effect sprites
@@ -607,8 +728,8 @@ void Track::DrawSprite(RenderQueue& rq, Vector3 pos, Vector2 size, Texture tex,
 		spriteTransform *= Transform::Rotation({ tilt, 0.0f, 0.0f });
 
 	MaterialParameterSet params;
-	params.SetParameter("mainTex", tex);
-	params.SetParameter("color", color);
+	params.SetParameter(mainTexParam, tex);
+	params.SetParameter(colorParam, color);
 	rq.Draw(spriteTransform, centeredTrackMesh, spriteMaterial, params);
 }
 void Track::DrawCombo(RenderQueue& rq, uint32 score, Color color, float scale)
@@ -10,6 +10,7 @@
 #include "BinaryStream.hpp"
 #include "MemoryStream.hpp"
 #include "FileStream.hpp"
+#include "MappedFile.hpp"
 
 // Text layer above binary streams
 #include "TextStream.hpp"
@@ -1,6 +1,7 @@
 #pragma once
 #include "Shared/String.hpp"
 #include "Shared/Vector.hpp"
+#include "Shared/Map.hpp"
 
 enum class FileType
 {
@@ -19,6 +20,21 @@ struct FileInfo
 
 };
 
+/*
+	Cached listing of a single folder, used by incremental scans
+	the listing is reused as long as the folder's last write time doesn't change
+	NOTE: modifying a file in place does not change the folder's last write time
+*/
+struct FolderScanCache
+{
+	// Last write time of the folder itself
+	uint64 lastWriteTime = 0;
+	// Files in this folder that passed the extension filter
+	Vector<FileInfo> files;
+	// Full paths of sub-folders
+	Vector<String> subFolders;
+};
+
 /*
 	File enumeration functions
 */
@@ -34,4 +50,10 @@ public:
 	// uses the given extension filter if specified
 	// Additional interruptible flag can contain a boolean which can interrupt the search when set to true
 	static Vector<FileInfo> ScanFilesRecursive(const String& folder, String extFilter = String(), bool* interrupt = nullptr);
+
+	// Finds files in a given folder, recursively
+	// only folders with a changed last write time are listed again, others are taken from the cache
+	// the cache is updated in place and should always be used with the same extension filter
+	// Additional interruptible flag can contain a boolean which can interrupt the search when set to true
+	static Vector<FileInfo> ScanFilesRecursiveCached(const String& folder, Map<String, FolderScanCache>& cache, String extFilter = String(), bool* interrupt = nullptr);
 };
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/String.hpp"
+#include "Shared/Vector.hpp"
+
+/*
+	Watches folders and all their sub-folders for changes to files
+	currently only implemented on Linux (inotify), on other platforms IsSupported returns false and no changes are reported
+*/
+class FolderWatcher : public Unique
+{
+public:
+	struct Change
+	{
+		// Files that are written or moved into a watched folder are reported as Updated,
+		//	Added is only used for new folders and the files they already contain
+		enum Action
+		{
+			Added,
+			Removed,
+			Updated
+		};
+		Action action;
+		String path;
+		// Set when the change refers to a whole folder
+		//	removing a folder does not report Removed for the files it contained
+		bool isFolder = false;
+	};
+
+	FolderWatcher();
+	~FolderWatcher();
+
+	static bool IsSupported();
+
+	// Starts watching a folder, sub-folders are watched as well when recursive is set
+	//	sub-folders created after this call are always watched
+	bool AddFolder(const String& folder, bool recursive = true);
+	// Stops watching all folders
+	void Clear();
+
+	// Returns all changes since the last call, does not block
+	Vector<Change> Poll();
+
+private:
+	class FolderWatcher_Impl* m_impl;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "Shared/String.hpp"
+
+/*
+	Immutable string that shares its storage with all other interned strings of the same value
+	used for fields that only take a few distinct values, like the difficulty name of a chart
+	interned values live until the program exits, never use this for values that are unique per object
+*/
+class InternedString
+{
+public:
+	// Empty string
+	InternedString();
+	InternedString(const String& str);
+	InternedString(const char* str);
+
+	const String& Get() const
+	{
+		return *m_str;
+	}
+	operator const String&() const
+	{
+		return *m_str;
+	}
+	const char* operator*() const
+	{
+		return m_str->c_str();
+	}
+	const char* c_str() const
+	{
+		return m_str->c_str();
+	}
+	size_t length() const
+	{
+		return m_str->length();
+	}
+	bool empty() const
+	{
+		return m_str->empty();
+	}
+
+	// Equal values share the same storage, so this is a pointer comparison
+	bool operator==(const InternedString& other) const
+	{
+		return m_str == other.m_str;
+	}
+	bool operator!=(const InternedString& other) const
+	{
+		return m_str != other.m_str;
+	}
+
+	// Number of distinct values interned so far
+	static size_t GetNumInterned();
+
+private:
+	const String* m_str;
+};
@@ -5,10 +5,13 @@
 #include "Shared/Unique.hpp"
 #include "Shared/Ref.hpp"
 #include "Shared/Delegate.hpp"
+#include "Shared/Vector.hpp"
+#include <atomic>
+#include <memory>
 
 /*
 	Additional job flags,
-	this allows clustering IO operation onto the same thread as to not lock up the system
+	IO jobs run on their own threads, so they can't block the other jobs and don't all hit the disk at once
 */
 enum class JobFlags : uint8
 {
@@ -18,6 +21,33 @@ enum class JobFlags : uint8
 JobFlags operator|(JobFlags a, JobFlags b);
 JobFlags operator&(JobFlags a, JobFlags b);
 
+/*
+	Queued jobs with a higher priority are started first
+*/
+enum class JobPriority : uint8
+{
+	Low = 0,
+	Normal,
+	High,
+	_Length
+};
+
+/*
+	Flag used to cancel jobs
+	copies share the same flag, so a single token can cancel a group of jobs
+*/
+class JobCancelToken
+{
+public:
+	JobCancelToken();
+
+	void Cancel();
+	bool IsCancelled() const;
+
+private:
+	std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
 /*
 	A single task that gets completed by the JobSheduler
 	abstract
@@ -34,10 +64,23 @@ public:
 
 	// Either cancel this job or wait till it finished if it is already being processed
 	void Terminate();
+
+	// Cancels this job through its token without waiting for it
+	//	jobs that are cancelled before they start are skipped and finish as unsuccessful
+	//	long running jobs can check IsCancelled() from Run() to stop early
+	void Cancel();
+	bool IsCancelled() const;
+
+	// Makes this job run after another one finished, should be called before queueing this job
+	//	dependencies that are not queued when this job gets queued are ignored,
+	//	a dependency that fails or gets cancelled still releases this job
+	void AddDependency(Ref<JobBase> other);
 	
 	// Flags for jobs
 	// make sure to add the IO flag if this job performs file operations
 	JobFlags jobFlags = JobFlags::None;
+	JobPriority priority = JobPriority::Normal;
+	JobCancelToken cancelToken;
 
 	// Performs the task to be done, returns success
 	virtual bool Run() = 0;
@@ -56,6 +99,14 @@ private:
 	bool m_ret = false;
 	bool m_finished = false;
 	class JobSheduler_Impl* m_sheduler = nullptr;
+
+	// Jobs this job runs after, kept until it is released
+	Vector<Ref<JobBase>> m_dependencies;
+	// The following are guarded by the sheduler lock
+	// jobs waiting for this one
+	Vector<Ref<JobBase>> m_dependents;
+	uint32 m_numPendingDependencies = 0;
+	bool m_waiting = false;
 	friend class JobSheduler_Impl;
 };
 
@@ -96,13 +147,19 @@ Job JobBase::CreateLambda(Lambda&& obj, Args... args)
 /*
 	The manager for performing asynchronous tasks
 	you should only have one of these
+	every worker thread has its own queue and takes jobs from the others when it runs out,
+	IO jobs go to a separate set of threads
 */
 class JobSheduler : public Unique
 {
 public:
-	JobSheduler();
+	// numThreads = 0 uses one thread per core, minus the ones used by the main and IO threads
+	JobSheduler(uint32 numThreads = 0, uint32 numIOThreads = 1);
 	~JobSheduler();
 
+	uint32 GetNumThreads() const;
+	uint32 GetNumIOThreads() const;
+
 	// Runs callbacks on finished tasks on the main thread
 	// should thus be called from the main thread only
 	void Update();
@@ -0,0 +1,51 @@
+#pragma once
+#include "Shared/BinaryStream.hpp"
+#include "Shared/Unique.hpp"
+#include "Shared/String.hpp"
+
+/*
+	Read-only view of a whole file mapped into memory
+	pages are only loaded when they are accessed and are shared with the file cache of the OS
+*/
+class MappedFile : Unique
+{
+private:
+	class MappedFile_Impl* m_impl = nullptr;
+	const uint8* m_data = nullptr;
+	size_t m_size = 0;
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const String& path);
+	void Close();
+	bool IsOpen() const
+	{
+		return m_impl != nullptr;
+	}
+
+	// Null for empty files
+	const uint8* GetData() const
+	{
+		return m_data;
+	}
+	size_t GetSize() const
+	{
+		return m_size;
+	}
+};
+
+/* Stream that reads from a mapped file */
+class MappedFileReader : public BinaryStream
+{
+protected:
+	const MappedFile* m_file = nullptr;
+	size_t m_cursor = 0;
+public:
+	MappedFileReader() = default;
+	MappedFileReader(const MappedFile& file);
+	virtual size_t Serialize(void* data, size_t len);
+	virtual void Seek(size_t pos);
+	virtual size_t Tell() const;
+	virtual size_t GetSize() const;
+};
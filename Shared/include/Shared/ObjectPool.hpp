@@ -0,0 +1,83 @@
+#pragma once
+#include "Shared/Types.hpp"
+#include "Shared/Unique.hpp"
+#include "Shared/Vector.hpp"
+#include <new>
+#include <utility>
+#include <assert.h>
+
+/*
+	Allocates objects of a single type from large blocks instead of one heap allocation per object
+	destroyed objects are recycled, blocks are only freed when the pool is destroyed
+*/
+template<typename T, size_t BlockSize = 256>
+class ObjectPool : public Unique
+{
+public:
+	ObjectPool() = default;
+	~ObjectPool()
+	{
+		// All objects should have been destroyed by now, their destructors are not called from here
+		assert(m_numAllocated == 0);
+		for(Slot* block : m_blocks)
+		{
+			::operator delete(block);
+		}
+	}
+
+	template<typename... Args>
+	T* Create(Args&&... args)
+	{
+		if(!m_freeList)
+			m_AddBlock();
+		Slot* slot = m_freeList;
+		m_freeList = slot->next;
+		m_numAllocated++;
+		return new(slot->data) T(std::forward<Args>(args)...);
+	}
+	void Destroy(T* object)
+	{
+		if(!object)
+			return;
+		object->~T();
+		Slot* slot = reinterpret_cast<Slot*>(object);
+		slot->next = m_freeList;
+		m_freeList = slot;
+		assert(m_numAllocated > 0);
+		m_numAllocated--;
+	}
+
+	// Number of live objects
+	size_t GetNumAllocated() const
+	{
+		return m_numAllocated;
+	}
+	// Memory reserved by the pool in bytes
+	size_t GetReservedSize() const
+	{
+		return m_blocks.size() * BlockSize * sizeof(Slot);
+	}
+
+private:
+	union Slot
+	{
+		Slot* next;
+		alignas(T) char data[sizeof(T)];
+	};
+
+	void m_AddBlock()
+	{
+		Slot* block = static_cast<Slot*>(::operator new(BlockSize * sizeof(Slot)));
+		m_blocks.Add(block);
+		// Link in reverse so objects are handed out in memory order
+		for(size_t i = BlockSize; i > 0; i--)
+		{
+			block[i - 1].next = m_freeList;
+			m_freeList = &block[i - 1];
+		}
+	}
+
+	Vector<Slot*> m_blocks;
+	Slot* m_freeList = nullptr;
+	size_t m_numAllocated = 0;
+};
@@ -0,0 +1,82 @@
+#include "stdafx.h"
+#include "Files.hpp"
+#include "Path.hpp"
+#include "File.hpp"
+#include "Log.hpp"
+#include "List.hpp"
+#include "Set.hpp"
+
+/*
+	Common
+*/
+Vector<FileInfo> Files::ScanFilesRecursiveCached(const String& folder, Map<String, FolderScanCache>& cache, String extFilter, bool* interrupt)
+{
+	Vector<FileInfo> ret;
+	String rootFolder = Path::Normalize(folder);
+	if(!Path::IsDirectory(rootFolder))
+	{
+		Logf("Can't run ScanFiles, \"%s\" is not a folder", Logger::Warning, rootFolder);
+		return ret;
+	}
+
+	bool filterByExtension = !extFilter.empty();
+	extFilter.TrimFront('.'); // Remove possible leading dot
+
+	// List of paths to process, subfolders are getting added to this list
+	List<String> folderQueue;
+	folderQueue.AddBack(rootFolder);
+	Set<String> visited;
+
+	while(!folderQueue.empty() && (!interrupt || !*interrupt))
+	{
+		String searchPath = folderQueue.front();
+		folderQueue.pop_front();
+		visited.Add(searchPath);
+
+		// A single stat on the folder decides if its listing needs to be refreshed
+		uint64 lwt = File::GetLastWriteTime(searchPath);
+		FolderScanCache* entry = cache.Find(searchPath);
+		if(!entry || entry->lastWriteTime != lwt)
+		{
+			FolderScanCache newEntry;
+			newEntry.lastWriteTime = lwt;
+			for(FileInfo& info : ScanFiles(searchPath, String(), interrupt))
+			{
+				if(info.type == FileType::Folder)
+				{
+					newEntry.subFolders.Add(info.fullPath);
+				}
+				else if(!filterByExtension || Path::GetExtension(info.fullPath) == extFilter)
+				{
+					newEntry.files.Add(info);
+				}
+			}
+			if(interrupt && *interrupt)
+				break;
+			entry = &cache.FindOrAdd(searchPath);
+			*entry = std::move(newEntry);
+		}
+
+		ret.insert(ret.end(), entry->files.begin(), entry->files.end());
+		for(const String& subFolder : entry->subFolders)
+		{
+			folderQueue.AddBack(subFolder);
+		}
+	}
+
+	if(interrupt && *interrupt)
+		return ret;
+
+	// Remove folders below the root that no longer exist
+	String rootPrefix = rootFolder + Path::sep;
+	for(auto it = cache.begin(); it != cache.end();)
+	{
+		bool inRoot = it->first == rootFolder || it->first.compare(0, rootPrefix.size(), rootPrefix) == 0;
+		if(inRoot && !visited.Contains(it->first))
+			it = cache.erase(it);
+		else
+			++it;
+	}
+
+	return ret;
+}
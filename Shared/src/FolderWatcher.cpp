@@ -0,0 +1,29 @@
+#include "stdafx.h"
+#include "FolderWatcher.hpp"
+
+// Fallback for platforms without a folder watcher implementation, changes are never reported
+#if defined(_WIN32) || defined(__APPLE__)
+
+FolderWatcher::FolderWatcher()
+{
+	m_impl = nullptr;
+}
+FolderWatcher::~FolderWatcher()
+{
+}
+bool FolderWatcher::IsSupported()
+{
+	return false;
+}
+bool FolderWatcher::AddFolder(const String& folder, bool recursive)
+{
+	return false;
+}
+void FolderWatcher::Clear()
+{
+}
+Vector<FolderWatcher::Change> FolderWatcher::Poll()
+{
+	return Vector<Change>();
+}
+#endif
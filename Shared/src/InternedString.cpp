@@ -0,0 +1,41 @@
+#include "stdafx.h"
+#include "InternedString.hpp"
+#include <unordered_set>
+#include <mutex>
+
+// Nodes never move, so the addresses of the values stay valid
+typedef std::unordered_set<String, std::hash<std::string>> InternTable;
+static InternTable& GetInternTable()
+{
+	static InternTable table;
+	return table;
+}
+static std::mutex& GetInternLock()
+{
+	static std::mutex lock;
+	return lock;
+}
+static const String* Intern(const String& str)
+{
+	std::lock_guard<std::mutex> guard(GetInternLock());
+	return &*GetInternTable().insert(str).first;
+}
+
+InternedString::InternedString()
+{
+	static const String* empty = Intern(String());
+	m_str = empty;
+}
+InternedString::InternedString(const String& str)
+{
+	m_str = Intern(str);
+}
+InternedString::InternedString(const char* str)
+{
+	m_str = Intern(String(str));
+}
+size_t InternedString::GetNumInterned()
+{
+	std::lock_guard<std::mutex> guard(GetInternLock());
+	return GetInternTable().size();
+}
@@ -4,8 +4,10 @@
 #include "Vector.hpp"
 #include "Log.hpp"
 #include "Thread.hpp"
+#include "Math.hpp"
 #include <thread>
-#include "Timer.hpp"
+#include <condition_variable>
+#include <atomic>
 
 JobFlags operator|(JobFlags a, JobFlags b)
 {
@@ -16,46 +18,65 @@ JobFlags operator&(JobFlags a, JobFlags b)
 	return (JobFlags)((uint8)a & (uint8)b);
 }
 
+static const size_t numPriorities = (size_t)JobPriority::_Length;
+
 struct JobThread
 {
 	// Thread index
 	uint32 index = 0;
-	bool terminate = false;
+	// Only runs IO jobs
+	bool io = false;
 	Thread thread;
 
+	// Jobs queued on this thread for every priority, the thread itself takes them from the front
+	//	other threads steal from the back when they run out of work
+	//	IO threads share the IO queue instead
+	List<Job> queues[numPriorities];
+	Mutex lock;
+
 	// Job currently being processed
 	Job activeJob;
+	// Same as activeJob, readable from other threads
+	//	set while holding the lock of the queue it was taken from, cleared under the sheduler lock
+	std::atomic<JobBase*> active;
 
-	Timer idleDuration;
-
-	// Terminate this thread
-	void Terminate()
-	{
-		if(terminate)
-			return; // Already terminated
-		terminate = true;
-		if(thread.joinable())
-			thread.join();
-	}
-	bool IsActive() const { return activeJob.IsValid(); }
+	JobThread() : active(nullptr) {}
 };
 
 class JobSheduler_Impl
 {
 public:
-	// Contains tasks to be done
-	List<Job> m_jobQueue;
 	// Contains tasks that are done
 	List<Job> m_finishedJobs;
-	
+	// Contains IO tasks to be done for every priority
+	List<Job> m_ioQueue[numPriorities];
+	// Jobs waiting for their dependencies
+	List<Job> m_waitingJobs;
+
+	// Guards the finished, IO and waiting queues and is used for waiting on the condition variables
 	Mutex m_lock;
+	// Signaled when a job is queued
+	std::condition_variable_any m_workAvailable;
+	std::condition_variable_any m_ioAvailable;
+	// Signaled when a job finished running
+	std::condition_variable_any m_jobFinished;
+	// Number of jobs in the thread queues
+	//	increased under m_lock so waiting threads can't miss it, and before the job is added so taking it can't wrap the count
+	std::atomic<uint32> m_numQueued;
+	bool m_terminate = false;
+
 	Vector<JobThread*> m_threadPool;
+	Vector<JobThread*> m_ioThreads;
+	// Thread that gets the next queued job
+	std::atomic<uint32> m_nextThread;
 
 	friend class JobBase;
 
-	JobSheduler_Impl()
+	JobSheduler_Impl(uint32 numThreads, uint32 numIOThreads)
 	{
-		AllocateThreads();
+		m_numQueued = 0;
+		m_nextThread = 0;
+		AllocateThreads(numThreads, numIOThreads);
 	}
 	~JobSheduler_Impl()
 	{
@@ -63,50 +84,92 @@ public:
 	}
 	void ClearThreads()
 	{
+		m_lock.lock();
+		m_terminate = true;
+		m_lock.unlock();
+		m_workAvailable.notify_all();
+		m_ioAvailable.notify_all();
+
 		for(JobThread* t : m_threadPool)
 		{
-			t->Terminate();
-			delete t;
+			if(t->thread.joinable())
+				t->thread.join();
 		}
+		for(JobThread* t : m_ioThreads)
+		{
+			if(t->thread.joinable())
+				t->thread.join();
+		}
+
 		m_lock.lock();
 		// Unregister jobs
-		for(auto job : m_jobQueue)
+		for(JobThread* t : m_threadPool)
 		{
-			job->m_sheduler = nullptr;
+			for(auto& queue : t->queues)
+			{
+				m_UnregisterJobs(queue);
+			}
+			delete t;
 		}
-		for(auto job : m_finishedJobs)
+		for(JobThread* t : m_ioThreads)
 		{
-			job->m_sheduler = nullptr;
+			delete t;
 		}
+		for(auto& queue : m_ioQueue)
+		{
+			m_UnregisterJobs(queue);
+		}
+		m_UnregisterJobs(m_waitingJobs);
+		m_UnregisterJobs(m_finishedJobs);
 		m_threadPool.clear();
+		m_ioThreads.clear();
 		m_lock.unlock();
 	}
-	void AllocateThreads()
+	void AllocateThreads(uint32 numThreads, uint32 numIOThreads)
 	{
 		assert(m_threadPool.empty());
 
-		unsigned concurentThreadsSupported = std::thread::hardware_concurrency();
-		int32 targetThreadCount = concurentThreadsSupported - 2;
-		if(targetThreadCount <= 0)
-			targetThreadCount = 1;
+		numIOThreads = Math::Max(numIOThreads, 1u);
+		int32 targetThreadCount = numThreads;
+		if(numThreads == 0)
+		{
+			unsigned concurentThreadsSupported = std::thread::hardware_concurrency();
+			targetThreadCount = concurentThreadsSupported - 1 - numIOThreads;
+			if(targetThreadCount <= 0)
+				targetThreadCount = 1;
+		}
 
+		// Create all thread states before starting any threads, workers steal from each others queues
 		for(int32 i = 0; i < targetThreadCount; i++)
 		{
-			// Create affinity mask for job threads
-			// always skip the first core since it runs the main thread
-			uint32 affinityMask = 1 << (i+1);
-
 			JobThread* thread = m_threadPool.Add(new JobThread());
 			thread->index = i;
+		}
+		for(uint32 i = 0; i < numIOThreads; i++)
+		{
+			JobThread* thread = m_ioThreads.Add(new JobThread());
+			thread->index = i;
+			thread->io = true;
+		}
+
+		for(JobThread* thread : m_threadPool)
+		{
+			// Create affinity mask for job threads
+			// always skip the first core since it runs the main thread
+			uint32 affinityMask = 1 << (thread->index + 1);
 			thread->thread = Thread(&JobSheduler_Impl::m_JobThread, this, thread);
 			thread->thread.SetAffinityMask(affinityMask);
 		}
+		for(JobThread* thread : m_ioThreads)
+		{
+			thread->thread = Thread(&JobSheduler_Impl::m_IOThread, this, thread);
+		}
 	}
 
 	void Update()
 	{
 		m_lock.lock();
-		List<Job> finished = m_finishedJobs;
+		List<Job> finished = std::move(m_finishedJobs);
 		m_finishedJobs.clear();
 		m_lock.unlock();
 
@@ -123,75 +186,288 @@ public:
 	{
 		job->m_sheduler = this;
 
-		m_lock.lock();
-		m_jobQueue.AddBack(job);
-		m_lock.unlock();
+		if(!job->m_dependencies.empty())
+		{
+			// Wait for dependencies that are still queued or running
+			m_lock.lock();
+			job->m_numPendingDependencies = 0;
+			for(Job& dependency : job->m_dependencies)
+			{
+				if(dependency->m_sheduler == this && !dependency->m_finished)
+				{
+					dependency->m_dependents.Add(job);
+					job->m_numPendingDependencies++;
+				}
+			}
+			if(job->m_numPendingDependencies > 0)
+			{
+				job->m_waiting = true;
+				m_waitingJobs.AddBack(std::move(job));
+				m_lock.unlock();
+				return true;
+			}
+			job->m_dependencies.clear();
+			m_lock.unlock();
+		}
 
+		m_Push(std::move(job));
 		return true;
 	}
 
+	// Removes a job that has not started yet, returns false if it is not queued
+	bool Dequeue(JobBase* job)
+	{
+		const size_t priority = (size_t)job->priority;
+		const bool io = (job->jobFlags & JobFlags::IO) == JobFlags::IO;
+		bool removed = false;
+		if(!io)
+		{
+			for(JobThread* t : m_threadPool)
+			{
+				std::lock_guard<Mutex> guard(t->lock);
+				if(m_Remove(t->queues[priority], job))
+				{
+					m_numQueued--;
+					removed = true;
+					break;
+				}
+			}
+		}
+
+		Vector<Job> released;
+		{
+			std::lock_guard<Mutex> guard(m_lock);
+			if(!removed && io)
+				removed = m_Remove(m_ioQueue[priority], job);
+			if(!removed && job->m_waiting)
+			{
+				// Stop waiting for dependencies
+				for(Job& dependency : job->m_dependencies)
+				{
+					m_Remove(dependency->m_dependents, job);
+				}
+				job->m_dependencies.clear();
+				job->m_waiting = false;
+				removed = m_Remove(m_waitingJobs, job);
+			}
+			if(removed)
+				m_ReleaseDependents(job, released);
+		}
+		for(Job& j : released)
+		{
+			m_Push(std::move(j));
+		}
+		return removed;
+	}
+	// Waits for a job to finish if it is running right now
+	void WaitForActiveJob(JobBase* job)
+	{
+		for(JobThread* t : m_threadPool)
+		{
+			m_WaitForActiveJob(t, job);
+		}
+		for(JobThread* t : m_ioThreads)
+		{
+			m_WaitForActiveJob(t, job);
+		}
+	}
+
 private:
-	// Single job thread
-	void m_JobThread(JobThread* myThread)
+	template<typename Container>
+	static bool m_Remove(Container& container, JobBase* job)
 	{
-		while(!myThread->terminate)
+		for(auto it = container.begin(); it != container.end(); it++)
 		{
-			if(!m_jobQueue.empty())
+			if(*it == job)
 			{
-				m_lock.lock();
-				if(!m_jobQueue.empty())
+				container.erase(it);
+				return true;
+			}
+		}
+		return false;
+	}
+	void m_UnregisterJobs(List<Job>& jobs)
+	{
+		for(auto& job : jobs)
+		{
+			job->m_sheduler = nullptr;
+			job->m_waiting = false;
+			job->m_dependencies.clear();
+			job->m_dependents.clear();
+		}
+		jobs.clear();
+	}
+
+	// Adds a job to the queues so it can be picked up by a thread
+	void m_Push(Job job)
+	{
+		const size_t priority = (size_t)job->priority;
+		if((job->jobFlags & JobFlags::IO) == JobFlags::IO)
+		{
+			m_lock.lock();
+			m_ioQueue[priority].AddBack(std::move(job));
+			m_lock.unlock();
+			m_ioAvailable.notify_one();
+			return;
+		}
+
+		// Count the job before any thread can take it
+		m_lock.lock();
+		m_numQueued++;
+		m_lock.unlock();
+
+		// Spread jobs over the threads, idle threads will steal the rest
+		JobThread* thread = m_threadPool[m_nextThread++ % m_threadPool.size()];
+		thread->lock.lock();
+		thread->queues[priority].AddBack(std::move(job));
+		thread->lock.unlock();
+		m_workAvailable.notify_one();
+	}
+	// Collects the jobs that no longer wait for anything after the given job is done
+	//	must be called while holding m_lock
+	void m_ReleaseDependents(JobBase* job, Vector<Job>& released)
+	{
+		for(Job& dependent : job->m_dependents)
+		{
+			if(!dependent->m_waiting || --dependent->m_numPendingDependencies > 0)
+				continue;
+			dependent->m_waiting = false;
+			dependent->m_dependencies.clear();
+			m_Remove(m_waitingJobs, dependent.GetData());
+			released.Add(dependent);
+		}
+		job->m_dependents.clear();
+	}
+	bool m_HasIOJobs() const
+	{
+		for(auto& queue : m_ioQueue)
+		{
+			if(!queue.empty())
+				return true;
+		}
+		return false;
+	}
+
+	void m_WaitForActiveJob(JobThread* thread, JobBase* job)
+	{
+		std::unique_lock<Mutex> lock(m_lock);
+		m_jobFinished.wait(lock, [&]() { return thread->active != job; });
+	}
+
+	// Takes the highest priority job, from the front of this thread's queue or from the back of another one
+	bool m_TakeJob(JobThread* myThread)
+	{
+		const uint32 numThreads = (uint32)m_threadPool.size();
+		for(size_t priority = numPriorities; priority > 0; priority--)
+		{
+			for(uint32 i = 0; i < numThreads; i++)
+			{
+				JobThread* other = m_threadPool[(myThread->index + i) % numThreads];
+				std::lock_guard<Mutex> guard(other->lock);
+				List<Job>& queue = other->queues[priority - 1];
+				if(queue.empty())
+					continue;
+
+				if(other == myThread)
 				{
-					myThread->idleDuration.Restart();
-
-					// Process a job
-					Job peekJob = m_jobQueue.front();
-					if((peekJob->jobFlags & JobFlags::IO) != JobFlags::IO || (myThread->index != 0)) // Only perform IO on first thread
-					{
-						myThread->activeJob = m_jobQueue.PopFront();
-						m_lock.unlock();
-
-						// Run
-						myThread->activeJob->m_ret = myThread->activeJob->Run();
-						myThread->activeJob->m_finished = true;
-
-						// Add to finished queue
-						m_lock.lock();
-						m_finishedJobs.AddBack(myThread->activeJob);
-						m_lock.unlock();
-
-						// Clear the active job
-						myThread->activeJob.Release();
-					}
-					else
-					{
-						m_lock.unlock();
-					}
+					myThread->activeJob = std::move(queue.front());
+					queue.pop_front();
 				}
 				else
 				{
-					// Just do nothing
-					m_lock.unlock();
+					myThread->activeJob = std::move(queue.back());
+					queue.pop_back();
 				}
+				myThread->active = myThread->activeJob.GetData();
+				m_numQueued--;
+				return true;
 			}
+		}
+		return false;
+	}
+	void m_RunJob(JobThread* myThread)
+	{
+		// Cancelled jobs are skipped but still reported as finished
+		JobBase* job = myThread->activeJob.GetData();
+		job->m_ret = !job->IsCancelled() && job->Run();
 
-			// Various idle levels
-			if(myThread->idleDuration.Minutes() > 1)
-				std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-			if(myThread->idleDuration.Seconds() > 1)
-				std::this_thread::sleep_for(std::chrono::milliseconds(500));
-			else
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		// Add to finished queue
+		Vector<Job> released;
+		m_lock.lock();
+		job->m_finished = true;
+		m_ReleaseDependents(job, released);
+		m_finishedJobs.AddBack(myThread->activeJob);
+		myThread->activeJob.Release();
+		myThread->active = nullptr;
+		m_lock.unlock();
+		m_jobFinished.notify_all();
+
+		for(Job& j : released)
+		{
+			m_Push(std::move(j));
+		}
+	}
+
+	// Single job thread
+	void m_JobThread(JobThread* myThread)
+	{
+		while(true)
+		{
+			if(m_TakeJob(myThread))
+			{
+				m_RunJob(myThread);
+				continue;
+			}
+
+			// Sleep until there is something to do
+			std::unique_lock<Mutex> lock(m_lock);
+			m_workAvailable.wait(lock, [&]() { return m_terminate || m_numQueued > 0; });
+			if(m_terminate)
+				return;
+		}
+	}
+	// Single IO thread
+	void m_IOThread(JobThread* myThread)
+	{
+		while(true)
+		{
+			{
+				std::unique_lock<Mutex> lock(m_lock);
+				m_ioAvailable.wait(lock, [&]() { return m_terminate || m_HasIOJobs(); });
+				if(m_terminate)
+					return;
+
+				for(size_t priority = numPriorities; priority > 0; priority--)
+				{
+					List<Job>& queue = m_ioQueue[priority - 1];
+					if(queue.empty())
+						continue;
+					myThread->activeJob = std::move(queue.front());
+					myThread->active = myThread->activeJob.GetData();
+					queue.pop_front();
+					break;
+				}
+			}
+			m_RunJob(myThread);
 		}
 	}
 };
-JobSheduler::JobSheduler()
+JobSheduler::JobSheduler(uint32 numThreads, uint32 numIOThreads)
 {
-	m_impl = new JobSheduler_Impl();
+	m_impl = new JobSheduler_Impl(numThreads, numIOThreads);
 }
 JobSheduler::~JobSheduler()
 {
 	delete m_impl;
 }
+uint32 JobSheduler::GetNumThreads() const
+{
+	return (uint32)m_impl->m_threadPool.size();
+}
+uint32 JobSheduler::GetNumIOThreads() const
+{
+	return (uint32)m_impl->m_ioThreads.size();
+}
 void JobSheduler::Update()
 {
 	m_impl->Update();
@@ -233,46 +509,55 @@ void JobBase::Terminate()
 	JobSheduler_Impl* sheduler = m_sheduler;
 
 	// Try to erase from queue first
-	m_sheduler->m_lock.lock();
-	for(auto it = sheduler->m_jobQueue.begin(); it != sheduler->m_jobQueue.end(); it++)
+	if(sheduler->Dequeue(this))
 	{
-		if(*it == this)
-		{
-			sheduler->m_jobQueue.erase(it);
-			m_sheduler->m_lock.unlock();
-			m_sheduler = nullptr;
-			return; // Ok
-		}
+		m_sheduler = nullptr;
+		return; // Ok
 	}
-	m_sheduler->m_lock.unlock();
 
 	// Wait for running job
-	for(JobThread* t : m_sheduler->m_threadPool)
-	{
-		if(t->activeJob == this)
-		{
-			// Wait for job to complete
-			while(t->activeJob == this)
-			{
-				std::this_thread::yield();
-			}
-			break;
-		}
-	}
+	sheduler->WaitForActiveJob(this);
 
 	// Remove from finished jobs list
-	m_sheduler->m_lock.lock();
-	for(auto it = m_sheduler->m_finishedJobs.rbegin(); it != m_sheduler->m_finishedJobs.rend(); it++)
+	sheduler->m_lock.lock();
+	for(auto it = sheduler->m_finishedJobs.rbegin(); it != sheduler->m_finishedJobs.rend(); it++)
 	{
 		if(*it == this)
 		{
-			m_sheduler->m_finishedJobs.erase(--(it.base()));
-			m_sheduler->m_lock.unlock();
-			return;
+			sheduler->m_finishedJobs.erase(--(it.base()));
+			break;
 		}
 	}
-	m_sheduler->m_lock.unlock();
+	sheduler->m_lock.unlock();
+}
+void JobBase::Cancel()
+{
+	cancelToken.Cancel();
+}
+bool JobBase::IsCancelled() const
+{
+	return cancelToken.IsCancelled();
+}
+void JobBase::AddDependency(Ref<JobBase> other)
+{
+	assert(!IsQueued());
+	if(other.GetData() == this)
+		return;
+	m_dependencies.Add(other);
 }
 void JobBase::Finalize()
 {
 }
+
+JobCancelToken::JobCancelToken()
+{
+	m_cancelled = std::make_shared<std::atomic<bool>>(false);
+}
+void JobCancelToken::Cancel()
+{
+	*m_cancelled = true;
+}
+bool JobCancelToken::IsCancelled() const
+{
+	return *m_cancelled;
+}
@@ -0,0 +1,197 @@
+#include "stdafx.h"
+#include "FolderWatcher.hpp"
+#include "Files.hpp"
+#include "Path.hpp"
+#include "Log.hpp"
+#include "Map.hpp"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+class FolderWatcher_Impl
+{
+public:
+	int handle = -1;
+	// Watch descriptor -> folder path
+	Map<int, String> folders;
+	// Folder path -> watch descriptor
+	Map<String, int> watches;
+
+	FolderWatcher_Impl()
+	{
+		handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(handle == -1)
+			Logf("Failed to initialize inotify: %s", Logger::Warning, strerror(errno));
+	}
+	~FolderWatcher_Impl()
+	{
+		if(handle != -1)
+			close(handle);
+	}
+
+	bool AddWatch(const String& folder)
+	{
+		if(watches.Contains(folder))
+			return true;
+
+		const uint32 mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+		int wd = inotify_add_watch(handle, *folder, mask);
+		if(wd == -1)
+		{
+			// Most likely ENOSPC, see /proc/sys/fs/inotify/max_user_watches
+			Logf("Failed to watch folder \"%s\": %s", Logger::Warning, folder, strerror(errno));
+			return false;
+		}
+		folders.FindOrAdd(wd) = folder;
+		watches.FindOrAdd(folder) = wd;
+		return true;
+	}
+	// Watches a folder and all its sub-folders
+	//	files that already exist are reported as added when a change list is given,
+	//	this catches files created before the watch on a new folder was in place
+	bool AddTree(const String& folder, Vector<FolderWatcher::Change>* added)
+	{
+		if(!AddWatch(folder))
+			return false;
+
+		bool ok = true;
+		for(FileInfo& info : Files::ScanFiles(folder))
+		{
+			if(info.type == FileType::Folder)
+			{
+				ok = AddTree(info.fullPath, added) && ok;
+			}
+			else if(added)
+			{
+				FolderWatcher::Change change;
+				change.action = FolderWatcher::Change::Added;
+				change.path = info.fullPath;
+				added->Add(change);
+			}
+		}
+		return ok;
+	}
+	void RemoveTree(const String& folder)
+	{
+		String prefix = folder + Path::sep;
+		for(auto it = watches.begin(); it != watches.end();)
+		{
+			if(it->first == folder || it->first.compare(0, prefix.size(), prefix) == 0)
+			{
+				inotify_rm_watch(handle, it->second);
+				folders.erase(it->second);
+				it = watches.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+};
+
+FolderWatcher::FolderWatcher()
+{
+	m_impl = new FolderWatcher_Impl();
+}
+FolderWatcher::~FolderWatcher()
+{
+	delete m_impl;
+}
+bool FolderWatcher::IsSupported()
+{
+	return true;
+}
+bool FolderWatcher::AddFolder(const String& folder, bool recursive)
+{
+	if(m_impl->handle == -1)
+		return false;
+	if(!recursive)
+		return m_impl->AddWatch(Path::Normalize(folder));
+	return m_impl->AddTree(Path::Normalize(folder), nullptr);
+}
+void FolderWatcher::Clear()
+{
+	for(auto& w : m_impl->watches)
+	{
+		inotify_rm_watch(m_impl->handle, w.second);
+	}
+	m_impl->watches.clear();
+	m_impl->folders.clear();
+}
+Vector<FolderWatcher::Change> FolderWatcher::Poll()
+{
+	Vector<Change> changes;
+	if(m_impl->handle == -1)
+		return changes;
+
+	alignas(inotify_event) char buffer[4096];
+	while(true)
+	{
+		ssize_t len = read(m_impl->handle, buffer, sizeof(buffer));
+		if(len <= 0)
+			break; // EAGAIN, nothing left to read
+
+		for(char* ptr = buffer; ptr < buffer + len; ptr += sizeof(inotify_event) + ((inotify_event*)ptr)->len)
+		{
+			const inotify_event* evt = (const inotify_event*)ptr;
+			if(evt->mask & IN_Q_OVERFLOW)
+			{
+				Log("Folder watcher event queue overflowed, some changes were lost", Logger::Warning);
+				continue;
+			}
+			if(evt->mask & IN_IGNORED)
+			{
+				// Watch was removed because the folder is gone
+				String* folder = m_impl->folders.Find(evt->wd);
+				if(folder)
+				{
+					m_impl->watches.erase(*folder);
+					m_impl->folders.erase(evt->wd);
+				}
+				continue;
+			}
+
+			String* folder = m_impl->folders.Find(evt->wd);
+			if(!folder || evt->len == 0)
+				continue;
+
+			Change change;
+			change.path = Path::Normalize(*folder + Path::sep + evt->name);
+			change.isFolder = (evt->mask & IN_ISDIR) != 0;
+			if(change.isFolder)
+			{
+				if(evt->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					change.action = Change::Added;
+					changes.Add(change);
+					m_impl->AddTree(change.path, &changes);
+				}
+				else if(evt->mask & (IN_DELETE | IN_MOVED_FROM))
+				{
+					change.action = Change::Removed;
+					changes.Add(change);
+					m_impl->RemoveTree(change.path);
+				}
+			}
+			else
+			{
+				// Files are reported once they are closed after writing, not when they are created
+				if(evt->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+				{
+					change.action = Change::Updated;
+					changes.Add(change);
+				}
+				else if(evt->mask & (IN_DELETE | IN_MOVED_FROM))
+				{
+					change.action = Change::Removed;
+					changes.Add(change);
+				}
+			}
+		}
+	}
+
+	return changes;
+}
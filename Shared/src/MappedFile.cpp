@@ -0,0 +1,38 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+
+MappedFileReader::MappedFileReader(const MappedFile& file) : BinaryStream(true), m_file(&file)
+{
+}
+size_t MappedFileReader::Serialize(void* data, size_t len)
+{
+	assert(m_file);
+	size_t size = m_file->GetSize();
+	if(m_cursor + len > size)
+	{
+		if(m_cursor >= size)
+			return 0;
+		len = size - m_cursor;
+	}
+	if(len > 0)
+	{
+		memcpy(data, m_file->GetData() + m_cursor, len);
+		m_cursor += len;
+	}
+	return len;
+}
+void MappedFileReader::Seek(size_t pos)
+{
+	assert(m_file);
+	assert(pos <= m_file->GetSize());
+	m_cursor = pos;
+}
+size_t MappedFileReader::Tell() const
+{
+	return m_cursor;
+}
+size_t MappedFileReader::GetSize() const
+{
+	assert(m_file);
+	return m_file->GetSize();
+}
@@ -0,0 +1,83 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+#include "Log.hpp"
+
+/*
+	Unix implementation
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+class MappedFile_Impl
+{
+public:
+	void* view = nullptr;
+	size_t size = 0;
+	~MappedFile_Impl()
+	{
+		if(view)
+			munmap(view, size);
+	}
+};
+
+MappedFile::MappedFile()
+{
+}
+MappedFile::~MappedFile()
+{
+	Close();
+}
+bool MappedFile::Open(const String& path)
+{
+	Close();
+
+	int handle = open(*path, O_RDONLY);
+	if(handle == -1)
+	{
+		Logf("Failed to open file for mapping %s: %d", Logger::Warning, *path, errno);
+		return false;
+	}
+
+	struct stat sb;
+	if(fstat(handle, &sb) != 0)
+	{
+		close(handle);
+		return false;
+	}
+
+	MappedFile_Impl* impl = new MappedFile_Impl();
+	impl->size = sb.st_size;
+	// Empty files can't be mapped
+	if(impl->size > 0)
+	{
+		impl->view = mmap(nullptr, impl->size, PROT_READ, MAP_PRIVATE, handle, 0);
+		if(impl->view == MAP_FAILED)
+		{
+			Logf("Failed to map file %s: %d", Logger::Warning, *path, errno);
+			impl->view = nullptr;
+			delete impl;
+			close(handle);
+			return false;
+		}
+	}
+	// The mapping stays valid after the file is closed
+	close(handle);
+
+	m_impl = impl;
+	m_data = (const uint8*)impl->view;
+	m_size = impl->size;
+	return true;
+}
+void MappedFile::Close()
+{
+	if(m_impl)
+	{
+		delete m_impl;
+		m_impl = nullptr;
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -145,7 +145,7 @@ uint64 File::GetLastWriteTime(const String& path)
 {
 	WString wstringPath = Utility::ConvertToWString(path);
 	HANDLE h = CreateFileW(*wstringPath,
-		GENERIC_READ, FILE_SHARE_WRITE, 0, OPEN_ALWAYS, 0, 0);
+		GENERIC_READ, FILE_SHARE_WRITE, 0, OPEN_ALWAYS, FILE_FLAG_BACKUP_SEMANTICS, 0); // Backup semantics allows opening folders
 	if(h == INVALID_HANDLE_VALUE)
 		return -1;
 
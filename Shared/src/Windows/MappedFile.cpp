@@ -0,0 +1,84 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+#include "Log.hpp"
+
+/*
+	Windows implementation
+*/
+class MappedFile_Impl
+{
+public:
+	const void* view = nullptr;
+	~MappedFile_Impl()
+	{
+		if(view)
+			UnmapViewOfFile(view);
+	}
+};
+
+MappedFile::MappedFile()
+{
+}
+MappedFile::~MappedFile()
+{
+	Close();
+}
+bool MappedFile::Open(const String& path)
+{
+	Close();
+	WString wstringPath = Utility::ConvertToWString(path);
+	HANDLE file = CreateFileW(*wstringPath,
+		GENERIC_READ, // Desired Access
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		0, 0);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		Logf("Failed to open file for mapping %s: %s", Logger::Warning, *path, Utility::WindowsFormatMessage(GetLastError()));
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	MappedFile_Impl* impl = new MappedFile_Impl();
+	// Empty files can't be mapped
+	if(size.QuadPart > 0)
+	{
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mapping)
+		{
+			impl->view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			// The view keeps the mapping alive
+			CloseHandle(mapping);
+		}
+		if(!impl->view)
+		{
+			Logf("Failed to map file %s: %s", Logger::Warning, *path, Utility::WindowsFormatMessage(GetLastError()));
+			delete impl;
+			CloseHandle(file);
+			return false;
+		}
+	}
+	CloseHandle(file);
+
+	m_impl = impl;
+	m_data = (const uint8*)impl->view;
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+void MappedFile::Close()
+{
+	if(m_impl)
+	{
+		delete m_impl;
+		m_impl = nullptr;
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
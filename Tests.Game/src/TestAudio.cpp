@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include <Audio/Audio.hpp>
 #include <Audio/DSP.hpp>
+#include <Audio/Audio_Impl.hpp>
+#include <Beatmap/AudioEffects.hpp>
 #include <float.h>
 #include "TestMusicPlayer.hpp"
 
@@ -45,6 +47,69 @@ Test("Audio.Playback")
 	delete audio;
 }
 
+// Plays a sample faster than it ends, the voices should overlap instead of restarting
+Test("Audio.SampleVoices")
+{
+	Audio* audio = new Audio();
+	TestEnsure(audio->Init(false));
+
+	Sample testSample = audio->CreateSample(testSamplePath);
+	TestEnsure(testSample.IsValid());
+	testSample->SetMaxVoices(4);
+
+	for(uint32 i = 0; i < 16; i++)
+	{
+		// Alternate between left and right
+		testSample->PlayVoice(1.0f, (i % 2) ? 1.0f : -1.0f);
+		this_thread::sleep_for(chrono::milliseconds(50));
+	}
+	TestEnsure(testSample->IsPlaying());
+
+	testSample->Stop();
+	this_thread::sleep_for(chrono::milliseconds(50));
+	TestEnsure(!testSample->IsPlaying());
+
+	testSample.Release();
+	delete audio;
+}
+
+// DSP's added to a sample apply to all of its voices
+Test("Audio.SampleDSP")
+{
+	Audio* audio = new Audio();
+	TestEnsure(audio->InitOffline(48000));
+
+	Sample testSample = audio->CreateSample(testSamplePath);
+	TestEnsure(testSample.IsValid());
+	PanDSP* pan = new PanDSP();
+	pan->panning = 1.0f;
+	testSample->AddDSP(pan);
+
+	testSample->PlayVoice(1.0f, -0.5f);
+	testSample->PlayVoice(0.5f, 0.5f);
+
+	// Panned to the right, so the left channel should stay silent
+	Vector<float> output(512 * 2);
+	float left = 0.0f;
+	float right = 0.0f;
+	for(uint32 i = 0; i < 20; i++)
+	{
+		audio->Render(output.data(), 512);
+		for(uint32 j = 0; j < 512; j++)
+		{
+			left = Math::Max(left, fabsf(output[j * 2]));
+			right = Math::Max(right, fabsf(output[j * 2 + 1]));
+		}
+	}
+	TestEnsure(left == 0.0f);
+	TestEnsure(right > 0.0f);
+
+	testSample->RemoveDSP(pan);
+	delete pan;
+	testSample.Release();
+	delete audio;
+}
+
 Test("Audio.Music.Phaser")
 {
 	class MusicPlayer : public TestMusicPlayer
@@ -301,3 +366,594 @@ Test("Audio.Music.Flanger")
 	mp.Init(testSongPath, testSongOffset);
 	mp.Run();
 }
+
+// Plays a generated stream while seeking around, the decoder thread should keep up without underruns
+//	the mixer is driven by the test at the pace of a device, so no output device or song files are needed
+Test("Audio.StreamUnderruns")
+{
+	Audio* audio = new Audio();
+	// Unlike InitOffline, streams still decode ahead on their own thread
+	audio->GetImpl()->InitMixer(44100);
+	audio->SetDecodeAhead(200);
+
+	// 10 seconds of a tone at a different rate than the output, so it goes through the resampler
+	Ref<AudioClip> clip = Ref<AudioClip>(new AudioClip());
+	clip->sampleRate = 48000;
+	clip->pcm.resize(clip->sampleRate * 10 * 2);
+	for(uint32 i = 0; i < clip->GetNumFrames(); i++)
+	{
+		float v = sinf((float)i * 440.0f * Math::pi * 2.0f / (float)clip->sampleRate) * 0.5f;
+		clip->pcm[i * 2] = v;
+		clip->pcm[i * 2 + 1] = v;
+	}
+
+	Ref<AudioStream> song = audio->CreateStream(clip);
+	TestEnsure(song.IsValid());
+	song->Play();
+
+	const uint32 bufferSize = 384;
+	const double bufferDuration = (double)bufferSize / 44100.0;
+	Vector<float> buffer;
+	buffer.resize(bufferSize * 2);
+
+	Timer t;
+	uint32 numSeeks = 0;
+	uint32 numAudible = 0;
+	for(uint32 i = 0; (double)i * bufferDuration < 4.0 && !song->HasEnded(); i++)
+	{
+		if((double)i * bufferDuration > (numSeeks + 1) * 0.5)
+		{
+			song->SetPosition((numSeeks % 2) * 5000);
+			numSeeks++;
+		}
+
+		memset(buffer.data(), 0, sizeof(float) * buffer.size());
+		song->Process(buffer.data(), bufferSize);
+		for(float v : buffer)
+		{
+			if(fabsf(v) > 0.1f)
+			{
+				numAudible++;
+				break;
+			}
+		}
+
+		// Wait until a device would ask for the next buffer
+		while(t.SecondsAsDouble() < (double)(i + 1) * bufferDuration)
+			this_thread::sleep_for(chrono::microseconds(500));
+	}
+	Logf("%d underruns (%llu frames) after %d seeks, %d buffers with sound", Logger::Info, song->GetNumUnderruns(), song->GetUnderrunFrames(), numSeeks, numAudible);
+	TestEnsure(numSeeks == 7);
+	TestEnsure(song->GetNumUnderruns() == 0);
+	// Only the buffers right after a seek should be silent
+	TestEnsure(numAudible > (uint32)(3.0 / bufferDuration));
+
+	song.Release();
+	// Not initialized through Init, so the audio object doesn't release the mixer
+	audio->GetImpl()->ReleaseMixer();
+	delete audio;
+}
+
+// Plays a song while the main thread is busy, the position should follow the device clock
+Test("Audio.Timing")
+{
+	Audio* audio = new Audio();
+	TestEnsure(audio->Init(false));
+
+	Ref<AudioStream> song = audio->CreateStream(testSongPath, false);
+	TestEnsure(song.IsValid());
+	song->SetPosition(testSongOffset);
+	song->Play();
+
+	// Wait for the first buffer to be heard
+	Timer t;
+	while(song->GetPosition() <= testSongOffset && t.SecondsAsFloat() < 2.0f)
+		this_thread::sleep_for(chrono::milliseconds(1));
+
+	int32 startPosition = song->GetPosition();
+	uint32 numBackwards = 0;
+	double maxError = 0.0;
+	int32 lastPosition = startPosition;
+	t.Restart();
+	while(t.SecondsAsFloat() < 10.0f && !song->HasEnded())
+	{
+		// Simulate frames that take a varying amount of time
+		Timer busy;
+		while(busy.Microseconds() < (rand() % 12000))
+			;
+
+		int32 position = song->GetPosition();
+		if(position < lastPosition)
+			numBackwards++;
+		lastPosition = position;
+		maxError = Math::Max(maxError, fabs((double)(position - startPosition) - t.SecondsAsDouble() * 1000.0));
+	}
+
+	AudioTiming timing = audio->GetTiming();
+	Logf("Latency %.1f ms, jitter %.2f ms, drift %.2f ms, %d resyncs in %d callbacks", Logger::Info,
+		timing.latency * 1000.0, timing.jitter * 1000.0, timing.drift * 1000.0, timing.numResyncs, timing.numCallbacks);
+	Logf("Largest difference from the system clock %.1f ms, went backwards %d times", Logger::Info, maxError, numBackwards);
+	TestEnsure(numBackwards == 0);
+	TestEnsure(maxError < 10.0);
+
+	song.Release();
+	delete audio;
+}
+
+// Decodes a preview window into memory and loops it a few times
+Test("Audio.PreviewClip")
+{
+	Audio* audio = new Audio();
+	TestEnsure(audio->Init(false));
+
+	Timer t;
+	Ref<AudioClip> clip = audio->DecodeClip(testSongPath, testSongOffset, 3000);
+	TestEnsure(clip.IsValid());
+	Logf("Decoded %d frames (%.1f KB) in %.2f ms", Logger::Info, clip->GetNumFrames(), clip->GetMemorySize() / 1024.0f, t.SecondsAsFloat() * 1000.0f);
+	TestEnsure(clip->GetNumFrames() == clip->sampleRate * 3);
+
+	Ref<AudioStream> preview = audio->CreateStream(clip);
+	TestEnsure(preview.IsValid());
+	preview->Play();
+
+	uint32 numLoops = 0;
+	t.Restart();
+	while(numLoops < 3 && t.SecondsAsFloat() < 15.0f)
+	{
+		if(preview->HasEnded())
+		{
+			preview->SetPosition(0);
+			preview->Play();
+			numLoops++;
+		}
+		this_thread::sleep_for(chrono::milliseconds(5));
+	}
+	TestEnsure(numLoops == 3);
+
+	preview.Release();
+	delete audio;
+}
+
+// Renders a song without an output device, the stream position should follow the rendered frames
+Test("Audio.OfflineRender")
+{
+	Audio* audio = new Audio();
+	TestEnsure(audio->InitOffline(48000));
+
+	Ref<AudioStream> song = audio->CreateStream(testSongPath, false);
+	TestEnsure(song.IsValid());
+	song->SetPosition(testSongOffset);
+	song->Play();
+
+	const uint32 blockSize = 512;
+	Vector<float> output(blockSize * 2);
+	uint64 numFrames = 0;
+	int32 maxDrift = 0;
+	Timer t;
+	while(!song->HasEnded() && numFrames < 48000 * 30)
+	{
+		audio->Render(output.data(), blockSize);
+		numFrames += blockSize;
+		int32 expected = testSongOffset + (int32)(numFrames * 1000 / 48000);
+		if(!song->HasEnded())
+			maxDrift = Math::Max(maxDrift, abs(song->GetPosition() - expected));
+	}
+	Logf("Rendered %.1f s in %.2f s, position drifted at most %d ms", Logger::Info, numFrames / 48000.0, t.SecondsAsFloat(), maxDrift);
+	TestEnsure(song->GetNumUnderruns() == 0);
+	TestEnsure(maxDrift < 20);
+
+	song.Release();
+	delete audio;
+}
+
+// Generates a saw wave, stands in for a stream in the mixer benchmark
+class BenchmarkSource : public AudioBase
+{
+public:
+	float phase = 0.0f;
+	float step = 0.01f;
+	int32 position = 0;
+
+	virtual void Process(float* out, uint32 numSamples) override
+	{
+		for(uint32 i = 0; i < numSamples; i++)
+		{
+			out[i * 2] = phase;
+			out[i * 2 + 1] = -phase;
+			phase += step;
+			if(phase > 1.0f)
+				phase -= 2.0f;
+		}
+		position += numSamples;
+	}
+	virtual int32 GetPosition() const override
+	{
+		return position / 48;
+	}
+	virtual uint32 GetSampleRate() const override
+	{
+		return 48000;
+	}
+	virtual float* GetPCM() override
+	{
+		return nullptr;
+	}
+};
+
+// Mixes a number of streams with DSP's applied to each, without an audio device
+Benchmark("Audio.MixBenchmark")
+{
+	const uint32 sampleRate = 48000;
+	const uint32 bufferLength = 1024;
+	const uint32 numBuffers = 500;
+	const uint32 streamCounts[] = { 1, 8, 32, 128 };
+	const uint32 dspCounts[] = { 0, 2, 4 };
+
+	Vector<float> output;
+	output.resize(bufferLength * 2);
+	for(uint32 numStreams : streamCounts)
+	{
+		for(uint32 numDSPs : dspCounts)
+		{
+			Audio_Impl mixer;
+			mixer.InitMixer(sampleRate);
+
+			Vector<BenchmarkSource*> sources;
+			for(uint32 i = 0; i < numStreams; i++)
+			{
+				BenchmarkSource* source = new BenchmarkSource();
+				source->step = 0.001f * (i + 1);
+				source->SetVolume(1.0f / numStreams);
+				mixer.Register(source);
+				sources.Add(source);
+
+				for(uint32 j = 0; j < numDSPs; j++)
+				{
+					DSP* dsp = nullptr;
+					if(j % 2 == 0)
+					{
+						BQFDSP* filter = new BQFDSP();
+						filter->audio = &mixer;
+						filter->SetLowPass(1.0f, 400.0f + j * 100.0f);
+						dsp = filter;
+					}
+					else
+					{
+						PanDSP* pan = new PanDSP();
+						pan->panning = 0.5f;
+						dsp = pan;
+					}
+					source->AddDSP(dsp);
+				}
+			}
+
+			Timer t;
+			for(uint32 i = 0; i < numBuffers; i++)
+			{
+				mixer.Render(output.data(), bufferLength);
+			}
+			double bufferTime = t.SecondsAsDouble() / numBuffers;
+			double bufferDuration = (double)bufferLength / sampleRate;
+			Logf("%3d streams, %d DSPs each: %8.2f us per buffer (%.2f%% of realtime)", Logger::Info,
+				numStreams, numDSPs, bufferTime * 1000000.0, bufferTime / bufferDuration * 100.0);
+
+			for(BenchmarkSource* source : sources)
+			{
+				while(!source->DSPs.empty())
+				{
+					DSP* dsp = source->DSPs.back();
+					source->RemoveDSP(dsp);
+					delete dsp;
+				}
+				source->Deregister();
+				delete source;
+			}
+			mixer.ReleaseMixer();
+		}
+	}
+}
+
+// Level of a frequency in the left channel relative to full scale, in dB
+static double MeasureLevel(const Vector<float>& samples, double frequency, double sampleRate)
+{
+	// Goertzel filter over the whole buffer
+	const uint32 numFrames = (uint32)(samples.size() / 2);
+	const double coef = 2.0 * cos(2.0 * 3.14159265358979323846 * frequency / sampleRate);
+	double s1 = 0.0;
+	double s2 = 0.0;
+	for(uint32 i = 0; i < numFrames; i++)
+	{
+		double s0 = samples[i * 2] + coef * s1 - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+	double power = s1 * s1 + s2 * s2 - coef * s1 * s2;
+	return 10.0 * log10(Math::Max(power, 1e-30) / ((double)numFrames * numFrames / 4.0));
+}
+
+// Converts a 44.1kHz stream to 48kHz the same way streams do during playback
+//	measures the cost per second of audio for every quality level and the level of the image of a high tone,
+//	the nearest sample path is what streams used before the resampler was added
+Benchmark("Audio.ResampleBenchmark")
+{
+	const double inputRate = 44100.0;
+	const double outputRate = 48000.0;
+	const uint32 bufferLength = 384;
+	const uint32 numSeconds = 20;
+	const double toneFrequency = 15000.0;
+	// The image of the tone above the input nyquist frequency, folded back into the output range
+	const double imageFrequency = outputRate - (inputRate - toneFrequency);
+
+	Vector<float> input;
+	input.resize((size_t)inputRate * 2);
+	for(size_t i = 0; i < input.size() / 2; i++)
+	{
+		float v = 0.5f * (float)sin(2.0 * 3.14159265358979323846 * toneFrequency * i / inputRate);
+		input[i * 2] = v;
+		input[i * 2 + 1] = v;
+	}
+
+	const float speeds[] = { 1.0f, 1.5f };
+	double imageLevels[(size_t)ResampleQuality::_Length];
+	for(float speed : speeds)
+	{
+		for(uint32 q = 0; q < (uint32)ResampleQuality::_Length; q++)
+		{
+			Resampler::PrepareFilter((ResampleQuality)q, inputRate / outputRate * speed);
+			Resampler resampler;
+			resampler.SetQuality((ResampleQuality)q);
+			resampler.SetRatio(inputRate / outputRate * speed);
+
+			Vector<float> output;
+			output.resize((size_t)outputRate * 2);
+			uint32 inputPos = 0;
+			uint32 outputPos = 0;
+			uint32 totalFrames = 0;
+			Timer t;
+			while(totalFrames < (uint32)outputRate * numSeconds)
+			{
+				uint32 needed = resampler.GetInputNeeded(bufferLength);
+				while(needed > 0)
+				{
+					uint32 part = Math::Min(needed, (uint32)(input.size() / 2) - inputPos);
+					resampler.Write(input.data() + inputPos * 2, part);
+					inputPos = (inputPos + part) % (uint32)(input.size() / 2);
+					needed -= part;
+				}
+				// Keep the last second of output for the measurement
+				uint32 consumed;
+				uint32 rendered = resampler.Render(output.data() + outputPos * 2, Math::Min(bufferLength, (uint32)(output.size() / 2) - outputPos), consumed);
+				outputPos = (outputPos + rendered) % (uint32)(output.size() / 2);
+				totalFrames += rendered;
+			}
+			double time = t.SecondsAsDouble();
+
+			String name = Enum_ResampleQuality::ToString((ResampleQuality)q);
+			if(speed == 1.0f)
+			{
+				imageLevels[q] = MeasureLevel(output, imageFrequency, outputRate);
+				Logf("%-8s %6.3f ms per second of audio, tone %.1f dB, image %.1f dB", Logger::Info, *name,
+					time * 1000.0 / numSeconds, MeasureLevel(output, toneFrequency, outputRate), imageLevels[q]);
+			}
+			else
+			{
+				Logf("%-8s %6.3f ms per second of audio at %.1fx speed", Logger::Info, *name, time * 1000.0 / numSeconds, speed);
+			}
+		}
+	}
+
+	// The sinc filters should attenuate the image far more than picking the nearest sample
+	TestEnsure(imageLevels[(size_t)ResampleQuality::Medium] < imageLevels[(size_t)ResampleQuality::Nearest] - 30.0);
+	TestEnsure(imageLevels[(size_t)ResampleQuality::High] < imageLevels[(size_t)ResampleQuality::Medium]);
+}
+
+// Decoded noise that the DSP's in the DSP benchmark are applied to, the retrigger effect samples from it
+class DSPBenchmarkSource : public AudioBase
+{
+public:
+	Vector<float> pcm;
+	int32 position = 0;
+
+	virtual void Process(float* out, uint32 numSamples) override
+	{
+	}
+	virtual int32 GetPosition() const override
+	{
+		return position;
+	}
+	virtual uint32 GetSampleRate() const override
+	{
+		return 48000;
+	}
+	virtual float* GetPCM() override
+	{
+		return pcm.data();
+	}
+};
+
+// Creates the DSP of an effect type with settings close to the game defaults
+static DSP* CreateBenchmarkDSP(EffectType type, Audio_Impl* audio, AudioBase* source)
+{
+	DSP* dsp = nullptr;
+	switch(type)
+	{
+	case EffectType::Retrigger:
+	{
+		RetriggerDSP* retrigger = new RetriggerDSP();
+		retrigger->audio = audio;
+		retrigger->SetMaxLength(250);
+		retrigger->SetLength(125);
+		retrigger->SetGating(0.75f);
+		retrigger->SetResetDuration(500);
+		dsp = retrigger;
+		break;
+	}
+	case EffectType::Flanger:
+	{
+		FlangerDSP* flanger = new FlangerDSP();
+		flanger->audio = audio;
+		flanger->SetLength(2000);
+		flanger->SetDelayRange(30, 60);
+		dsp = flanger;
+		break;
+	}
+	case EffectType::Phaser:
+	{
+		PhaserDSP* phaser = new PhaserDSP();
+		phaser->audio = audio;
+		phaser->SetLength(500);
+		dsp = phaser;
+		break;
+	}
+	case EffectType::Gate:
+	{
+		GateDSP* gate = new GateDSP();
+		gate->audio = audio;
+		gate->SetLength(125);
+		gate->SetGating(0.5f);
+		dsp = gate;
+		break;
+	}
+	case EffectType::TapeStop:
+	{
+		TapeStopDSP* tapeStop = new TapeStopDSP();
+		tapeStop->audio = audio;
+		tapeStop->SetLength(5000);
+		dsp = tapeStop;
+		break;
+	}
+	case EffectType::Bitcrush:
+	{
+		BitCrusherDSP* bitcrusher = new BitCrusherDSP();
+		bitcrusher->audio = audio;
+		bitcrusher->SetPeriod(10);
+		dsp = bitcrusher;
+		break;
+	}
+	case EffectType::Wobble:
+	{
+		WobbleDSP* wobble = new WobbleDSP();
+		wobble->audio = audio;
+		wobble->SetLength(250);
+		dsp = wobble;
+		break;
+	}
+	case EffectType::SideChain:
+	{
+		SidechainDSP* sidechain = new SidechainDSP();
+		sidechain->audio = audio;
+		sidechain->SetLength(500);
+		sidechain->amount = 1.0f;
+		sidechain->curve = Interpolation::CubicBezier(0.39, 0.575, 0.565, 1);
+		dsp = sidechain;
+		break;
+	}
+	case EffectType::Echo:
+	{
+		EchoDSP* echo = new EchoDSP();
+		echo->audio = audio;
+		echo->SetLength(250);
+		dsp = echo;
+		break;
+	}
+	case EffectType::Panning:
+	{
+		PanDSP* pan = new PanDSP();
+		pan->panning = 0.5f;
+		dsp = pan;
+		break;
+	}
+	case EffectType::PitchShift:
+	{
+		PitchShiftDSP* pitchShift = new PitchShiftDSP();
+		pitchShift->amount = 6.0f;
+		dsp = pitchShift;
+		break;
+	}
+	case EffectType::LowPassFilter:
+	case EffectType::HighPassFilter:
+	case EffectType::PeakingFilter:
+	{
+		BQFDSP* filter = new BQFDSP();
+		filter->audio = audio;
+		if(type == EffectType::LowPassFilter)
+			filter->SetLowPass(1.0f, 800.0f);
+		else if(type == EffectType::HighPassFilter)
+			filter->SetHighPass(1.0f, 2000.0f);
+		else
+			filter->SetPeaking(1.0f, 1000.0f, 6.0f);
+		dsp = filter;
+		break;
+	}
+	default:
+		return nullptr;
+	}
+	dsp->audio = audio;
+	dsp->audioBase = source;
+	return dsp;
+}
+
+// Measures the cost of every effect with the scalar kernels and the best ones supported by the cpu
+//	the output of both has to be the same
+Benchmark("Audio.DSPBenchmark")
+{
+	const uint32 sampleRate = 48000;
+	const uint32 bufferLength = 384;
+	const uint32 numBuffers = 1000;
+
+	Audio_Impl mixer;
+	mixer.InitMixer(sampleRate);
+
+	DSPBenchmarkSource source;
+	source.pcm.resize(sampleRate * 20 * 2);
+	uint32 seed = 1;
+	for(float& sample : source.pcm)
+	{
+		seed = seed * 1664525 + 1013904223;
+		sample = (float)(seed >> 8) / (float)(1 << 24) - 0.5f;
+	}
+
+	const DSPKernelLevel levels[] = { DSPKernelLevel::Scalar, DSPKernels::GetSupportedLevel() };
+	Logf("Comparing scalar kernels against %s", Logger::Info, *Enum_DSPKernelLevel::ToString(levels[1]));
+
+	Vector<float> outputs[2];
+	for(uint32 t = (uint32)EffectType::Retrigger; t <= (uint32)EffectType::PeakingFilter; t++)
+	{
+		EffectType type = (EffectType)t;
+		double times[2];
+		for(uint32 l = 0; l < 2; l++)
+		{
+			TestEnsure(DSPKernels::SetLevel(levels[l]));
+			DSP* dsp = CreateBenchmarkDSP(type, &mixer, &source);
+			TestEnsure(dsp);
+
+			outputs[l].resize(bufferLength * numBuffers * 2);
+			memcpy(outputs[l].data(), source.pcm.data(), sizeof(float) * outputs[l].size());
+			Timer timer;
+			for(uint32 i = 0; i < numBuffers; i++)
+			{
+				source.position = (int32)((uint64)i * bufferLength * 1000 / sampleRate);
+				dsp->Process(outputs[l].data() + i * bufferLength * 2, bufferLength);
+			}
+			times[l] = timer.SecondsAsDouble();
+
+			dsp->audioBase = nullptr;
+			delete dsp;
+		}
+
+		float maxError = 0.0f;
+		for(size_t i = 0; i < outputs[0].size(); i++)
+		{
+			maxError = Math::Max(maxError, fabsf(outputs[0][i] - outputs[1][i]));
+		}
+
+		const double numSamples = (double)bufferLength * numBuffers;
+		Logf("%-15s scalar %7.2f ns/sample, %-6s %7.2f ns/sample (%.2fx), max error %g", Logger::Info,
+			*Enum_EffectType::ToString(type), times[0] * 1e9 / numSamples, *Enum_DSPKernelLevel::ToString(levels[1]),
+			times[1] * 1e9 / numSamples, times[0] / times[1], maxError);
+		TestEnsure(maxError < 1e-5f);
+	}
+
+	DSPKernels::SetLevel(levels[1]);
+	mixer.ReleaseMixer();
+}
@@ -0,0 +1,141 @@
+#include "stdafx.h"
+#include <Graphics/Font.hpp>
+#include <Graphics/RenderQueue.hpp>
+using namespace Graphics;
+
+// Creates the graphics context and loads the font used by the font tests
+static Graphics::Font LoadTestFont(TestContext& context, Graphics::Window& window, OpenGL& gl)
+{
+	TestEnsure(gl.Init(window, 0));
+	TestEnsure(FontRes::InitLibrary());
+	Graphics::Font font = FontRes::Create(&gl, Path::Absolute("fonts/settings/NotoSans-Regular.ttf"));
+	TestEnsure(font);
+	return font;
+}
+// Mesh of a text the way a render queue draws it, doesn't hand out the mesh like TextRes::GetMesh
+static MeshRes* GetDrawnMesh(Text text)
+{
+	RenderQueue queue;
+	queue.Draw(Transform(), text, Material());
+	return ((SimpleDrawCall*)queue.GetCommands()[0])->mesh.GetData();
+}
+static WString GetNumberText(uint32 number)
+{
+	return Utility::ConvertToWString(Utility::Sprintf("Text %d", number));
+}
+
+// Every size of a font adds its glyphs to the same atlas, which keeps its texture when it grows
+Test("Font.AtlasSharing")
+{
+	Graphics::Window window;
+	OpenGL gl;
+	Graphics::Font font = LoadTestFont(context, window, gl);
+
+	Text small = font->CreateText(L"Shared atlas", 16);
+	Texture texture = small->GetTexture();
+	Vector2i atlasSize = texture->GetSize();
+
+	Text large = font->CreateText(L"Shared atlas", 48);
+	Text digits = font->CreateText(L"0123456789", 32);
+	TestEnsure(large->GetTexture() == texture);
+	TestEnsure(digits->GetTexture() == texture);
+	TestEnsure(small->GetTexture() == texture);
+	// The larger glyphs grew the atlas
+	TestEnsure(texture->GetSize().x * texture->GetSize().y > atlasSize.x * atlasSize.y);
+	TestEnsure(large->size.x > small->size.x);
+}
+
+// The least recently used text is removed from the cache when the number of texts reaches the limit
+Test("Font.TextCacheCount")
+{
+	Graphics::Window window;
+	OpenGL gl;
+	Graphics::Font font = LoadTestFont(context, window, gl);
+
+	Text first = font->CreateText(L"First", 16);
+	Text recent = font->CreateText(L"Recent", 16);
+	TestEnsure(font->CreateText(L"First", 16) == first);
+	// Options and sizes are part of the key
+	TestEnsure(font->CreateText(L"First", 16, FontRes::Monospace) != first);
+	TestEnsure(font->CreateText(L"First", 20) != first);
+
+	// Fill the cache up to one text over the limit, using the other text halfway
+	const uint32 numTexts = FontRes::maxCachedTexts - 3;
+	for(uint32 i = 0; i < numTexts; i++)
+	{
+		font->CreateText(GetNumberText(i), 16);
+		if(i == numTexts / 2)
+			TestEnsure(font->CreateText(L"Recent", 16) == recent);
+	}
+	TestEnsure(font->CreateText(L"Recent", 16) == recent);
+	TestEnsure(font->CreateText(L"First", 16) != first);
+}
+
+// Long texts are removed from the cache when the size of their vertices reaches the limit
+Test("Font.TextCacheSize")
+{
+	Graphics::Window window;
+	OpenGL gl;
+	Graphics::Font font = LoadTestFont(context, window, gl);
+
+	// Texts of the same length that differ in their last two characters
+	//	every character is a quad of 6 vertices with a position and texture coordinate
+	const uint32 textLength = 1000;
+	const size_t textBytes = textLength * 6 * sizeof(Vector2) * 2;
+	auto GetLongText = [&](uint32 index)
+	{
+		WString str = WString(std::wstring(textLength - 2, L'a'));
+		str.push_back(L'A' + index / 26);
+		str.push_back(L'A' + index % 26);
+		return str;
+	};
+
+	// As many texts as fit, far below the limit on the number of texts
+	const uint32 numTexts = (uint32)(FontRes::maxCachedTextBytes / textBytes);
+	Text first = font->CreateText(GetLongText(0), 16);
+	Text second = font->CreateText(GetLongText(1), 16);
+	Text third = font->CreateText(GetLongText(2), 16);
+	for(uint32 i = 3; i < numTexts; i++)
+	{
+		font->CreateText(GetLongText(i), 16);
+	}
+	TestEnsure(font->CreateText(GetLongText(0), 16) == first);
+	TestEnsure(font->CreateText(GetLongText(1), 16) == second);
+
+	// Over the limit, the least recently used text is removed
+	font->CreateText(GetLongText(numTexts), 16);
+	TestEnsure(font->CreateText(GetLongText(0), 16) == first);
+	TestEnsure(font->CreateText(GetLongText(1), 16) == second);
+	TestEnsure(font->CreateText(GetLongText(2), 16) != third);
+}
+
+// Meshes of destroyed texts are reused, but not while a render queue still draws the text or after the mesh was handed out
+Test("Font.TextMeshReuse")
+{
+	Graphics::Window window;
+	OpenGL gl;
+	Graphics::Font font = LoadTestFont(context, window, gl);
+
+	Text shared = font->CreateText(L"Shared", 16);
+	Mesh sharedMesh = shared->GetMesh();
+	Text text = font->CreateText(L"Queued", 16);
+	MeshRes* queuedMesh = GetDrawnMesh(text);
+	RenderQueue queue;
+	queue.Draw(Transform(), text, Material());
+	shared.Release();
+	text.Release();
+
+	// Push both texts out of the cache, only the render queue keeps the second text alive
+	//	a text is removed after the new text got its mesh, so the last text is the first that could get the mesh of the second
+	for(uint32 i = 0; i <= FontRes::maxCachedTexts; i++)
+	{
+		MeshRes* mesh = GetDrawnMesh(font->CreateText(GetNumberText(i), 16));
+		TestEnsure(mesh != sharedMesh.GetData());
+		TestEnsure(mesh != queuedMesh);
+	}
+
+	// Destroys the text, its mesh is used for the next new text
+	queue.Clear();
+	text = font->CreateText(L"Reused", 16);
+	TestEnsure(GetDrawnMesh(text) == queuedMesh);
+}
@@ -0,0 +1,443 @@
+#include "stdafx.h"
+#include <Beatmap/MapDatabase.hpp>
+#include <Beatmap/TinySHA1.hpp>
+
+#include <algorithm>
+#ifdef __linux__
+#include <unistd.h>
+#include <malloc.h>
+#endif
+using namespace std;
+
+// Number of charts generated for the database benchmarks
+static const uint32 benchmarkChartCount = 4000;
+
+// Writes a small but valid ksh chart with a unique title
+static void CreateBenchmarkChart(const String& path, uint32 index)
+{
+	File file;
+	TestEnsure(file.OpenWrite(path));
+	String chart = Utility::Sprintf(
+		"title=Benchmark Song %d\r\n"
+		"artist=Benchmark Artist Number %d\r\n"
+		"effect=Benchmark Effector Number %d\r\n"
+		"jacket=jacket.png\r\n"
+		"illustrator=Benchmark Illustrator\r\n"
+		"difficulty=%s\r\n"
+		"level=%d\r\n"
+		"t=%d\r\n"
+		"m=song.ogg\r\n"
+		"o=0\r\n"
+		"po=10000\r\n"
+		"plength=15000\r\n"
+		"ver=160\r\n"
+		"--\r\n", index, index % 97, index % 13, (index % 2) ? "challenge" : "extended", 1 + index % 20, 120 + index % 100);
+	for(uint32 i = 0; i < 64; i++)
+	{
+		chart += "beat=4/4\r\n1000|00|--\r\n0100|00|--\r\n0010|00|--\r\n0001|00|--\r\n--\r\n";
+	}
+	file.Write(*chart, chart.size());
+}
+
+// Resident memory of this process in bytes, 0 if not supported on this platform
+static uint64 GetResidentMemory()
+{
+#ifdef __linux__
+	File file;
+	if(!file.OpenRead("/proc/self/statm"))
+		return 0;
+	char buffer[128] = { 0 };
+	file.Read(buffer, sizeof(buffer) - 1);
+	unsigned long long size, resident;
+	if(sscanf(buffer, "%llu %llu", &size, &resident) != 2)
+		return 0;
+	return resident * sysconf(_SC_PAGESIZE);
+#else
+	return 0;
+#endif
+}
+
+// Heap memory in use in bytes, 0 if not supported on this platform
+static uint64 GetHeapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+// Generates a library with two charts per song folder
+static String CreateTestLibrary(const String& basePath, const String& name, uint32 numCharts)
+{
+	String libraryPath = Path::Absolute(basePath + Path::sep + name);
+	TestEnsure(Path::CreateDir(libraryPath));
+	for(uint32 i = 0; i < numCharts; i++)
+	{
+		String folder = libraryPath + Path::sep + Utility::Sprintf("Song%05d", i / 2);
+		if(i % 2 == 0)
+			TestEnsure(Path::CreateDir(folder));
+		CreateBenchmarkChart(folder + Path::sep + Utility::Sprintf("chart%d.ksh", i % 2), i);
+	}
+	return libraryPath;
+}
+
+// Adds the library to the database, then scans it and waits for the changes to be applied
+static void ScanLibrary(MapDatabase& database, const String& libraryPath)
+{
+	database.AddSearchPath(libraryPath);
+	database.StartSearching();
+	database.WaitForSearch();
+}
+
+// Sha1 of a file in the same format as the chart hashes
+static String HashFile(const String& path)
+{
+	File file;
+	TestEnsure(file.OpenRead(path));
+	Buffer data(file.GetSize());
+	file.Read(data.data(), data.size());
+	uint32_t digest[5];
+	sha1::SHA1 s;
+	s.processBytes(data.data(), data.size());
+	s.getDigest(digest);
+	return Utility::Sprintf("%08x%08x%08x%08x%08x", digest[0], digest[1], digest[2], digest[3], digest[4]);
+}
+
+// Charts are parsed and hashed by the workers, but added in the order they were found on disk
+Test("MapDatabase.Scan")
+{
+	const uint32 numCharts = 24;
+	String libraryPath = CreateTestLibrary(TestBasePath, "ScanLibrary", numCharts);
+
+	// Corrupted charts are skipped
+	File corrupted;
+	TestEnsure(corrupted.OpenWrite(libraryPath + Path::sep + "Song00000" + Path::sep + "corrupted.ksh"));
+	String corruptedData = "not a chart\r\n";
+	corrupted.Write(*corruptedData, corruptedData.size());
+	corrupted.Close();
+
+	MapDatabase database(false, TestBasePath + Path::sep + "scan.db");
+	ScanLibrary(database, libraryPath);
+
+	MapDatabaseScanStats stats = database.GetLastScanStats();
+	TestEnsure(stats.numFiles == numCharts + 1);
+	TestEnsure(stats.numProcessed == numCharts + 1);
+	TestEnsure(stats.numWorkers >= 1);
+
+	Map<int32, ChartIndex*> charts;
+	for(auto& folder : database.FindFoldersByPath(""))
+	{
+		for(ChartIndex* chart : folder.second->charts)
+		{
+			TestEnsure(chart->hash == HashFile(chart->path));
+			charts.Add(chart->id, chart);
+		}
+	}
+	TestEnsure(charts.size() == numCharts);
+
+	String previousPath;
+	for(auto& chart : charts)
+	{
+		TestEnsure(previousPath < chart.second->path);
+		previousPath = chart.second->path;
+	}
+
+	// Nothing changed, only the chart that was never added is parsed again
+	database.StartSearching();
+	database.WaitForSearch();
+	stats = database.GetLastScanStats();
+	TestEnsure(stats.numFiles == numCharts + 1);
+	TestEnsure(stats.numProcessed == 1);
+}
+
+// Generates a chart library, then measures a cold scan into an empty database
+Benchmark("MapDatabase.ScanBenchmark")
+{
+	String libraryPath = CreateTestLibrary(TestBasePath, "Library", benchmarkChartCount);
+
+	MapDatabase database(false, TestBasePath + Path::sep + "benchmark.db");
+	Timer t;
+	ScanLibrary(database, libraryPath);
+	uint32 totalTime = t.Milliseconds();
+
+	MapDatabaseScanStats stats = database.GetLastScanStats();
+	Logf("Scanned %d charts in %d ms (%.1f charts/s on %d threads)", Logger::Info,
+		stats.numFiles, totalTime, stats.GetChartsPerSecond(), stats.numWorkers);
+	Logf(" Enumerate: %d ms", Logger::Info, stats.enumerateTime);
+	Logf(" Removed:   %d ms", Logger::Info, stats.removedTime);
+	Logf(" Process:   %d ms", Logger::Info, stats.processTime);
+	Logf(" Flush:     %d ms", Logger::Info, totalTime - stats.enumerateTime - stats.removedTime - stats.processTime);
+
+	TestEnsure(stats.numProcessed == benchmarkChartCount);
+	TestEnsure(database.FindFoldersByPath("").size() == benchmarkChartCount / 2);
+
+	// Rescanning the unchanged library only has to check the folders
+	t.Restart();
+	database.StartSearching();
+	database.WaitForSearch();
+
+	stats = database.GetLastScanStats();
+	Logf("Rescanned %d charts in %d ms (enumerate: %d ms)", Logger::Info, stats.numFiles, t.Milliseconds(), stats.enumerateTime);
+	TestEnsure(stats.numFiles == benchmarkChartCount);
+	TestEnsure(stats.numProcessed == 0);
+}
+
+// Search terms match the start of words in the indexed fields, the index follows changes from later scans
+Test("MapDatabase.Search")
+{
+	const uint32 numCharts = 20;
+	String libraryPath = CreateTestLibrary(TestBasePath, "SearchLibrary", numCharts);
+	MapDatabase database(false, TestBasePath + Path::sep + "search.db");
+	ScanLibrary(database, libraryPath);
+
+	TestEnsure(database.FindFolders("bench").size() == numCharts / 2);
+	TestEnsure(database.FindFolders("BENCHMARK song").size() == numCharts / 2);
+	// Every term has to match, only chart 12 has a word starting with 12
+	TestEnsure(database.FindFolders("song 12").size() == 1);
+	// Charts 1 and 10-19, in 6 folders
+	TestEnsure(database.FindFolders("song 1").size() == 6);
+	// Words are not matched in the middle
+	TestEnsure(database.FindFolders("ench").empty());
+	TestEnsure(database.FindFolders("nothing").empty());
+	// Quotes and punctuation are not interpreted as query syntax
+	TestEnsure(database.FindFolders("\"").empty());
+	TestEnsure(database.FindFolders("\"benchmark").size() == numCharts / 2);
+	TestEnsure(database.FindFolders("song* OR nothing").empty());
+
+	TestEnsure(database.FindFoldersByPath("").size() == numCharts / 2);
+	TestEnsure(database.FindFoldersByPath("Song00003").size() == 1);
+	TestEnsure(database.FindFoldersByFolder("Song00003").size() == 1);
+	// Only whole path components match a folder
+	TestEnsure(database.FindFoldersByFolder("Song0000").empty());
+
+	// Removed charts disappear from the index
+	TestEnsure(Path::DeleteDir(libraryPath + Path::sep + "Song00003"));
+	database.StartSearching();
+	database.WaitForSearch();
+	TestEnsure(database.FindFolders("bench").size() == numCharts / 2 - 1);
+	TestEnsure(database.FindFoldersByFolder("Song00003").empty());
+}
+
+// Measures search latency for libraries of increasing size
+Benchmark("MapDatabase.SearchBenchmark")
+{
+	const uint32 librarySizes[] = { 500, 2000, 8000 };
+	const char* queries[] = { "benchmark", "song 12", "artist 5", "effector 3", "song00", "nothing" };
+	const uint32 numRepeats = 50;
+
+	for(uint32 numCharts : librarySizes)
+	{
+		String libraryPath = CreateTestLibrary(TestBasePath, Utility::Sprintf("Library%d", numCharts), numCharts);
+		MapDatabase database(false, TestBasePath + Path::sep + Utility::Sprintf("search%d.db", numCharts));
+		ScanLibrary(database, libraryPath);
+
+		// Every chart has this in its title
+		TestEnsure(database.FindFolders("bench").size() == numCharts / 2);
+		TestEnsure(database.FindFolders("Benchmark Song 1").size() > 0);
+		TestEnsure(database.FindFolders("nothing").empty());
+		TestEnsure(database.FindFoldersByFolder("Song00000").size() == 1);
+
+		Logf("%d charts:", Logger::Info, numCharts);
+		for(const char* query : queries)
+		{
+			size_t numResults = 0;
+			Timer t;
+			for(uint32 i = 0; i < numRepeats; i++)
+			{
+				numResults = database.FindFolders(query).size();
+			}
+			Logf(" \"%s\": %.3f ms (%d results)", Logger::Info, query, t.SecondsAsFloat() * 1000.0f / numRepeats, numResults);
+		}
+	}
+}
+
+// Full combo badge like Scoring::CalculateBadge, everything else is a played badge
+static uint8 TestBadge(const ScoreIndex& score)
+{
+	return score.miss == 0 ? 4 : 1;
+}
+
+// Only the best scores are loaded up front, the rest is loaded on demand and limited by the cache size
+//	the top score and badge still include the scores that were not loaded
+Test("MapDatabase.LazyScores")
+{
+	const uint32 numCharts = 8;
+	const uint32 scoresPerChart = 30;
+	String libraryPath = CreateTestLibrary(TestBasePath, "ScoreLibrary", numCharts);
+	String databasePath = TestBasePath + Path::sep + "scores.db";
+	{
+		MapDatabase database(false, databasePath);
+		ScanLibrary(database, libraryPath);
+
+		for(auto& folder : database.FindFoldersByPath(""))
+		{
+			for(ChartIndex* chart : folder.second->charts)
+			{
+				for(uint32 i = 0; i < scoresPerChart - 1; i++)
+				{
+					database.AddScore(*chart, 9000000 + (i * 7919) % 1000000, 1000, 10, 5, 1.0f, 0, Vector<SimpleHitStat>(), 0);
+				}
+				// The best badge belongs to the worst score
+				database.AddScore(*chart, 8000000, 900, 100, 0, 1.0f, 0, Vector<SimpleHitStat>(), 0);
+			}
+		}
+	}
+
+	MapDatabase database(true, databasePath);
+	database.SetScoreLimits(5, 50);
+	database.SetBadgeFunction(&TestBadge);
+	database.FinishInit();
+	Vector<ChartIndex*> charts;
+	for(auto& folder : database.FindFoldersByPath(""))
+	{
+		for(ChartIndex* chart : folder.second->charts)
+		{
+			TestEnsure(!chart->scoresComplete);
+			TestEnsure(chart->scores.size() == 5);
+			TestEnsure(chart->scores.back()->miss == 5);
+			TestEnsure(chart->topScore == chart->scores[0]->score);
+			TestEnsure(chart->topBadge == 4);
+			charts.Add(chart);
+		}
+	}
+	TestEnsure(charts.size() == numCharts);
+
+	ScoreIndex* best = charts[0]->scores[0];
+	const Vector<ScoreIndex*>& scores = database.GetScores(charts[0]);
+	TestEnsure(charts[0]->scoresComplete);
+	TestEnsure(scores.size() == scoresPerChart);
+	TestEnsure(scores[0] == best);
+	for(size_t i = 1; i < scores.size(); i++)
+	{
+		TestEnsure(scores[i - 1]->score >= scores[i]->score);
+	}
+
+	// Two charts fit in the cache, loading a third one drops the least recently used
+	database.GetScores(charts[1]);
+	database.GetScores(charts[0]);
+	database.GetScores(charts[2]);
+	TestEnsure(charts[0]->scoresComplete);
+	TestEnsure(!charts[1]->scoresComplete);
+	TestEnsure(charts[1]->scores.size() == 5);
+	TestEnsure(charts[2]->scores.size() == scoresPerChart);
+	TestEnsure(charts[1]->topBadge == 4);
+
+	// Charts found by a scan pick up the existing scores of charts with the same hash
+	String copyPath = CreateTestLibrary(TestBasePath, "ScoreLibraryCopy", numCharts);
+	ScanLibrary(database, copyPath);
+	Map<int32, FolderIndex*> copies = database.FindFoldersByPath("ScoreLibraryCopy");
+	TestEnsure(copies.size() == numCharts / 2);
+	for(auto& folder : copies)
+	{
+		for(ChartIndex* chart : folder.second->charts)
+		{
+			TestEnsure(!chart->scoresComplete);
+			TestEnsure(chart->scores.size() == 5);
+			TestEnsure(chart->topScore == chart->scores[0]->score);
+			TestEnsure(chart->topBadge == 4);
+		}
+	}
+}
+
+// Only fields with a few distinct values are interned, charts added later don't grow the intern table
+Test("MapDatabase.InternedFields")
+{
+	const uint32 numCharts = 20;
+	String libraryPath = CreateTestLibrary(TestBasePath, "InternLibrary", numCharts);
+	MapDatabase database(false, TestBasePath + Path::sep + "intern.db");
+	ScanLibrary(database, libraryPath);
+
+	Map<int32, ChartIndex*> charts;
+	for(auto& folder : database.FindFoldersByPath(""))
+	{
+		for(ChartIndex* chart : folder.second->charts)
+		{
+			charts.Add(chart->id, chart);
+		}
+	}
+	TestEnsure(charts.size() == numCharts);
+	ChartIndex* first = charts.begin()->second;
+	for(auto& chart : charts)
+	{
+		bool sameDifficulty = chart.second->diff_index == first->diff_index;
+		TestEnsure(sameDifficulty == (chart.second->diff_name.c_str() == first->diff_name.c_str()));
+	}
+
+	// Same field values, but every chart has its own path and title
+	size_t numInterned = InternedString::GetNumInterned();
+	String copyPath = CreateTestLibrary(TestBasePath, "InternLibraryCopy", numCharts);
+	database.AddSearchPath(copyPath);
+	database.StartSearching();
+	database.WaitForSearch();
+	TestEnsure(database.FindFoldersByPath("").size() == numCharts);
+	TestEnsure(InternedString::GetNumInterned() == numInterned);
+}
+
+// Measures loading the chart index, its memory use and iterating it the way the song wheel does
+Benchmark("MapDatabase.IndexBenchmark")
+{
+	const uint32 numCharts = 20000;
+	String libraryPath = CreateTestLibrary(TestBasePath, "IndexLibrary", numCharts);
+	String databasePath = TestBasePath + Path::sep + "index.db";
+	{
+		MapDatabase database(false, databasePath);
+		ScanLibrary(database, libraryPath);
+	}
+
+	uint64 memoryBefore = GetResidentMemory();
+	uint64 heapBefore = GetHeapInUse();
+	Timer t;
+	MapDatabase database(false, databasePath);
+	uint32 loadTime = t.Milliseconds();
+	uint64 memoryAfter = GetResidentMemory();
+	uint64 heapAfter = GetHeapInUse();
+
+	Map<int32, FolderIndex*> folders = database.FindFoldersByPath("");
+	TestEnsure(folders.size() == numCharts / 2);
+	Logf("Loaded %d charts in %d ms, resident memory +%.2f MB, heap +%.2f MB", Logger::Info,
+		numCharts, loadTime, (double)(memoryAfter - memoryBefore) / (1024.0 * 1024.0), (double)(heapAfter - heapBefore) / (1024.0 * 1024.0));
+
+	// Level filter
+	const uint32 numRepeats = 20;
+	uint32 numFiltered = 0;
+	t.Restart();
+	for(uint32 i = 0; i < numRepeats; i++)
+	{
+		numFiltered = 0;
+		for(auto& folder : folders)
+		{
+			for(ChartIndex* chart : folder.second->charts)
+			{
+				if(chart->level == 10)
+					numFiltered++;
+			}
+		}
+	}
+	Logf(" Filter by level: %.3f ms (%d charts)", Logger::Info, t.SecondsAsFloat() * 1000.0f / numRepeats, numFiltered);
+
+	// Sort by artist, then title, the same way the song wheel does
+	Vector<FolderIndex*> sorted;
+	for(auto& folder : folders)
+	{
+		sorted.Add(folder.second);
+	}
+	t.Restart();
+	for(uint32 i = 0; i < numRepeats; i++)
+	{
+		std::sort(sorted.begin(), sorted.end(), [](FolderIndex* a, FolderIndex* b)
+		{
+			auto& artistA = a->charts[0]->artist;
+			auto& artistB = b->charts[0]->artist;
+			if(artistA == artistB)
+				return a->charts[0]->title < b->charts[0]->title;
+			String upperA = artistA;
+			String upperB = artistB;
+			upperA.ToUpper();
+			upperB.ToUpper();
+			return upperA < upperB;
+		});
+		std::reverse(sorted.begin(), sorted.end());
+	}
+	Logf(" Sort by artist: %.3f ms", Logger::Info, t.SecondsAsFloat() * 1000.0f / numRepeats);
+}
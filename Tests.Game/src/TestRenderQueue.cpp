@@ -0,0 +1,61 @@
+#include "stdafx.h"
+#include <Graphics/RenderQueue.hpp>
+using namespace Graphics;
+
+// Material that is never bound, only used to tell the commands in a queue apart
+class OrderTestMaterial : public MaterialRes
+{
+public:
+	OrderTestMaterial(bool opaque)
+	{
+		this->opaque = opaque;
+	}
+	void AssignShader(ShaderType t, Shader shader) override {}
+	void Bind(const RenderState& rs, const MaterialParameterSet& params) override {}
+	void BindParameters(const MaterialParameterSet& params, const Transform& worldTransform) override {}
+	bool HasUniform(String name) override
+	{
+		return false;
+	}
+	void BindToContext() override {}
+};
+
+static Material GetCommandMaterial(const RenderQueueItem* item)
+{
+	return ((const SimpleDrawCall*)item)->mat;
+}
+
+// There is no depth test, so opaque and transparent commands have to be drawn in the order they were added
+Test("RenderQueue.Order")
+{
+	Material opaque[3];
+	Material transparent[3];
+	for(uint32 i = 0; i < 3; i++)
+	{
+		opaque[i] = Material(new OrderTestMaterial(true));
+		transparent[i] = Material(new OrderTestMaterial(false));
+	}
+
+	RenderQueue queue;
+	queue.Draw(Transform(), Mesh(), transparent[0]);
+	queue.Draw(Transform(), Mesh(), opaque[0]);
+	queue.Draw(Transform(), Mesh(), transparent[1]);
+	queue.Draw(Transform(), Mesh(), opaque[1]);
+	// Same material as an earlier command, still not grouped with it
+	queue.Draw(Transform(), Mesh(), opaque[0]);
+	// Higher layers are drawn after lower ones, regardless of the order they were added in
+	queue.SetLayer(1);
+	queue.Draw(Transform(), Mesh(), opaque[2]);
+	queue.SetLayer(0);
+	queue.Draw(Transform(), Mesh(), transparent[2]);
+
+	Material expected[] = { transparent[0], opaque[0], transparent[1], opaque[1], opaque[0], transparent[2], opaque[2] };
+	const Vector<RenderQueueItem*>& commands = queue.GetCommands();
+	TestEnsure(commands.size() == 7);
+	for(size_t i = 0; i < commands.size(); i++)
+	{
+		TestEnsure(GetCommandMaterial(commands[i]) == expected[i]);
+	}
+	TestEnsure(commands[5]->layer == 0);
+	TestEnsure(commands[6]->layer == 1);
+}
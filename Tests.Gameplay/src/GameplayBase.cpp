@@ -0,0 +1,84 @@
+#include "stdafx.h"
+#include "GameplayBase.hpp"
+#include "GameConfig.hpp"
+#include "Game.hpp"
+#include <Beatmap/Beatmap.hpp>
+
+// Parts of Application and Game that the gameplay code uses, these are not part of the test build
+GameConfig g_gameConfig;
+
+Ref<Beatmap> TryLoadMap(const String& path)
+{
+	Beatmap* newMap = new Beatmap();
+	File mapFile;
+	if(!mapFile.OpenRead(path))
+	{
+		delete newMap;
+		return Ref<Beatmap>();
+	}
+	FileReader reader(mapFile);
+	if(!newMap->Load(reader))
+	{
+		delete newMap;
+		return Ref<Beatmap>();
+	}
+	return Ref<Beatmap>(newMap);
+}
+
+GameFlags operator|(const GameFlags& a, const GameFlags& b)
+{
+	return (GameFlags)((uint32)a | (uint32)b);
+}
+GameFlags operator&(const GameFlags& a, const GameFlags& b)
+{
+	return (GameFlags)((uint32)a & (uint32)b);
+}
+GameFlags operator~(const GameFlags& a)
+{
+	return (GameFlags)(~(uint32)a);
+}
+
+const char* emptyMeasure = "0000|00|--\n--\n";
+
+String CreateTestChart(TestContext& context, const String& name, const String& measures)
+{
+	String path = context.GetTestBasePath() + Path::sep + name + ".ksh";
+	File file;
+	TestEnsure(file.OpenWrite(path));
+	String chart = Utility::Sprintf("title=%s\r\n", name) +
+		"artist=Tests\r\n"
+		"effect=Tests\r\n"
+		"t=120\r\n"
+		"m=song.ogg\r\n"
+		"o=0\r\n"
+		"beat=4/4\r\n"
+		"--\r\n";
+	Vector<String> lines = measures.Explode("\n");
+	for(String& line : lines)
+	{
+		line.TrimBack('\r');
+		line.Trim();
+		if(!line.empty())
+			chart += line + "\r\n";
+	}
+	file.Write(*chart, chart.size());
+	return path;
+}
+
+void AddHold(GameSimulation& simulation, Input::Button button, MapTime start, MapTime end)
+{
+	GameSimulation::InputEvent press;
+	press.time = start;
+	press.button = button;
+	press.pressed = true;
+	simulation.AddInput(press);
+
+	GameSimulation::InputEvent release = press;
+	release.time = end;
+	release.pressed = false;
+	simulation.AddInput(release);
+}
+void AddPress(GameSimulation& simulation, Input::Button button, MapTime time)
+{
+	AddHold(simulation, button, time, time + 20);
+}
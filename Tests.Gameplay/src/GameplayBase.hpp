@@ -0,0 +1,16 @@
+#pragma once
+#include <Tests/Tests.hpp>
+#include "GameSimulation.hpp"
+
+// Empty first measure, so the first objects are not at the first gameplay tick
+extern const char* emptyMeasure;
+
+// Writes a chart to the test folder and returns its path
+//	the chart plays at 120 bpm in 4/4, so every measure is 2 seconds long
+//	measures contains the rows of the chart in the ksh format, starting with the first measure
+String CreateTestChart(TestContext& context, const String& name, const String& measures);
+
+// Presses a button at the start time and releases it at the end time
+void AddHold(GameSimulation& simulation, Input::Button button, MapTime start, MapTime end);
+// Presses and releases a button, the release is 20ms after the press
+void AddPress(GameSimulation& simulation, Input::Button button, MapTime time);
@@ -0,0 +1,7 @@
+#include "stdafx.h"
+#include <Tests/Tests.hpp>
+
+int main(void)
+{
+	return TestMain();
+}
@@ -0,0 +1,96 @@
+#include "stdafx.h"
+#include "GameplayBase.hpp"
+
+// Quarter notes on BT-A starting at 2000ms
+static const char* quarterNotes = "1000|00|--\n1000|00|--\n1000|00|--\n1000|00|--\n--\n";
+
+// Adds presses that are critical, early and late by the same amount, and a near that is almost a miss
+static void AddQuarterNoteInput(GameSimulation& simulation)
+{
+	AddPress(simulation, Input::Button::BT_0, 2030);
+	AddPress(simulation, Input::Button::BT_0, 2440);
+	AddPress(simulation, Input::Button::BT_0, 3060);
+	AddPress(simulation, Input::Button::BT_0, 3590);
+}
+static void CheckQuarterNoteResult(const GameSimulation& simulation)
+{
+	const Scoring& scoring = simulation.GetScoring();
+	TestEnsure(scoring.categorizedHits[2] == 1);
+	TestEnsure(scoring.categorizedHits[1] == 3);
+	TestEnsure(scoring.categorizedHits[0] == 0);
+	TestEnsure(scoring.timedHits[0] == 1);
+	TestEnsure(scoring.timedHits[1] == 2);
+}
+
+// Without input the chart is played by autoplay
+Test("GameSimulation.Autoplay")
+{
+	// Buttons, FX, holds and a laser that moves from left to right
+	String chartPath = CreateTestChart(context, "Autoplay", String(emptyMeasure) +
+		"1000|20|0-\n0200|00|:-\n0200|00|o-\n0001|02|--\n--\n" + emptyMeasure);
+
+	GameSimulation simulation;
+	TestEnsure(simulation.Init(chartPath));
+	simulation.Run(60.0f);
+	const Scoring& scoring = simulation.GetScoring();
+	TestEnsure(scoring.categorizedHits[0] == 0);
+	TestEnsure(scoring.categorizedHits[1] == 0);
+	TestEnsure(scoring.CalculateCurrentScore() == 10000000);
+	// Runs until every object has left its hit window
+	TestEnsure(simulation.GetNumSteps() >= (uint32)((simulation.GetEndTime() + Scoring::missHitTime) * 60 / 1000));
+}
+
+// The result doesn't depend on the step rate, even when steps are further apart than the limit on the input time correction
+Test("GameSimulation.LowRate")
+{
+	String chartPath = CreateTestChart(context, "LowRate", String(emptyMeasure) + quarterNotes);
+
+	GameSimulation simulation;
+	TestEnsure(simulation.Init(chartPath));
+	AddQuarterNoteInput(simulation);
+
+	simulation.Run(1000.0f);
+	CheckQuarterNoteResult(simulation);
+	simulation.Run(60.0f);
+	CheckQuarterNoteResult(simulation);
+	// 200ms apart, presses are up to 190ms after the last step
+	simulation.Run(5.0f);
+	CheckQuarterNoteResult(simulation);
+}
+
+// Recorded input files give the same result as the same events added directly
+Test("GameSimulation.LoadInput")
+{
+	String chartPath = CreateTestChart(context, "LoadInput", String(emptyMeasure) + quarterNotes);
+	String inputPath = context.GetTestBasePath() + Path::sep + "LoadInput.txt";
+	{
+		File file;
+		TestEnsure(file.OpenWrite(inputPath));
+		String input =
+			"# Recorded input\r\n"
+			"2030 BT_0 1\r\n2050 BT_0 0\r\n"
+			"2440 BT_0 1\r\n2460 BT_0 0\r\n"
+			"\r\n"
+			"3060 BT_0 1\r\n3080 BT_0 0\r\n"
+			"3590 BT_0 1\r\n3610 BT_0 0\r\n"
+			"2000 Laser0 1.5\r\n2500 Laser0 0\r\n";
+		file.Write(*input, input.size());
+	}
+
+	GameSimulation simulation;
+	TestEnsure(simulation.Init(chartPath));
+	TestEnsure(simulation.LoadInput(inputPath));
+	simulation.Run(60.0f);
+	CheckQuarterNoteResult(simulation);
+
+	// Unknown buttons are rejected
+	String invalidPath = context.GetTestBasePath() + Path::sep + "LoadInputInvalid.txt";
+	{
+		File file;
+		TestEnsure(file.OpenWrite(invalidPath));
+		String input = "2000 BT_Z 1\r\n";
+		file.Write(*input, input.size());
+	}
+	GameSimulation invalid;
+	TestEnsure(!invalid.LoadInput(invalidPath));
+}
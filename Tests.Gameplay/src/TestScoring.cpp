@@ -0,0 +1,115 @@
+#include "stdafx.h"
+#include "GameplayBase.hpp"
+
+// Buttons are judged at the time their input event was received, not at the gameplay tick that handles it
+Test("Scoring.InputEventTime")
+{
+	// Eighth notes on all four buttons starting at 2000ms
+	String chartPath = CreateTestChart(context, "InputEventTime", String(emptyMeasure) +
+		"1000|00|--\n0100|00|--\n0010|00|--\n0001|00|--\n"
+		"1000|00|--\n0100|00|--\n0010|00|--\n0001|00|--\n--\n");
+
+	GameSimulation simulation;
+	TestEnsure(simulation.Init(chartPath));
+	for(uint32 i = 0; i < 8; i++)
+	{
+		MapTime time = 2000 + i * 250;
+		// The first two presses are late and early by more than the critical window
+		if(i == 0)
+			time += 60;
+		else if(i == 1)
+			time -= 60;
+		AddPress(simulation, (Input::Button)(i % 4), time);
+	}
+
+	// Ticks are 83ms apart, so judging at the tick would turn most on time presses into nears
+	simulation.Run(12.0f);
+	const Scoring& scoring = simulation.GetScoring();
+	TestEnsure(scoring.categorizedHits[2] == 6);
+	TestEnsure(scoring.categorizedHits[1] == 2);
+	TestEnsure(scoring.categorizedHits[0] == 0);
+	// Early and late hits
+	TestEnsure(scoring.timedHits[0] == 1);
+	TestEnsure(scoring.timedHits[1] == 1);
+}
+
+// Every button is judged once, presses outside of the hit windows miss or are ignored
+Test("Scoring.HitsAndMisses")
+{
+	// Quarter notes on BT-A starting at 2000ms
+	String chartPath = CreateTestChart(context, "HitsAndMisses", String(emptyMeasure) +
+		"1000|00|--\n1000|00|--\n1000|00|--\n1000|00|--\n--\n");
+
+	GameSimulation simulation;
+	TestEnsure(simulation.Init(chartPath));
+	// Critical, late near, not pressed and a press that is too early
+	AddPress(simulation, Input::Button::BT_0, 2000);
+	AddPress(simulation, Input::Button::BT_0, 2570);
+	AddPress(simulation, Input::Button::BT_0, 3350);
+	// Nothing left to judge
+	AddPress(simulation, Input::Button::BT_0, 3500);
+	// No objects on this lane
+	AddPress(simulation, Input::Button::BT_1, 2000);
+
+	simulation.Run(60.0f);
+	const Scoring& scoring = simulation.GetScoring();
+	TestEnsure(scoring.categorizedHits[2] == 1);
+	TestEnsure(scoring.categorizedHits[1] == 1);
+	TestEnsure(scoring.categorizedHits[0] == 2);
+	TestEnsure(scoring.timedHits[0] == 0);
+	TestEnsure(scoring.timedHits[1] == 1);
+	TestEnsure(scoring.maxComboCounter == 2);
+}
+
+// Hold ticks are hit while the button is held and missed after it is released
+Test("Scoring.Holds")
+{
+	// Holds on BT-A and BT-B for a whole measure, 2000ms to 4000ms
+	String chartPath = CreateTestChart(context, "Holds", String(emptyMeasure) +
+		"2200|00|--\n2200|00|--\n2200|00|--\n2200|00|--\n--\n" + emptyMeasure);
+
+	GameSimulation simulation;
+	TestEnsure(simulation.Init(chartPath));
+	AddHold(simulation, Input::Button::BT_0, 1990, 4100);
+	// Released halfway
+	AddHold(simulation, Input::Button::BT_1, 2010, 2950);
+
+	simulation.Run(60.0f);
+	const Scoring& scoring = simulation.GetScoring();
+	// A tick every 16th note, without the ones at the start and end of the hold
+	TestEnsure(scoring.categorizedHits[2] == 14 + 7);
+	TestEnsure(scoring.categorizedHits[1] == 0);
+	TestEnsure(scoring.categorizedHits[0] == 7);
+	// The combo breaks at the first missed BT-B tick, after the BT-A tick at the same time
+	TestEnsure(scoring.maxComboCounter == 7 + 7 + 1);
+}
+
+// Input that is added out of order or is handled in a different order than the lanes is judged by its event time
+Test("Scoring.OutOfOrderInput")
+{
+	// Two BT-A notes a 16th apart, a chord on BT-B, BT-C and BT-D, then a hold on BT-D right after it
+	String chartPath = CreateTestChart(context, "OutOfOrderInput", String(emptyMeasure) +
+		"1000|00|--\n1000|00|--\n0000|00|--\n0000|00|--\n"
+		"0000|00|--\n0000|00|--\n0000|00|--\n0000|00|--\n"
+		"0111|00|--\n0002|00|--\n0002|00|--\n0002|00|--\n"
+		"0002|00|--\n0000|00|--\n0000|00|--\n0000|00|--\n--\n" + emptyMeasure);
+
+	GameSimulation simulation;
+	TestEnsure(simulation.Init(chartPath));
+	// Added from last to first
+	AddHold(simulation, Input::Button::BT_3, 3125, 3650);
+	AddPress(simulation, Input::Button::BT_3, 3000);
+	AddPress(simulation, Input::Button::BT_1, 3010);
+	AddPress(simulation, Input::Button::BT_2, 2990);
+	// The first press is too late for the first note and misses it, the second one hits the next note
+	AddPress(simulation, Input::Button::BT_0, 2140);
+	AddPress(simulation, Input::Button::BT_0, 2110);
+
+	// Both BT-A presses and all presses of the chord are handled by the same tick
+	simulation.Run(12.0f);
+	const Scoring& scoring = simulation.GetScoring();
+	TestEnsure(scoring.categorizedHits[2] == 1 + 3 + 2);
+	TestEnsure(scoring.categorizedHits[1] == 0);
+	TestEnsure(scoring.categorizedHits[0] == 1);
+	TestEnsure(scoring.maxComboCounter == 3 + 3);
+}
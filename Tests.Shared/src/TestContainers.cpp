@@ -0,0 +1,46 @@
+#include <Shared/Shared.hpp>
+#include <Shared/ObjectPool.hpp>
+#include <Shared/InternedString.hpp>
+#include <Tests/Tests.hpp>
+
+Test("ObjectPool.Reuse")
+{
+	ObjectPool<String, 4> pool;
+	Vector<String*> objects;
+	for(int i = 0; i < 10; i++)
+	{
+		objects.Add(pool.Create(Utility::Sprintf("Object %d", i)));
+	}
+	TestEnsure(pool.GetNumAllocated() == 10);
+	TestEnsure(*objects[9] == "Object 9");
+
+	// Freed slots are handed out again before a new block is added
+	size_t reserved = pool.GetReservedSize();
+	String* freed = objects[3];
+	pool.Destroy(freed);
+	String* reused = pool.Create("Reused");
+	TestEnsure(reused == freed);
+	TestEnsure(pool.GetReservedSize() == reserved);
+	objects[3] = reused;
+
+	for(String* object : objects)
+	{
+		pool.Destroy(object);
+	}
+	TestEnsure(pool.GetNumAllocated() == 0);
+}
+
+Test("InternedString.Sharing")
+{
+	InternedString a = String("Some Artist Name");
+	InternedString b = "Some Artist Name";
+	InternedString c = "Another Artist";
+	TestEnsure(a == b);
+	TestEnsure(a != c);
+	TestEnsure(&a.Get() == &b.Get());
+	TestEnsure(a.Get() == "Some Artist Name");
+
+	InternedString empty;
+	TestEnsure(empty.empty());
+	TestEnsure(empty == InternedString(""));
+}
@@ -2,6 +2,8 @@
 #include <Shared/Enum.hpp>
 #include <Tests/Tests.hpp>
 #include <Shared/Files.hpp>
+#include <Shared/FolderWatcher.hpp>
+#include <Shared/MappedFile.hpp>
 
 void CreateDummyFile(const String& filename)
 {
@@ -65,6 +67,60 @@ Test("File.ScanFilesRecursive")
 	}
 	TestEnsure(expectedPaths.empty());
 }
+Test("File.ScanFilesRecursiveCached")
+{
+	String folder = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
+	TestEnsure(Path::CreateDir(folder));
+	String folder1 = folder + Path::sep + "Folder";
+	TestEnsure(Path::CreateDir(folder1));
+	CreateDummyFile(folder + Path::sep + "fileA.ksh");
+	CreateDummyFile(folder + Path::sep + "fileB.txt");
+	CreateDummyFile(folder1 + Path::sep + "fileC.ksh");
+
+	Map<String, FolderScanCache> cache;
+	Vector<FileInfo> files = Files::ScanFilesRecursiveCached(folder, cache, "ksh");
+	TestEnsure(files.size() == 2);
+	TestEnsure(cache.size() == 2);
+
+	// Unchanged folders come from the cache
+	cache[Path::Normalize(folder1)].files.clear();
+	files = Files::ScanFilesRecursiveCached(folder, cache, "ksh");
+	TestEnsure(files.size() == 1);
+
+	// Removed folders are dropped from the cache
+	TestEnsure(Path::DeleteDir(folder1));
+	files = Files::ScanFilesRecursiveCached(folder, cache, "ksh");
+	TestEnsure(files.size() == 1);
+	TestEnsure(files[0].fullPath == Path::Normalize(folder + Path::sep + "fileA.ksh"));
+	TestEnsure(cache.size() == 1);
+}
+Test("File.FolderWatcher")
+{
+	if(!FolderWatcher::IsSupported())
+		return;
+
+	String folder = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
+	TestEnsure(Path::CreateDir(folder));
+
+	FolderWatcher watcher;
+	TestEnsure(watcher.AddFolder(folder));
+	TestEnsure(watcher.Poll().empty());
+
+	String folder1 = folder + Path::sep + "Folder";
+	TestEnsure(Path::CreateDir(folder1));
+	Vector<FolderWatcher::Change> changes = watcher.Poll();
+	TestEnsure(changes.size() == 1 && changes[0].isFolder && changes[0].action == FolderWatcher::Change::Added);
+
+	// Files in the new sub-folder are watched as well
+	CreateDummyFile(folder1 + Path::sep + "fileA");
+	changes = watcher.Poll();
+	TestEnsure(changes.size() == 1 && changes[0].action == FolderWatcher::Change::Updated);
+	TestEnsure(changes[0].path == Path::Normalize(folder1 + Path::sep + "fileA"));
+
+	TestEnsure(Path::Delete(folder1 + Path::sep + "fileA"));
+	changes = watcher.Poll();
+	TestEnsure(changes.size() == 1 && changes[0].action == FolderWatcher::Change::Removed);
+}
 Test("File.ScanFiles")
 {
 	String folder = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
@@ -166,3 +222,31 @@ Test("File.ReadWrite")
 		TestEnsure(file.Read(data, 1) == 0);
 	}
 }
+Test("File.Mapped")
+{
+	char data[] = "\r\n-- Test Data --\r\n@@\r\n";
+	size_t dataLength = strlen(data);
+
+	{
+		File file;
+		TestEnsure(file.OpenWrite(TestFilename, false));
+		file.Write(data, dataLength);
+	}
+
+	MappedFile mapped;
+	TestEnsure(mapped.Open(TestFilename));
+	TestEnsure(mapped.GetSize() == dataLength);
+	TestEnsure(memcmp(mapped.GetData(), data, dataLength) == 0);
+
+	// Read through the stream, past the end
+	MappedFileReader reader(mapped);
+	char confirmData[8];
+	reader.Seek(dataLength - 4);
+	TestEnsure(reader.Serialize(confirmData, 8) == 4);
+	TestEnsure(memcmp(confirmData, data + dataLength - 4, 4) == 0);
+	TestEnsure(reader.Serialize(confirmData, 1) == 0);
+
+	mapped.Close();
+	TestEnsure(!mapped.IsOpen());
+	TestEnsure(!mapped.Open(TestFilename + "_missing"));
+}
@@ -0,0 +1,318 @@
+#include <Shared/Shared.hpp>
+#include <Shared/Jobs.hpp>
+#include <Tests/Tests.hpp>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+// Waits for all jobs to be finalized, or fails after a few seconds
+static void WaitForJobs(JobSheduler& sheduler, std::atomic<uint32>& numFinished, uint32 target)
+{
+	Timer t;
+	while(numFinished < target)
+	{
+		TestEnsure(t.Seconds() < 10);
+		sheduler.Update();
+		std::this_thread::yield();
+	}
+}
+
+Test("Jobs.Queue")
+{
+	JobSheduler sheduler(2, 1);
+	std::atomic<uint32> numRun(0);
+	std::atomic<uint32> numFinished(0);
+	const uint32 numJobs = 100;
+	for(uint32 i = 0; i < numJobs; i++)
+	{
+		Job job = JobBase::CreateLambda([&]()
+		{
+			numRun++;
+			return true;
+		});
+		if(i % 4 == 0)
+			job->jobFlags = JobFlags::IO;
+		job->OnFinished.AddLambda([&](Job finished)
+		{
+			TestEnsure(finished->IsSuccessfull());
+			numFinished++;
+		});
+		TestEnsure(sheduler.Queue(job));
+	}
+	WaitForJobs(sheduler, numFinished, numJobs);
+	TestEnsure(numRun == numJobs);
+}
+
+Test("Jobs.Terminate")
+{
+	JobSheduler sheduler(1, 1);
+	std::atomic<bool> release(false);
+	std::atomic<bool> started(false);
+
+	// Keeps the only worker busy
+	Job blocking = JobBase::CreateLambda([&]()
+	{
+		started = true;
+		while(!release)
+			std::this_thread::yield();
+		return true;
+	});
+	bool ran = false;
+	Job queued = JobBase::CreateLambda([&]()
+	{
+		ran = true;
+		return true;
+	});
+	sheduler.Queue(blocking);
+	sheduler.Queue(queued);
+	while(!started)
+		std::this_thread::yield();
+
+	// Removed before it runs
+	queued->Terminate();
+	TestEnsure(!queued->IsQueued());
+
+	// Waits for the running job
+	std::thread releaser([&]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		release = true;
+	});
+	blocking->Terminate();
+	releaser.join();
+	TestEnsure(blocking->IsSuccessfull());
+	sheduler.Update();
+	TestEnsure(!ran);
+}
+
+// Keeps the worker threads busy until released
+class BlockingJob : public JobBase
+{
+public:
+	std::atomic<bool> started;
+	std::atomic<bool> release;
+	BlockingJob() : started(false), release(false) {}
+	virtual bool Run()
+	{
+		started = true;
+		while(!release)
+			std::this_thread::yield();
+		return true;
+	}
+};
+
+Test("Jobs.Priority")
+{
+	JobSheduler sheduler(1, 1);
+	Ref<BlockingJob> blocking = Ref<BlockingJob>(new BlockingJob());
+	sheduler.Queue(blocking.As<JobBase>());
+	while(!blocking->started)
+		std::this_thread::yield();
+
+	// Only touched by the single worker thread
+	Vector<int32> order;
+	std::atomic<uint32> numFinished(0);
+	const JobPriority priorities[] = { JobPriority::Low, JobPriority::Normal, JobPriority::High, JobPriority::Normal };
+	for(JobPriority priority : priorities)
+	{
+		Job job = JobBase::CreateLambda([&order, priority]()
+		{
+			order.Add((int32)priority);
+			return true;
+		});
+		job->priority = priority;
+		job->OnFinished.AddLambda([&](Job) { numFinished++; });
+		sheduler.Queue(job);
+	}
+	blocking->release = true;
+	WaitForJobs(sheduler, numFinished, 4);
+	TestEnsure(order.size() == 4);
+	TestEnsure(order[0] == (int32)JobPriority::High);
+	TestEnsure(order[1] == (int32)JobPriority::Normal);
+	TestEnsure(order[2] == (int32)JobPriority::Normal);
+	TestEnsure(order[3] == (int32)JobPriority::Low);
+}
+
+// Queued IO jobs can be removed the same way
+Test("Jobs.TerminateIO")
+{
+	JobSheduler sheduler(1, 1);
+	Ref<BlockingJob> blocking = Ref<BlockingJob>(new BlockingJob());
+	blocking->jobFlags = JobFlags::IO;
+	sheduler.Queue(blocking.As<JobBase>());
+	while(!blocking->started)
+		std::this_thread::yield();
+
+	std::atomic<bool> ran(false);
+	Job queued = JobBase::CreateLambda([&]()
+	{
+		ran = true;
+		return true;
+	});
+	queued->jobFlags = JobFlags::IO;
+	sheduler.Queue(queued);
+	queued->Terminate();
+	TestEnsure(!queued->IsQueued());
+
+	// Runs after the removed job would have
+	std::atomic<uint32> numFinished(0);
+	Job last = JobBase::CreateLambda([]() { return true; });
+	last->jobFlags = JobFlags::IO;
+	last->OnFinished.AddLambda([&](Job) { numFinished++; });
+	sheduler.Queue(last);
+	blocking->release = true;
+	WaitForJobs(sheduler, numFinished, 1);
+	TestEnsure(!ran);
+}
+
+Test("Jobs.Cancel")
+{
+	JobSheduler sheduler(1, 1);
+	Ref<BlockingJob> blocking = Ref<BlockingJob>(new BlockingJob());
+	sheduler.Queue(blocking.As<JobBase>());
+	while(!blocking->started)
+		std::this_thread::yield();
+
+	// Both jobs share a token
+	JobCancelToken token;
+	std::atomic<uint32> numRun(0);
+	std::atomic<uint32> numFinished(0);
+	for(uint32 i = 0; i < 2; i++)
+	{
+		Job job = JobBase::CreateLambda([&]()
+		{
+			numRun++;
+			return true;
+		});
+		job->cancelToken = token;
+		if(i == 1)
+			job->jobFlags = JobFlags::IO;
+		job->OnFinished.AddLambda([&](Job finished)
+		{
+			TestEnsure(finished->IsCancelled());
+			TestEnsure(!finished->IsSuccessfull());
+			numFinished++;
+		});
+		sheduler.Queue(job);
+	}
+	token.Cancel();
+	blocking->release = true;
+	WaitForJobs(sheduler, numFinished, 2);
+	TestEnsure(numRun == 0);
+}
+
+Test("Jobs.Dependencies")
+{
+	JobSheduler sheduler(2, 1);
+	std::atomic<uint32> step(0);
+	std::atomic<uint32> numFinished(0);
+	auto addJob = [&](uint32 expectedStep, JobFlags flags)
+	{
+		Job job = JobBase::CreateLambda([&step, expectedStep]()
+		{
+			// Give jobs that run out of order a chance to do so
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			return step.exchange(expectedStep + 1) == expectedStep;
+		});
+		job->jobFlags = flags;
+		job->OnFinished.AddLambda([&](Job finished)
+		{
+			TestEnsure(finished->IsSuccessfull());
+			numFinished++;
+		});
+		return job;
+	};
+
+	// Chain that alternates between the IO and worker threads
+	Job a = addJob(0, JobFlags::IO);
+	Job b = addJob(1, JobFlags::None);
+	Job c = addJob(2, JobFlags::IO);
+	Job d = addJob(3, JobFlags::None);
+	b->AddDependency(a);
+	c->AddDependency(b);
+	d->AddDependency(b);
+	d->AddDependency(c);
+	sheduler.Queue(a);
+	sheduler.Queue(b);
+	sheduler.Queue(c);
+	sheduler.Queue(d);
+	WaitForJobs(sheduler, numFinished, 4);
+	TestEnsure(step == 4);
+
+	// Removing a dependency before it runs releases the jobs waiting for it
+	Ref<BlockingJob> blocking = Ref<BlockingJob>(new BlockingJob());
+	Job removed = JobBase::CreateLambda([]() { return true; });
+	removed->jobFlags = JobFlags::IO;
+	Job waiting = JobBase::CreateLambda([]() { return true; });
+	waiting->AddDependency(blocking.As<JobBase>());
+	waiting->AddDependency(removed);
+	bool waitingFinished = false;
+	waiting->OnFinished.AddLambda([&](Job) { waitingFinished = true; });
+	blocking->jobFlags = JobFlags::IO;
+	sheduler.Queue(blocking.As<JobBase>());
+	sheduler.Queue(removed);
+	sheduler.Queue(waiting);
+	while(!blocking->started)
+		std::this_thread::yield();
+	removed->Terminate();
+	sheduler.Update();
+	TestEnsure(!waitingFinished);
+	blocking->release = true;
+	Timer t;
+	while(!waitingFinished)
+	{
+		TestEnsure(t.Seconds() < 10);
+		sheduler.Update();
+		std::this_thread::yield();
+	}
+}
+
+// Time between queueing a job on an idle sheduler and the job starting, and the number of small jobs per second
+Benchmark("Jobs.Benchmark")
+{
+	JobSheduler sheduler;
+	Logf("%d worker threads, %d IO threads", Logger::Info, sheduler.GetNumThreads(), sheduler.GetNumIOThreads());
+
+	const JobFlags lanes[] = { JobFlags::None, JobFlags::IO };
+	for(JobFlags flags : lanes)
+	{
+		const uint32 numSamples = 50;
+		double totalLatency = 0.0;
+		double maxLatency = 0.0;
+		std::atomic<uint32> numFinished(0);
+		for(uint32 i = 0; i < numSamples; i++)
+		{
+			// Give the threads time to go idle
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+			Timer t;
+			std::atomic<double> latency(0.0);
+			Job job = JobBase::CreateLambda([&]()
+			{
+				latency = t.SecondsAsFloat() * 1000.0;
+				return true;
+			});
+			job->jobFlags = flags;
+			job->OnFinished.AddLambda([&](Job) { numFinished++; });
+			sheduler.Queue(job);
+			WaitForJobs(sheduler, numFinished, i + 1);
+			totalLatency += latency;
+			maxLatency = Math::Max<double>(maxLatency, latency);
+		}
+		Logf("%s dispatch latency: %.3f ms average, %.3f ms max", Logger::Info,
+			flags == JobFlags::IO ? "IO" : "Worker", totalLatency / numSamples, maxLatency);
+	}
+
+	const uint32 numJobs = 20000;
+	std::atomic<uint32> numFinished(0);
+	Timer t;
+	for(uint32 i = 0; i < numJobs; i++)
+	{
+		Job job = JobBase::CreateLambda([]() { return true; });
+		job->OnFinished.AddLambda([&](Job) { numFinished++; });
+		sheduler.Queue(job);
+	}
+	WaitForJobs(sheduler, numFinished, numJobs);
+	Logf("Throughput: %d jobs in %.1f ms (%.0f jobs/s)", Logger::Info,
+		numJobs, t.SecondsAsFloat() * 1000.0f, numJobs / t.SecondsAsFloat());
+}
@@ -19,11 +19,12 @@ class TestEntry
 public:
 	typedef void(*TestFunction)(class TestContext& context);
 
-	TestEntry(String name, TestFunction function);
+	TestEntry(String name, TestFunction function, bool benchmark = false);
 
 private:
 	String m_name;
 	TestFunction m_function;
+	bool m_benchmark;
 	friend class TestManager;
 };
 
@@ -34,7 +35,7 @@ public:
 	~TestManager();
 	static TestManager& Get();
 
-	// Run all tests
+	// Run all tests, except for benchmarks
 	// returns the number of failed tests
 	// 0 = all good
 	int32 RunAll();
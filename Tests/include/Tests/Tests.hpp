@@ -6,6 +6,11 @@
 static void CONCAT(LocalTest, __LINE__)(TestContext& context);\
 static TestEntry* CONCAT(te, __LINE__) = new TestEntry(testName, &CONCAT(LocalTest, __LINE__));\
 void CONCAT(LocalTest, __LINE__)(TestContext& context)
+// Same as Test, but skipped when running all tests, only runs when requested by name
+#define Benchmark(testName)\
+static void CONCAT(LocalTest, __LINE__)(TestContext& context);\
+static TestEntry* CONCAT(te, __LINE__) = new TestEntry(testName, &CONCAT(LocalTest, __LINE__), true);\
+void CONCAT(LocalTest, __LINE__)(TestContext& context)
 #define TestEnsure(__expr) if(!(__expr)) throw TestFailure(STRINGIFY(__expr));
 #define TestFilename context.GenerateTestFilePath()
 #define TestBasePath context.GetTestBasePath()
@@ -23,6 +23,8 @@ int32 TestManager::RunAll()
 	int32 failed = 0;
 	for(int32 i = 0; i < m_tests.size(); i++)
 	{
+		if(m_tests[i]->m_benchmark)
+			continue;
 		if(m_RunTest(m_tests[i]) != 0)
 			failed++;
 	}
@@ -162,7 +164,7 @@ int32 TestManager::m_RunTest(TestEntry* test)
 	return 0;
 }
 
-TestEntry::TestEntry(String name, TestFunction function) : m_name(name), m_function(function)
+TestEntry::TestEntry(String name, TestFunction function, bool benchmark) : m_name(name), m_function(function), m_benchmark(benchmark)
 {
 	// Make sure tests have unique namings
 	assert(!TestManager::Get().m_testsByName.Contains(name));
@@ -0,0 +1,33 @@
+// Instanced version of the button shader, used to draw all buttons of the same type with a single draw call
+#extension GL_ARB_separate_shader_objects : enable
+layout(location=0) in vec2 inPos;
+layout(location=1) in vec2 inTex;
+// Per instance: offset (xy) and scale (zw) on the track
+layout(location=2) in vec4 inPlacement;
+// Per instance: trackPos, trackScale, objectGlow, hitState
+layout(location=3) in vec4 inState;
+layout(location=4) in float inHasSample;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+layout(location=1) out vec2 fsTex;
+layout(location=2) out vec4 fsState;
+layout(location=3) out float fsHasSample;
+out vec4 position;
+
+uniform mat4 proj;
+uniform mat4 camera;
+uniform mat4 world;
+
+void main()
+{
+	fsTex = inTex;
+	fsState = inState;
+	fsHasSample = inHasSample;
+
+	position = vec4(inPos.xy, 0, 1);
+
+	gl_Position = proj * camera * world * vec4(inPlacement.xy + inPos.xy * inPlacement.zw, 0, 1);
+}